@@ -19,6 +19,13 @@ OBJS += main.c
 OBJS += fst_cfgmgr.c
 OBJS += fst_ini_conf.c
 OBJS += fst_rateupg.c
+OBJS += fst_trace.c
+OBJS += fst_metrics.c
+OBJS += fst_pool.c
+OBJS += fst_ifreg.c
+OBJS += fst_ctrl_prof.c
+OBJS += fst_status.c
+OBJS += fst_hist.c
 
 OBJS += external/wpa_ctrl.c
 OBJS += external/eloop.c
@@ -28,7 +35,18 @@ OBJS += external/wpa_debug.c
 OBJS += external/fst_ctrl_aux.c
 OBJS += external/inih/ini.c
 
+# bench_ctrl.c, bench_mgr.c and bench_tc.c compile in the file they measure
+BENCH_OBJS = bench/bench_main.c
+BENCH_OBJS += bench/bench_eloop.c
+BENCH_OBJS += bench/bench_ctrl.c
+BENCH_OBJS += bench/bench_mgr.c
+BENCH_OBJS += bench/bench_tc.c
+BENCH_OBJS += bench/bench_ini.c
+BENCH_OBJS += $(filter-out main.c fst_ctrl.c fst_manager.c fst_tc.c,$(OBJS))
+
 L_CFLAGS += -DCONFIG_CTRL_IFACE -DCONFIG_CTRL_IFACE_UNIX -DCONFIG_FST -DCONFIG_LIBNL20 -DANDROID
+L_CFLAGS += -DCONFIG_ELOOP_EPOLL
+L_CFLAGS += -DCONFIG_DEBUG_ASYNC
 L_CFLAGS += -DCONFIG_CTRL_IFACE_CLIENT_DIR=\"/data/vendor/wifi/sockets\"
 L_CFLAGS += -DDEFAULT_HAPD_CLI_DIR=\"/data/vendor/wifi/hostapd\"
 L_CFLAGS += -DDEFAULT_WPAS_CLI_DIR=\"\"
@@ -54,3 +72,14 @@ LOCAL_CFLAGS := $(L_CFLAGS)
 LOCAL_SRC_FILES := $(OBJS)
 LOCAL_C_INCLUDES := $(INCLUDES)
 include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := fstman_bench
+LOCAL_MODULE_TAGS := optional
+LOCAL_VENDOR_MODULE := true
+LOCAL_SHARED_LIBRARIES := libnl
+LOCAL_SHARED_LIBRARIES += libcutils liblog
+LOCAL_CFLAGS := $(L_CFLAGS)
+LOCAL_SRC_FILES := $(BENCH_OBJS)
+LOCAL_C_INCLUDES := $(INCLUDES)
+include $(BUILD_EXECUTABLE)
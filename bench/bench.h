@@ -0,0 +1,92 @@
+/*
+ * FST Manager: Benchmarks
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __FST_BENCH_H__
+#define __FST_BENCH_H__
+
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * struct fst_bench_suite - a named group of microbenchmarks
+ * @name: suite name, used as the first component of every result name
+ * @run: runs all benchmarks of the suite, returns 0 on success
+ */
+struct fst_bench_suite {
+	const char *name;
+	int (*run)(void);
+};
+
+static inline uint64_t fst_bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * fst_bench_report - prints a single benchmark result
+ * @suite: suite name
+ * @name: benchmark name
+ * @ops: number of operations measured
+ * @elapsed_ns: total time spent for all operations
+ *
+ * Results are printed one per line as whitespace separated key=value pairs:
+ * "bench=<suite>.<name> ops=<n> total_ns=<n> ns_per_op=<x>" so that the
+ * output can be diffed or fed to a script across builds.
+ */
+void fst_bench_report(const char *suite, const char *name, uint64_t ops,
+	uint64_t elapsed_ns);
+
+/**
+ * fst_bench_shuffle - fills an array with a permutation of 0..n-1
+ * @order: array to fill
+ * @n: number of elements
+ *
+ * The permutation is always the same so that runs are comparable across
+ * builds.
+ */
+void fst_bench_shuffle(unsigned int *order, unsigned int n);
+
+/*
+ * Suites. Those of static functions include the file under test, see
+ * bench_ctrl.c, bench_mgr.c and bench_tc.c.
+ */
+int fst_bench_eloop_run(void);
+int fst_bench_ctrl_run(void);
+int fst_bench_mbies_run(void);
+int fst_bench_mgr_run(void);
+int fst_bench_tc_run(void);
+int fst_bench_ini_run(void);
+
+#endif /* __FST_BENCH_H__ */
@@ -0,0 +1,167 @@
+/*
+ * FST Manager: Control interface parsing benchmarks
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * The parsers are static, so the file under test is compiled into the
+ * benchmark. Nothing here talks to hostapd: events and replies are fed to
+ * the parsers directly, as fst_ctrl_receiver() and do_command_ex() would.
+ */
+#include "fst_ctrl.c"
+#include "bench.h"
+
+#define SUITE "ctrl"
+
+#define BENCH_CTRL_OPS 100000
+
+static unsigned int bench_ctrl_events;
+
+static void bench_ctrl_ntfy(void *cb_ctx, u32 session_id,
+	enum fst_event_type event_type, void *extra)
+{
+	bench_ctrl_events++;
+}
+
+/* the parsers modify the buffer, so each run works on a fresh copy */
+static void bench_ctrl_notify(const char *name, const char *event)
+{
+	char buf[512];
+	size_t len = os_strlen(event);
+	unsigned int i;
+	uint64_t start;
+
+	start = fst_bench_now_ns();
+	for (i = 0; i < BENCH_CTRL_OPS; i++) {
+		os_memcpy(buf, event, len + 1);
+		fst_ctrl_notify(buf, len);
+	}
+	fst_bench_report(SUITE, name, BENCH_CTRL_OPS,
+			 fst_bench_now_ns() - start);
+}
+
+static int bench_ctrl_list(const char *name, const char *reply,
+	int (*item_parser)(char *str, void *data), size_t item_size)
+{
+	struct parse_list_proc_ctx ctx;
+	char buf[1024];
+	size_t len = os_strlen(reply);
+	void *items;
+	unsigned int i;
+	uint64_t start;
+	int n = 0;
+
+	start = fst_bench_now_ns();
+	for (i = 0; i < BENCH_CTRL_OPS; i++) {
+		os_memcpy(buf, reply, len + 1);
+		ctx.item_size = item_size;
+		ctx.item_parser = item_parser;
+		ctx.output = &items;
+		ctx.current = NULL;
+		n = parse_list_proc(buf, &ctx);
+		if (n <= 0)
+			return -1;
+		os_free(items);
+	}
+	fst_bench_report(SUITE, name, BENCH_CTRL_OPS,
+			 fst_bench_now_ns() - start);
+
+	return 0;
+}
+
+static int bench_ctrl_session_info(void)
+{
+	static const char reply[] =
+		FST_CSG_PNAME_OLD_PEER_ADDR "=02:00:00:00:01:01 "
+		FST_CSG_PNAME_NEW_PEER_ADDR "=02:00:00:00:02:01 "
+		FST_CSG_PNAME_NEW_IFNAME "=wigig0 "
+		FST_CSG_PNAME_OLD_IFNAME "=wlan0 "
+		FST_CSG_PNAME_LLT "=3600 "
+		FST_CSG_PNAME_STATE "=" FST_CS_PVAL_STATE_SETUP_COMPLETION;
+	struct parse_list_proc_ctx ctx;
+	struct fst_session_info si;
+	char buf[sizeof(reply)];
+	unsigned int i;
+	uint64_t start;
+
+	start = fst_bench_now_ns();
+	for (i = 0; i < BENCH_CTRL_OPS; i++) {
+		os_memcpy(buf, reply, sizeof(reply));
+		ctx.item_size = 0;
+		ctx.item_parser = session_info_parser;
+		ctx.current = &si;
+		if (parse_list_proc(buf, &ctx) != 6)
+			return -1;
+	}
+	fst_bench_report(SUITE, "session_info_parser", BENCH_CTRL_OPS,
+			 fst_bench_now_ns() - start);
+
+	return si.llt == 3600 ? 0 : -1;
+}
+
+int fst_bench_ctrl_run(void)
+{
+	bench_ctrl_events = 0;
+	fst_set_notify_cb(bench_ctrl_ntfy, NULL);
+
+	bench_ctrl_notify("notify_peer",
+		"<3>" FST_CTRL_EVENT_PEER " " FST_CEP_PNAME_IFNAME "=wlan0 "
+		FST_CEP_PNAME_ADDR "=02:00:00:00:01:01 "
+		FST_CEP_PNAME_CONNECTED);
+	bench_ctrl_notify("notify_session_state",
+		"<3>" FST_CTRL_EVENT_SESSION " " FST_CES_PNAME_SESSION_ID "=7 "
+		FST_CES_PNAME_EVT_TYPE "=" FST_PVAL_EVT_TYPE_SESSION_STATE " "
+		FST_CES_PNAME_OLD_STATE "=" FST_CS_PVAL_STATE_TRANSITION_DONE
+		" " FST_CES_PNAME_NEW_STATE "=" FST_CS_PVAL_STATE_INITIAL " "
+		FST_CES_PNAME_REASON "=" FST_CS_PVAL_REASON_SWITCH " "
+		FST_CES_PNAME_INITIATOR "=" FST_CS_PVAL_INITIATOR_REMOTE);
+	bench_ctrl_notify("notify_unrelated",
+		"<3>CTRL-EVENT-SCAN-RESULTS ");
+	fst_set_notify_cb(NULL, NULL);
+	if (bench_ctrl_events != 2 * BENCH_CTRL_OPS)
+		return -1;
+
+	if (bench_ctrl_list("iface_parser_2",
+			"wlan0|02:00:00:00:00:01|100|3600 "
+			"wigig0|02:00:00:00:00:02|110|3600",
+			iface_parser, sizeof(struct fst_iface_info)))
+		return -1;
+	if (bench_ctrl_list("iface_peer_parser_16",
+			"02:00:00:00:01:00 02:00:00:00:01:01 02:00:00:00:01:02 "
+			"02:00:00:00:01:03 02:00:00:00:01:04 02:00:00:00:01:05 "
+			"02:00:00:00:01:06 02:00:00:00:01:07 02:00:00:00:01:08 "
+			"02:00:00:00:01:09 02:00:00:00:01:0a 02:00:00:00:01:0b "
+			"02:00:00:00:01:0c 02:00:00:00:01:0d 02:00:00:00:01:0e "
+			"02:00:00:00:01:0f",
+			iface_peer_parser, ETH_ALEN))
+		return -1;
+
+	return bench_ctrl_session_info();
+}
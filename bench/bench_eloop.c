@@ -0,0 +1,115 @@
+/*
+ * FST Manager: Event loop benchmarks
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "bench.h"
+
+#define SUITE "eloop"
+
+/* Number of concurrently registered timeouts */
+#define BENCH_ELOOP_TIMEOUTS 10000
+
+struct bench_eloop_ctx {
+	unsigned int fired;
+	unsigned int expected;
+};
+
+static struct bench_eloop_ctx ctx;
+static unsigned int cookies[BENCH_ELOOP_TIMEOUTS];
+
+static void bench_eloop_timeout(void *eloop_data, void *user_data)
+{
+	struct bench_eloop_ctx *c = eloop_data;
+
+	if (++c->fired == c->expected)
+		eloop_terminate();
+}
+
+int fst_bench_eloop_run(void)
+{
+	static unsigned int order[BENCH_ELOOP_TIMEOUTS];
+	unsigned int i, n = BENCH_ELOOP_TIMEOUTS;
+	uint64_t start;
+
+	if (eloop_init()) {
+		fprintf(stderr, "eloop_init failed\n");
+		return -1;
+	}
+
+	fst_bench_shuffle(order, n);
+
+	/* Random expiration times within 10 seconds */
+	start = fst_bench_now_ns();
+	for (i = 0; i < n; i++)
+		eloop_register_timeout(order[i] / 1000, (order[i] % 1000) * 1000,
+				       bench_eloop_timeout, &ctx, &cookies[i]);
+	fst_bench_report(SUITE, "register_10k", n, fst_bench_now_ns() - start);
+
+	start = fst_bench_now_ns();
+	for (i = 0; i < n; i++)
+		eloop_is_timeout_registered(bench_eloop_timeout, &ctx,
+					    &cookies[order[i]]);
+	fst_bench_report(SUITE, "lookup_10k", n, fst_bench_now_ns() - start);
+
+	start = fst_bench_now_ns();
+	for (i = 0; i < n; i++)
+		eloop_cancel_timeout(bench_eloop_timeout, &ctx,
+				     &cookies[order[i]]);
+	fst_bench_report(SUITE, "cancel_10k", n, fst_bench_now_ns() - start);
+
+	/* 10k timeouts that are all due by the time eloop_run() starts */
+	ctx.fired = 0;
+	ctx.expected = n;
+	for (i = 0; i < n; i++)
+		eloop_register_timeout(0, (order[i] % 100) * 1000,
+				       bench_eloop_timeout, &ctx, &cookies[i]);
+	os_sleep(0, 100000);
+	start = fst_bench_now_ns();
+	eloop_run();
+	fst_bench_report(SUITE, "expire_10k", ctx.fired,
+			 fst_bench_now_ns() - start);
+
+	/* Wildcard cancellation of a fully populated heap */
+	for (i = 0; i < n; i++)
+		eloop_register_timeout(10, order[i],
+				       bench_eloop_timeout, &ctx, &cookies[i]);
+	start = fst_bench_now_ns();
+	i = eloop_cancel_timeout(bench_eloop_timeout, &ctx, ELOOP_ALL_CTX);
+	fst_bench_report(SUITE, "cancel_all_10k", i,
+			 fst_bench_now_ns() - start);
+
+	eloop_destroy();
+
+	return ctx.fired == n && i == n ? 0 : -1;
+}
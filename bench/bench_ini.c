@@ -0,0 +1,152 @@
+/*
+ * FST Manager: INI configuration accessor benchmarks
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "fst_ini_conf.h"
+#include "bench.h"
+
+#define SUITE "ini"
+
+#define BENCH_INI_OPS 10000
+
+#ifdef ANDROID
+#define BENCH_INI_DIR "/data/local/tmp"
+#else
+#define BENCH_INI_DIR "/tmp"
+#endif
+
+/* the shipped fstman.ini */
+static const char bench_ini_conf[] =
+	"[fst_manager]\n"
+	"ctrl_iface=/data/vendor/wifi/hostapd/global\n"
+	"groups=bond0\n"
+	"\n"
+	"[bond0]\n"
+	"interfaces=wlan0,wigig0\n"
+	"mux_type=bonding\n"
+	"mux_ifname=bond0\n"
+	"mux_managed=1\n"
+	"mac_address_by=wlan0\n"
+	"rate_upgrade_master=wlan0\n"
+	"txqueuelen=100\n"
+	"rate_upgrade_acl_file=/data/vendor/wifi/fst_rate_upgrade.accept\n"
+	"\n"
+	"[wlan0]\n"
+	"priority=100\n"
+	"default_llt=3600\n"
+	"\n"
+	"[wigig0]\n"
+	"priority=110\n"
+	"wpa_group=GCMP\n"
+	"wpa_pairwise=GCMP\n"
+	"hw_mode=ad\n"
+	"channel=2\n";
+
+int fst_bench_ini_run(void)
+{
+	char path[] = BENCH_INI_DIR "/fstman_bench_XXXXXX";
+	struct fst_ini_config *h = NULL;
+	struct fst_group_info *groups = NULL;
+	struct fst_iface_info *ifaces;
+	char buf[80];
+	unsigned int i;
+	uint64_t start;
+	int fd, res = -1;
+
+	fd = mkstemp(path);
+	if (fd < 0)
+		return -1;
+	if (write(fd, bench_ini_conf, sizeof(bench_ini_conf) - 1) !=
+	    sizeof(bench_ini_conf) - 1) {
+		close(fd);
+		goto out;
+	}
+	close(fd);
+
+	h = fst_ini_config_init(path);
+	if (!h)
+		goto out;
+
+	start = fst_bench_now_ns();
+	for (i = 0; i < BENCH_INI_OPS; i++)
+		if (fst_ini_config_get_ctrl_iface(h, buf, sizeof(buf)))
+			goto out;
+	fst_bench_report(SUITE, "get_ctrl_iface", BENCH_INI_OPS,
+			 fst_bench_now_ns() - start);
+
+	start = fst_bench_now_ns();
+	for (i = 0; i < BENCH_INI_OPS; i++) {
+		if (fst_ini_config_get_groups(h, &groups) != 1)
+			goto out;
+		os_free(groups);
+	}
+	fst_bench_report(SUITE, "get_groups", BENCH_INI_OPS,
+			 fst_bench_now_ns() - start);
+
+	if (fst_ini_config_get_groups(h, &groups) != 1)
+		goto out;
+	start = fst_bench_now_ns();
+	for (i = 0; i < BENCH_INI_OPS; i++) {
+		if (fst_ini_config_get_group_ifaces(h, groups, &ifaces) != 2)
+			goto out;
+		os_free(ifaces);
+	}
+	fst_bench_report(SUITE, "get_group_ifaces_2", BENCH_INI_OPS,
+			 fst_bench_now_ns() - start);
+
+	start = fst_bench_now_ns();
+	for (i = 0; i < BENCH_INI_OPS; i++)
+		if (!fst_ini_config_get_mux_ifname(h, groups->id, buf,
+						   sizeof(buf)))
+			goto out;
+	fst_bench_report(SUITE, "get_mux_ifname", BENCH_INI_OPS,
+			 fst_bench_now_ns() - start);
+
+	start = fst_bench_now_ns();
+	for (i = 0; i < BENCH_INI_OPS; i++)
+		if (!fst_ini_config_is_mux_managed(h, groups->id))
+			goto out;
+	fst_bench_report(SUITE, "is_mux_managed", BENCH_INI_OPS,
+			 fst_bench_now_ns() - start);
+
+	res = 0;
+out:
+	os_free(groups);
+	fst_ini_config_deinit(h);
+	unlink(path);
+	return res;
+}
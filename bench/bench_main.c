@@ -0,0 +1,125 @@
+/*
+ * FST Manager: Benchmark driver
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "common/defs.h"
+#include "bench.h"
+
+static const struct fst_bench_suite suites[] = {
+	{ "eloop", fst_bench_eloop_run },
+	{ "ctrl", fst_bench_ctrl_run },
+	{ "mbies", fst_bench_mbies_run },
+	{ "mgr", fst_bench_mgr_run },
+	{ "tc", fst_bench_tc_run },
+	{ "ini", fst_bench_ini_run },
+};
+
+/* the knobs main.c sets from the command line, with its defaults */
+unsigned int fst_debug_level = MSG_ERROR + 1;
+unsigned int fst_num_of_retries = 20;
+unsigned int fst_retry_backoff_ms = 100;
+unsigned int fst_max_concurrent_setups = 4;
+unsigned int fst_setup_rate = 0;
+unsigned int fst_setup_burst = 4;
+unsigned int fst_lazy_setup_rate = 0;
+unsigned int fst_session_pool_size = 4;
+unsigned int fst_max_peers = 16;
+unsigned int fst_resync_interval = 0;
+Boolean      fst_force_nc = FALSE;
+
+void fst_bench_report(const char *suite, const char *name, uint64_t ops,
+	uint64_t elapsed_ns)
+{
+	printf("bench=%s.%s ops=%" PRIu64 " total_ns=%" PRIu64
+	       " ns_per_op=%.1f\n", suite, name, ops, elapsed_ns,
+	       ops ? (double)elapsed_ns / ops : 0.0);
+	fflush(stdout);
+}
+
+void fst_bench_shuffle(unsigned int *order, unsigned int n)
+{
+	unsigned int i, seed = 12345;
+
+	for (i = 0; i < n; i++)
+		order[i] = i;
+	for (i = n - 1; i > 0; i--) {
+		unsigned int j, tmp;
+
+		seed = seed * 1103515245 + 12345;
+		j = (seed >> 8) % (i + 1);
+		tmp = order[i];
+		order[i] = order[j];
+		order[j] = tmp;
+	}
+}
+
+static void usage(const char *prog)
+{
+	size_t i;
+
+	printf("Usage: %s [suite...]\n"
+	       "Runs the given benchmark suites, or all of them. Suites:\n",
+	       prog);
+	for (i = 0; i < ARRAY_SIZE(suites); i++)
+		printf("\t%s\n", suites[i].name);
+}
+
+int main(int argc, char *argv[])
+{
+	size_t i;
+	int j, res = 0;
+
+	if (argc > 1 && (!strcmp(argv[1], "-h") || !strcmp(argv[1], "--help"))) {
+		usage(argv[0]);
+		return 0;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(suites); i++) {
+		int selected = argc < 2;
+
+		for (j = 1; j < argc && !selected; j++)
+			selected = !strcmp(argv[j], suites[i].name);
+		if (!selected)
+			continue;
+		if (suites[i].run()) {
+			fprintf(stderr, "suite %s failed\n", suites[i].name);
+			res = 1;
+		}
+	}
+
+	return res;
+}
@@ -0,0 +1,296 @@
+/*
+ * FST Manager: Manager lookup and MB IE decoding benchmarks
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * The lookups are static, so the file under test is compiled into the
+ * benchmark. They run on groups, ifaces, peers and sessions laid out the
+ * way fst_manager.c links them, without the manager being initialized.
+ */
+#include "fst_manager.c"
+#include "bench.h"
+
+#define SUITE_MGR   "mgr"
+#define SUITE_MBIES "mbies"
+
+#define BENCH_MGR_GROUPS 8
+#define BENCH_MGR_IFACES 2
+#define BENCH_MGR_PEERS  256 /* per group, each with a session */
+#define BENCH_MGR_ROUNDS 10
+#define BENCH_MBIES_OPS  100000
+
+static struct fst_mgr bench_mgr;
+static struct fst_mgr_group *bench_groups[BENCH_MGR_GROUPS];
+
+static void bench_mgr_peer_addr(unsigned int g, unsigned int i,
+	unsigned int p, u8 *addr)
+{
+	addr[0] = 0x02;
+	addr[1] = i;
+	addr[2] = g;
+	addr[3] = 0;
+	addr[4] = p >> 8;
+	addr[5] = p & 0xff;
+}
+
+static int bench_mgr_build_group(unsigned int gi)
+{
+	struct fst_mgr_iface *ifaces[BENCH_MGR_IFACES];
+	struct fst_mgr_group *g;
+	unsigned int i, k;
+
+	g = os_zalloc(sizeof(*g));
+	if (!g)
+		return -1;
+	os_snprintf(g->info.id, sizeof(g->info.id), "bond%u", gi);
+	dl_list_init(&g->sessions);
+	dl_list_init(&g->ifaces);
+	dl_list_init(&g->peers);
+	dl_list_init(&g->pairs);
+	dl_list_init(&g->setup_queue);
+	dl_list_add_tail(&bench_mgr.groups, &g->mgr_lentry);
+	bench_groups[gi] = g;
+
+	for (i = 0; i < BENCH_MGR_IFACES; i++) {
+		ifaces[i] = os_zalloc(sizeof(*ifaces[i]));
+		if (!ifaces[i])
+			return -1;
+		os_snprintf(ifaces[i]->info.name, sizeof(ifaces[i]->info.name),
+			    "wlan%u", gi * BENCH_MGR_IFACES + i);
+		ifaces[i]->ifid = fst_ifreg_get(ifaces[i]->info.name);
+		ifaces[i]->link_loss_fd = -1;
+		dl_list_init(&ifaces[i]->link_loss_pending);
+		dl_list_add_tail(&g->ifaces, &ifaces[i]->grp_lentry);
+	}
+
+	for (k = 0; k < BENCH_MGR_PEERS; k++) {
+		struct fst_mgr_peer *p = os_zalloc(sizeof(*p));
+		struct fst_mgr_session *s = os_zalloc(sizeof(*s));
+
+		if (!p || !s) {
+			os_free(p);
+			os_free(s);
+			return -1;
+		}
+		dl_list_init(&p->ifaces);
+		dl_list_add_tail(&g->peers, &p->grp_lentry);
+		s->id = gi * BENCH_MGR_PEERS + k;
+		s->group = g;
+		dl_list_add_tail(&g->sessions, &s->grp_lentry);
+		p->session = s;
+
+		for (i = 0; i < BENCH_MGR_IFACES; i++) {
+			struct fst_mgr_peer_iface *pi = os_zalloc(sizeof(*pi));
+
+			if (!pi)
+				return -1;
+			pi->iface = ifaces[i];
+			bench_mgr_peer_addr(gi, i, k, pi->addr);
+			dl_list_add_tail(&p->ifaces, &pi->peer_lentry);
+		}
+	}
+
+	return 0;
+}
+
+static void bench_mgr_free(void)
+{
+	struct fst_mgr_group *g;
+
+	while ((g = dl_list_first(&bench_mgr.groups, struct fst_mgr_group,
+				  mgr_lentry)) != NULL) {
+		struct fst_mgr_session *s;
+		struct fst_mgr_iface *i;
+		struct fst_mgr_peer *p;
+
+		while ((p = dl_list_first(&g->peers, struct fst_mgr_peer,
+					  grp_lentry)) != NULL) {
+			struct fst_mgr_peer_iface *pi;
+
+			while ((pi = dl_list_first(&p->ifaces,
+					struct fst_mgr_peer_iface,
+					peer_lentry)) != NULL) {
+				dl_list_del(&pi->peer_lentry);
+				os_free(pi);
+			}
+			dl_list_del(&p->grp_lentry);
+			os_free(p);
+		}
+		while ((s = dl_list_first(&g->sessions,
+				struct fst_mgr_session, grp_lentry)) != NULL) {
+			dl_list_del(&s->grp_lentry);
+			os_free(s);
+		}
+		while ((i = dl_list_first(&g->ifaces, struct fst_mgr_iface,
+					  grp_lentry)) != NULL) {
+			dl_list_del(&i->grp_lentry);
+			fst_ifreg_put(i->ifid);
+			os_free(i);
+		}
+		dl_list_del(&g->mgr_lentry);
+		os_free(g);
+	}
+}
+
+int fst_bench_mgr_run(void)
+{
+	static unsigned int order[BENCH_MGR_GROUPS * BENCH_MGR_PEERS];
+	const unsigned int n = ARRAY_SIZE(order);
+	struct fst_mgr_session *s;
+	struct fst_mgr_iface *iface;
+	unsigned int gi, k, r, found = 0;
+	char ifname[IFNAMSIZ];
+	u8 addr[ETH_ALEN];
+	uint64_t start;
+	int res = -1;
+
+	dl_list_init(&bench_mgr.groups);
+	for (gi = 0; gi < BENCH_MGR_GROUPS; gi++)
+		if (bench_mgr_build_group(gi))
+			goto out;
+	fst_bench_shuffle(order, n);
+
+	/* the address of the last iface is the furthest from the peer */
+	start = fst_bench_now_ns();
+	for (r = 0; r < BENCH_MGR_ROUNDS; r++)
+		for (k = 0; k < n; k++) {
+			gi = order[k] / BENCH_MGR_PEERS;
+			bench_mgr_peer_addr(gi, BENCH_MGR_IFACES - 1,
+				order[k] % BENCH_MGR_PEERS, addr);
+			if (_fst_mgr_group_peer_by_addr(bench_groups[gi],
+					addr))
+				found++;
+		}
+	fst_bench_report(SUITE_MGR, "peer_by_addr_256", found,
+			 fst_bench_now_ns() - start);
+
+	start = fst_bench_now_ns();
+	for (r = 0; r < BENCH_MGR_ROUNDS; r++)
+		for (k = 0; k < n; k++) {
+			gi = order[k] / BENCH_MGR_PEERS;
+			bench_mgr_peer_addr(gi, BENCH_MGR_IFACES,
+				order[k] % BENCH_MGR_PEERS, addr);
+			if (!_fst_mgr_group_peer_by_addr(bench_groups[gi],
+					addr))
+				found++;
+		}
+	fst_bench_report(SUITE_MGR, "peer_by_addr_miss_256",
+			 found - BENCH_MGR_ROUNDS * n,
+			 fst_bench_now_ns() - start);
+
+	found = 0;
+	start = fst_bench_now_ns();
+	for (r = 0; r < BENCH_MGR_ROUNDS; r++)
+		for (k = 0; k < n; k++) {
+			os_snprintf(ifname, sizeof(ifname), "wlan%u",
+				    order[k] % (BENCH_MGR_GROUPS *
+						BENCH_MGR_IFACES));
+			if (_fst_mgr_group_by_ifname(&bench_mgr, ifname,
+						     &iface))
+				found++;
+		}
+	fst_bench_report(SUITE_MGR, "group_by_ifname_8", found,
+			 fst_bench_now_ns() - start);
+
+	found = 0;
+	start = fst_bench_now_ns();
+	for (r = 0; r < BENCH_MGR_ROUNDS; r++)
+		for (k = 0; k < n; k++)
+			if (_fst_mgr_group_by_session_id(&bench_mgr, order[k],
+							 &s))
+				found++;
+	fst_bench_report(SUITE_MGR, "group_by_session_id_2k", found,
+			 fst_bench_now_ns() - start);
+
+	res = found == BENCH_MGR_ROUNDS * n ? 0 : -1;
+out:
+	bench_mgr_free();
+	return res;
+}
+
+/* MB IEs of a peer connected on 3 ifaces, as GET_PEER_MBIES reports them */
+static int bench_mbies_build(char *buf, size_t size)
+{
+	size_t len = 0;
+	unsigned int i;
+
+	for (i = 1; i < 3; i++) {
+		struct {
+			struct multi_band_ie ie;
+			u8 sta_addr[ETH_ALEN];
+		} STRUCT_PACKED mbie;
+
+		os_memset(&mbie, 0, sizeof(mbie));
+		mbie.ie.eid = WLAN_EID_MULTI_BAND;
+		mbie.ie.len = sizeof(mbie) - 2;
+		mbie.ie.mb_ctrl = MB_STA_ROLE_NON_PCP_NON_AP |
+			MB_CTRL_STA_MAC_PRESENT;
+		mbie.ie.band_id = i == 1 ? MB_BAND_ID_WIFI_5GHZ :
+			MB_BAND_ID_WIFI_60GHZ;
+		bench_mgr_peer_addr(0, i, 0, mbie.ie.bssid);
+		mbie.ie.bssid[0] = 0x04;
+		bench_mgr_peer_addr(0, i, 0, mbie.sta_addr);
+		len += wpa_snprintf_hex(buf + len, size - len, (u8 *)&mbie,
+			sizeof(mbie));
+	}
+
+	return len;
+}
+
+int fst_bench_mbies_run(void)
+{
+	char mbies[256];
+	u8 addr[ETH_ALEN];
+	unsigned int i, found = 0;
+	uint64_t start;
+	int len;
+
+	len = bench_mbies_build(mbies, sizeof(mbies));
+
+	/* the address is in the last element */
+	bench_mgr_peer_addr(0, 2, 0, addr);
+	start = fst_bench_now_ns();
+	for (i = 0; i < BENCH_MBIES_OPS; i++)
+		if (_fst_mgr_mbies_has_addr(mbies, len, addr))
+			found++;
+	fst_bench_report(SUITE_MBIES, "decode_hit_2", found,
+			 fst_bench_now_ns() - start);
+
+	bench_mgr_peer_addr(0, 3, 0, addr);
+	start = fst_bench_now_ns();
+	for (i = 0; i < BENCH_MBIES_OPS; i++)
+		if (!_fst_mgr_mbies_has_addr(mbies, len, addr))
+			found++;
+	fst_bench_report(SUITE_MBIES, "decode_miss_2", found - BENCH_MBIES_OPS,
+			 fst_bench_now_ns() - start);
+
+	return found == 2 * BENCH_MBIES_OPS ? 0 : -1;
+}
@@ -0,0 +1,115 @@
+/*
+ * FST Manager: TC netlink message construction benchmarks
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * The message builders are static, so the file under test is compiled into
+ * the benchmark. Messages are built the way tc_filter_modify() builds them
+ * but never sent, so no netlink socket or bond is needed.
+ */
+#include "fst_tc.c"
+#include "bench.h"
+
+#define SUITE "tc"
+
+#define BENCH_TC_OPS     100000
+#define BENCH_TC_FILTERS 1024
+#define BENCH_TC_PRIO_OPS 200
+
+static int bench_tc_l2da_msg(struct fst_tc *f, const u8 *mac)
+{
+	struct tc_l2da_filter_modify_ctx ctx = {
+		.mac = mac,
+		.queue_id = 1,
+	};
+	struct nl_msg *msg;
+	struct tcmsg t;
+	int res;
+
+	msg = nlmsg_alloc_simple(RTM_NEWTFILTER,
+		NLM_F_REQUEST | NLM_F_ACK | NLM_F_EXCL | NLM_F_CREATE);
+	if (!msg)
+		return -1;
+
+	os_memset(&t, 0, sizeof(t));
+	t.tcm_family = AF_UNSPEC;
+	t.tcm_parent = MULTIQ_QDISC_HANDLE;
+	t.tcm_ifindex = 1;
+	t.tcm_info = TC_H_MAKE(((uint32_t) 2) << 16, htons(ETH_P_ALL));
+	nlmsg_append(msg, &t, sizeof(t), NLMSG_ALIGNTO);
+	nla_put(msg, TCA_KIND, sizeof("u32"), "u32");
+
+	res = tc_l2da_filter_modify_clb(f, 1, msg, &ctx);
+	nlmsg_free(msg);
+
+	return res;
+}
+
+int fst_bench_tc_run(void)
+{
+	static struct fst_tc_filter_handle handles[BENCH_TC_FILTERS];
+	static const u8 mac[ETH_ALEN] = { 0x02, 0, 0, 0, 0x01, 0x01 };
+	struct fst_tc f;
+	unsigned int i;
+	uint64_t start;
+	u16 prio = 0;
+
+	os_memset(&f, 0, sizeof(f));
+	dl_list_init(&f.ifaces);
+	dl_list_init(&f.filters);
+
+	start = fst_bench_now_ns();
+	for (i = 0; i < BENCH_TC_OPS; i++)
+		if (bench_tc_l2da_msg(&f, mac))
+			return -1;
+	fst_bench_report(SUITE, "l2da_filter_msg", BENCH_TC_OPS,
+			 fst_bench_now_ns() - start);
+
+	start = fst_bench_now_ns();
+	for (i = 0; i < BENCH_TC_OPS; i++)
+		if (bench_tc_l2da_msg(&f, NULL))
+			return -1;
+	fst_bench_report(SUITE, "universal_filter_msg", BENCH_TC_OPS,
+			 fst_bench_now_ns() - start);
+
+	/* every filter install looks up a free priority, here the last one */
+	for (i = 0; i < BENCH_TC_FILTERS; i++) {
+		handles[i].prio = PRIO_BOND_TX_BASE + i;
+		dl_list_add(&f.filters, &handles[i].filters_lentry);
+	}
+	start = fst_bench_now_ns();
+	for (i = 0; i < BENCH_TC_PRIO_OPS; i++)
+		prio = fst_tc_get_lowest_unused_prio(&f);
+	fst_bench_report(SUITE, "lowest_unused_prio_1k", BENCH_TC_PRIO_OPS,
+			 fst_bench_now_ns() - start);
+
+	return prio == PRIO_BOND_TX_BASE + BENCH_TC_FILTERS ? 0 : -1;
+}
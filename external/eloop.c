@@ -28,6 +28,8 @@
 
 #ifdef CONFIG_ELOOP_EPOLL
 #include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
 #endif /* CONFIG_ELOOP_EPOLL */
 
 struct eloop_sock {
@@ -41,7 +43,9 @@ struct eloop_sock {
 };
 
 struct eloop_timeout {
-	struct dl_list list;
+	struct dl_list hlist; /* eloop_data::timeout_hash chain */
+	size_t heap_idx; /* position in eloop_data::timeout_heap */
+	unsigned int seq; /* registration order, breaks ties and bounds runs */
 	struct os_reltime time;
 	void *eloop_data;
 	void *user_data;
@@ -68,6 +72,8 @@ struct eloop_sock_table {
 #endif /* CONFIG_ELOOP_EPOLL */
 };
 
+#define ELOOP_TIMEOUT_HASH_SIZE 1024
+
 struct eloop_data {
 	int max_sock;
 
@@ -84,12 +90,34 @@ struct eloop_data {
 	int epoll_max_fd;
 	struct eloop_sock *epoll_table;
 	struct epoll_event *epoll_events;
+	/*
+	 * Timeouts and signals are delivered through the epoll set as well:
+	 * timerfd is armed for the first timeout in the heap and signalfd
+	 * receives the registered signals while eloop_run() keeps them
+	 * blocked. epoll_internal is the number of such internal fds.
+	 */
+	int epoll_internal;
+	int timerfd;
+	int timerfd_armed;
+	struct os_reltime timerfd_time;
+	int signalfd;
+	sigset_t signalfd_mask;
 #endif /* CONFIG_ELOOP_EPOLL */
 	struct eloop_sock_table readers;
 	struct eloop_sock_table writers;
 	struct eloop_sock_table exceptions;
 
-	struct dl_list timeout;
+	/*
+	 * Timeouts are kept in a binary min-heap ordered by expiration time,
+	 * so that registration and cancellation are O(log n) and the next
+	 * expiration is always timeout_heap[0]. The hash indexes the same
+	 * timeouts by <handler,eloop_data,user_data> for exact-match lookups.
+	 */
+	struct eloop_timeout **timeout_heap;
+	size_t timeout_count;
+	size_t timeout_alloc;
+	unsigned int timeout_seq;
+	struct dl_list timeout_hash[ELOOP_TIMEOUT_HASH_SIZE];
 
 	int signal_count;
 	struct eloop_signal *signals;
@@ -102,6 +130,10 @@ struct eloop_data {
 static struct eloop_data eloop;
 
 
+/* Initial capacity of the timeout heap; doubled on demand */
+#define ELOOP_TIMEOUT_HEAP_MIN 16
+
+
 #ifdef WPA_TRACE
 
 static void eloop_sigsegv_handler(int sig)
@@ -145,10 +177,149 @@ static void eloop_trace_sock_remove_ref(struct eloop_sock_table *table)
 #endif /* WPA_TRACE */
 
 
+#ifdef CONFIG_ELOOP_EPOLL
+
+/* Room for the internal timerfd and signalfd in every epoll_wait() */
+#define ELOOP_EPOLL_MIN_EVENTS 8
+
+static void eloop_process_pending_signals(void);
+
+static int eloop_epoll_add_internal(int fd)
+{
+	struct epoll_event ev;
+
+	if (eloop.count + eloop.epoll_internal + 1 >
+	    eloop.epoll_max_event_num) {
+		struct epoll_event *temp_events;
+		int next = eloop.epoll_max_event_num * 2;
+
+		temp_events = os_realloc_array(eloop.epoll_events, next,
+					       sizeof(struct epoll_event));
+		if (temp_events == NULL)
+			return -1;
+		eloop.epoll_max_event_num = next;
+		eloop.epoll_events = temp_events;
+	}
+
+	os_memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = fd;
+	if (epoll_ctl(eloop.epollfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+		wpa_printf(MSG_ERROR, "%s: epoll_ctl(ADD) for fd=%d "
+			   "failed. %s\n", __func__, fd, strerror(errno));
+		return -1;
+	}
+	eloop.epoll_internal++;
+	return 0;
+}
+
+
+static void eloop_timerfd_init(void)
+{
+	/* Use the clock os_get_reltime() is based on, if available */
+	eloop.timerfd = timerfd_create(CLOCK_BOOTTIME,
+				       TFD_NONBLOCK | TFD_CLOEXEC);
+	if (eloop.timerfd < 0)
+		eloop.timerfd = timerfd_create(CLOCK_MONOTONIC,
+					       TFD_NONBLOCK | TFD_CLOEXEC);
+	if (eloop.timerfd < 0) {
+		wpa_printf(MSG_INFO, "ELOOP: timerfd not available (%s), "
+			   "using epoll_wait() timeouts", strerror(errno));
+		return;
+	}
+	if (eloop_epoll_add_internal(eloop.timerfd) < 0) {
+		close(eloop.timerfd);
+		eloop.timerfd = -1;
+	}
+}
+
+
+static void eloop_timerfd_set(const struct os_reltime *when,
+			      const struct os_reltime *rel)
+{
+	struct itimerspec its;
+
+	if (eloop.timerfd_armed && when &&
+	    eloop.timerfd_time.sec == when->sec &&
+	    eloop.timerfd_time.usec == when->usec)
+		return;
+	if (!eloop.timerfd_armed && !when)
+		return;
+
+	os_memset(&its, 0, sizeof(its));
+	if (when) {
+		its.it_value.tv_sec = rel->sec;
+		its.it_value.tv_nsec = rel->usec * 1000;
+	}
+	if (timerfd_settime(eloop.timerfd, 0, &its, NULL) < 0) {
+		wpa_printf(MSG_ERROR, "ELOOP: timerfd_settime failed: %s",
+			   strerror(errno));
+		eloop.timerfd_armed = 0;
+		return;
+	}
+	eloop.timerfd_armed = when != NULL;
+	if (when)
+		eloop.timerfd_time = *when;
+}
+
+
+static void eloop_timerfd_read(void)
+{
+	u64 expirations;
+
+	/* The timer is one-shot, so it is disarmed once it has fired */
+	if (read(eloop.timerfd, &expirations, sizeof(expirations)) > 0)
+		eloop.timerfd_armed = 0;
+}
+
+
+static int eloop_signalfd_update(void)
+{
+	if (eloop.signalfd >= 0) {
+		if (signalfd(eloop.signalfd, &eloop.signalfd_mask, 0) < 0)
+			return -1;
+		return 0;
+	}
+
+	eloop.signalfd = signalfd(-1, &eloop.signalfd_mask,
+				  SFD_NONBLOCK | SFD_CLOEXEC);
+	if (eloop.signalfd < 0)
+		return -1;
+	if (eloop_epoll_add_internal(eloop.signalfd) < 0) {
+		close(eloop.signalfd);
+		eloop.signalfd = -1;
+		return -1;
+	}
+	return 0;
+}
+
+
+static void eloop_signalfd_read(void)
+{
+	struct signalfd_siginfo info;
+	int i;
+
+	while (read(eloop.signalfd, &info, sizeof(info)) == sizeof(info)) {
+		eloop.signaled++;
+		for (i = 0; i < eloop.signal_count; i++) {
+			if (eloop.signals[i].sig == (int) info.ssi_signo) {
+				eloop.signals[i].signaled++;
+				break;
+			}
+		}
+	}
+}
+
+#endif /* CONFIG_ELOOP_EPOLL */
+
+
 int eloop_init(void)
 {
+	int i;
+
 	os_memset(&eloop, 0, sizeof(eloop));
-	dl_list_init(&eloop.timeout);
+	for (i = 0; i < ELOOP_TIMEOUT_HASH_SIZE; i++)
+		dl_list_init(&eloop.timeout_hash[i]);
 #ifdef CONFIG_ELOOP_EPOLL
 	eloop.epollfd = epoll_create1(0);
 	if (eloop.epollfd < 0) {
@@ -159,6 +330,16 @@ int eloop_init(void)
 	eloop.readers.type = EVENT_TYPE_READ;
 	eloop.writers.type = EVENT_TYPE_WRITE;
 	eloop.exceptions.type = EVENT_TYPE_EXCEPTION;
+	eloop.signalfd = -1;
+	sigemptyset(&eloop.signalfd_mask);
+	eloop.epoll_events = os_calloc(ELOOP_EPOLL_MIN_EVENTS,
+				       sizeof(struct epoll_event));
+	if (eloop.epoll_events == NULL) {
+		close(eloop.epollfd);
+		return -1;
+	}
+	eloop.epoll_max_event_num = ELOOP_EPOLL_MIN_EVENTS;
+	eloop_timerfd_init();
 #endif /* CONFIG_ELOOP_EPOLL */
 #ifdef WPA_TRACE
 	signal(SIGSEGV, eloop_sigsegv_handler);
@@ -223,7 +404,8 @@ static int eloop_sock_table_add_sock(struct eloop_sock_table *table,
 		eloop.epoll_table = temp_table;
 	}
 
-	if (eloop.count + 1 > eloop.epoll_max_event_num) {
+	if (eloop.count + 1 + eloop.epoll_internal >
+	    eloop.epoll_max_event_num) {
 		next = eloop.epoll_max_event_num == 0 ? 8 :
 			eloop.epoll_max_event_num * 2;
 		temp_events = os_realloc_array(eloop.epoll_events, next,
@@ -518,6 +700,15 @@ static void eloop_sock_table_dispatch(struct epoll_event *events, int nfds)
 	int i;
 
 	for (i = 0; i < nfds; i++) {
+		if (events[i].data.fd == eloop.timerfd) {
+			eloop_timerfd_read();
+			continue;
+		}
+		if (events[i].data.fd == eloop.signalfd) {
+			eloop_signalfd_read();
+			eloop_process_pending_signals();
+			continue;
+		}
 		table = &eloop.epoll_table[events[i].data.fd];
 		if (table->handler == NULL)
 			continue;
@@ -601,13 +792,98 @@ void eloop_unregister_sock(int sock, eloop_event_type type)
 }
 
 
+static unsigned int eloop_timeout_hash(eloop_timeout_handler handler,
+				       void *eloop_data, void *user_data)
+{
+	u32 h = (u32) (uintptr_t) handler;
+
+	h = (h ^ (u32) (uintptr_t) eloop_data) * 2654435761U;
+	h = (h ^ (u32) (uintptr_t) user_data) * 2654435761U;
+	return (h >> 16) % ELOOP_TIMEOUT_HASH_SIZE;
+}
+
+
+static int eloop_timeout_before(struct eloop_timeout *a,
+				struct eloop_timeout *b)
+{
+	if (a->time.sec != b->time.sec || a->time.usec != b->time.usec)
+		return os_reltime_before(&a->time, &b->time);
+	/* Equal expiration times fire in registration order */
+	return (int) (a->seq - b->seq) < 0;
+}
+
+
+static void eloop_timeout_heap_set(size_t idx, struct eloop_timeout *timeout)
+{
+	eloop.timeout_heap[idx] = timeout;
+	timeout->heap_idx = idx;
+}
+
+
+static void eloop_timeout_sift_up(size_t idx)
+{
+	struct eloop_timeout *timeout = eloop.timeout_heap[idx];
+
+	while (idx > 0) {
+		size_t parent = (idx - 1) / 2;
+
+		if (!eloop_timeout_before(timeout, eloop.timeout_heap[parent]))
+			break;
+		eloop_timeout_heap_set(idx, eloop.timeout_heap[parent]);
+		idx = parent;
+	}
+	eloop_timeout_heap_set(idx, timeout);
+}
+
+
+static void eloop_timeout_sift_down(size_t idx)
+{
+	struct eloop_timeout *timeout = eloop.timeout_heap[idx];
+
+	for (;;) {
+		size_t child = 2 * idx + 1;
+
+		if (child >= eloop.timeout_count)
+			break;
+		if (child + 1 < eloop.timeout_count &&
+		    eloop_timeout_before(eloop.timeout_heap[child + 1],
+					 eloop.timeout_heap[child]))
+			child++;
+		if (!eloop_timeout_before(eloop.timeout_heap[child], timeout))
+			break;
+		eloop_timeout_heap_set(idx, eloop.timeout_heap[child]);
+		idx = child;
+	}
+	eloop_timeout_heap_set(idx, timeout);
+}
+
+
+static struct eloop_timeout * eloop_first_timeout(void)
+{
+	return eloop.timeout_count ? eloop.timeout_heap[0] : NULL;
+}
+
+
 int eloop_register_timeout(unsigned int secs, unsigned int usecs,
 			   eloop_timeout_handler handler,
 			   void *eloop_data, void *user_data)
 {
-	struct eloop_timeout *timeout, *tmp;
+	struct eloop_timeout *timeout;
 	os_time_t now_sec;
 
+	if (eloop.timeout_count == eloop.timeout_alloc) {
+		struct eloop_timeout **heap;
+		size_t alloc = eloop.timeout_alloc ?
+			eloop.timeout_alloc * 2 : ELOOP_TIMEOUT_HEAP_MIN;
+
+		heap = os_realloc_array(eloop.timeout_heap, alloc,
+					sizeof(*heap));
+		if (heap == NULL)
+			return -1;
+		eloop.timeout_heap = heap;
+		eloop.timeout_alloc = alloc;
+	}
+
 	timeout = os_zalloc(sizeof(*timeout));
 	if (timeout == NULL)
 		return -1;
@@ -635,18 +911,17 @@ int eloop_register_timeout(unsigned int secs, unsigned int usecs,
 	timeout->eloop_data = eloop_data;
 	timeout->user_data = user_data;
 	timeout->handler = handler;
+	timeout->seq = eloop.timeout_seq++;
 	wpa_trace_add_ref(timeout, eloop, eloop_data);
 	wpa_trace_add_ref(timeout, user, user_data);
 	wpa_trace_record(timeout);
 
-	/* Maintain timeouts in order of increasing time */
-	dl_list_for_each(tmp, &eloop.timeout, struct eloop_timeout, list) {
-		if (os_reltime_before(&timeout->time, &tmp->time)) {
-			dl_list_add(tmp->list.prev, &timeout->list);
-			return 0;
-		}
-	}
-	dl_list_add_tail(&eloop.timeout, &timeout->list);
+	dl_list_add_tail(&eloop.timeout_hash[eloop_timeout_hash(handler,
+								 eloop_data,
+								 user_data)],
+			 &timeout->hlist);
+	eloop_timeout_heap_set(eloop.timeout_count++, timeout);
+	eloop_timeout_sift_up(timeout->heap_idx);
 
 	return 0;
 }
@@ -654,29 +929,85 @@ int eloop_register_timeout(unsigned int secs, unsigned int usecs,
 
 static void eloop_remove_timeout(struct eloop_timeout *timeout)
 {
-	dl_list_del(&timeout->list);
+	size_t idx = timeout->heap_idx;
+
+	eloop.timeout_count--;
+	if (idx != eloop.timeout_count) {
+		eloop_timeout_heap_set(idx,
+				       eloop.timeout_heap[eloop.timeout_count]);
+		if (idx > 0 &&
+		    eloop_timeout_before(eloop.timeout_heap[idx],
+					 eloop.timeout_heap[(idx - 1) / 2]))
+			eloop_timeout_sift_up(idx);
+		else
+			eloop_timeout_sift_down(idx);
+	}
+	dl_list_del(&timeout->hlist);
 	wpa_trace_remove_ref(timeout, eloop, timeout->eloop_data);
 	wpa_trace_remove_ref(timeout, user, timeout->user_data);
 	os_free(timeout);
 }
 
 
+static struct eloop_timeout *
+eloop_find_timeout(eloop_timeout_handler handler, void *eloop_data,
+		   void *user_data)
+{
+	struct eloop_timeout *tmp;
+
+	dl_list_for_each(tmp, &eloop.timeout_hash[eloop_timeout_hash(
+					handler, eloop_data, user_data)],
+			 struct eloop_timeout, hlist) {
+		if (tmp->handler == handler &&
+		    tmp->eloop_data == eloop_data &&
+		    tmp->user_data == user_data)
+			return tmp;
+	}
+
+	return NULL;
+}
+
+
 int eloop_cancel_timeout(eloop_timeout_handler handler,
 			 void *eloop_data, void *user_data)
 {
-	struct eloop_timeout *timeout, *prev;
+	struct eloop_timeout *timeout;
+	size_t i;
 	int removed = 0;
 
-	dl_list_for_each_safe(timeout, prev, &eloop.timeout,
-			      struct eloop_timeout, list) {
+	if (eloop_data != ELOOP_ALL_CTX && user_data != ELOOP_ALL_CTX) {
+		while ((timeout = eloop_find_timeout(handler, eloop_data,
+						     user_data)) != NULL) {
+			eloop_remove_timeout(timeout);
+			removed++;
+		}
+		return removed;
+	}
+
+	/* Wildcard match - walk the whole heap */
+	i = 0;
+	while (i < eloop.timeout_count) {
+		timeout = eloop.timeout_heap[i];
 		if (timeout->handler == handler &&
 		    (timeout->eloop_data == eloop_data ||
 		     eloop_data == ELOOP_ALL_CTX) &&
 		    (timeout->user_data == user_data ||
 		     user_data == ELOOP_ALL_CTX)) {
+			struct eloop_timeout *last =
+				eloop.timeout_heap[eloop.timeout_count - 1];
+
+			/*
+			 * Removal moves the last heap entry into slot i and
+			 * may sift it further up; continue from wherever it
+			 * ended so that it is not skipped.
+			 */
 			eloop_remove_timeout(timeout);
 			removed++;
+			if (last != timeout && last->heap_idx < i)
+				i = last->heap_idx;
+			continue;
 		}
+		i++;
 	}
 
 	return removed;
@@ -687,42 +1018,26 @@ int eloop_cancel_timeout_one(eloop_timeout_handler handler,
 			     void *eloop_data, void *user_data,
 			     struct os_reltime *remaining)
 {
-	struct eloop_timeout *timeout, *prev;
-	int removed = 0;
+	struct eloop_timeout *timeout;
 	struct os_reltime now;
 
 	os_get_reltime(&now);
 	remaining->sec = remaining->usec = 0;
 
-	dl_list_for_each_safe(timeout, prev, &eloop.timeout,
-			      struct eloop_timeout, list) {
-		if (timeout->handler == handler &&
-		    (timeout->eloop_data == eloop_data) &&
-		    (timeout->user_data == user_data)) {
-			removed = 1;
-			if (os_reltime_before(&now, &timeout->time))
-				os_reltime_sub(&timeout->time, &now, remaining);
-			eloop_remove_timeout(timeout);
-			break;
-		}
-	}
-	return removed;
+	timeout = eloop_find_timeout(handler, eloop_data, user_data);
+	if (timeout == NULL)
+		return 0;
+	if (os_reltime_before(&now, &timeout->time))
+		os_reltime_sub(&timeout->time, &now, remaining);
+	eloop_remove_timeout(timeout);
+	return 1;
 }
 
 
 int eloop_is_timeout_registered(eloop_timeout_handler handler,
 				void *eloop_data, void *user_data)
 {
-	struct eloop_timeout *tmp;
-
-	dl_list_for_each(tmp, &eloop.timeout, struct eloop_timeout, list) {
-		if (tmp->handler == handler &&
-		    tmp->eloop_data == eloop_data &&
-		    tmp->user_data == user_data)
-			return 1;
-	}
-
-	return 0;
+	return eloop_find_timeout(handler, eloop_data, user_data) != NULL;
 }
 
 
@@ -733,28 +1048,21 @@ int eloop_deplete_timeout(unsigned int req_secs, unsigned int req_usecs,
 	struct os_reltime now, requested, remaining;
 	struct eloop_timeout *tmp;
 
-	dl_list_for_each(tmp, &eloop.timeout, struct eloop_timeout, list) {
-		if (tmp->handler == handler &&
-		    tmp->eloop_data == eloop_data &&
-		    tmp->user_data == user_data) {
-			requested.sec = req_secs;
-			requested.usec = req_usecs;
-			os_get_reltime(&now);
-			os_reltime_sub(&tmp->time, &now, &remaining);
-			if (os_reltime_before(&requested, &remaining)) {
-				eloop_cancel_timeout(handler, eloop_data,
-						     user_data);
-				eloop_register_timeout(requested.sec,
-						       requested.usec,
-						       handler, eloop_data,
-						       user_data);
-				return 1;
-			}
-			return 0;
-		}
-	}
+	tmp = eloop_find_timeout(handler, eloop_data, user_data);
+	if (tmp == NULL)
+		return -1;
 
-	return -1;
+	requested.sec = req_secs;
+	requested.usec = req_usecs;
+	os_get_reltime(&now);
+	os_reltime_sub(&tmp->time, &now, &remaining);
+	if (os_reltime_before(&requested, &remaining)) {
+		eloop_cancel_timeout(handler, eloop_data, user_data);
+		eloop_register_timeout(requested.sec, requested.usec,
+				       handler, eloop_data, user_data);
+		return 1;
+	}
+	return 0;
 }
 
 
@@ -765,28 +1073,48 @@ int eloop_replenish_timeout(unsigned int req_secs, unsigned int req_usecs,
 	struct os_reltime now, requested, remaining;
 	struct eloop_timeout *tmp;
 
-	dl_list_for_each(tmp, &eloop.timeout, struct eloop_timeout, list) {
-		if (tmp->handler == handler &&
-		    tmp->eloop_data == eloop_data &&
-		    tmp->user_data == user_data) {
-			requested.sec = req_secs;
-			requested.usec = req_usecs;
-			os_get_reltime(&now);
-			os_reltime_sub(&tmp->time, &now, &remaining);
-			if (os_reltime_before(&remaining, &requested)) {
-				eloop_cancel_timeout(handler, eloop_data,
-						     user_data);
-				eloop_register_timeout(requested.sec,
-						       requested.usec,
-						       handler, eloop_data,
-						       user_data);
-				return 1;
-			}
-			return 0;
-		}
+	tmp = eloop_find_timeout(handler, eloop_data, user_data);
+	if (tmp == NULL)
+		return -1;
+
+	requested.sec = req_secs;
+	requested.usec = req_usecs;
+	os_get_reltime(&now);
+	os_reltime_sub(&tmp->time, &now, &remaining);
+	if (os_reltime_before(&remaining, &requested)) {
+		eloop_cancel_timeout(handler, eloop_data, user_data);
+		eloop_register_timeout(requested.sec, requested.usec,
+				       handler, eloop_data, user_data);
+		return 1;
 	}
+	return 0;
+}
+
+
+/**
+ * eloop_process_timeouts - Call handlers of all expired timeouts
+ *
+ * Timeouts registered by the handlers themselves are left for the next
+ * iteration even if they are already due, so that a handler re-arming itself
+ * with a zero timeout cannot starve socket processing.
+ */
+static void eloop_process_timeouts(void)
+{
+	struct eloop_timeout *timeout;
+	struct os_reltime now;
+	unsigned int seq_limit = eloop.timeout_seq;
 
-	return -1;
+	os_get_reltime(&now);
+	while ((timeout = eloop_first_timeout()) != NULL &&
+	       !os_reltime_before(&now, &timeout->time) &&
+	       (int) (timeout->seq - seq_limit) < 0) {
+		void *eloop_data = timeout->eloop_data;
+		void *user_data = timeout->user_data;
+		eloop_timeout_handler handler = timeout->handler;
+
+		eloop_remove_timeout(timeout);
+		handler(eloop_data, user_data);
+	}
 }
 
 
@@ -869,6 +1197,19 @@ int eloop_register_signal(int sig, eloop_signal_handler handler,
 	eloop.signal_count++;
 	eloop.signals = tmp;
 	signal(sig, eloop_handle_signal);
+#ifdef CONFIG_ELOOP_EPOLL
+	/*
+	 * The async handler above stays installed for the time the signal is
+	 * not blocked, i.e., outside of eloop_run().
+	 */
+	if (!sigismember(&eloop.signalfd_mask, sig)) {
+		sigaddset(&eloop.signalfd_mask, sig);
+		if (eloop_signalfd_update() < 0)
+			wpa_printf(MSG_INFO, "ELOOP: signalfd not available "
+				   "(%s), using signal handler for %d",
+				   strerror(errno), sig);
+	}
+#endif /* CONFIG_ELOOP_EPOLL */
 
 	return 0;
 }
@@ -907,9 +1248,18 @@ void eloop_run(void)
 #endif /* CONFIG_ELOOP_SELECT */
 #ifdef CONFIG_ELOOP_EPOLL
 	int timeout_ms = -1;
+	sigset_t oldmask;
+	int sigblocked = 0;
 #endif /* CONFIG_ELOOP_EPOLL */
 	int res;
-	struct os_reltime tv, now;
+	struct os_reltime tv, now, deadline;
+	int virtual_wait;
+
+#ifdef CONFIG_ELOOP_EPOLL
+	if (eloop.signalfd >= 0 &&
+	    sigprocmask(SIG_BLOCK, &eloop.signalfd_mask, &oldmask) == 0)
+		sigblocked = 1;
+#endif /* CONFIG_ELOOP_EPOLL */
 
 #ifdef CONFIG_ELOOP_SELECT
 	rfds = os_malloc(sizeof(*rfds));
@@ -920,17 +1270,27 @@ void eloop_run(void)
 #endif /* CONFIG_ELOOP_SELECT */
 
 	while (!eloop.terminate &&
-	       (!dl_list_empty(&eloop.timeout) || eloop.readers.count > 0 ||
+	       (eloop.timeout_count > 0 || eloop.readers.count > 0 ||
 		eloop.writers.count > 0 || eloop.exceptions.count > 0)) {
 		struct eloop_timeout *timeout;
-		timeout = dl_list_first(&eloop.timeout, struct eloop_timeout,
-					list);
+		timeout = eloop_first_timeout();
+		virtual_wait = 0;
 		if (timeout) {
 			os_get_reltime(&now);
 			if (os_reltime_before(&now, &timeout->time))
 				os_reltime_sub(&timeout->time, &now, &tv);
 			else
 				tv.sec = tv.usec = 0;
+			/*
+			 * On the virtual clock only poll the sockets and, if
+			 * there is nothing to do, jump to the deadline instead
+			 * of waiting for it
+			 */
+			if (os_is_virtual_clock() && (tv.sec || tv.usec)) {
+				virtual_wait = 1;
+				deadline = timeout->time;
+				tv.sec = tv.usec = 0;
+			}
 #if defined(CONFIG_ELOOP_POLL) || defined(CONFIG_ELOOP_EPOLL)
 			timeout_ms = tv.sec * 1000 + tv.usec / 1000;
 #endif /* defined(CONFIG_ELOOP_POLL) || defined(CONFIG_ELOOP_EPOLL) */
@@ -939,6 +1299,26 @@ void eloop_run(void)
 			_tv.tv_usec = tv.usec;
 #endif /* CONFIG_ELOOP_SELECT */
 		}
+#ifdef CONFIG_ELOOP_EPOLL
+		if (eloop.timerfd >= 0) {
+			/*
+			 * Let the timerfd wake us up, so that the epoll set is
+			 * the only thing waited for. Only re-arm it when the
+			 * first timeout has changed.
+			 */
+			if (timeout && (tv.sec || tv.usec)) {
+				eloop_timerfd_set(&timeout->time, &tv);
+				timeout_ms = -1;
+			} else if (timeout) {
+				timeout_ms = 0;
+			} else {
+				eloop_timerfd_set(NULL, NULL);
+				timeout_ms = -1;
+			}
+		} else if (!timeout) {
+			timeout_ms = -1;
+		}
+#endif /* CONFIG_ELOOP_EPOLL */
 
 #ifdef CONFIG_ELOOP_POLL
 		num_poll_fds = eloop_sock_table_set_fds(
@@ -956,11 +1336,12 @@ void eloop_run(void)
 			     timeout ? &_tv : NULL);
 #endif /* CONFIG_ELOOP_SELECT */
 #ifdef CONFIG_ELOOP_EPOLL
-		if (eloop.count == 0) {
+		if (eloop.count + eloop.epoll_internal == 0) {
 			res = 0;
 		} else {
 			res = epoll_wait(eloop.epollfd, eloop.epoll_events,
-					 eloop.count, timeout_ms);
+					 eloop.count + eloop.epoll_internal,
+					 timeout_ms);
 		}
 #endif /* CONFIG_ELOOP_EPOLL */
 		if (res < 0 && errno != EINTR && errno != 0) {
@@ -979,21 +1360,11 @@ void eloop_run(void)
 		}
 		eloop_process_pending_signals();
 
-		/* check if some registered timeouts have occurred */
-		timeout = dl_list_first(&eloop.timeout, struct eloop_timeout,
-					list);
-		if (timeout) {
-			os_get_reltime(&now);
-			if (!os_reltime_before(&now, &timeout->time)) {
-				void *eloop_data = timeout->eloop_data;
-				void *user_data = timeout->user_data;
-				eloop_timeout_handler handler =
-					timeout->handler;
-				eloop_remove_timeout(timeout);
-				handler(eloop_data, user_data);
-			}
+		if (virtual_wait && res == 0)
+			os_advance_virtual_clock(&deadline);
 
-		}
+		/* run all registered timeouts that have occurred */
+		eloop_process_timeouts();
 
 		if (res <= 0)
 			continue;
@@ -1015,6 +1386,14 @@ void eloop_run(void)
 
 	eloop.terminate = 0;
 out:
+#ifdef CONFIG_ELOOP_EPOLL
+	if (sigblocked) {
+		/* Do not leave signals that arrived meanwhile pending */
+		eloop_signalfd_read();
+		eloop_process_pending_signals();
+		sigprocmask(SIG_SETMASK, &oldmask, NULL);
+	}
+#endif /* CONFIG_ELOOP_EPOLL */
 #ifdef CONFIG_ELOOP_SELECT
 	os_free(rfds);
 	os_free(wfds);
@@ -1032,12 +1411,11 @@ void eloop_terminate(void)
 
 void eloop_destroy(void)
 {
-	struct eloop_timeout *timeout, *prev;
+	struct eloop_timeout *timeout;
 	struct os_reltime now;
 
 	os_get_reltime(&now);
-	dl_list_for_each_safe(timeout, prev, &eloop.timeout,
-			      struct eloop_timeout, list) {
+	while ((timeout = eloop_first_timeout()) != NULL) {
 		int sec, usec;
 		sec = timeout->time.sec - now.sec;
 		usec = timeout->time.usec - now.usec;
@@ -1054,6 +1432,9 @@ void eloop_destroy(void)
 		wpa_trace_dump("eloop timeout", timeout);
 		eloop_remove_timeout(timeout);
 	}
+	os_free(eloop.timeout_heap);
+	eloop.timeout_heap = NULL;
+	eloop.timeout_count = eloop.timeout_alloc = 0;
 	eloop_sock_table_destroy(&eloop.readers);
 	eloop_sock_table_destroy(&eloop.writers);
 	eloop_sock_table_destroy(&eloop.exceptions);
@@ -1066,6 +1447,10 @@ void eloop_destroy(void)
 #ifdef CONFIG_ELOOP_EPOLL
 	os_free(eloop.epoll_table);
 	os_free(eloop.epoll_events);
+	if (eloop.timerfd >= 0)
+		close(eloop.timerfd);
+	if (eloop.signalfd >= 0)
+		close(eloop.signalfd);
 	close(eloop.epollfd);
 #endif /* CONFIG_ELOOP_EPOLL */
 }
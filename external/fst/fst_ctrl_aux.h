@@ -30,9 +30,12 @@ enum fst_event_type {
 	EVENT_FST_ESTABLISHED,          /* FST Session has been established */
 	EVENT_FST_SETUP,                /* FST Session request received */
 	EVENT_FST_SESSION_STATE_CHANGED,/* FST Session state has been changed */
-	EVENT_PEER_STATE_CHANGED        /* FST related generic event occurred,
+	EVENT_PEER_STATE_CHANGED,       /* FST related generic event occurred,
 					 * see struct fst_hostap_event_data for
 					 *  more info */
+	EVENT_FST_EVENTS_LOST           /* Events of the control interface
+					 * were lost, the state must be read
+					 * back */
 };
 
 enum fst_initiator {
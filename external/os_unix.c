@@ -61,7 +61,11 @@ int os_get_time(struct os_time *t)
 }
 
 
-int os_get_reltime(struct os_reltime *t)
+static int os_virtual_clock = 0;
+static struct os_reltime os_virtual_now;
+
+
+static int os_get_system_reltime(struct os_reltime *t)
 {
 #if defined(CLOCK_BOOTTIME)
 	static clockid_t clock_id = CLOCK_BOOTTIME;
@@ -98,6 +102,39 @@ int os_get_reltime(struct os_reltime *t)
 }
 
 
+int os_get_reltime(struct os_reltime *t)
+{
+	if (os_virtual_clock) {
+		*t = os_virtual_now;
+		return 0;
+	}
+	return os_get_system_reltime(t);
+}
+
+
+void os_set_virtual_clock(int enable)
+{
+	if (enable && !os_virtual_clock &&
+	    os_get_system_reltime(&os_virtual_now) < 0)
+		os_memset(&os_virtual_now, 0, sizeof(os_virtual_now));
+	os_virtual_clock = !!enable;
+}
+
+
+int os_is_virtual_clock(void)
+{
+	return os_virtual_clock;
+}
+
+
+void os_advance_virtual_clock(const struct os_reltime *t)
+{
+	if (t->sec > os_virtual_now.sec ||
+	    (t->sec == os_virtual_now.sec && t->usec > os_virtual_now.usec))
+		os_virtual_now = *t;
+}
+
+
 int os_mktime(int year, int month, int day, int hour, int min, int sec,
 	      os_time_t *t)
 {
@@ -42,6 +42,29 @@ int os_get_time(struct os_time *t);
  */
 int os_get_reltime(struct os_reltime *t);
 
+/**
+ * os_set_virtual_clock - Switch os_get_reltime() to a virtual clock
+ * @enable: 1 to use the virtual clock, 0 to go back to the system clock
+ *
+ * The virtual clock starts at the current relative time and only moves
+ * forward with os_advance_virtual_clock(), e.g., when eloop_run() skips the
+ * wait for the next timeout. Relative times taken on one clock must not be
+ * compared with times taken on the other.
+ */
+void os_set_virtual_clock(int enable);
+
+/**
+ * os_is_virtual_clock - Check whether the virtual clock is in use
+ * Returns: 1 if os_get_reltime() returns the virtual clock, 0 otherwise
+ */
+int os_is_virtual_clock(void);
+
+/**
+ * os_advance_virtual_clock - Move the virtual clock forward
+ * @t: New relative time, ignored if not later than the current one
+ */
+void os_advance_virtual_clock(const struct os_reltime *t);
+
 
 /* Helpers for handling struct os_time */
 
@@ -36,6 +36,9 @@ enum {
 #define wpa_debug_close_file() do { } while (0)
 #define wpa_debug_setup_stdout() do { } while (0)
 #define wpa_dbg(args...) do { } while (0)
+#define wpa_debug_async_start() 0
+#define wpa_debug_async_stop() do { } while (0)
+#define wpa_debug_async_dropped() 0
 
 static inline int wpa_debug_reopen_file(void)
 {
@@ -49,6 +52,42 @@ int wpa_debug_reopen_file(void);
 void wpa_debug_close_file(void);
 void wpa_debug_setup_stdout(void);
 
+#ifdef CONFIG_DEBUG_ASYNC
+/**
+ * wpa_debug_async_start - Start the asynchronous log writer
+ * Returns: 0 on success, -1 on failure
+ *
+ * Once started, wpa_printf() only formats the message into a lock-free ring
+ * and a writer thread does the output. Messages are dropped while the ring is
+ * full. Syslog and the hex dumps are still written synchronously.
+ */
+int wpa_debug_async_start(void);
+
+/**
+ * wpa_debug_async_stop - Flush the ring and stop the asynchronous log writer
+ */
+void wpa_debug_async_stop(void);
+
+/**
+ * wpa_debug_async_dropped - Number of messages dropped on a full ring
+ */
+unsigned int wpa_debug_async_dropped(void);
+#else /* CONFIG_DEBUG_ASYNC */
+static inline int wpa_debug_async_start(void)
+{
+	return 0;
+}
+
+static inline void wpa_debug_async_stop(void)
+{
+}
+
+static inline unsigned int wpa_debug_async_dropped(void)
+{
+	return 0;
+}
+#endif /* CONFIG_DEBUG_ASYNC */
+
 /**
  * wpa_debug_printf_timestamp - Print timestamp for debug output
  *
@@ -62,6 +62,250 @@ static FILE *out_file = NULL;
 #endif /* CONFIG_DEBUG_FILE */
 
 
+#ifdef CONFIG_DEBUG_ASYNC
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <signal.h>
+
+#define WPA_DEBUG_ASYNC_SLOTS 512 /* power of 2 */
+/* 512 slots of 256 bytes take 140 KiB */
+#ifndef WPA_DEBUG_ASYNC_MSG_LEN
+#define WPA_DEBUG_ASYNC_MSG_LEN 256
+#endif
+/* ends a message cut to the slot size */
+#define WPA_DEBUG_ASYNC_TRUNCATED " [truncated]"
+#define WPA_DEBUG_ASYNC_BATCH 16384
+
+/*
+ * Bounded MPSC ring (D. Vyukov): a slot is free for position pos when its seq
+ * equals pos and holds a message for the writer when its seq equals pos + 1.
+ */
+struct wpa_debug_async_rec {
+	unsigned int seq;
+	int level;
+	struct os_time tv;
+	char msg[WPA_DEBUG_ASYNC_MSG_LEN];
+};
+
+static struct wpa_debug_async_rec *async_ring = NULL;
+static unsigned int async_head; /* next position to reserve, producers */
+static unsigned int async_tail; /* next position to write, writer only */
+static unsigned int async_dropped;
+static int async_stop;
+static sem_t async_sem;
+static pthread_t async_thread;
+/* writer only: lines collected while more messages are queued */
+static char async_batch[WPA_DEBUG_ASYNC_BATCH];
+static size_t async_batch_len;
+
+
+static int wpa_debug_async_enqueue(int level, const char *fmt, va_list ap)
+{
+	struct wpa_debug_async_rec *r;
+	unsigned int pos, seq;
+	int len;
+
+	pos = __atomic_load_n(&async_head, __ATOMIC_RELAXED);
+	for (;;) {
+		r = &async_ring[pos & (WPA_DEBUG_ASYNC_SLOTS - 1)];
+		seq = __atomic_load_n(&r->seq, __ATOMIC_ACQUIRE);
+		if (seq == pos) {
+			if (__atomic_compare_exchange_n(&async_head, &pos,
+							pos + 1, 1,
+							__ATOMIC_RELAXED,
+							__ATOMIC_RELAXED))
+				break;
+		} else if ((int) (seq - pos) < 0) {
+			/* the writer has not caught up, the ring is full */
+			__atomic_fetch_add(&async_dropped, 1, __ATOMIC_RELAXED);
+			return -1;
+		} else {
+			pos = __atomic_load_n(&async_head, __ATOMIC_RELAXED);
+		}
+	}
+
+	r->level = level;
+	if (wpa_debug_timestamp)
+		os_get_time(&r->tv);
+	len = vsnprintf(r->msg, sizeof(r->msg), fmt, ap);
+	if (len >= (int) sizeof(r->msg))
+		os_memcpy(r->msg + sizeof(r->msg) -
+			  sizeof(WPA_DEBUG_ASYNC_TRUNCATED),
+			  WPA_DEBUG_ASYNC_TRUNCATED,
+			  sizeof(WPA_DEBUG_ASYNC_TRUNCATED));
+	__atomic_store_n(&r->seq, pos + 1, __ATOMIC_RELEASE);
+	sem_post(&async_sem);
+	return 0;
+}
+
+
+static void wpa_debug_async_flush(void)
+{
+#ifndef CONFIG_ANDROID_LOG
+	FILE *f = stdout;
+
+#ifdef CONFIG_DEBUG_FILE
+	if (out_file)
+		f = out_file;
+#endif /* CONFIG_DEBUG_FILE */
+	if (async_batch_len) {
+		fwrite(async_batch, 1, async_batch_len, f);
+		fflush(f);
+		async_batch_len = 0;
+	}
+#endif /* CONFIG_ANDROID_LOG */
+}
+
+
+static void wpa_debug_async_output(struct wpa_debug_async_rec *r)
+{
+#ifdef CONFIG_ANDROID_LOG
+	__android_log_print(wpa_to_android_level(r->level), ANDROID_LOG_NAME,
+			    "%s", r->msg);
+#else /* CONFIG_ANDROID_LOG */
+	char *pos;
+	size_t left;
+	int len;
+
+	/* timestamp, message and new line must fit */
+	if (sizeof(async_batch) - async_batch_len < WPA_DEBUG_ASYNC_MSG_LEN + 32)
+		wpa_debug_async_flush();
+	pos = async_batch + async_batch_len;
+	left = sizeof(async_batch) - async_batch_len;
+	len = 0;
+	if (wpa_debug_timestamp)
+		len = os_snprintf(pos, left, "%ld.%06u: ", (long) r->tv.sec,
+				  (unsigned int) r->tv.usec);
+	len += os_snprintf(pos + len, left - len, "%s\n", r->msg);
+	async_batch_len += len;
+#endif /* CONFIG_ANDROID_LOG */
+}
+
+
+/* Returns 0 once stopped with no more messages to write */
+static int wpa_debug_async_write_next(unsigned int *reported)
+{
+	struct wpa_debug_async_rec *r;
+	unsigned int dropped;
+
+	/* a producer may still be formatting into the oldest slot */
+	for (;;) {
+		r = &async_ring[async_tail & (WPA_DEBUG_ASYNC_SLOTS - 1)];
+		if (__atomic_load_n(&r->seq, __ATOMIC_ACQUIRE) ==
+		    async_tail + 1)
+			break;
+		if (__atomic_load_n(&async_stop, __ATOMIC_ACQUIRE))
+			return 0;
+		sched_yield();
+	}
+
+	dropped = __atomic_load_n(&async_dropped, __ATOMIC_RELAXED);
+	if (dropped != *reported) {
+		struct wpa_debug_async_rec note;
+
+		note.level = MSG_WARNING;
+		note.tv = r->tv;
+		os_snprintf(note.msg, sizeof(note.msg),
+			    "%u log messages dropped", dropped - *reported);
+		wpa_debug_async_output(&note);
+		*reported = dropped;
+	}
+
+	wpa_debug_async_output(r);
+	__atomic_store_n(&r->seq, async_tail + WPA_DEBUG_ASYNC_SLOTS,
+			 __ATOMIC_RELEASE);
+	async_tail++;
+	return 1;
+}
+
+
+static void * wpa_debug_async_writer(void *arg)
+{
+	unsigned int reported = 0;
+	int more = 1;
+
+	while (more) {
+		while (sem_wait(&async_sem) < 0 && errno == EINTR)
+			;
+		/* write out whatever is queued with a single write */
+		do {
+			more = wpa_debug_async_write_next(&reported);
+		} while (more && async_batch_len < sizeof(async_batch) / 2 &&
+			 sem_trywait(&async_sem) == 0);
+		wpa_debug_async_flush();
+	}
+
+	return NULL;
+}
+
+
+int wpa_debug_async_start(void)
+{
+	sigset_t all, old;
+	unsigned int i;
+	int res;
+
+	if (async_ring)
+		return 0;
+
+	async_ring = os_calloc(WPA_DEBUG_ASYNC_SLOTS, sizeof(*async_ring));
+	if (async_ring == NULL)
+		return -1;
+	for (i = 0; i < WPA_DEBUG_ASYNC_SLOTS; i++)
+		async_ring[i].seq = i;
+	async_head = async_tail = 0;
+	async_stop = 0;
+	if (sem_init(&async_sem, 0, 0) < 0) {
+		os_free(async_ring);
+		async_ring = NULL;
+		return -1;
+	}
+
+	/* signals are left to the event loop thread */
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	res = pthread_create(&async_thread, NULL, wpa_debug_async_writer, NULL);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	if (res) {
+		sem_destroy(&async_sem);
+		os_free(async_ring);
+		async_ring = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+
+void wpa_debug_async_stop(void)
+{
+	struct wpa_debug_async_rec *ring = async_ring;
+
+	if (ring == NULL)
+		return;
+
+	__atomic_store_n(&async_stop, 1, __ATOMIC_RELEASE);
+	sem_post(&async_sem);
+	pthread_join(async_thread, NULL);
+	async_ring = NULL;
+	sem_destroy(&async_sem);
+	os_free(ring);
+	if (async_dropped)
+		wpa_printf(MSG_WARNING, "%u log messages dropped in total",
+			   async_dropped);
+}
+
+
+unsigned int wpa_debug_async_dropped(void)
+{
+	return __atomic_load_n(&async_dropped, __ATOMIC_RELAXED);
+}
+
+#endif /* CONFIG_DEBUG_ASYNC */
+
+
 void wpa_debug_print_timestamp(void)
 {
 #ifndef CONFIG_ANDROID_LOG
@@ -206,6 +450,15 @@ void wpa_printf(int level, const char *fmt, ...)
 	va_list ap;
 
 	va_start(ap, fmt);
+#ifdef CONFIG_DEBUG_ASYNC
+	if (level >= wpa_debug_level && async_ring
+#ifdef CONFIG_DEBUG_SYSLOG
+	    && !wpa_debug_syslog
+#endif /* CONFIG_DEBUG_SYSLOG */
+	   ) {
+		wpa_debug_async_enqueue(level, fmt, ap);
+	} else
+#endif /* CONFIG_DEBUG_ASYNC */
 	if (level >= wpa_debug_level) {
 #ifdef CONFIG_ANDROID_LOG
 		__android_log_vprint(wpa_to_android_level(level),
@@ -657,7 +657,7 @@ int fst_cfgmgr_on_group_deinit(const struct fst_group_info *group)
 }
 
 
-int fst_cfgmgr_on_connect(struct fst_group_info *group, const char *iface,
+int fst_cfgmgr_on_connect(struct fst_group_info *group, u16 ifid,
 	const u8* addr)
 {
 	int res = 0;
@@ -665,7 +665,7 @@ int fst_cfgmgr_on_connect(struct fst_group_info *group, const char *iface,
 	case FST_CONFIG_CLI:
 		break;
 	case FST_CONFIG_INI:
-		res = fst_rate_upgrade_on_connect(group, iface, addr);
+		res = fst_rate_upgrade_on_connect(group, ifid, addr);
 		break;
 	default:
 		fst_mgr_printf(MSG_ERROR, "Wrong config method");
@@ -675,7 +675,7 @@ int fst_cfgmgr_on_connect(struct fst_group_info *group, const char *iface,
 	return res;
 }
 
-int fst_cfgmgr_on_disconnect(struct fst_group_info *group, const char *iface,
+int fst_cfgmgr_on_disconnect(struct fst_group_info *group, u16 ifid,
 	const u8* addr)
 {
 	int res = 0;
@@ -683,7 +683,7 @@ int fst_cfgmgr_on_disconnect(struct fst_group_info *group, const char *iface,
 	case FST_CONFIG_CLI:
 		break;
 	case FST_CONFIG_INI:
-		res = fst_rate_upgrade_on_disconnect(group, iface, addr);
+		res = fst_rate_upgrade_on_disconnect(group, ifid, addr);
 		break;
 	default:
 		fst_mgr_printf(MSG_ERROR, "Wrong config method");
@@ -694,13 +694,13 @@ int fst_cfgmgr_on_disconnect(struct fst_group_info *group, const char *iface,
 }
 
 void fst_cfgmgr_on_switch_completed(const struct fst_group_info *group,
-	const char *old_iface, const char *new_iface, const u8* peer_addr)
+	u16 old_ifid, u16 new_ifid, const u8* peer_addr)
 {
 	if (fstcfg.method != FST_CONFIG_INI)
 		return;
 
-	fst_rate_upgrade_on_switch_completed(group, old_iface,
-		new_iface, peer_addr);
+	fst_rate_upgrade_on_switch_completed(group, old_ifid,
+		new_ifid, peer_addr);
 }
 
 int fst_cfgmgr_get_mux_type(const char *gname, char *buf, int blen)
@@ -66,12 +66,13 @@ int fst_cfgmgr_on_group_deinit(const struct fst_group_info *group);
 int fst_cfgmgr_on_iface_init(const struct fst_group_info *group,
 	struct fst_iface_info *iface);
 int fst_cfgmgr_on_iface_deinit(struct fst_iface_info *iface);
-int fst_cfgmgr_on_connect(struct fst_group_info *group, const char *iface,
+/* the interfaces are IDs of the interface registry, see fst_ifreg.h */
+int fst_cfgmgr_on_connect(struct fst_group_info *group, u16 ifid,
 	const u8* addr);
-int fst_cfgmgr_on_disconnect(struct fst_group_info *group, const char *iface,
+int fst_cfgmgr_on_disconnect(struct fst_group_info *group, u16 ifid,
 	const u8* addr);
 void fst_cfgmgr_on_switch_completed(const struct fst_group_info *group,
-	const char *old_iface, const char *new_iface, const u8* peer_addr);
+	u16 old_ifid, u16 new_ifid, const u8* peer_addr);
 int fst_cfgmgr_get_mux_type(const char *gname, char *buf, int blen);
 int fst_cfgmgr_get_mux_ifname(const char *gname, char *buf, int blen);
 int fst_cfgmgr_get_l2da_ap_default_ifname(const char *gname, char *buf,
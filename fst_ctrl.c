@@ -40,6 +40,10 @@
 #include <sys/stat.h>
 #include <dirent.h>
 #include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/eventfd.h>
 
 #define FST_MGR_COMPONENT "CTRL"
 #include "fst_manager.h"
@@ -52,6 +56,9 @@
 #include "fst/fst_ctrl_defs.h"
 #include "fst_ctrl.h"
 #include "fst_cfgmgr.h"
+#include "fst_trace.h"
+#include "fst_metrics.h"
+#include "fst_ctrl_prof.h"
 
 #ifndef DEFAULT_WPAS_CLI_DIR
 #define DEFAULT_WPAS_CLI_DIR "/var/run/wpa_supplicant"
@@ -68,6 +75,61 @@ static Boolean          ctrl_is_supplicant;
 static fst_notification_cb_func global_ntfy_cb = NULL;
 static void *global_ntfy_cb_ctx = NULL;
 
+/*
+ * Capture file: a struct fst_ctrl_rec_file_hdr followed by records, each a
+ * struct fst_ctrl_rec_hdr followed by the event text, or by the command and
+ * its reply, padded to FST_CTRL_REC_ALIGN. Host byte order, the captures are
+ * replayed on the same kind of machine.
+ */
+#define FST_CTRL_REC_MAGIC   0x46535452 /* "FSTR" */
+#define FST_CTRL_REC_VERSION 1
+#define FST_CTRL_REC_ALIGN   8
+#define FST_CTRL_REC_SIZE(hdr) \
+	(sizeof(*(hdr)) + (((hdr)->cmd_len + (hdr)->len + \
+	  FST_CTRL_REC_ALIGN - 1) & ~(FST_CTRL_REC_ALIGN - 1)))
+
+struct fst_ctrl_rec_file_hdr {
+	u32 magic;
+	u32 version;
+};
+
+enum fst_ctrl_rec_type {
+	FST_CTRL_REC_EVENT = 1,
+	FST_CTRL_REC_CMD   = 2,
+};
+
+struct fst_ctrl_rec_hdr {
+	u64 ts_ns;      /* CLOCK_MONOTONIC, relative to the capture start */
+	u32 latency_us; /* FST_CTRL_REC_CMD only */
+	s32 res;        /* FST_CTRL_REC_CMD only, do_hostap_command() result */
+	u16 type;
+	u16 cmd_len;    /* FST_CTRL_REC_CMD only */
+	u32 len;        /* event or reply length */
+};
+
+static FILE *ctrl_rec_file;
+static u64   ctrl_rec_start_ns;
+
+/* commands not matching the next recorded one are looked up this far */
+#define FST_CTRL_REPLAY_WINDOW 64
+
+struct fst_ctrl_replay {
+	u8 *buf;
+	const struct fst_ctrl_rec_hdr **events;
+	const struct fst_ctrl_rec_hdr **cmds;
+	Boolean *cmd_used;
+	size_t events_num;
+	size_t cmds_num;
+	size_t next_event;
+	size_t next_cmd;
+	Boolean fast;
+	u64 start_ns;
+	u64 clock_start_ns; /* on fst_ctrl_replay_clock_ns() */
+	size_t cmds_unmatched;
+};
+
+static struct fst_ctrl_replay *ctrl_replay;
+
 #define defstrcmp(s, d) strncmp((s), (d), sizeof(d) - 1)
 
 #ifndef CONFIG_CTRL_IFACE_DIR
@@ -279,17 +341,177 @@ int fst_set_notify_cb(fst_notification_cb_func ntfy_cb, void *ntfy_cb_ctx)
 	return 0;
 }
 
+/* capture */
+static void fst_ctrl_record(const struct fst_ctrl_rec_hdr *hdr,
+	const void *data1, size_t len1, const void *data2, size_t len2)
+{
+	static const u8 pad[FST_CTRL_REC_ALIGN];
+	size_t pad_len = FST_CTRL_REC_SIZE(hdr) - sizeof(*hdr) - len1 - len2;
+
+	if (fwrite(hdr, sizeof(*hdr), 1, ctrl_rec_file) != 1 ||
+	    (len1 && fwrite(data1, len1, 1, ctrl_rec_file) != 1) ||
+	    (len2 && fwrite(data2, len2, 1, ctrl_rec_file) != 1) ||
+	    (pad_len && fwrite(pad, pad_len, 1, ctrl_rec_file) != 1)) {
+		fst_mgr_printf(MSG_ERROR, "cannot write capture: %s",
+			strerror(errno));
+		fst_ctrl_record_stop();
+	}
+}
+
+static void fst_ctrl_record_event(const char *buf, size_t len)
+{
+	struct fst_ctrl_rec_hdr hdr;
+
+	os_memset(&hdr, 0, sizeof(hdr));
+	hdr.ts_ns = fst_trace_now() - ctrl_rec_start_ns;
+	hdr.type = FST_CTRL_REC_EVENT;
+	hdr.len = len;
+	fst_ctrl_record(&hdr, buf, len, NULL, 0);
+	/* keep the file usable if we crash handling the event */
+	if (ctrl_rec_file)
+		fflush(ctrl_rec_file);
+}
+
+static void fst_ctrl_record_cmd(const char *cmd, size_t cmd_len,
+	u64 start_ns, int res, const char *resp, size_t resp_len)
+{
+	struct fst_ctrl_rec_hdr hdr;
+
+	os_memset(&hdr, 0, sizeof(hdr));
+	hdr.ts_ns = start_ns - ctrl_rec_start_ns;
+	hdr.latency_us = (fst_trace_now() - start_ns) / 1000;
+	hdr.res = res;
+	hdr.type = FST_CTRL_REC_CMD;
+	hdr.cmd_len = cmd_len;
+	hdr.len = res < 0 ? 0 : resp_len;
+	fst_ctrl_record(&hdr, cmd, cmd_len, resp, hdr.len);
+}
+
+int fst_ctrl_record_start(const char *path)
+{
+	struct fst_ctrl_rec_file_hdr fhdr;
+
+	ctrl_rec_file = fopen(path, "wb");
+	if (!ctrl_rec_file) {
+		fst_mgr_printf(MSG_ERROR, "cannot open capture %s: %s", path,
+			strerror(errno));
+		return -1;
+	}
+
+	fhdr.magic = FST_CTRL_REC_MAGIC;
+	fhdr.version = FST_CTRL_REC_VERSION;
+	if (fwrite(&fhdr, sizeof(fhdr), 1, ctrl_rec_file) != 1) {
+		fst_mgr_printf(MSG_ERROR, "cannot write capture %s: %s", path,
+			strerror(errno));
+		fclose(ctrl_rec_file);
+		ctrl_rec_file = NULL;
+		return -1;
+	}
+
+	ctrl_rec_start_ns = fst_trace_now();
+	fst_mgr_printf(MSG_INFO, "capturing control traffic to %s", path);
+	return 0;
+}
+
+void fst_ctrl_record_stop(void)
+{
+	if (!ctrl_rec_file)
+		return;
+	fclose(ctrl_rec_file);
+	ctrl_rec_file = NULL;
+}
+
+/* replay */
+
+/* the clock replayed events are scheduled on, virtual if eloop runs on one */
+static u64 fst_ctrl_replay_clock_ns(void)
+{
+	struct os_reltime now;
+
+	if (!os_is_virtual_clock())
+		return fst_trace_now();
+	os_get_reltime(&now);
+	return (u64)now.sec * 1000000000ULL + (u64)now.usec * 1000ULL;
+}
+
+static void fst_ctrl_replay_latency(u32 latency_us)
+{
+	struct os_reltime t;
+
+	if (!os_is_virtual_clock()) {
+		os_sleep(latency_us / 1000000, latency_us % 1000000);
+		return;
+	}
+	os_get_reltime(&t);
+	t.sec += latency_us / 1000000;
+	t.usec += latency_us % 1000000;
+	if (t.usec >= 1000000) {
+		t.sec++;
+		t.usec -= 1000000;
+	}
+	os_advance_virtual_clock(&t);
+}
+
+static int fst_ctrl_replay_command(const char *cmd, size_t cmd_len,
+	char *resp, size_t *resp_len)
+{
+	struct fst_ctrl_replay *r = ctrl_replay;
+	size_t i, end = r->next_cmd + FST_CTRL_REPLAY_WINDOW;
+
+	if (end > r->cmds_num)
+		end = r->cmds_num;
+
+	for (i = r->next_cmd; i < end; i++) {
+		const struct fst_ctrl_rec_hdr *hdr = r->cmds[i];
+		const char *rec_cmd = (const char *)(hdr + 1);
+
+		if (r->cmd_used[i] || hdr->cmd_len != cmd_len ||
+		    os_memcmp(rec_cmd, cmd, cmd_len))
+			continue;
+
+		r->cmd_used[i] = TRUE;
+		while (r->next_cmd < r->cmds_num && r->cmd_used[r->next_cmd])
+			r->next_cmd++;
+
+		if (!r->fast && hdr->latency_us)
+			fst_ctrl_replay_latency(hdr->latency_us);
+		if (hdr->res < 0)
+			return hdr->res;
+		if (*resp_len > hdr->len)
+			*resp_len = hdr->len;
+		os_memcpy(resp, rec_cmd + hdr->cmd_len, *resp_len);
+		return hdr->res;
+	}
+
+	fst_mgr_printf(MSG_WARNING, "replay: no recorded reply to '%s'", cmd);
+	r->cmds_unmatched++;
+	return -1;
+}
+
 /* commands */
 
 static int do_hostap_command(const char* cmd, size_t cmd_len,
 	char* resp, size_t* resp_len)
 {
+	u64 start_ns = fst_trace_now();
 	int ret;
 
 	fst_mgr_printf(MSG_DEBUG, "send: %s", cmd);
 
-	ret = wpa_ctrl_request(ctrl_cmd, cmd, cmd_len, resp, resp_len, NULL);
+	if (ctrl_replay)
+		ret = fst_ctrl_replay_command(cmd, cmd_len, resp, resp_len);
+	else
+		ret = wpa_ctrl_request(ctrl_cmd, cmd, cmd_len, resp, resp_len,
+			NULL);
+	if (ctrl_rec_file)
+		fst_ctrl_record_cmd(cmd, cmd_len, start_ns, ret, resp,
+			*resp_len);
+	fst_trace_ctrl_cmd(cmd, start_ns, ret);
+	fst_metrics_inc(ctrl_commands);
+	fst_hist_add(&fst_metrics.ctrl_rtt_us,
+		fst_ctrl_prof_add(cmd, start_ns, ret));
 	if (ret < 0) {
+		fst_metrics_inc(ctrl_failures);
 		fst_mgr_printf(MSG_ERROR, "command '%s' %s.", cmd,
 		    ret == -2 ? "timed out" : "failed");
 		return ret;
@@ -1041,6 +1263,14 @@ void fst_free(void *p)
 	free(p);
 }
 
+/* the state is read back by the manager after events were lost */
+static void fst_ctrl_notify_lost(void)
+{
+	if (global_ntfy_cb)
+		global_ntfy_cb(global_ntfy_cb_ctx, FST_INVALID_SESSION_ID,
+			EVENT_FST_EVENTS_LOST, NULL);
+}
+
 /* wpa ctrl */
 static void fst_ctrl_receiver(int sock, void *eloop_ctx, void *sock_ctx)
 {
@@ -1051,10 +1281,13 @@ static void fst_ctrl_receiver(int sock, void *eloop_ctx, void *sock_ctx)
 	while (wpa_ctrl_pending(ctrl) > 0) {
 		len = sizeof(buf) - 1;
 		if (wpa_ctrl_recv(ctrl, buf, &len)) {
-			fst_mgr_printf(MSG_ERROR, "wpa_ctrl_recv");
+			fst_mgr_printf(MSG_ERROR, "wpa_ctrl_recv: %s",
+				strerror(errno));
 			break;
 		}
 		buf[len] = '\0';
+		if (ctrl_rec_file)
+			fst_ctrl_record_event(buf, len);
 		if (fst_ctrl_notify(buf, len)) {
 			fst_mgr_printf(MSG_ERROR, "fst_ctrl_notify");
 			goto cli_disconnected;
@@ -1073,6 +1306,296 @@ cli_disconnected:
 	eloop_terminate();
 }
 
+/*
+ * Event ingest: with fst_ctrl_ingest_kb set, a thread drains the monitor
+ * socket into a single producer single consumer ring and wakes the eloop
+ * through an eventfd, so that event bursts arriving while the eloop waits
+ * for a command reply are queued here rather than overflowing the socket.
+ *
+ * Records are a struct fst_ctrl_ingest_hdr followed by the NUL terminated
+ * event, padded to FST_CTRL_INGEST_ALIGN. Records do not wrap: a header with
+ * FST_CTRL_INGEST_WRAP sends the consumer back to the ring start. head is
+ * only written by the thread and tail only by the eloop, both free running.
+ */
+#define FST_CTRL_INGEST_ALIGN  8
+#define FST_CTRL_INGEST_WRAP   0xffffffff
+#define FST_CTRL_INGEST_MIN_KB 16
+#define FST_CTRL_INGEST_REC_SIZE(len) \
+	(sizeof(struct fst_ctrl_ingest_hdr) + (((len) + 1 + \
+	  FST_CTRL_INGEST_ALIGN - 1) & ~(FST_CTRL_INGEST_ALIGN - 1)))
+
+struct fst_ctrl_ingest_hdr {
+	u32 len;
+	u32 reserved;
+};
+
+struct fst_ctrl_ingest {
+	struct wpa_ctrl *ctrl;
+	u8 *buf;
+	size_t size;      /* power of 2 */
+	size_t head;      /* thread */
+	size_t tail;      /* eloop */
+	u32 queued;       /* thread, events */
+	u32 consumed;     /* eloop, events */
+	u32 max_depth;    /* thread, events */
+	u32 overflows;    /* thread, events dropped as the ring was full */
+	u32 overflows_reported;
+	int lost;         /* thread, the monitor socket failed */
+	int wake_fd;      /* thread -> eloop */
+	int stop_fd;      /* eloop -> thread */
+	pthread_t thread;
+};
+
+unsigned int fst_ctrl_ingest_kb = 0;
+static struct fst_ctrl_ingest *ctrl_ingest;
+
+static void fst_ctrl_ingest_push(struct fst_ctrl_ingest *q, const char *ev,
+	size_t len)
+{
+	struct fst_ctrl_ingest_hdr *hdr;
+	size_t need = FST_CTRL_INGEST_REC_SIZE(len);
+	size_t head = q->head;
+	size_t off = head & (q->size - 1);
+	size_t pad = off + need > q->size ? q->size - off : 0;
+	size_t tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+	u32 depth;
+
+	if (head + pad + need - tail > q->size) {
+		__atomic_add_fetch(&q->overflows, 1, __ATOMIC_RELAXED);
+		return;
+	}
+
+	if (pad) {
+		hdr = (struct fst_ctrl_ingest_hdr *)(q->buf + off);
+		hdr->len = FST_CTRL_INGEST_WRAP;
+		head += pad;
+		off = 0;
+	}
+	hdr = (struct fst_ctrl_ingest_hdr *)(q->buf + off);
+	hdr->len = len;
+	os_memcpy(hdr + 1, ev, len);
+	((char *)(hdr + 1))[len] = '\0';
+	__atomic_store_n(&q->head, head + need, __ATOMIC_RELEASE);
+
+	__atomic_store_n(&q->queued, q->queued + 1, __ATOMIC_RELAXED);
+	depth = q->queued - __atomic_load_n(&q->consumed, __ATOMIC_RELAXED);
+	if (depth > q->max_depth)
+		__atomic_store_n(&q->max_depth, depth, __ATOMIC_RELAXED);
+}
+
+static void *fst_ctrl_ingest_thread(void *arg)
+{
+	struct fst_ctrl_ingest *q = arg;
+	struct pollfd fds[2];
+	char buf[4096];
+	size_t len;
+	u64 one = 1;
+
+	fds[0].fd = wpa_ctrl_get_fd(q->ctrl);
+	fds[0].events = POLLIN;
+	fds[1].fd = q->stop_fd;
+	fds[1].events = POLLIN;
+
+	for (;;) {
+		if (poll(fds, 2, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		if (fds[1].revents)
+			return NULL;
+		if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL))
+			break;
+		if (!(fds[0].revents & POLLIN))
+			continue;
+
+		len = sizeof(buf) - 1;
+		if (wpa_ctrl_recv(q->ctrl, buf, &len)) {
+			if (errno == EINTR || errno == EAGAIN)
+				continue;
+			break;
+		}
+		fst_ctrl_ingest_push(q, buf, len);
+		if (write(q->wake_fd, &one, sizeof(one)) < 0)
+			break;
+	}
+
+	__atomic_store_n(&q->lost, 1, __ATOMIC_RELEASE);
+	if (write(q->wake_fd, &one, sizeof(one)) < 0)
+		return NULL;
+	return NULL;
+}
+
+static void fst_ctrl_ingest_receiver(int sock, void *eloop_ctx,
+	void *sock_ctx)
+{
+	struct fst_ctrl_ingest *q = eloop_ctx;
+	struct fst_ctrl_ingest_hdr *hdr;
+	size_t head, off;
+	u32 overflows;
+	char *ev;
+	u64 cnt;
+	int res;
+
+	/* reset before looking at head, later pushes signal again */
+	if (read(sock, &cnt, sizeof(cnt)) < 0 && errno != EAGAIN)
+		fst_mgr_printf(MSG_ERROR, "read(eventfd): %s", strerror(errno));
+
+	head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+	while (q->tail != head) {
+		off = q->tail & (q->size - 1);
+		hdr = (struct fst_ctrl_ingest_hdr *)(q->buf + off);
+		if (hdr->len == FST_CTRL_INGEST_WRAP) {
+			__atomic_store_n(&q->tail, q->tail + q->size - off,
+				__ATOMIC_RELEASE);
+			continue;
+		}
+
+		ev = (char *)(hdr + 1);
+		if (ctrl_rec_file)
+			fst_ctrl_record_event(ev, hdr->len);
+		res = fst_ctrl_notify(ev, hdr->len);
+		__atomic_store_n(&q->tail, q->tail +
+			FST_CTRL_INGEST_REC_SIZE(hdr->len), __ATOMIC_RELEASE);
+		__atomic_store_n(&q->consumed, q->consumed + 1,
+			__ATOMIC_RELAXED);
+		if (res) {
+			fst_mgr_printf(MSG_ERROR, "fst_ctrl_notify");
+			goto cli_disconnected;
+		}
+	}
+
+	overflows = __atomic_load_n(&q->overflows, __ATOMIC_RELAXED);
+	if (overflows != q->overflows_reported) {
+		fst_mgr_printf(MSG_WARNING, "ingest queue full: %u events "
+			"dropped", overflows - q->overflows_reported);
+		q->overflows_reported = overflows;
+		fst_ctrl_notify_lost();
+	}
+
+	if (__atomic_load_n(&q->lost, __ATOMIC_ACQUIRE)) {
+		fst_mgr_printf(MSG_ERROR, "ingest: connection lost: "
+			"terminating");
+		goto cli_disconnected;
+	}
+
+	return;
+
+cli_disconnected:
+	eloop_terminate();
+}
+
+static void fst_ctrl_ingest_metrics_collect(FILE *f, void *ctx)
+{
+	struct fst_ctrl_ingest *q = ctx;
+	u32 queued = __atomic_load_n(&q->queued, __ATOMIC_RELAXED);
+
+	fst_metrics_print_header(f, "ctrl_events_total", "counter",
+		"Events queued by the ingest thread");
+	fst_metrics_print(f, "ctrl_events_total", NULL, queued);
+	fst_metrics_print_header(f, "ctrl_ingest_depth", "gauge",
+		"Events queued and not processed yet");
+	fst_metrics_print(f, "ctrl_ingest_depth", NULL,
+		queued - q->consumed);
+	fst_metrics_print_header(f, "ctrl_ingest_high_water", "gauge",
+		"Most events ever queued at once");
+	fst_metrics_print(f, "ctrl_ingest_high_water", NULL,
+		__atomic_load_n(&q->max_depth, __ATOMIC_RELAXED));
+	fst_metrics_print_header(f, "ctrl_ingest_overflows_total", "counter",
+		"Events dropped as the ingest queue was full");
+	fst_metrics_print(f, "ctrl_ingest_overflows_total", NULL,
+		__atomic_load_n(&q->overflows, __ATOMIC_RELAXED));
+}
+
+static int fst_ctrl_ingest_start(struct wpa_ctrl *ctrl, unsigned int kb)
+{
+	struct fst_ctrl_ingest *q;
+	sigset_t all, old;
+	size_t size = FST_CTRL_INGEST_MIN_KB * 1024;
+	int res;
+
+	while (size < (size_t)kb * 1024)
+		size <<= 1;
+
+	q = os_zalloc(sizeof(*q));
+	if (!q)
+		return -1;
+	q->ctrl = ctrl;
+	q->size = size;
+	q->buf = os_malloc(size);
+	if (!q->buf)
+		goto error_buf;
+
+	q->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (q->wake_fd < 0) {
+		fst_mgr_printf(MSG_ERROR, "eventfd: %s", strerror(errno));
+		goto error_wake_fd;
+	}
+	q->stop_fd = eventfd(0, EFD_CLOEXEC);
+	if (q->stop_fd < 0) {
+		fst_mgr_printf(MSG_ERROR, "eventfd: %s", strerror(errno));
+		goto error_stop_fd;
+	}
+
+	if (eloop_register_read_sock(q->wake_fd, fst_ctrl_ingest_receiver, q,
+		NULL)) {
+		fst_mgr_printf(MSG_ERROR, "eloop_register_read_sock");
+		goto error_eloop_register_read_sock;
+	}
+
+	/* signals are for the eloop */
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	res = pthread_create(&q->thread, NULL, fst_ctrl_ingest_thread, q);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	if (res) {
+		fst_mgr_printf(MSG_ERROR, "pthread_create: %s", strerror(res));
+		goto error_thread;
+	}
+
+	fst_metrics_register_collector(fst_ctrl_ingest_metrics_collect, q);
+	ctrl_ingest = q;
+	fst_mgr_printf(MSG_INFO, "event ingest thread started, %zu KiB queue",
+		size / 1024);
+	return 0;
+
+error_thread:
+	eloop_unregister_read_sock(q->wake_fd);
+error_eloop_register_read_sock:
+	close(q->stop_fd);
+error_stop_fd:
+	close(q->wake_fd);
+error_wake_fd:
+	os_free(q->buf);
+error_buf:
+	os_free(q);
+	return -1;
+}
+
+static void fst_ctrl_ingest_stop(void)
+{
+	struct fst_ctrl_ingest *q = ctrl_ingest;
+	u64 one = 1;
+
+	if (!q)
+		return;
+	ctrl_ingest = NULL;
+
+	fst_metrics_unregister_collector(fst_ctrl_ingest_metrics_collect, q);
+	if (write(q->stop_fd, &one, sizeof(one)) < 0)
+		fst_mgr_printf(MSG_ERROR, "write(eventfd): %s", strerror(errno));
+	pthread_join(q->thread, NULL);
+	eloop_unregister_read_sock(q->wake_fd);
+
+	fst_mgr_printf(MSG_INFO, "ingest: %u events, %u queued at most, "
+		"%u dropped", q->queued, q->max_depth, q->overflows);
+
+	close(q->stop_fd);
+	close(q->wake_fd);
+	os_free(q->buf);
+	os_free(q);
+}
+
 static struct wpa_ctrl *try_to_open_wpa_ctrl(const char *name)
 {
 	WPA_ASSERT(name != NULL);
@@ -1092,6 +1615,50 @@ static struct wpa_ctrl *try_to_open_wpa_ctrl(const char *name)
 	return NULL;
 }
 
+/* events that arrive while the monitor waits for a reply */
+static void fst_ctrl_monitor_event(char *msg, size_t len)
+{
+	if (ctrl_rec_file)
+		fst_ctrl_record_event(msg, len);
+	if (fst_ctrl_notify(msg, len))
+		eloop_terminate();
+}
+
+/*
+ * hostapd drops the events the monitor socket has no room for without a
+ * trace on this side, and detaches the monitor after a few drops in a row.
+ * LEVEL fails for a monitor hostapd does not know, so a failure means events
+ * were lost: the monitor is attached again and the state is read back.
+ * With the ingest thread draining the socket, its overflows are reported
+ * instead.
+ */
+static void fst_ctrl_check_monitor(void)
+{
+	char buf[4096], cmd[16];
+	size_t buf_len = sizeof(buf) - 1;
+	int len;
+
+	if (ctrl_ingest)
+		return;
+
+	len = os_snprintf(cmd, sizeof(cmd), "LEVEL %d", MSG_INFO);
+	if (wpa_ctrl_request(ctrl_evt, cmd, len, buf, &buf_len,
+			     fst_ctrl_monitor_event) < 0)
+		return;
+	buf[buf_len] = '\0';
+	if (os_strncmp(buf, "FAIL", 4))
+		return;
+
+	fst_mgr_printf(MSG_WARNING, "monitor detached by hostapd, "
+		"events lost: attaching again");
+	if (wpa_ctrl_attach(ctrl_evt)) {
+		fst_mgr_printf(MSG_ERROR, "cannot attach control iface: %s",
+			strerror(errno));
+		return;
+	}
+	fst_ctrl_notify_lost();
+}
+
 static void fst_ping(void *eloop_ctx, void *timeout_ctx)
 {
 	char buf[4096];
@@ -1113,6 +1680,7 @@ static void fst_ping(void *eloop_ctx, void *timeout_ctx)
 		goto error_pong;
 	}
 
+	fst_ctrl_check_monitor();
 	eloop_register_timeout(ctrl_ping_interval, 0, fst_ping, NULL, NULL);
 
 	return;
@@ -1153,7 +1721,12 @@ Boolean fst_ctrl_create(const char *ctrl_iface, unsigned int ping_interval)
 		goto error_open_cmd;
 	}
 
-	if (eloop_register_read_sock(wpa_ctrl_get_fd(ctrl_evt),
+	if (fst_ctrl_ingest_kb) {
+		if (fst_ctrl_ingest_start(ctrl_evt, fst_ctrl_ingest_kb)) {
+			fst_mgr_printf(MSG_ERROR, "cannot start event ingest");
+			goto error_eloop_register_read_sock;
+		}
+	} else if (eloop_register_read_sock(wpa_ctrl_get_fd(ctrl_evt),
 		fst_ctrl_receiver, NULL, ctrl_evt)) {
 		fst_mgr_printf(MSG_ERROR, "eloop_register_read_sock");
 		goto error_eloop_register_read_sock;
@@ -1174,7 +1747,10 @@ Boolean fst_ctrl_create(const char *ctrl_iface, unsigned int ping_interval)
 	return TRUE;
 
 error_detect_cli_type:
-	eloop_unregister_read_sock(wpa_ctrl_get_fd(ctrl_evt));
+	if (ctrl_ingest)
+		fst_ctrl_ingest_stop();
+	else
+		eloop_unregister_read_sock(wpa_ctrl_get_fd(ctrl_evt));
 error_eloop_register_read_sock:
 	wpa_ctrl_close(ctrl_cmd);
 	ctrl_cmd = NULL;
@@ -1187,12 +1763,156 @@ error_open_evt:
 	return FALSE;
 }
 
+static void fst_ctrl_replay_free(void)
+{
+	struct fst_ctrl_replay *r = ctrl_replay;
+
+	ctrl_replay = NULL;
+	if (!r)
+		return;
+	os_free(r->events);
+	os_free(r->cmds);
+	os_free(r->cmd_used);
+	os_free(r->buf);
+	os_free(r);
+}
+
+static void fst_ctrl_replay_next(void *eloop_ctx, void *timeout_ctx)
+{
+	struct fst_ctrl_replay *r = ctrl_replay;
+	const struct fst_ctrl_rec_hdr *hdr;
+	char buf[4096];
+	size_t len;
+
+	if (r->next_event == r->events_num) {
+		u64 elapsed_us = (fst_trace_now() - r->start_ns) / 1000;
+
+		fst_mgr_printf(MSG_INFO, "replay: %zu events, %zu/%zu commands "
+			"replayed, %zu unmatched in %llu us (%llu events/s)",
+			r->events_num, r->next_cmd, r->cmds_num,
+			r->cmds_unmatched, (unsigned long long)elapsed_us,
+			elapsed_us ? (unsigned long long)r->events_num *
+				1000000 / elapsed_us : 0);
+		eloop_terminate();
+		return;
+	}
+
+	hdr = r->events[r->next_event++];
+	len = hdr->len < sizeof(buf) ? hdr->len : sizeof(buf) - 1;
+	os_memcpy(buf, hdr + 1, len);
+	buf[len] = '\0';
+	if (fst_ctrl_notify(buf, len)) {
+		eloop_terminate();
+		return;
+	}
+
+	if (r->fast || r->next_event == r->events_num) {
+		eloop_register_timeout(0, 0, fst_ctrl_replay_next, NULL, NULL);
+	} else {
+		u64 due = r->clock_start_ns + r->events[r->next_event]->ts_ns;
+		u64 now = fst_ctrl_replay_clock_ns();
+		u64 delay_us = due > now ? (due - now) / 1000 : 0;
+
+		eloop_register_timeout(delay_us / 1000000, delay_us % 1000000,
+			fst_ctrl_replay_next, NULL, NULL);
+	}
+}
+
+static int fst_ctrl_replay_load(struct fst_ctrl_replay *r, const char *path)
+{
+	const struct fst_ctrl_rec_file_hdr *fhdr;
+	size_t size, pos, n;
+
+	r->buf = (u8 *)os_readfile(path, &size);
+	if (!r->buf) {
+		fst_mgr_printf(MSG_ERROR, "cannot read capture %s", path);
+		return -1;
+	}
+
+	fhdr = (const struct fst_ctrl_rec_file_hdr *)r->buf;
+	if (size < sizeof(*fhdr) || fhdr->magic != FST_CTRL_REC_MAGIC ||
+	    fhdr->version != FST_CTRL_REC_VERSION) {
+		fst_mgr_printf(MSG_ERROR, "%s is not a capture", path);
+		return -1;
+	}
+
+	for (n = 0, pos = sizeof(*fhdr); ; n++) {
+		const struct fst_ctrl_rec_hdr *hdr =
+			(const struct fst_ctrl_rec_hdr *)(r->buf + pos);
+
+		if (pos + sizeof(*hdr) > size ||
+		    pos + FST_CTRL_REC_SIZE(hdr) > size)
+			break;
+		pos += FST_CTRL_REC_SIZE(hdr);
+	}
+	if (pos != size)
+		fst_mgr_printf(MSG_WARNING, "%s: truncated record dropped",
+			path);
+
+	r->events = os_calloc(n, sizeof(*r->events));
+	r->cmds = os_calloc(n, sizeof(*r->cmds));
+	r->cmd_used = os_calloc(n, sizeof(*r->cmd_used));
+	if (n && (!r->events || !r->cmds || !r->cmd_used))
+		return -1;
+
+	for (pos = sizeof(*fhdr); n--; ) {
+		const struct fst_ctrl_rec_hdr *hdr =
+			(const struct fst_ctrl_rec_hdr *)(r->buf + pos);
+
+		pos += FST_CTRL_REC_SIZE(hdr);
+		if (hdr->type == FST_CTRL_REC_EVENT)
+			r->events[r->events_num++] = hdr;
+		else if (hdr->type == FST_CTRL_REC_CMD)
+			r->cmds[r->cmds_num++] = hdr;
+	}
+
+	return 0;
+}
+
+Boolean fst_ctrl_replay_create(const char *path, Boolean fast)
+{
+	WPA_ASSERT(ctrl_replay == NULL);
+
+	ctrl_replay = os_zalloc(sizeof(*ctrl_replay));
+	if (!ctrl_replay)
+		return FALSE;
+	ctrl_replay->fast = fast;
+
+	if (fst_ctrl_replay_load(ctrl_replay, path))
+		goto error;
+
+	ctrl_replay->start_ns = fst_trace_now();
+	ctrl_replay->clock_start_ns = fst_ctrl_replay_clock_ns();
+	if (fst_detect_ctrl_type()) {
+		fst_mgr_printf(MSG_ERROR, "cannot detect CTRL type");
+		goto error;
+	}
+
+	eloop_register_timeout(0, 0, fst_ctrl_replay_next, NULL, NULL);
+	fst_mgr_printf(MSG_INFO, "replaying %zu events and %zu commands "
+		"from %s%s", ctrl_replay->events_num, ctrl_replay->cmds_num,
+		path, fast ? " as fast as possible" : "");
+	return TRUE;
+
+error:
+	fst_ctrl_replay_free();
+	return FALSE;
+}
+
 void fst_ctrl_free(void)
 {
+	if (ctrl_replay) {
+		eloop_cancel_timeout(fst_ctrl_replay_next, NULL, NULL);
+		fst_ctrl_replay_free();
+		return;
+	}
+
 	WPA_ASSERT(ctrl_evt != NULL);
 	WPA_ASSERT(ctrl_cmd != NULL);
 
-	if (ctrl_evt != NULL)
+	if (ctrl_ingest)
+		fst_ctrl_ingest_stop();
+	else if (ctrl_evt != NULL)
 		eloop_unregister_read_sock(wpa_ctrl_get_fd(ctrl_evt));
 
 	eloop_cancel_timeout(fst_ping, NULL, NULL);
@@ -126,6 +126,40 @@ int fst_detach_iface(const struct fst_iface_info *iface);
 int fst_attach_iface(const struct fst_group_info *group,
 	const struct fst_iface_info *iface);
 
+/*
+ * Size in KiB of the queue an event ingest thread drains the control
+ * interface into, 0 to read the events from the eloop. CLI implementation
+ * only, set before fst_ctrl_create().
+ */
+extern unsigned int fst_ctrl_ingest_kb;
+
+/**
+ * fst_ctrl_record_start - capture the control traffic to a file
+ * @path: capture file, truncated if exists
+ * Returns: 0 if success, -1 otherwise
+ *
+ * Every event received and every command sent with its reply is written with
+ * monotonic timestamps, for a later replay with fst_ctrl_replay_create().
+ */
+int fst_ctrl_record_start(const char *path);
+
+/**
+ * fst_ctrl_record_stop - stop capturing and close the capture file
+ */
+void fst_ctrl_record_stop(void);
+
+/**
+ * fst_ctrl_replay_create - use a capture instead of the control interface
+ * @path: capture file written by fst_ctrl_record_start()
+ * @fast: replay the events back to back rather than at the recorded times
+ * Returns: TRUE if success, FALSE otherwise
+ *
+ * The recorded events are fed to the notification callback and the commands
+ * are answered with the recorded replies. The eloop is terminated once all
+ * the events are replayed. fst_ctrl_free() releases the capture.
+ */
+Boolean fst_ctrl_replay_create(const char *path, Boolean fast);
+
 /**
  * fst_is_supplicant - Returns true if the hostap application is
  * the wpa_supplicant, FALSE  - if the hostapd
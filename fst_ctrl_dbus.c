@@ -52,6 +52,8 @@
 
 #include "fst/fst_ctrl_defs.h"
 #include "fst_ctrl.h"
+#include "fst_trace.h"
+#include "fst_ctrl_prof.h"
 
 #define WPAS_DBUS_OBJECT_PATH_MAX 150
 
@@ -505,6 +507,7 @@ static int session_call_method(u32 session_id, const char *method,
 	GDBusProxy *proxy = NULL;
 	GError     *error = NULL;
 	GVariant   *value = NULL;
+	u64         start_ns;
 
 	session_path = get_session_path(session_id);
 	if (!session_path) {
@@ -516,8 +519,10 @@ static int session_call_method(u32 session_id, const char *method,
 	if (!proxy)
 		goto out;
 
+	start_ns = fst_trace_now();
 	value = g_dbus_proxy_call_sync(proxy, method,  parameters,
 				G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
+	fst_ctrl_prof_add(method, start_ns, error ? -1 : 0);
 	if (error) {
       fst_mgr_printf(MSG_ERROR, "Error calling method: %s", error->message);
       g_error_free(error);
@@ -0,0 +1,203 @@
+/*
+ * FST Manager: control command profiler
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "fst_ctrl_prof.h"
+#include "fst_hist.h"
+#include "fst_metrics.h"
+#include "fst_trace.h"
+#define FST_MGR_COMPONENT "CTRL"
+#include "fst_manager.h"
+
+#define FST_CTRL_PROF_VERBS    32
+#define FST_CTRL_PROF_VERB_LEN 24
+/* verb="<verb>",quantile="0.<n>" */
+#define FST_CTRL_PROF_LABELS_LEN (FST_CTRL_PROF_VERB_LEN + 32)
+
+struct fst_ctrl_prof_verb {
+	char verb[FST_CTRL_PROF_VERB_LEN];
+	u32 failures;
+	struct fst_hist latency_us;
+};
+
+unsigned int fst_ctrl_prof_slow_ms = 0;
+
+static struct fst_ctrl_prof_verb prof_verbs[FST_CTRL_PROF_VERBS];
+static unsigned int prof_verbs_num;
+
+/* verbs that did not fit into prof_verbs */
+static struct fst_ctrl_prof_verb prof_other = { "OTHER", 0, { 0 } };
+
+/*
+ * "FST-MANAGER SESSION_SET 3 ..." is accounted as SESSION_SET and
+ * "IFNAME=wlan0 SET hw_mode a" as SET
+ */
+static void fst_ctrl_prof_verb_of(const char *cmd, char *verb)
+{
+	const char *p;
+	size_t len;
+
+	p = os_strchr(cmd, ' ');
+	if (p && (!os_strncmp(cmd, "FST-MANAGER ", 12) ||
+		  !os_strncmp(cmd, "IFNAME=", 7)))
+		cmd = p + 1;
+	for (len = 0; len < FST_CTRL_PROF_VERB_LEN - 1 && cmd[len] &&
+	     cmd[len] != ' '; len++)
+		verb[len] = cmd[len];
+	verb[len] = '\0';
+}
+
+static struct fst_ctrl_prof_verb *fst_ctrl_prof_lookup(const char *verb)
+{
+	unsigned int i;
+
+	for (i = 0; i < prof_verbs_num; i++)
+		if (!os_strcmp(prof_verbs[i].verb, verb))
+			return &prof_verbs[i];
+
+	if (prof_verbs_num == FST_CTRL_PROF_VERBS)
+		return &prof_other;
+
+	os_strlcpy(prof_verbs[prof_verbs_num].verb, verb,
+		FST_CTRL_PROF_VERB_LEN);
+	return &prof_verbs[prof_verbs_num++];
+}
+
+u32 fst_ctrl_prof_add(const char *cmd, u64 start_ns, int res)
+{
+	char verb[FST_CTRL_PROF_VERB_LEN];
+	struct fst_ctrl_prof_verb *v;
+	u64 us = (fst_trace_now() - start_ns) / 1000;
+
+	if (us > 0xffffffff)
+		us = 0xffffffff;
+
+	fst_ctrl_prof_verb_of(cmd, verb);
+	v = fst_ctrl_prof_lookup(verb);
+	fst_hist_add(&v->latency_us, (u32)us);
+	if (res < 0)
+		v->failures++;
+
+	if (fst_ctrl_prof_slow_ms && us >= fst_ctrl_prof_slow_ms * 1000ULL)
+		fst_mgr_printf(MSG_WARNING, "slow command '%s': %llu us%s",
+			cmd, (unsigned long long)us, res < 0 ? " (failed)" : "");
+
+	return (u32)us;
+}
+
+static void fst_ctrl_prof_dump_verb(const struct fst_ctrl_prof_verb *v)
+{
+	const struct fst_hist *h = &v->latency_us;
+
+	if (!h->count)
+		return;
+
+	fst_mgr_printf(MSG_INFO, "ctrl %s: count=%u failures=%u total=%llu "
+		"avg=%llu p50=%u p90=%u p99=%u max=%u us", v->verb, h->count,
+		v->failures, (unsigned long long)h->sum,
+		(unsigned long long)(h->sum / h->count),
+		fst_hist_percentile(h, 500), fst_hist_percentile(h, 900),
+		fst_hist_percentile(h, 990), h->max);
+}
+
+void fst_ctrl_prof_dump(void)
+{
+	const struct fst_ctrl_prof_verb *by_total[FST_CTRL_PROF_VERBS];
+	unsigned int i, j;
+
+	/* sorted by the total time spent, the worst offenders first */
+	for (i = 0; i < prof_verbs_num; i++) {
+		const struct fst_ctrl_prof_verb *v = &prof_verbs[i];
+
+		for (j = i; j > 0 && by_total[j - 1]->latency_us.sum <
+		     v->latency_us.sum; j--)
+			by_total[j] = by_total[j - 1];
+		by_total[j] = v;
+	}
+
+	for (i = 0; i < prof_verbs_num; i++)
+		fst_ctrl_prof_dump_verb(by_total[i]);
+	fst_ctrl_prof_dump_verb(&prof_other);
+}
+
+static void fst_ctrl_prof_write_verb(FILE *f,
+	const struct fst_ctrl_prof_verb *v)
+{
+	const struct fst_hist *h = &v->latency_us;
+	static const unsigned int quantiles[] = { 500, 900, 990 };
+	char labels[FST_CTRL_PROF_LABELS_LEN];
+	unsigned int i;
+
+	if (!h->count)
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(quantiles); i++) {
+		os_snprintf(labels, sizeof(labels),
+			"verb=\"%.*s\",quantile=\"0.%u\"",
+			FST_CTRL_PROF_VERB_LEN - 1, v->verb,
+			quantiles[i] / 10);
+		fst_metrics_print(f, "ctrl_command_latency_us", labels,
+			fst_hist_percentile(h, quantiles[i]));
+	}
+	os_snprintf(labels, sizeof(labels), "verb=\"%.*s\"",
+		FST_CTRL_PROF_VERB_LEN - 1, v->verb);
+	fprintf(f, "fstman_ctrl_command_latency_us_sum{%s} %llu\n", labels,
+		(unsigned long long)h->sum);
+	fprintf(f, "fstman_ctrl_command_latency_us_count{%s} %u\n", labels,
+		h->count);
+}
+
+void fst_ctrl_prof_write_metrics(FILE *f)
+{
+	unsigned int i;
+
+	fst_metrics_print_header(f, "ctrl_command_latency_us", "summary",
+		"Latency of the control commands, by verb");
+	for (i = 0; i < prof_verbs_num; i++)
+		fst_ctrl_prof_write_verb(f, &prof_verbs[i]);
+	fst_ctrl_prof_write_verb(f, &prof_other);
+
+	fst_metrics_print_header(f, "ctrl_command_failures_total", "counter",
+		"Failed control commands, by verb");
+	for (i = 0; i < prof_verbs_num; i++) {
+		char labels[FST_CTRL_PROF_LABELS_LEN];
+
+		os_snprintf(labels, sizeof(labels), "verb=\"%.*s\"",
+			FST_CTRL_PROF_VERB_LEN - 1, prof_verbs[i].verb);
+		fst_metrics_print(f, "ctrl_command_failures_total", labels,
+			prof_verbs[i].failures);
+	}
+	if (prof_other.latency_us.count)
+		fst_metrics_print(f, "ctrl_command_failures_total",
+			"verb=\"OTHER\"", prof_other.failures);
+}
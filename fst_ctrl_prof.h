@@ -0,0 +1,63 @@
+/*
+ * FST Manager: control command profiler definitions
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __FST_CTRL_PROF_H__
+#define __FST_CTRL_PROF_H__
+
+#include <stdio.h>
+#include "utils/common.h"
+
+/* commands slower than this are logged, 0 disables the slow command log */
+extern unsigned int fst_ctrl_prof_slow_ms;
+
+/**
+ * fst_ctrl_prof_add - account one control transaction
+ * @cmd: the command as sent; only its verb is used for aggregation
+ * @start_ns: fst_trace_now() before the command was sent
+ * @res: result of the transaction, negative on failure
+ * Returns: latency of the transaction in us
+ */
+u32 fst_ctrl_prof_add(const char *cmd, u64 start_ns, int res);
+
+/**
+ * fst_ctrl_prof_dump - log the per verb statistics
+ */
+void fst_ctrl_prof_dump(void);
+
+/**
+ * fst_ctrl_prof_write_metrics - print the per verb statistics in the
+ * Prometheus text format
+ * @f: stream to print to
+ */
+void fst_ctrl_prof_write_metrics(FILE *f);
+
+#endif /* __FST_CTRL_PROF_H__ */
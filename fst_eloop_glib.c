@@ -0,0 +1,180 @@
+/*
+ * FST Manager: eloop timeouts and sockets on the glib main loop
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * The D-Bus build runs a glib main loop instead of eloop. The manager and
+ * the metrics exporter only need eloop timeouts and read sockets, so these
+ * are implemented here on top of glib sources, with the eloop semantics:
+ * a timeout fires once and ELOOP_ALL_CTX matches any context on cancel.
+ */
+
+#include <glib.h>
+#include <glib-unix.h>
+
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "utils/list.h"
+#include "utils/eloop.h"
+
+struct eloop_glib_timeout {
+	guint id;
+	eloop_timeout_handler handler;
+	void *eloop_data;
+	void *user_data;
+	struct dl_list lentry;
+};
+
+struct eloop_glib_sock {
+	guint id;
+	int sock;
+	eloop_sock_handler handler;
+	void *eloop_data;
+	void *user_data;
+	struct dl_list lentry;
+};
+
+static struct dl_list eloop_glib_timeouts =
+	{ &eloop_glib_timeouts, &eloop_glib_timeouts };
+static struct dl_list eloop_glib_socks =
+	{ &eloop_glib_socks, &eloop_glib_socks };
+
+static gboolean eloop_glib_timeout_cb(gpointer data)
+{
+	struct eloop_glib_timeout *t = data;
+
+	/* the handler may register the same timeout again */
+	dl_list_del(&t->lentry);
+	t->handler(t->eloop_data, t->user_data);
+	os_free(t);
+	return G_SOURCE_REMOVE;
+}
+
+int eloop_register_timeout(unsigned int secs, unsigned int usecs,
+			   eloop_timeout_handler handler,
+			   void *eloop_data, void *user_data)
+{
+	struct eloop_glib_timeout *t;
+	guint ms;
+
+	t = os_zalloc(sizeof(*t));
+	if (!t)
+		return -1;
+
+	/* glib timeouts have ms resolution, never fire early */
+	ms = secs * 1000 + (usecs + 999) / 1000;
+	t->handler = handler;
+	t->eloop_data = eloop_data;
+	t->user_data = user_data;
+	t->id = g_timeout_add(ms, eloop_glib_timeout_cb, t);
+	dl_list_add_tail(&eloop_glib_timeouts, &t->lentry);
+	return 0;
+}
+
+int eloop_cancel_timeout(eloop_timeout_handler handler,
+			 void *eloop_data, void *user_data)
+{
+	struct eloop_glib_timeout *t, *n;
+	int removed = 0;
+
+	dl_list_for_each_safe(t, n, &eloop_glib_timeouts,
+			      struct eloop_glib_timeout, lentry) {
+		if (t->handler != handler ||
+		    (t->eloop_data != eloop_data &&
+		     eloop_data != ELOOP_ALL_CTX) ||
+		    (t->user_data != user_data && user_data != ELOOP_ALL_CTX))
+			continue;
+		g_source_remove(t->id);
+		dl_list_del(&t->lentry);
+		os_free(t);
+		removed++;
+	}
+
+	return removed;
+}
+
+int eloop_is_timeout_registered(eloop_timeout_handler handler,
+				void *eloop_data, void *user_data)
+{
+	struct eloop_glib_timeout *t;
+
+	dl_list_for_each(t, &eloop_glib_timeouts, struct eloop_glib_timeout,
+			 lentry)
+		if (t->handler == handler && t->eloop_data == eloop_data &&
+		    t->user_data == user_data)
+			return 1;
+
+	return 0;
+}
+
+static gboolean eloop_glib_sock_cb(gint fd, GIOCondition condition,
+	gpointer data)
+{
+	struct eloop_glib_sock *s = data;
+
+	/* the handler may unregister the socket, s must not be used after */
+	s->handler(s->sock, s->eloop_data, s->user_data);
+	return G_SOURCE_CONTINUE;
+}
+
+int eloop_register_read_sock(int sock, eloop_sock_handler handler,
+			     void *eloop_data, void *user_data)
+{
+	struct eloop_glib_sock *s;
+
+	s = os_zalloc(sizeof(*s));
+	if (!s)
+		return -1;
+
+	s->sock = sock;
+	s->handler = handler;
+	s->eloop_data = eloop_data;
+	s->user_data = user_data;
+	s->id = g_unix_fd_add(sock, G_IO_IN | G_IO_HUP | G_IO_ERR,
+		eloop_glib_sock_cb, s);
+	dl_list_add_tail(&eloop_glib_socks, &s->lentry);
+	return 0;
+}
+
+void eloop_unregister_read_sock(int sock)
+{
+	struct eloop_glib_sock *s;
+
+	dl_list_for_each(s, &eloop_glib_socks, struct eloop_glib_sock,
+			 lentry) {
+		if (s->sock == sock) {
+			g_source_remove(s->id);
+			dl_list_del(&s->lentry);
+			os_free(s);
+			return;
+		}
+	}
+}
@@ -0,0 +1,95 @@
+/*
+ * FST Manager: latency histograms
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "fst_hist.h"
+
+#define FST_HIST_SUB (1U << FST_HIST_SUB_BITS)
+
+static unsigned int fst_hist_index(u32 value)
+{
+	unsigned int msb;
+
+	if (value < FST_HIST_SUB)
+		return value;
+
+	msb = 31 - __builtin_clz(value);
+	return ((msb - FST_HIST_SUB_BITS + 1) << FST_HIST_SUB_BITS) +
+		((value >> (msb - FST_HIST_SUB_BITS)) & (FST_HIST_SUB - 1));
+}
+
+u32 fst_hist_bucket_upper(unsigned int idx)
+{
+	unsigned int msb, shift;
+
+	if (idx < FST_HIST_SUB)
+		return idx;
+
+	msb = (idx >> FST_HIST_SUB_BITS) + FST_HIST_SUB_BITS - 1;
+	shift = msb - FST_HIST_SUB_BITS;
+	return (u32)(((u64)(FST_HIST_SUB | (idx & (FST_HIST_SUB - 1))) + 1)
+		<< shift) - 1;
+}
+
+void fst_hist_add(struct fst_hist *h, u32 value)
+{
+	h->buckets[fst_hist_index(value)]++;
+	h->count++;
+	h->sum += value;
+	if (value > h->max)
+		h->max = value;
+}
+
+u32 fst_hist_percentile(const struct fst_hist *h, unsigned int permille)
+{
+	u64 rank, seen = 0;
+	unsigned int idx;
+
+	if (!h->count)
+		return 0;
+
+	/* rank of the value, counting from 1 */
+	rank = ((u64)h->count * permille + 999) / 1000;
+	if (!rank)
+		rank = 1;
+	for (idx = 0; idx < FST_HIST_BUCKETS; idx++) {
+		seen += h->buckets[idx];
+		if (seen >= rank) {
+			u32 upper = fst_hist_bucket_upper(idx);
+
+			return upper < h->max ? upper : h->max;
+		}
+	}
+
+	return h->max;
+}
@@ -0,0 +1,73 @@
+/*
+ * FST Manager: latency histograms definitions
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __FST_HIST_H__
+#define __FST_HIST_H__
+
+#include "utils/common.h"
+
+/*
+ * Log-linear (HDR-style) histogram of u32 values: every power of 2 range is
+ * split into 2^FST_HIST_SUB_BITS buckets, so a value is known within 12.5%.
+ */
+#define FST_HIST_SUB_BITS 3
+#define FST_HIST_BUCKETS  ((32 - FST_HIST_SUB_BITS + 1) << FST_HIST_SUB_BITS)
+
+struct fst_hist {
+	u32 count;
+	u32 max;
+	u64 sum;
+	u32 buckets[FST_HIST_BUCKETS];
+};
+
+/**
+ * fst_hist_add - account a value
+ * @h: histogram
+ * @value: value, typically a latency in us
+ */
+void fst_hist_add(struct fst_hist *h, u32 value);
+
+/**
+ * fst_hist_percentile - get a percentile of the accounted values
+ * @h: histogram
+ * @permille: percentile in 1/1000, e.g. 990 for p99
+ * Returns: upper bound of the bucket the percentile falls in, or 0 if empty
+ */
+u32 fst_hist_percentile(const struct fst_hist *h, unsigned int permille);
+
+/**
+ * fst_hist_bucket_upper - get the largest value accounted in a bucket
+ * @idx: bucket index
+ */
+u32 fst_hist_bucket_upper(unsigned int idx);
+
+#endif /* __FST_HIST_H__ */
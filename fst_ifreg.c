@@ -0,0 +1,199 @@
+/*
+ * FST Manager: interface registry
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <net/if.h>
+
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "fst_ifreg.h"
+#define FST_MGR_COMPONENT "IFREG"
+#include "fst_manager.h"
+
+#define FST_IFREG_HASH_SIZE 64
+#define FST_IFREG_MAX       0xffff
+
+struct fst_ifreg_entry {
+	char         name[IFNAMSIZ + 1];
+	int          ifindex;
+	unsigned int refs;
+	u16          hash_next;
+};
+
+/* indexed by ID, entries do not move so the names can be handed out */
+static struct fst_ifreg_entry **fst_ifreg_entries;
+static unsigned int fst_ifreg_size;
+static u16 fst_ifreg_hash[FST_IFREG_HASH_SIZE];
+
+static unsigned int fst_ifreg_bucket(const char *ifname)
+{
+	unsigned int h = 5381;
+
+	while (*ifname)
+		h = h * 33 + (u8) *ifname++;
+
+	return h % FST_IFREG_HASH_SIZE;
+}
+
+static struct fst_ifreg_entry *fst_ifreg_entry(u16 id)
+{
+	return id < fst_ifreg_size ? fst_ifreg_entries[id] : NULL;
+}
+
+u16 fst_ifreg_lookup(const char *ifname)
+{
+	u16 id = fst_ifreg_hash[fst_ifreg_bucket(ifname)];
+
+	while (id != FST_IFREG_NONE) {
+		struct fst_ifreg_entry *e = fst_ifreg_entries[id];
+
+		if (!os_strcmp(e->name, ifname))
+			return id;
+		id = e->hash_next;
+	}
+
+	return FST_IFREG_NONE;
+}
+
+static u16 fst_ifreg_alloc_id(void)
+{
+	struct fst_ifreg_entry **entries;
+	unsigned int id, size;
+
+	for (id = 1; id < fst_ifreg_size; id++)
+		if (!fst_ifreg_entries[id])
+			return id;
+
+	if (fst_ifreg_size > FST_IFREG_MAX)
+		return FST_IFREG_NONE;
+
+	size = fst_ifreg_size ? fst_ifreg_size * 2 : 16;
+	if (size > FST_IFREG_MAX + 1)
+		size = FST_IFREG_MAX + 1;
+	entries = os_realloc_array(fst_ifreg_entries, size, sizeof(*entries));
+	if (!entries)
+		return FST_IFREG_NONE;
+	os_memset(entries + fst_ifreg_size, 0,
+		(size - fst_ifreg_size) * sizeof(*entries));
+	id = fst_ifreg_size ? fst_ifreg_size : 1;
+	fst_ifreg_entries = entries;
+	fst_ifreg_size = size;
+
+	return id;
+}
+
+u16 fst_ifreg_get(const char *ifname)
+{
+	struct fst_ifreg_entry *e;
+	unsigned int bucket;
+	u16 id;
+
+	id = fst_ifreg_lookup(ifname);
+	if (id != FST_IFREG_NONE) {
+		fst_ifreg_entries[id]->refs++;
+		return id;
+	}
+
+	if (os_strlen(ifname) >= sizeof(e->name)) {
+		fst_mgr_printf(MSG_ERROR, "interface name %s too long", ifname);
+		return FST_IFREG_NONE;
+	}
+
+	id = fst_ifreg_alloc_id();
+	e = id != FST_IFREG_NONE ? os_zalloc(sizeof(*e)) : NULL;
+	if (!e) {
+		fst_mgr_printf(MSG_ERROR, "cannot register interface %s",
+			ifname);
+		return FST_IFREG_NONE;
+	}
+
+	os_strlcpy(e->name, ifname, sizeof(e->name));
+	e->refs = 1;
+	bucket = fst_ifreg_bucket(ifname);
+	e->hash_next = fst_ifreg_hash[bucket];
+	fst_ifreg_hash[bucket] = id;
+	fst_ifreg_entries[id] = e;
+
+	fst_mgr_printf(MSG_DEBUG, "interface %s registered as #%u", ifname, id);
+	return id;
+}
+
+void fst_ifreg_put(u16 id)
+{
+	struct fst_ifreg_entry *e = fst_ifreg_entry(id);
+	u16 *link;
+
+	if (!e || --e->refs)
+		return;
+
+	for (link = &fst_ifreg_hash[fst_ifreg_bucket(e->name)];
+	     *link != id; link = &fst_ifreg_entries[*link]->hash_next)
+		;
+	*link = e->hash_next;
+	fst_ifreg_entries[id] = NULL;
+	os_free(e);
+
+	for (id = 1; id < fst_ifreg_size; id++)
+		if (fst_ifreg_entries[id])
+			return;
+
+	/* nothing registered anymore */
+	os_free(fst_ifreg_entries);
+	fst_ifreg_entries = NULL;
+	fst_ifreg_size = 0;
+}
+
+const char *fst_ifreg_name(u16 id)
+{
+	struct fst_ifreg_entry *e = fst_ifreg_entry(id);
+
+	return e ? e->name : "";
+}
+
+int fst_ifreg_ifindex(u16 id)
+{
+	struct fst_ifreg_entry *e = fst_ifreg_entry(id);
+
+	if (!e)
+		return 0;
+	if (!e->ifindex)
+		e->ifindex = if_nametoindex(e->name);
+
+	return e->ifindex;
+}
+
+void fst_ifreg_set_ifindex(u16 id, int ifindex)
+{
+	struct fst_ifreg_entry *e = fst_ifreg_entry(id);
+
+	if (e)
+		e->ifindex = ifindex;
+}
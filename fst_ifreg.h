@@ -0,0 +1,91 @@
+/*
+ * FST Manager: interface registry
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __FST_IFREG_H__
+#define __FST_IFREG_H__
+
+#include "utils/common.h"
+
+/*
+ * Process-wide registry giving every interface name a small integer ID, so
+ * the subsystems compare and store IDs and resolve the names only to log
+ * them or to talk to hostapd and the kernel.
+ */
+#define FST_IFREG_NONE 0
+
+/**
+ * fst_ifreg_get - get the ID of an interface, registering it if needed
+ * @ifname: interface name
+ * Returns: ID, or FST_IFREG_NONE on error
+ *
+ * Every successful fst_ifreg_get() must be balanced by fst_ifreg_put().
+ */
+u16 fst_ifreg_get(const char *ifname);
+
+/**
+ * fst_ifreg_put - release an ID obtained with fst_ifreg_get()
+ * @id: ID, FST_IFREG_NONE is ignored
+ *
+ * The ID is recycled once it is no longer referenced.
+ */
+void fst_ifreg_put(u16 id);
+
+/**
+ * fst_ifreg_lookup - get the ID of a registered interface
+ * @ifname: interface name
+ * Returns: ID, or FST_IFREG_NONE if the interface is not registered
+ */
+u16 fst_ifreg_lookup(const char *ifname);
+
+/**
+ * fst_ifreg_name - get the name of an interface
+ * @id: ID
+ * Returns: name, or "" for an unknown ID
+ */
+const char *fst_ifreg_name(u16 id);
+
+/**
+ * fst_ifreg_ifindex - get the kernel index of an interface
+ * @id: ID
+ * Returns: index, resolved on first use and cached; 0 if there is no such
+ *	interface
+ */
+int fst_ifreg_ifindex(u16 id);
+
+/**
+ * fst_ifreg_set_ifindex - update the cached kernel index of an interface
+ * @id: ID
+ * @ifindex: index as reported by the kernel, 0 to resolve it again on use
+ */
+void fst_ifreg_set_ifindex(u16 id, int ifindex);
+
+#endif /* __FST_IFREG_H__ */
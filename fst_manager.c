@@ -33,20 +33,89 @@
 #include "utils/includes.h"
 #include "utils/common.h"
 #include "utils/list.h"
+#include "utils/eloop.h"
 #include "common/defs.h"
 #include "common/ieee802_11_defs.h"
 #include "fst_ctrl.h"
 #include "fst_mux.h"
 #include "fst/fst_ctrl_defs.h"
 #include "fst_cfgmgr.h"
+#include "fst_trace.h"
+#include "fst_hist.h"
+#include "fst_metrics.h"
+#include "fst_ctrl_prof.h"
+#include "fst_pool.h"
+#include "fst_ifreg.h"
+#include "fst_status.h"
 #define FST_MGR_COMPONENT "MGR"
 #include "fst_manager.h"
 #include <stdbool.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
 
 #define FST_LLT_SWITCH_IMMEDIATELY 0
 #define LLT_UNIT_US        32 /* See 10.32.2.2  Transitioning between states */
 #define MS_TO_LLT_VALUE(l) (((l) * 1000) / LLT_UNIT_US)
 
+/* Upper bound of the exponential setup retry backoff */
+#define FST_MGR_RETRY_BACKOFF_MAX_MS 10000
+
+/* Disconnects within the window that make an iface probe its carrier */
+#define FST_MGR_LINK_PROBE_DISCONNECTS 4
+#define FST_MGR_LINK_PROBE_WINDOW_MS   100
+
+/* Period of background session pool refill while the group is busy */
+#define FST_MGR_POOL_REFILL_INTERVAL_MS 100
+
+/*
+ * A setup hostapd still holds this long after it was initiated has been
+ * accepted by the peer, hostapd gives up on a setup after about 260 ms (STT)
+ */
+#define FST_MGR_RESYNC_SETUP_TIMEOUT_MS 1000
+
+/* Period of the traffic counter reads of the lazy setup */
+#define FST_MGR_LAZY_POLL_INTERVAL_MS 1000
+
+struct fst_mgr_group_stats
+{
+	unsigned int setups_initiated;
+	unsigned int setups_deferred; /* queued by the setup admission */
+	unsigned int setup_queue_high_water;
+	unsigned int setup_timeouts;  /* REASON_STT */
+	unsigned int retries;
+	unsigned int retries_exhausted;
+	unsigned int pool_hits;
+	unsigned int pool_misses;
+	unsigned int bulk_failovers;
+	unsigned int bulk_failover_peers;
+	unsigned int bulk_failover_last_us;
+	unsigned int resyncs;
+	unsigned int resync_fixes;    /* differences applied by resyncs */
+	unsigned int lazy_deferrals;  /* setups waiting for peer traffic */
+	unsigned int lazy_activations;
+};
+
+/*
+ * Phases of a band switch. The trigger is the disconnect that initiates a
+ * local switch, or REASON_SWITCH for a switch initiated by the peer.
+ */
+enum fst_mgr_switch_phase
+{
+	FST_MGR_SWITCH_TRANSFER,  /* trigger -> fst_session_transfer() done */
+	FST_MGR_SWITCH_MAP,       /* trigger -> mux map updated */
+	FST_MGR_SWITCH_HOSTAPD,   /* fst_session_transfer() -> REASON_SWITCH */
+	FST_MGR_SWITCH_LINK_LOSS, /* REASON_SWITCH -> link loss sysfs written */
+	FST_MGR_SWITCH_TOTAL,     /* trigger -> REASON_SWITCH */
+	FST_MGR_SWITCH_PHASE_LAST
+};
+
+/* switch latencies in us */
+struct fst_mgr_switch_stats
+{
+	struct fst_hist phase[FST_MGR_SWITCH_PHASE_LAST];
+};
+
 struct fst_mgr
 {
 	struct dl_list groups;
@@ -60,12 +129,47 @@ struct fst_mgr_group
 	struct dl_list        ifaces;
 	struct dl_list        peers;
 	struct dl_list        mgr_lentry;
+	struct fst_mgr_group_stats stats;
+	u32                  *pool; /* idle hostapd sessions ready for reuse */
+	unsigned int          pool_count;
+	struct fst_mgr_switch_stats switch_stats;
+	struct dl_list        pairs; /* struct fst_mgr_iface_pair */
+	struct dl_list        setup_queue; /* struct fst_mgr_peer, by setup_prio */
+	u64                   setup_full_us; /* setup token bucket full again */
+	struct fst_hist       setup_wait; /* setup queue wait, us */
+	u64                   lazy_poll_us; /* last traffic counter read */
+	Boolean               lazy_blind; /* no counters, set up all peers */
 };
 
 struct fst_mgr_iface
 {
 	struct fst_iface_info info;
+	u16                   ifid; /* info.name in the interface registry */
 	struct dl_list        grp_lentry;
+	Boolean               link_down; /* peers already failed over */
+	u64                   disconnects_since_us; /* see link probe window */
+	unsigned int          disconnects;
+	int                   link_loss_fd; /* wil6210 sysfs, -1 if closed */
+	struct dl_list        link_loss_pending;
+};
+
+/* fst link loss setting queued for the end of the event loop iteration */
+struct fst_mgr_link_loss
+{
+	u8                    addr[ETH_ALEN];
+	Boolean               enable;
+	u64                   switched_us; /* REASON_SWITCH, 0 if none */
+	struct fst_mgr_switch_stats *stats[2]; /* group and iface pair */
+	struct dl_list        lentry;
+};
+
+/* switch latencies between two ifaces of a group */
+struct fst_mgr_iface_pair
+{
+	struct fst_mgr_iface       *old_iface;
+	struct fst_mgr_iface       *new_iface;
+	struct fst_mgr_switch_stats stats;
+	struct dl_list              grp_lentry;
 };
 
 enum fst_mgr_session_state
@@ -86,6 +190,12 @@ struct fst_mgr_session
 	struct fst_mgr_iface      *new_iface;
 	u32                        llt;
 	Boolean                    non_compliant;
+	Boolean                    dirty; /* hostapd may still report on it */
+	Boolean                    gone;  /* hostapd does not hold it any more */
+	u64                        setup_us;
+	u64                        switch_trigger_us;
+	u64                        switch_transfer_us;
+	u64                        switch_done_us;
 	struct dl_list             grp_lentry;
 };
 
@@ -102,10 +212,42 @@ struct fst_mgr_peer
 	struct fst_mgr_iface   *active_iface;
 	struct dl_list          ifaces;
 	struct dl_list          grp_lentry;
+	unsigned int            retries; /* consecutive setup timeouts */
+	Boolean                 link_loss;
+	unsigned int            link_loss_toggles;
+	int                     status;      /* status page record, -1 if none */
+	u16                     mapped_ifid; /* iface last mapped via */
+	unsigned int            switches;    /* changes of mapped_ifid */
+	u64                     switch_us;   /* CLOCK_MONOTONIC, as published */
+	struct dl_list          setup_lentry; /* in the group setup queue */
+	Boolean                 setup_queued;
+	Boolean                 setup_admitted; /* token taken by the dispatcher */
+	int                     setup_prio;   /* priority gained by the setup */
+	u64                     queued_us;
+	Boolean                 lazy_waiting; /* setup deferred until active */
+	Boolean                 tx_active;    /* sent fst_lazy_setup_rate */
+	u16                     tx_ifid;      /* iface the counter belongs to */
+	u64                     tx_bytes;
+	u64                     tx_sampled_us;
 };
 
+/* recycled on every connect, disconnect and switch */
+static struct fst_pool fst_mgr_session_pool =
+	FST_POOL_INITIALIZER("session", struct fst_mgr_session, 1, 0);
+static struct fst_pool fst_mgr_peer_pool =
+	FST_POOL_INITIALIZER("peer", struct fst_mgr_peer, 1, 0);
+static struct fst_pool fst_mgr_peer_iface_pool =
+	FST_POOL_INITIALIZER("peer_iface", struct fst_mgr_peer_iface, 2, 0);
+
 extern unsigned int fst_num_of_retries;
+extern unsigned int fst_retry_backoff_ms;
+extern unsigned int fst_max_concurrent_setups;
+extern unsigned int fst_setup_rate;
+extern unsigned int fst_setup_burst;
+extern unsigned int fst_lazy_setup_rate;
+extern unsigned int fst_session_pool_size;
 extern Boolean fst_force_nc;
+extern unsigned int fst_resync_interval;
 
 #define _fst_mgr_foreach_grp(m, g) \
 	dl_list_for_each((g), &(m)->groups, struct fst_mgr_group, mgr_lentry)
@@ -134,6 +276,19 @@ static void _fst_mgr_peer_check_compliance(struct fst_mgr_peer *p);
 static const u8 *_fst_mgr_peer_get_addr_of_iface(struct fst_mgr_peer *p,
 					   struct fst_mgr_iface *iface);
 
+static void _fst_mgr_peer_retry_timeout(void *eloop_data, void *user_ctx);
+
+static void _fst_mgr_session_publish(struct fst_mgr_session *s);
+
+static void _fst_mgr_group_setup_kick(struct fst_mgr_group *g);
+
+static Boolean _fst_mgr_peer_try_to_initiate_next_setup(
+	struct fst_mgr_peer *p, struct fst_mgr_group *g);
+
+static int _fst_mgr_group_pool_get(struct fst_mgr_group *g, u32 *session_id);
+
+static int _fst_mgr_group_pool_put(struct fst_mgr_group *g, u32 session_id);
+
 /* helpers */
 static const char *state_name(enum fst_mgr_session_state state)
 {
@@ -179,6 +334,95 @@ static inline int _fst_mgr_session_is_ready(struct fst_mgr_session *s)
 	return (s->state == FST_MGR_SESSION_STATE_ESTABLISHED);
 }
 
+static inline void _fst_mgr_session_set_state(struct fst_mgr_session *s,
+	enum fst_mgr_session_state state)
+{
+	Boolean slot_freed = s->state == FST_MGR_SESSION_STATE_INITIATED &&
+		state != FST_MGR_SESSION_STATE_INITIATED;
+
+	fst_trace_record(FST_TRACE_SESSION_STATE, s->id, s->state, state, 0, 0);
+	s->state = state;
+	if (slot_freed)
+		_fst_mgr_group_setup_kick(s->group);
+	if (fst_status_page)
+		_fst_mgr_session_publish(s);
+}
+
+static const char *switch_phase_name(enum fst_mgr_switch_phase phase)
+{
+	static const char *phase_names[] = {
+		[FST_MGR_SWITCH_TRANSFER] "transfer",
+		[FST_MGR_SWITCH_MAP] "map",
+		[FST_MGR_SWITCH_HOSTAPD] "hostapd",
+		[FST_MGR_SWITCH_LINK_LOSS] "link_loss",
+		[FST_MGR_SWITCH_TOTAL] "total",
+	};
+
+	if (phase >= FST_MGR_SWITCH_PHASE_LAST)
+		return "UNKNOWN_PHASE";
+
+	return phase_names[phase];
+}
+
+static u64 _fst_mgr_now_us(void)
+{
+	struct os_reltime t;
+
+	os_get_reltime(&t);
+	return (u64)t.sec * 1000000 + t.usec;
+}
+
+static void _fst_mgr_switch_account(struct fst_mgr_switch_stats *stats[2],
+	enum fst_mgr_switch_phase phase, u64 since_us)
+{
+	u64 lat = _fst_mgr_now_us() - since_us;
+
+	if (lat > 0xffffffff)
+		lat = 0xffffffff;
+	fst_hist_add(&stats[0]->phase[phase], (u32)lat);
+	if (stats[1])
+		fst_hist_add(&stats[1]->phase[phase], (u32)lat);
+}
+
+static struct fst_mgr_switch_stats *
+_fst_mgr_group_pair_stats(struct fst_mgr_group *g,
+	struct fst_mgr_iface *old_i, struct fst_mgr_iface *new_i)
+{
+	struct fst_mgr_iface_pair *pair;
+
+	dl_list_for_each(pair, &g->pairs, struct fst_mgr_iface_pair,
+			 grp_lentry)
+		if (pair->old_iface == old_i && pair->new_iface == new_i)
+			return &pair->stats;
+
+	pair = os_zalloc(sizeof(*pair));
+	if (!pair) {
+		fst_mgr_printf(MSG_WARNING, "group %s: cannot allocate iface pair",
+			g->info.id);
+		return NULL;
+	}
+
+	pair->old_iface = old_i;
+	pair->new_iface = new_i;
+	dl_list_add_tail(&g->pairs, &pair->grp_lentry);
+	return &pair->stats;
+}
+
+/* accounts a switch phase of the session, if its start was seen */
+static void _fst_mgr_session_switch_account(struct fst_mgr_session *s,
+	enum fst_mgr_switch_phase phase, u64 since_us)
+{
+	struct fst_mgr_switch_stats *stats[2];
+
+	if (!since_us)
+		return;
+
+	stats[0] = &s->group->switch_stats;
+	stats[1] = _fst_mgr_group_pair_stats(s->group, s->old_iface,
+		s->new_iface);
+	_fst_mgr_switch_account(stats, phase, since_us);
+}
+
 static inline struct fst_mgr_iface *
 _fst_mgr_session_get_old_iface(struct fst_mgr_session *s)
 {
@@ -288,12 +532,15 @@ static int _fst_mgr_session_initiate_setup(struct fst_mgr_session *s)
 	if (fst_session_initiate(s->id)) {
 		fst_mgr_printf(MSG_ERROR, "session %u: cannot initiate setup",
 				s->id);
+		fst_metrics_inc(setup_failures);
 		return -1;
 	}
 
 	fst_mgr_printf(MSG_INFO, "session %u: setup initiated",
 			s->id);
-	s->state = FST_MGR_SESSION_STATE_INITIATED;
+	fst_metrics_inc(setups_initiated);
+	s->setup_us = _fst_mgr_now_us();
+	_fst_mgr_session_set_state(s, FST_MGR_SESSION_STATE_INITIATED);
 	return 0;
 }
 
@@ -308,7 +555,7 @@ static void _fst_mgr_session_nc_transfer(struct fst_mgr_session *s,
 		s->id, s->old_iface->info.name,
 		s->new_iface->info.name);
 	_fst_mgr_peer_set_active_iface(p, s->new_iface, s->group->drv);
-	s->state = FST_MGR_SESSION_STATE_IDLE;
+	_fst_mgr_session_set_state(s, FST_MGR_SESSION_STATE_IDLE);
 }
 
 static void _fst_mgr_session_check_for_nc_transfer(struct fst_mgr_session *s,
@@ -328,7 +575,10 @@ static int _fst_mgr_session_transfer(struct fst_mgr_session *s)
 	}
 	fst_mgr_printf(MSG_INFO, "session %u: transfer initiated",
 			s->id);
-	s->state = FST_MGR_SESSION_STATE_IN_TRANSITION;
+	_fst_mgr_session_set_state(s, FST_MGR_SESSION_STATE_IN_TRANSITION);
+	s->switch_transfer_us = _fst_mgr_now_us();
+	_fst_mgr_session_switch_account(s, FST_MGR_SWITCH_TRANSFER,
+		s->switch_trigger_us);
 
 	return 0;
 }
@@ -346,38 +596,129 @@ _fst_mgr_group_peer_by_session(struct fst_mgr_group *g,
 	return NULL;
 }
 
-static int
-_fst_mgr_set_link_loss(const char *ifname, const u8 *addr, bool fst_link_loss)
+static int _fst_mgr_iface_link_loss_open(struct fst_mgr_iface *i)
 {
 	char fname[128];
-	FILE *f;
 
-	if (ifname == NULL)
+	os_snprintf(fname, sizeof(fname),
+		"/sys/class/net/%s/device/wil6210/fst_link_loss", i->info.name);
+	i->link_loss_fd = open(fname, O_WRONLY | O_CLOEXEC);
+	if (i->link_loss_fd < 0) {
+		fst_mgr_printf(MSG_ERROR, "failed to open: %s", fname);
 		return -1;
+	}
 
-	if (snprintf(fname, sizeof(fname), "/sys/class/net/%s/device/wil6210/fst_link_loss",
-		     ifname) < 0)
-		return -1;
+	return 0;
+}
 
-	f = fopen(fname, "r+");
-	if (!f) {
-		fst_mgr_printf(MSG_ERROR, "failed to open: %s", fname);
-		return -1;
+static void _fst_mgr_iface_link_loss_close(struct fst_mgr_iface *i)
+{
+	if (i->link_loss_fd >= 0) {
+		close(i->link_loss_fd);
+		i->link_loss_fd = -1;
 	}
+}
 
-	if (fprintf(f, MACSTR " %d\n", MAC2STR(addr), fst_link_loss) < 0) {
-		fclose(f);
-		return -1;
+static int _fst_mgr_iface_link_loss_write(struct fst_mgr_iface *i,
+	const u8 *addr, Boolean enable)
+{
+	char buf[32];
+	int len, attempt;
+
+	len = os_snprintf(buf, sizeof(buf), MACSTR " %d\n", MAC2STR(addr),
+		enable ? 1 : 0);
+	for (attempt = 0; attempt < 2; attempt++) {
+		if (i->link_loss_fd < 0 && _fst_mgr_iface_link_loss_open(i))
+			return -1;
+		/* each write is parsed as a single entry by the driver */
+		if (pwrite(i->link_loss_fd, buf, len, 0) == len)
+			return 0;
+		/* the fd is stale if the netdev was re-created, so reopen it */
+		fst_mgr_printf(MSG_WARNING, "iface %s: fst link loss write failed: %s",
+			i->info.name, strerror(errno));
+		_fst_mgr_iface_link_loss_close(i);
 	}
-	fclose(f);
 
-	return 0;
+	return -1;
+}
+
+static void _fst_mgr_iface_link_loss_flush(void *eloop_data, void *user_ctx)
+{
+	struct fst_mgr_iface *i = eloop_data;
+	struct fst_mgr_link_loss *ll;
+
+	while ((ll = dl_list_first(&i->link_loss_pending,
+			struct fst_mgr_link_loss, lentry)) != NULL) {
+		if (_fst_mgr_iface_link_loss_write(i, ll->addr, ll->enable))
+			fst_mgr_printf(MSG_WARNING, "failed to set fst link loss %s",
+				       ll->enable ? "On" : "Off");
+		else {
+			fst_mgr_printf(MSG_INFO, "fst link loss %s for peer "
+				       MACSTR " iface %s",
+				       ll->enable ? "enabled" : "disabled",
+				       MAC2STR(ll->addr), i->info.name);
+			if (ll->switched_us)
+				_fst_mgr_switch_account(ll->stats,
+					FST_MGR_SWITCH_LINK_LOSS,
+					ll->switched_us);
+		}
+		dl_list_del(&ll->lentry);
+		os_free(ll);
+	}
+}
+
+static struct fst_mgr_link_loss *
+_fst_mgr_iface_link_loss_pending(struct fst_mgr_iface *i, const u8 *addr)
+{
+	struct fst_mgr_link_loss *ll;
+
+	dl_list_for_each(ll, &i->link_loss_pending, struct fst_mgr_link_loss,
+			 lentry)
+		if (!os_memcmp(ll->addr, addr, ETH_ALEN))
+			return ll;
+
+	return NULL;
+}
+
+/*
+ * Queues an fst link loss setting. All the settings queued during an event
+ * loop iteration are written together once it is over, and a peer toggled
+ * several times meanwhile is only written with its final setting.
+ */
+static void _fst_mgr_iface_queue_link_loss(struct fst_mgr_iface *i,
+	const u8 *addr, Boolean enable, struct fst_mgr_session *s)
+{
+	struct fst_mgr_link_loss *ll;
+
+	ll = _fst_mgr_iface_link_loss_pending(i, addr);
+	if (!ll) {
+		ll = os_zalloc(sizeof(*ll));
+		if (!ll) {
+			fst_mgr_printf(MSG_ERROR,
+				"Cannot queue fst link loss, writing it");
+			_fst_mgr_iface_link_loss_write(i, addr, enable);
+			return;
+		}
+		os_memcpy(ll->addr, addr, ETH_ALEN);
+		if (dl_list_empty(&i->link_loss_pending))
+			eloop_register_timeout(0, 0,
+				_fst_mgr_iface_link_loss_flush, i, NULL);
+		dl_list_add_tail(&i->link_loss_pending, &ll->lentry);
+	}
+
+	ll->enable = enable;
+	/* the write completes the switch, if there was one */
+	ll->switched_us = s->switch_done_us;
+	if (ll->switched_us) {
+		ll->stats[0] = &s->group->switch_stats;
+		ll->stats[1] = _fst_mgr_group_pair_stats(s->group, s->old_iface,
+			s->new_iface);
+	}
 }
 
 static void
 _fst_mgr_session_set_link_loss(struct fst_mgr_session *s, bool fst_link_loss)
 {
-	int ret;
 	struct fst_mgr_peer *p = NULL;
 	struct fst_mgr_peer_iface *pi;
 
@@ -387,19 +728,15 @@ _fst_mgr_session_set_link_loss(struct fst_mgr_session *s, bool fst_link_loss)
 		return;
 	}
 
+	if (p->link_loss != (fst_link_loss ? TRUE : FALSE)) {
+		p->link_loss = fst_link_loss ? TRUE : FALSE;
+		p->link_loss_toggles++;
+	}
+
 	_fst_peer_foreach_iface(p, pi) {
 		if (pi->iface == s->old_iface) {
-			ret = _fst_mgr_set_link_loss(s->old_iface->info.name,
-						     pi->addr, fst_link_loss);
-			if (ret < 0)
-				fst_mgr_printf(MSG_WARNING, "failed to set fst link loss %s",
-					       fst_link_loss ? "On" : "Off");
-			else
-				fst_mgr_printf(MSG_INFO, "fst link loss %s for peer "
-					       MACSTR " iface %s",
-					       fst_link_loss ? "enabled" : "disabled",
-					       MAC2STR(pi->addr),
-					       s->old_iface->info.name);
+			_fst_mgr_iface_queue_link_loss(s->old_iface, pi->addr,
+						       p->link_loss, s);
 			break;
 		}
 	}
@@ -416,9 +753,9 @@ static int _fst_mgr_session_respond(struct fst_mgr_session *s, Boolean accept)
 		return -1;
 	}
 
-	s->state = accept ?
+	_fst_mgr_session_set_state(s, accept ?
 			FST_MGR_SESSION_STATE_ESTABLISHED :
-			FST_MGR_SESSION_STATE_IDLE;
+			FST_MGR_SESSION_STATE_IDLE);
 
 	if (accept && s->llt > 0)
 		/*
@@ -431,15 +768,37 @@ static int _fst_mgr_session_respond(struct fst_mgr_session *s, Boolean accept)
 	return 0;
 }
 
+static void _fst_mgr_session_established(struct fst_mgr_session *s)
+{
+	_fst_mgr_session_set_state(s, FST_MGR_SESSION_STATE_ESTABLISHED);
+
+	if (s->llt > 0)
+		/*
+		 * at this point the active interface is the one with highest
+		 * priority and we have a backup interface. Set active interface
+		 * to aggressive link loss detection for fast switching to
+		 * backup once signal quality is low.
+		 */
+		_fst_mgr_session_set_link_loss(s, true);
+}
+
 static void _fst_mgr_session_reset(struct fst_mgr_session *s,
 	Boolean allow_tear_down)
 {
+	/*
+	 * A session reset while in progress or torn down can still produce
+	 * state change events from hostapd (e.g. teardown or STT), so it must
+	 * not be handed to another peer.
+	 */
+	s->dirty = _fst_mgr_session_is_in_progress(s);
 	if (!s->non_compliant && allow_tear_down && _fst_mgr_session_is_ready(s)) {
 		if (fst_session_teardown(s->id))
 			fst_mgr_printf(MSG_WARNING, "session %u: cannot reset", s->id);
+		else
+			s->dirty = TRUE;
 	}
 
-	s->state = FST_MGR_SESSION_STATE_IDLE;
+	_fst_mgr_session_set_state(s, FST_MGR_SESSION_STATE_IDLE);
 }
 
 static void _fst_mgr_session_deinit(struct fst_mgr_session *s)
@@ -453,8 +812,12 @@ static void _fst_mgr_session_deinit(struct fst_mgr_session *s)
 		_fst_mgr_session_set_link_loss(s, false);
 
 	dl_list_del(&s->grp_lentry);
-	fst_session_remove(s->id);
-	os_free(s);
+	if (s->state == FST_MGR_SESSION_STATE_INITIATED)
+		_fst_mgr_group_setup_kick(s->group);
+	if (!s->gone && (s->dirty || _fst_mgr_session_is_in_progress(s) ||
+	    _fst_mgr_group_pool_put(s->group, s->id)))
+		fst_session_remove(s->id);
+	fst_pool_free(&fst_mgr_session_pool, s);
 }
 
 static int _fst_mgr_session_init(struct fst_mgr_group *g,
@@ -463,21 +826,20 @@ static int _fst_mgr_session_init(struct fst_mgr_group *g,
 	struct fst_mgr_session *s;
 
 	if (session_id == FST_INVALID_SESSION_ID &&
+		_fst_mgr_group_pool_get(g, &session_id) &&
 		fst_session_add(g->info.id, &session_id)) {
 		fst_mgr_printf(MSG_ERROR, "group %s: cannot add session ",
 				g->info.id);
 		goto error_add;
 	}
 
-	s = os_malloc(sizeof(*s));
+	s = fst_pool_zalloc(&fst_mgr_session_pool);
 	if (!s) {
 		fst_mgr_printf(MSG_ERROR, "group %s: cannot allocate session ",
 				g->info.id);
 		goto error_alloc;
 	}
 
-	os_memset(s, 0, sizeof(*s));
-
 	s->state = FST_MGR_SESSION_STATE_IDLE;
 	s->group = g;
 	s->id    = session_id;
@@ -499,6 +861,86 @@ error_add:
 
 }
 
+/*
+ * FST Manager Session Pool
+ *
+ * Every group keeps up to fst_session_pool_size sessions created in hostapd
+ * in advance. Sessions are taken from the pool when a peer needs one and are
+ * returned to it on deinit if hostapd is known to hold them in the initial
+ * state, so the switch -> next setup cycle does not need to add and remove
+ * a session. The pool is refilled from an eloop timeout while no setups are
+ * in progress.
+ */
+static unsigned int
+_fst_mgr_group_setups_in_progress(struct fst_mgr_group *g);
+
+static void _fst_mgr_group_pool_refill(void *eloop_data, void *user_ctx)
+{
+	struct fst_mgr_group *g = eloop_data;
+	u32 session_id;
+
+	if (g->pool_count >= fst_session_pool_size)
+		return;
+
+	if (!_fst_mgr_group_setups_in_progress(g)) {
+		if (fst_session_add(g->info.id, &session_id)) {
+			fst_mgr_printf(MSG_WARNING,
+				"group %s: cannot add pool session", g->info.id);
+			return;
+		}
+		g->pool[g->pool_count++] = session_id;
+		fst_mgr_printf(MSG_DEBUG, "group %s: session %u pooled (%u/%u)",
+			g->info.id, session_id, g->pool_count,
+			fst_session_pool_size);
+	}
+
+	if (g->pool_count < fst_session_pool_size)
+		eloop_register_timeout(0, FST_MGR_POOL_REFILL_INTERVAL_MS * 1000,
+			_fst_mgr_group_pool_refill, g, NULL);
+}
+
+static void _fst_mgr_group_pool_schedule_refill(struct fst_mgr_group *g)
+{
+	if (g->pool && g->pool_count < fst_session_pool_size &&
+	    !eloop_is_timeout_registered(_fst_mgr_group_pool_refill, g, NULL))
+		eloop_register_timeout(0, FST_MGR_POOL_REFILL_INTERVAL_MS * 1000,
+			_fst_mgr_group_pool_refill, g, NULL);
+}
+
+static int _fst_mgr_group_pool_get(struct fst_mgr_group *g, u32 *session_id)
+{
+	if (!g->pool_count) {
+		if (g->pool)
+			g->stats.pool_misses++;
+		return -1;
+	}
+
+	*session_id = g->pool[--g->pool_count];
+	g->stats.pool_hits++;
+	_fst_mgr_group_pool_schedule_refill(g);
+	return 0;
+}
+
+static int _fst_mgr_group_pool_put(struct fst_mgr_group *g, u32 session_id)
+{
+	if (!g->pool || g->pool_count >= fst_session_pool_size)
+		return -1;
+
+	g->pool[g->pool_count++] = session_id;
+	fst_mgr_printf(MSG_DEBUG, "group %s: session %u returned to pool",
+		g->info.id, session_id);
+	return 0;
+}
+
+static void _fst_mgr_group_pool_drain(struct fst_mgr_group *g)
+{
+	eloop_cancel_timeout(_fst_mgr_group_pool_refill, g, NULL);
+	while (g->pool_count)
+		fst_session_remove(g->pool[--g->pool_count]);
+	os_free(g->pool);
+	g->pool = NULL;
+}
+
 /*
  * FST Manager Peer
  */
@@ -530,6 +972,61 @@ static const u8 *_fst_mgr_peer_get_addr_of_iface(struct fst_mgr_peer *p,
 	return NULL;
 }
 
+/* refreshes the record of the peer on the status page */
+static void _fst_mgr_peer_publish(struct fst_mgr_peer *p)
+{
+	struct fst_status_peer *r = fst_status_peer_begin(p->status);
+	struct fst_mgr_peer_iface *pi;
+	unsigned int n = 0;
+
+	if (!r)
+		return;
+
+	r->active = FST_STATUS_NO_IFACE;
+	_fst_peer_foreach_iface(p, pi) {
+		if (n == FST_STATUS_MAX_IFACES)
+			break;
+		if (pi->iface == p->active_iface)
+			r->active = n;
+		os_strlcpy(r->ifaces[n].name, pi->iface->info.name,
+			sizeof(r->ifaces[n].name));
+		os_memcpy(r->ifaces[n].addr, pi->addr, ETH_ALEN);
+		n++;
+	}
+	os_memset(&r->ifaces[n], 0,
+		(FST_STATUS_MAX_IFACES - n) * sizeof(r->ifaces[0]));
+	r->ifaces_num = n;
+	/* the status states are in the order of the manager ones */
+	r->session_state = p->session ? p->session->state :
+		FST_STATUS_SESSION_NONE;
+	r->session_id = p->session ? p->session->id : FST_INVALID_SESSION_ID;
+	r->switches = p->switches;
+	r->switch_us = p->switch_us;
+	fst_status_peer_end(r);
+}
+
+static void _fst_mgr_session_publish(struct fst_mgr_session *s)
+{
+	struct fst_mgr_peer *p = _fst_mgr_group_peer_by_session(s->group, s);
+
+	if (p)
+		_fst_mgr_peer_publish(p);
+}
+
+/* the mux sends the peer's traffic via i now */
+static void _fst_mgr_peer_set_mapped(struct fst_mgr_peer *p,
+		struct fst_mgr_iface *i)
+{
+	p->active_iface = i;
+	if (p->mapped_ifid != i->ifid) {
+		p->switches++;
+		/* not _fst_mgr_now_us(), readers compare with CLOCK_MONOTONIC */
+		p->switch_us = fst_trace_now() / 1000;
+		p->mapped_ifid = i->ifid;
+	}
+	_fst_mgr_peer_publish(p);
+}
+
 static int _fst_mgr_peer_set_active_iface(struct fst_mgr_peer *p,
 		struct fst_mgr_iface *i,
 		struct fst_mux *drv)
@@ -555,26 +1052,31 @@ static int _fst_mgr_peer_set_active_iface(struct fst_mgr_peer *p,
 	}
 
 	if (!i)
-		return 0;
+		goto out;
 
 	const u8 *addr = _fst_mgr_peer_get_addr_of_iface(p, i);
 	if (!addr) {
 		fst_mgr_printf(MSG_ERROR, "Peer is not connected via %s",
 			i->info.name);
-		return -1;
+		res = -1;
+		goto out;
 	}
 
-	res = fst_mux_add_map_entry(drv, addr, i->info.name);
-	if (!res) {
-		/* Set iface as an active */
-		p->active_iface = i;
-		fst_mgr_printf(MSG_INFO,
-			"Map entry added: " MACSTR " via %s",
-			MAC2STR(addr), i->info.name);
-	} else
+	res = fst_mux_add_map_entry(drv, addr, i->ifid);
+	if (res) {
 		fst_mgr_printf(MSG_ERROR,
 			"Cannot add map entry: " MACSTR " via %s",
 			MAC2STR(addr), i->info.name);
+		goto out;
+	}
+
+	fst_mgr_printf(MSG_INFO, "Map entry added: " MACSTR " via %s",
+		MAC2STR(addr), i->info.name);
+	_fst_mgr_peer_set_mapped(p, i);
+	return 0;
+
+out:
+	_fst_mgr_peer_publish(p);
 	return res;
 }
 
@@ -599,31 +1101,358 @@ _fst_mgr_peer_get_next_iface(struct fst_mgr_peer *p)
 	return i;
 }
 
-static void _fst_mgr_peer_try_to_initiate_next_setup(struct fst_mgr_peer *p,
+/*
+ * A band loss shows up as a burst of disconnects on the iface, so the carrier
+ * is only probed once FST_MGR_LINK_PROBE_DISCONNECTS of them arrive within
+ * FST_MGR_LINK_PROBE_WINDOW_MS. Ordinary disconnects make no syscalls.
+ */
+static Boolean _fst_mgr_iface_disconnect_burst(struct fst_mgr_iface *i)
+{
+	u64 now_us = _fst_mgr_now_us();
+
+	if (now_us - i->disconnects_since_us >
+	    FST_MGR_LINK_PROBE_WINDOW_MS * 1000ULL) {
+		i->disconnects_since_us = now_us;
+		i->disconnects = 0;
+	}
+	if (++i->disconnects < FST_MGR_LINK_PROBE_DISCONNECTS)
+		return FALSE;
+	i->disconnects = 0;
+	return TRUE;
+}
+
+/* Returns TRUE if the iface has no carrier or is administratively down */
+static Boolean _fst_mgr_iface_is_link_down(struct fst_mgr_iface *i)
+{
+	struct ifreq ifr;
+	int sock, res;
+
+	sock = socket(AF_INET, SOCK_DGRAM, 0);
+	if (sock < 0) {
+		fst_mgr_printf(MSG_ERROR, "Cannot open socket: %s",
+			strerror(errno));
+		return FALSE;
+	}
+
+	os_memset(&ifr, 0, sizeof(ifr));
+	os_strlcpy(ifr.ifr_name, i->info.name, IFNAMSIZ);
+	res = ioctl(sock, SIOCGIFFLAGS, &ifr);
+	if (res < 0) {
+		int err = errno;
+
+		fst_mgr_printf(MSG_WARNING, "SIOCGIFFLAGS failed on %s: %s",
+			i->info.name, strerror(err));
+		/* the netdev is gone altogether */
+		res = (err == ENODEV);
+	} else
+		res = !(ifr.ifr_flags & IFF_UP) || !(ifr.ifr_flags & IFF_RUNNING);
+	close(sock);
+
+	return res ? TRUE : FALSE;
+}
+
+/*
+ * Moves all the peers mapped to a lost iface to their next iface with a
+ * single batch of mux operations, without waiting for the per-peer
+ * disconnect events. The per-peer session handling still runs as each
+ * disconnect arrives and finds the peer already remapped.
+ */
+static void _fst_mgr_group_iface_failover(struct fst_mgr_group *g,
+	struct fst_mgr_iface *i)
+{
+	struct fst_mgr_failover_move {
+		struct fst_mgr_peer  *peer;
+		struct fst_mgr_iface *iface;
+	} *moves = NULL;
+	struct fst_mux_map_entry *entries = NULL;
+	struct fst_mgr_peer *p;
+	struct os_reltime start, end, diff;
+	int n = 0, peers = 0, k, failed;
+
+	_fst_grp_foreach_peer(g, p)
+		if (p->active_iface == i)
+			peers++;
+	if (!peers)
+		return;
+
+	/* every peer may need its old entry removed and a new one added */
+	entries = os_calloc(peers * 2, sizeof(*entries));
+	moves = os_calloc(peers, sizeof(*moves));
+	if (!entries || !moves) {
+		fst_mgr_printf(MSG_ERROR, "group %s: cannot allocate failover batch",
+			g->info.id);
+		goto out;
+	}
+
+	os_get_reltime(&start);
+	peers = 0;
+	_fst_grp_foreach_peer(g, p) {
+		struct fst_mgr_iface *new_i;
+		const u8 *old_addr, *new_addr;
+
+		if (p->active_iface != i)
+			continue;
+		if (p->session && _fst_mgr_session_is_ready(p->session) &&
+		    p->session->old_iface == i)
+			new_i = p->session->new_iface;
+		else
+			new_i = _fst_mgr_peer_get_next_iface(p);
+		new_addr = new_i ? _fst_mgr_peer_get_addr_of_iface(p, new_i) : NULL;
+		if (!new_addr)
+			continue;
+		old_addr = _fst_mgr_peer_get_addr_of_iface(p, i);
+		if (old_addr && os_memcmp(old_addr, new_addr, ETH_ALEN)) {
+			entries[n].da = old_addr;
+			entries[n++].ifid = FST_IFREG_NONE;
+		}
+		entries[n].da = new_addr;
+		entries[n++].ifid = new_i->ifid;
+		moves[peers].peer = p;
+		moves[peers++].iface = new_i;
+	}
+
+	/*
+	 * The batch does not tell which entries failed, so after a failure
+	 * every peer is remapped on its own and keeps whatever that leaves
+	 */
+	failed = fst_mux_set_map_entries(g->drv, entries, n);
+	for (k = 0; k < peers; k++) {
+		if (!failed)
+			_fst_mgr_peer_set_mapped(moves[k].peer, moves[k].iface);
+		else
+			_fst_mgr_peer_set_active_iface(moves[k].peer,
+				moves[k].iface, g->drv);
+	}
+
+	os_get_reltime(&end);
+	os_reltime_sub(&end, &start, &diff);
+
+	g->stats.bulk_failovers++;
+	g->stats.bulk_failover_peers += peers;
+	g->stats.bulk_failover_last_us = diff.sec * 1000000 + diff.usec;
+	fst_mgr_printf(MSG_INFO, "group %s: iface %s is down, %d peers remapped "
+		"in %u us (%d mux errors)", g->info.id, i->info.name, peers,
+		g->stats.bulk_failover_last_us, failed);
+
+out:
+	os_free(moves);
+	os_free(entries);
+}
+
+static unsigned int
+_fst_mgr_group_setups_in_progress(struct fst_mgr_group *g)
+{
+	struct fst_mgr_session *s;
+	unsigned int n = 0;
+
+	_fst_grp_foreach_session(g, s)
+		if (s->state == FST_MGR_SESSION_STATE_INITIATED)
+			n++;
+
+	return n;
+}
+
+/*
+ * Setup admission. After an association storm many peers are ready for a
+ * setup at once. A setup is admitted while fewer than
+ * fst_max_concurrent_setups are in progress and a token is left in a bucket
+ * of fst_setup_burst tokens refilled at fst_setup_rate per second; the other
+ * peers wait in the group queue, those gaining the most priority from the
+ * setup first, and are dispatched as setups complete and tokens come back.
+ * The bucket is kept as the time it is full again, every token taken pushes
+ * it by one refill interval. A token taken for a setup that is not issued
+ * after all (deferred, no backup iface, configuration failed) is given back.
+ */
+static void _fst_mgr_group_setup_dispatch(void *eloop_data, void *user_ctx);
+
+static void _fst_mgr_group_setup_kick(struct fst_mgr_group *g)
+{
+	if (!dl_list_empty(&g->setup_queue) &&
+	    !eloop_is_timeout_registered(_fst_mgr_group_setup_dispatch, g, NULL))
+		eloop_register_timeout(0, 0, _fst_mgr_group_setup_dispatch, g,
+			NULL);
+}
+
+/* takes a setup slot and a token, or arranges a dispatch once they are back */
+static Boolean _fst_mgr_group_setup_take(struct fst_mgr_group *g)
+{
+	unsigned int burst = fst_setup_burst ? fst_setup_burst : 1;
+	u64 now_us, interval_us, wait_us;
+
+	/* the queue is kicked when a setup completes */
+	if (fst_max_concurrent_setups &&
+	    _fst_mgr_group_setups_in_progress(g) >= fst_max_concurrent_setups)
+		return FALSE;
+
+	if (!fst_setup_rate)
+		return TRUE;
+
+	now_us = _fst_mgr_now_us();
+	interval_us = 1000000 / fst_setup_rate;
+	if (g->setup_full_us < now_us)
+		g->setup_full_us = now_us;
+	if (g->setup_full_us - now_us > (burst - 1) * interval_us) {
+		wait_us = g->setup_full_us - now_us - (burst - 1) * interval_us;
+		if (!eloop_is_timeout_registered(_fst_mgr_group_setup_dispatch,
+						 g, NULL))
+			eloop_register_timeout(wait_us / 1000000,
+				wait_us % 1000000,
+				_fst_mgr_group_setup_dispatch, g, NULL);
+		return FALSE;
+	}
+	g->setup_full_us += interval_us;
+	return TRUE;
+}
+
+static void _fst_mgr_group_setup_refund(struct fst_mgr_group *g)
+{
+	u64 interval_us;
+
+	if (!fst_setup_rate)
+		return;
+
+	interval_us = 1000000 / fst_setup_rate;
+	if (g->setup_full_us >= interval_us)
+		g->setup_full_us -= interval_us;
+}
+
+static void _fst_mgr_group_setup_enqueue(struct fst_mgr_group *g,
+	struct fst_mgr_peer *p, int prio)
+{
+	struct fst_mgr_peer *q;
+	unsigned int queued;
+
+	if (p->setup_queued)
+		return;
+
+	p->setup_prio = prio;
+	p->queued_us = _fst_mgr_now_us();
+	/* behind the peers of the same priority */
+	dl_list_for_each(q, &g->setup_queue, struct fst_mgr_peer, setup_lentry)
+		if (q->setup_prio < prio)
+			break;
+	dl_list_add_tail(&q->setup_lentry, &p->setup_lentry);
+	p->setup_queued = TRUE;
+
+	queued = dl_list_len(&g->setup_queue);
+	if (queued > g->stats.setup_queue_high_water)
+		g->stats.setup_queue_high_water = queued;
+	g->stats.setups_deferred++;
+	fst_mgr_printf(MSG_INFO, "peer %p: setup queued (%u waiting)", p,
+		queued);
+}
+
+static void _fst_mgr_peer_setup_dequeue(struct fst_mgr_peer *p)
+{
+	if (p->setup_queued) {
+		dl_list_del(&p->setup_lentry);
+		p->setup_queued = FALSE;
+	}
+}
+
+static Boolean _fst_mgr_peer_setup_admit(struct fst_mgr_peer *p,
+	struct fst_mgr_group *g, struct fst_mgr_iface *new_i)
+{
+	if (p->setup_admitted)
+		return TRUE;
+
+	/* no overtaking the peers already waiting */
+	if (!p->setup_queued && dl_list_empty(&g->setup_queue) &&
+	    _fst_mgr_group_setup_take(g))
+		return TRUE;
+
+	_fst_mgr_group_setup_enqueue(g, p, (int)new_i->info.priority -
+		(int)p->active_iface->info.priority);
+	return FALSE;
+}
+
+static void _fst_mgr_group_setup_dispatch(void *eloop_data, void *user_ctx)
+{
+	struct fst_mgr_group *g = eloop_data;
+	struct fst_mgr_peer *p;
+
+	while (!dl_list_empty(&g->setup_queue) && _fst_mgr_group_setup_take(g)) {
+		p = dl_list_first(&g->setup_queue, struct fst_mgr_peer,
+			setup_lentry);
+		_fst_mgr_peer_setup_dequeue(p);
+		fst_hist_add(&g->setup_wait, _fst_mgr_now_us() - p->queued_us);
+
+		p->setup_admitted = TRUE;
+		if (!_fst_mgr_peer_try_to_initiate_next_setup(p, g))
+			_fst_mgr_group_setup_refund(g);
+		p->setup_admitted = FALSE;
+	}
+}
+
+/*
+ * Schedules the next setup attempt of the peer after an exponential backoff
+ * with jitter, based on the number of consecutive failures. The delay is
+ * randomized within [delay/2, delay] so that peers failing together do not
+ * retry together.
+ */
+static void _fst_mgr_peer_schedule_retry(struct fst_mgr_peer *p,
 	struct fst_mgr_group *g)
+{
+	unsigned int delay_ms = fst_retry_backoff_ms;
+	unsigned int i;
+
+	for (i = 1; i < p->retries && delay_ms < FST_MGR_RETRY_BACKOFF_MAX_MS;
+	     i++)
+		delay_ms *= 2;
+	if (delay_ms > FST_MGR_RETRY_BACKOFF_MAX_MS)
+		delay_ms = FST_MGR_RETRY_BACKOFF_MAX_MS;
+	if (delay_ms > 1)
+		delay_ms -= os_random() % (delay_ms / 2 + 1);
+
+	eloop_cancel_timeout(_fst_mgr_peer_retry_timeout, g, p);
+	eloop_register_timeout(delay_ms / 1000, (delay_ms % 1000) * 1000,
+		_fst_mgr_peer_retry_timeout, g, p);
+	fst_mgr_printf(MSG_DEBUG, "peer %p: next setup attempt in %u ms",
+		p, delay_ms);
+}
+
+/* returns TRUE if a setup was initiated */
+static Boolean _fst_mgr_peer_try_to_initiate_next_setup(
+	struct fst_mgr_peer *p, struct fst_mgr_group *g)
 {
 	struct fst_mgr_iface *new_i;
+	Boolean own_token = FALSE;
 	u32 llt;
 
 	if (p->session && _fst_mgr_session_is_in_progress(p->session)) {
 		fst_mgr_printf(MSG_WARNING,
 			"peer %p: Cannot initiate next setup: "
 			"another session is in progress", p);
-		return;
+		return FALSE;
 	}
 
 	if (!p->active_iface) {
 		fst_mgr_printf(MSG_WARNING,
 			"peer %p: Cannot initiate next setup: "
 			"no active iface", p);
-		return;
+		return FALSE;
 	}
 
-	if (!p->session &&
-		_fst_mgr_session_init(g, &p->session, FST_INVALID_SESSION_ID)) {
-		fst_mgr_printf(MSG_ERROR, "group %s: cannot initialize session with peer %p",
-				g->info.id, p);
-		return;
+	/* an idle peer does not need the other band yet */
+	if (fst_lazy_setup_rate && !g->lazy_blind && !p->tx_active) {
+		if (!p->lazy_waiting && _fst_mgr_peer_get_next_iface(p)) {
+			fst_mgr_printf(MSG_DEBUG,
+				"peer %p: setup deferred until it is active", p);
+			p->lazy_waiting = TRUE;
+			g->stats.lazy_deferrals++;
+		}
+		return FALSE;
+	}
+	p->lazy_waiting = FALSE;
+
+	if (!p->session) {
+		if (_fst_mgr_session_init(g, &p->session,
+				FST_INVALID_SESSION_ID)) {
+			fst_mgr_printf(MSG_ERROR, "group %s: cannot initialize session with peer %p",
+					g->info.id, p);
+			return FALSE;
+		}
+		_fst_mgr_peer_publish(p);
 	}
 
 	new_i = _fst_mgr_peer_get_next_iface(p);
@@ -631,10 +1460,17 @@ static void _fst_mgr_peer_try_to_initiate_next_setup(struct fst_mgr_peer *p,
 		fst_mgr_printf(MSG_WARNING,
 			"peer %p: Cannot initiate next setup: "
 			"no backup iface connected", p);
-		return;
+		return FALSE;
 	}
 
 	_fst_mgr_peer_check_compliance(p);
+	if (!p->session->non_compliant) {
+		if (!_fst_mgr_peer_setup_admit(p, g, new_i))
+			return FALSE;
+		/* a dispatched peer runs on the dispatcher's token */
+		own_token = !p->setup_admitted;
+	}
+
 	llt = MS_TO_LLT_VALUE(new_i->info.llt);
 	if (p->active_iface &&
 		p->active_iface->info.priority < new_i->info.priority) {
@@ -648,17 +1484,37 @@ static void _fst_mgr_peer_try_to_initiate_next_setup(struct fst_mgr_peer *p,
 		fst_mgr_printf(MSG_WARNING,
 			"peer %p: Cannot initiate next setup: "
 			"session %u configuration failed", p, p->session->id);
-		return;
+		goto refund;
 	}
 
-	if (!p->session->non_compliant) {
-		fst_mgr_printf(MSG_INFO,
-			"peer %p: session %u: initiating setup: "
-			"old_iface=%s new_iface=%s llt=%d",
-			p, p->session->id,
-			p->active_iface->info.name, new_i->info.name, llt);
-		_fst_mgr_session_initiate_setup(p->session);
-	}
+	if (p->session->non_compliant)
+		return FALSE;
+
+	fst_mgr_printf(MSG_INFO,
+		"peer %p: session %u: initiating setup: "
+		"old_iface=%s new_iface=%s llt=%d",
+		p, p->session->id,
+		p->active_iface->info.name, new_i->info.name, llt);
+	eloop_cancel_timeout(_fst_mgr_peer_retry_timeout, g, p);
+	if (_fst_mgr_session_initiate_setup(p->session))
+		goto refund;
+	g->stats.setups_initiated++;
+	return TRUE;
+
+refund:
+	if (own_token)
+		_fst_mgr_group_setup_refund(g);
+	return FALSE;
+}
+
+static void _fst_mgr_peer_retry_timeout(void *eloop_data, void *user_ctx)
+{
+	struct fst_mgr_group *g = eloop_data;
+	struct fst_mgr_peer  *p = user_ctx;
+
+	fst_mgr_printf(MSG_INFO, "peer %p: retrying setup (retry %u)",
+		p, p->retries);
+	_fst_mgr_peer_try_to_initiate_next_setup(p, g);
 }
 
 static void _fst_mgr_peer_check_compliance(struct fst_mgr_peer *p)
@@ -691,7 +1547,9 @@ static void _fst_mgr_peer_check_compliance(struct fst_mgr_peer *p)
 static Boolean _fst_mgr_peer_add_iface(struct fst_mgr_peer *p,
 		struct fst_mgr_iface *i, const u8 *addr)
 {
-	struct fst_mgr_peer_iface *pi = os_zalloc(sizeof(*pi));
+	struct fst_mgr_peer_iface *pi;
+
+	pi = fst_pool_zalloc(&fst_mgr_peer_iface_pool);
 	if (!pi)
 		return FALSE;
 
@@ -699,6 +1557,7 @@ static Boolean _fst_mgr_peer_add_iface(struct fst_mgr_peer *p,
 	os_memcpy(pi->addr, addr, ETH_ALEN);
 
 	dl_list_add_tail(&p->ifaces, &pi->peer_lentry);
+	_fst_mgr_peer_publish(p);
 
 	return TRUE;
 }
@@ -710,7 +1569,8 @@ static void _fst_mgr_peer_del_iface(struct fst_mgr_peer *p,
 	dl_list_for_each(pi, &p->ifaces, struct fst_mgr_peer_iface, peer_lentry)
 		if (pi->iface == i) {
 			dl_list_del(&pi->peer_lentry);
-			os_free(pi);
+			fst_pool_free(&fst_mgr_peer_iface_pool, pi);
+			_fst_mgr_peer_publish(p);
 			break;
 		}
 }
@@ -722,21 +1582,25 @@ static void _fst_mgr_peer_session_deinit(struct fst_mgr_peer *p,
 		_fst_mgr_session_reset(p->session, allow_tear_down);
 		_fst_mgr_session_deinit(p->session);
 		p->session = NULL;
+		_fst_mgr_peer_publish(p);
 	}
 }
 
 static void _fst_mgr_peer_deinit(struct fst_mgr_peer *p)
 {
+	eloop_cancel_timeout(_fst_mgr_peer_retry_timeout, ELOOP_ALL_CTX, p);
+	_fst_mgr_peer_setup_dequeue(p);
 	dl_list_del(&p->grp_lentry);
 	while (!dl_list_empty(&p->ifaces)) {
 		struct fst_mgr_peer_iface *pi = dl_list_first(&p->ifaces,
 				struct fst_mgr_peer_iface, peer_lentry);
 		dl_list_del(&pi->peer_lentry);
-		os_free(pi);
+		fst_pool_free(&fst_mgr_peer_iface_pool, pi);
 	}
 	if (p->session)
 		_fst_mgr_session_deinit(p->session);
-	os_free(p);
+	fst_status_peer_free(p->status);
+	fst_pool_free(&fst_mgr_peer_pool, p);
 }
 
 static int _fst_mgr_peer_init(struct fst_mgr_group *g, const u8 *addr,
@@ -751,19 +1615,19 @@ static int _fst_mgr_peer_init(struct fst_mgr_group *g, const u8 *addr,
 		goto error_session_init;
 	}
 
-	p = os_malloc(sizeof(*p));
+	p = fst_pool_zalloc(&fst_mgr_peer_pool);
 	if (!p) {
 		fst_mgr_printf(MSG_ERROR, "group %s: cannot allocate peer " MACSTR,
 				g->info.id, MAC2STR(addr));
 		goto error_alloc;
 	}
 
-	os_memset(p, 0, sizeof(*p));
-
 	dl_list_init(&p->ifaces);
 
 	p->active_iface  = i;
 	p->session       = s;
+	p->mapped_ifid   = i->ifid;
+	p->status        = fst_status_peer_alloc(g->info.id);
 
 	dl_list_add_tail(&g->peers, &p->grp_lentry);
 
@@ -779,7 +1643,9 @@ static int _fst_mgr_peer_init(struct fst_mgr_group *g, const u8 *addr,
 	return 0;
 
 error_add_iface:
-	os_free(p);
+	dl_list_del(&p->grp_lentry);
+	fst_status_peer_free(p->status);
+	fst_pool_free(&fst_mgr_peer_pool, p);
 error_alloc:
 	_fst_mgr_session_deinit(s);
 error_session_init:
@@ -791,9 +1657,13 @@ error_session_init:
  */
 static void _fst_mgr_iface_deinit(struct fst_mgr_iface *i, struct fst_mux *drv)
 {
+	eloop_cancel_timeout(_fst_mgr_iface_link_loss_flush, i, NULL);
+	_fst_mgr_iface_link_loss_flush(i, NULL);
+	_fst_mgr_iface_link_loss_close(i);
 	dl_list_del(&i->grp_lentry);
 	fst_mux_unregister_iface(drv, i->info.name);
 	fst_cfgmgr_on_iface_deinit(&i->info);
+	fst_ifreg_put(i->ifid);
 	os_free(i);
 }
 
@@ -823,11 +1693,19 @@ static int _fst_mgr_iface_init(struct fst_mgr_group *g,
 
 	os_memset(i, 0, sizeof(*i));
 
+	i->ifid = fst_ifreg_get(finfo->name);
+	if (i->ifid == FST_IFREG_NONE)
+		goto error_ifreg;
+
 	i->info = *finfo;
+	i->link_loss_fd = -1;
+	dl_list_init(&i->link_loss_pending);
 	dl_list_add_tail(&g->ifaces, &i->grp_lentry);
 
 	return 0;
 
+error_ifreg:
+	os_free(i);
 error_alloc:
 	fst_mux_unregister_iface(drv, finfo->name);
 error_slave:
@@ -876,23 +1754,21 @@ const u8 *fst_mgr_get_addr_from_mbie(struct multi_band_ie *mbie)
 	return addr;
 }
 
-static Boolean _fst_mgr_is_other_addr_in_mbies(struct fst_iface_info *info,
-					const u8 *addr, const u8 *other_addr)
+/* looks for other_addr in the MB IEs hostapd reports as a hex string */
+static Boolean _fst_mgr_mbies_has_addr(const char *str_mbies,
+				       int str_mbies_size, const u8 *other_addr)
 {
-	char *str_mbies = NULL;
-	int str_mbies_size;
-	u8 *mbies = NULL, *mbies_iter;
+	u8 *mbies, *mbies_iter;
 	int mbies_size;
 	Boolean result = FALSE;
 
-	str_mbies_size = fst_get_peer_mbies(info->name, addr, &str_mbies);
 	if (str_mbies_size < 2 || str_mbies_size & 1)
-		goto finish;
+		return FALSE;
 
 	mbies_size = str_mbies_size / 2;
 	mbies = os_malloc(mbies_size);
 	if (!mbies)
-		goto finish;
+		return FALSE;
 	if (hexstr2bin(str_mbies, mbies, mbies_size))
 		goto finish;
 
@@ -915,17 +1791,29 @@ static Boolean _fst_mgr_is_other_addr_in_mbies(struct fst_iface_info *info,
 		mbies_size -= mbie->len + 2;
 	}
 finish:
+	os_free(mbies);
+	return result;
+}
+
+static Boolean _fst_mgr_is_other_addr_in_mbies(struct fst_iface_info *info,
+					const u8 *addr, const u8 *other_addr)
+{
+	char *str_mbies = NULL;
+	int str_mbies_size;
+	Boolean result;
+
+	str_mbies_size = fst_get_peer_mbies(info->name, addr, &str_mbies);
+	result = _fst_mgr_mbies_has_addr(str_mbies, str_mbies_size,
+					 other_addr);
 	if (str_mbies)
 		os_free(str_mbies);
-	if (mbies)
-		os_free(mbies);
 	return result;
 }
 
 static struct fst_mgr_peer *
 _fst_mgr_group_peer_by_other_addr(struct fst_mgr_group *g,
 				  const u8 *other_addr,
-				  struct fst_iface_info *other_iface_info)
+				  struct fst_mgr_iface *other_iface)
 {
 	struct fst_mgr_peer *p;
 
@@ -937,13 +1825,11 @@ _fst_mgr_group_peer_by_other_addr(struct fst_mgr_group *g,
 	_fst_grp_foreach_peer(g, p) {
 		struct fst_mgr_peer_iface *pi;
 		_fst_peer_foreach_iface(p, pi) {
-			if (os_strncmp(pi->iface->info.name,
-				       other_iface_info->name,
-				       FST_MAX_INTERFACE_SIZE) &&
+			if (pi->iface != other_iface &&
 			    (_fst_mgr_is_other_addr_in_mbies(
 				&pi->iface->info, pi->addr, other_addr) ||
 			     _fst_mgr_is_other_addr_in_mbies(
-				other_iface_info, other_addr, pi->addr)))
+				&other_iface->info, other_addr, pi->addr)))
 				return p;
 		}
 	}
@@ -951,7 +1837,7 @@ _fst_mgr_group_peer_by_other_addr(struct fst_mgr_group *g,
 }
 
 static Boolean _fst_mgr_is_peer_connected(struct fst_mgr_group *g,
-					const char *ifname,
+					const struct fst_mgr_iface *i,
 					const u8 *addr)
 {
 	struct fst_mgr_peer *p = NULL;
@@ -959,8 +1845,8 @@ static Boolean _fst_mgr_is_peer_connected(struct fst_mgr_group *g,
 	_fst_grp_foreach_peer(g, p) {
 		struct fst_mgr_peer_iface *pi;
 		_fst_peer_foreach_iface(p, pi) {
-			if (!os_strncmp(pi->iface->info.name, ifname, FST_MAX_INTERFACE_SIZE) &&
-				!os_memcmp(pi->addr, addr, ETH_ALEN))
+			if (pi->iface == i &&
+			    !os_memcmp(pi->addr, addr, ETH_ALEN))
 				return TRUE;
 
 		}
@@ -968,6 +1854,77 @@ static Boolean _fst_mgr_is_peer_connected(struct fst_mgr_group *g,
 	return FALSE;
 }
 
+/*
+ * Lazy setup: the TX counters of the mux are read every
+ * FST_MGR_LAZY_POLL_INTERVAL_MS and the setups of peers sent less than
+ * fst_lazy_setup_rate bytes/s wait until they catch up. Sessions already set
+ * up are kept when their peer goes idle.
+ */
+static void _fst_mgr_group_on_peer_bytes(const u8 *da, u64 bytes, void *cb_ctx)
+{
+	struct fst_mgr_group *g = cb_ctx;
+	struct fst_mgr_peer *p = _fst_mgr_group_peer_by_addr(g, da);
+	u64 elapsed_us;
+
+	if (!p)
+		return;
+
+	/* a remapped destination counts from zero, take a new baseline */
+	if (p->tx_sampled_us && p->tx_ifid == p->mapped_ifid &&
+	    bytes >= p->tx_bytes) {
+		elapsed_us = g->lazy_poll_us - p->tx_sampled_us;
+		if (elapsed_us)
+			p->tx_active = (bytes - p->tx_bytes) * 1000000 /
+				elapsed_us >= fst_lazy_setup_rate;
+	}
+	p->tx_ifid = p->mapped_ifid;
+	p->tx_bytes = bytes;
+	p->tx_sampled_us = g->lazy_poll_us;
+}
+
+static void _fst_mgr_group_lazy_poll(void *eloop_data, void *user_ctx)
+{
+	struct fst_mgr_group *g = eloop_data;
+	struct fst_mgr_peer *p;
+
+	g->lazy_poll_us = _fst_mgr_now_us();
+	if (fst_mux_get_map_bytes(g->drv, _fst_mgr_group_on_peer_bytes, g)) {
+		if (!g->lazy_blind)
+			fst_mgr_printf(MSG_WARNING, "group %s: cannot read "
+				"peer traffic, setting up all peers",
+				g->info.id);
+		g->lazy_blind = TRUE;
+	} else {
+		g->lazy_blind = FALSE;
+		/* not in the dump, e.g. unmapped: the peer sends nothing */
+		_fst_grp_foreach_peer(g, p) {
+			if (p->tx_sampled_us == g->lazy_poll_us)
+				continue;
+			p->tx_active = FALSE;
+			p->tx_sampled_us = 0;
+		}
+	}
+
+	_fst_grp_foreach_peer(g, p) {
+		if (!p->lazy_waiting)
+			continue;
+		if (p->session && _fst_mgr_session_is_in_progress(p->session)) {
+			p->lazy_waiting = FALSE; /* the peer initiated it */
+			continue;
+		}
+		if (!p->tx_active && !g->lazy_blind)
+			continue;
+		fst_mgr_printf(MSG_INFO, "peer %p: active, initiating setup",
+			p);
+		g->stats.lazy_activations++;
+		_fst_mgr_peer_try_to_initiate_next_setup(p, g);
+	}
+
+	eloop_register_timeout(FST_MGR_LAZY_POLL_INTERVAL_MS / 1000,
+		(FST_MGR_LAZY_POLL_INTERVAL_MS % 1000) * 1000,
+		_fst_mgr_group_lazy_poll, g, NULL);
+}
+
 static void _fst_mgr_group_deinit(struct fst_mgr_group *g)
 {
 	fst_mux_stop(g->drv);
@@ -981,11 +1938,20 @@ static void _fst_mgr_group_deinit(struct fst_mgr_group *g)
 				struct fst_mgr_session, grp_lentry);
 		_fst_mgr_session_deinit(s);
 	}
+	eloop_cancel_timeout(_fst_mgr_group_setup_dispatch, g, NULL);
+	eloop_cancel_timeout(_fst_mgr_group_lazy_poll, g, NULL);
+	_fst_mgr_group_pool_drain(g);
 	while (!dl_list_empty(&g->ifaces)) {
 		struct fst_mgr_iface *i = dl_list_first(&g->ifaces,
 				struct fst_mgr_iface, grp_lentry);
 		_fst_mgr_iface_deinit(i, g->drv);
 	}
+	while (!dl_list_empty(&g->pairs)) {
+		struct fst_mgr_iface_pair *pair = dl_list_first(&g->pairs,
+				struct fst_mgr_iface_pair, grp_lentry);
+		dl_list_del(&pair->grp_lentry);
+		os_free(pair);
+	}
 	fst_mux_cleanup(g->drv);
 	dl_list_del(&g->mgr_lentry);
 	fst_cfgmgr_on_group_deinit(&g->info);
@@ -1033,10 +1999,20 @@ static int _fst_mgr_group_init(struct fst_mgr *mgr,
 	dl_list_init(&g->sessions);
 	dl_list_init(&g->ifaces);
 	dl_list_init(&g->peers);
+	dl_list_init(&g->pairs);
+	dl_list_init(&g->setup_queue);
 
 	g->drv  = drv;
 	g->info = *ginfo;
 
+	if (fst_session_pool_size) {
+		g->pool = os_calloc(fst_session_pool_size, sizeof(*g->pool));
+		if (!g->pool)
+			fst_mgr_printf(MSG_WARNING,
+				"group %s: cannot allocate session pool",
+				ginfo->id);
+	}
+
 	for (i = 0; i < nof_ifaces; i++)
 		if (_fst_mgr_iface_init(g, &ifaces[i], drv)) {
 			fst_mgr_printf(MSG_ERROR, "Cannot init iface for group %s",
@@ -1076,6 +2052,12 @@ static int _fst_mgr_group_init(struct fst_mgr *mgr,
 
 	fst_free(ifaces);
 
+	_fst_mgr_group_pool_schedule_refill(g);
+	if (fst_lazy_setup_rate)
+		eloop_register_timeout(FST_MGR_LAZY_POLL_INTERVAL_MS / 1000,
+			(FST_MGR_LAZY_POLL_INTERVAL_MS % 1000) * 1000,
+			_fst_mgr_group_lazy_poll, g, NULL);
+
 	return 0;
 
 error_drv_start:
@@ -1085,6 +2067,8 @@ error_iface:
 				struct fst_mgr_iface, grp_lentry);
 		_fst_mgr_iface_deinit(i, drv);
 	}
+	os_free(g->pool);
+	os_free(g);
 error_alloc:
 	fst_mux_cleanup(drv);
 error_drv:
@@ -1102,11 +2086,15 @@ static struct fst_mgr_group *_fst_mgr_group_by_ifname(struct fst_mgr *mgr,
 		const char *ifname, struct fst_mgr_iface **iface)
 {
 	struct fst_mgr_group *g;
+	u16 ifid = fst_ifreg_lookup(ifname);
+
+	if (ifid == FST_IFREG_NONE)
+		return NULL;
 
 	_fst_mgr_foreach_grp(mgr, g) {
 		struct fst_mgr_iface *i;
 		_fst_grp_foreach_iface(g, i) {
-			if (!os_strcmp(ifname, i->info.name)) {
+			if (i->ifid == ifid) {
 				if (iface)
 					*iface = i;
 				return g;
@@ -1151,18 +2139,20 @@ static void _fst_mgr_on_peer_connected(struct fst_mgr *mgr,
 		return;
 	}
 
-	if (_fst_mgr_is_peer_connected(g, ifname, addr)) {
+	if (_fst_mgr_is_peer_connected(g, i, addr)) {
 		fst_mgr_printf(MSG_INFO, "peer already connected on iface %s",
 				   ifname);
 		return;
 	}
 
-	if (fst_cfgmgr_on_connect(&g->info, ifname, addr))
+	if (fst_cfgmgr_on_connect(&g->info, i->ifid, addr))
 		return;
 
-	p = _fst_mgr_group_peer_by_other_addr(g, addr, &i->info);
+	i->link_down = FALSE;
+
+	p = _fst_mgr_group_peer_by_other_addr(g, addr, i);
 	if (!p) {
-		if (!fst_mux_add_map_entry(g->drv, addr, i->info.name))
+		if (!fst_mux_add_map_entry(g->drv, addr, i->ifid))
 			_fst_mgr_peer_init(g, addr, i);
 
 		/* We have not more than 1 iface connected to this peer, so session
@@ -1183,7 +2173,11 @@ static void _fst_mgr_on_peer_connected(struct fst_mgr *mgr,
 			fst_mgr_printf(MSG_WARNING,
 				"iface %s: higher priority resets session",
 				ifname);
-			_fst_mgr_session_reset(p->session, TRUE);
+			/*
+			 * Events of the old setup may still arrive, so the
+			 * next one must not reuse its session
+			 */
+			_fst_mgr_peer_session_deinit(p, TRUE);
 		}
 	}
 	_fst_mgr_peer_try_to_initiate_next_setup(p, g);
@@ -1218,6 +2212,14 @@ static void _fst_mgr_on_peer_disconnected(struct fst_mgr *mgr,
 		return;
 	}
 
+	/* already applied by a resync */
+	if (!_fst_mgr_is_peer_connected(g, i, addr)) {
+		fst_mgr_printf(MSG_INFO, "group %s: peer " MACSTR
+				": not connected on iface %s",
+				g->info.id, MAC2STR(addr), ifname);
+		return;
+	}
+
 	fst_mgr_printf(MSG_INFO, "group %s: peer " MACSTR
 			": disconnected (session=%p i=%s)",
 			g->info.id, MAC2STR(addr),
@@ -1225,6 +2227,16 @@ static void _fst_mgr_on_peer_disconnected(struct fst_mgr *mgr,
 
 	fst_mgr_printf_session_info(p->session);
 
+	/*
+	 * A burst of disconnects caused by the whole band going down fails
+	 * over all the peers still mapped to it at once
+	 */
+	if (!i->link_down && _fst_mgr_iface_disconnect_burst(i) &&
+	    _fst_mgr_iface_is_link_down(i)) {
+		i->link_down = TRUE;
+		_fst_mgr_group_iface_failover(g, i);
+	}
+
 	if (!p->session)
 		fst_mgr_printf(MSG_INFO, "group %s: peer " MACSTR
 				": disconnect ignored (no session)",
@@ -1234,6 +2246,7 @@ static void _fst_mgr_on_peer_disconnected(struct fst_mgr *mgr,
 		fst_mgr_printf(MSG_INFO, "group %s: peer " MACSTR
 				": initiating switch",
 				g->info.id, MAC2STR(addr));
+		p->session->switch_trigger_us = _fst_mgr_now_us();
 		if (p->session->non_compliant) {
 			_fst_mgr_session_nc_transfer(p->session, p);
 			switch_initiated = TRUE;
@@ -1262,9 +2275,12 @@ static void _fst_mgr_on_peer_disconnected(struct fst_mgr *mgr,
 	_fst_mgr_peer_del_iface(p, i);
 	_fst_mgr_peer_print_connected_addr(p);
 
-	if (switch_initiated)
+	if (switch_initiated) {
 		_fst_mgr_peer_set_active_iface(p, p->session->new_iface,
 			g->drv);
+		_fst_mgr_session_switch_account(p->session, FST_MGR_SWITCH_MAP,
+			p->session->switch_trigger_us);
+	}
 	else if (dl_list_empty(&p->ifaces)) {
 		fst_mgr_printf(MSG_INFO, "group %s: peer " MACSTR
 				   ": deinitializing peer (no more interfaces)",
@@ -1285,7 +2301,7 @@ static void _fst_mgr_on_peer_disconnected(struct fst_mgr *mgr,
 		_fst_mgr_peer_try_to_initiate_next_setup(p, g);
 	}
 
-	fst_cfgmgr_on_disconnect(&g->info, ifname, addr);
+	fst_cfgmgr_on_disconnect(&g->info, i->ifid, addr);
 }
 
 static void _fst_mgr_on_peer_state_changed(struct fst_mgr *mgr,
@@ -1305,7 +2321,6 @@ static void _fst_mgr_on_ctrl_notification_state_change(struct fst_mgr *mgr,
 		struct fst_mgr_group *g, struct fst_mgr_session *s,
 		union fst_event_extra *evext)
 {
-	static unsigned retry_counter = 0;
 	struct fst_mgr_peer *p;
 
 	fst_mgr_printf(MSG_INFO, "session %u: state %s => %s",
@@ -1316,6 +2331,14 @@ static void _fst_mgr_on_ctrl_notification_state_change(struct fst_mgr *mgr,
 	if (evext->session_state.new_state != FST_SESSION_STATE_INITIAL)
 		return;
 
+	if (evext->session_state.extra.to_initial.reason <
+	    FST_METRICS_REASONS &&
+	    evext->session_state.extra.to_initial.initiator <
+	    FST_METRICS_INITIATORS)
+		fst_metrics_inc(sessions_ended
+			[evext->session_state.extra.to_initial.reason]
+			[evext->session_state.extra.to_initial.initiator]);
+
 	p = _fst_mgr_group_peer_by_session(g, s);
 	WPA_ASSERT(p != NULL);
 	if (p == NULL) {
@@ -1334,14 +2357,26 @@ static void _fst_mgr_on_ctrl_notification_state_change(struct fst_mgr *mgr,
 			s->id,
 			(evext->session_state.extra.to_initial.initiator ==
 				FST_INITIATOR_LOCAL) ? "local" : "remote");
-		_fst_mgr_peer_set_active_iface(p, s->new_iface, g->drv);
-		s->state = FST_MGR_SESSION_STATE_IDLE;
+		s->switch_done_us = _fst_mgr_now_us();
+		if (!s->switch_trigger_us) {
+			/* initiated by the peer, the map follows the event */
+			s->switch_trigger_us = s->switch_done_us;
+			_fst_mgr_peer_set_active_iface(p, s->new_iface, g->drv);
+			_fst_mgr_session_switch_account(s, FST_MGR_SWITCH_MAP,
+				s->switch_trigger_us);
+		} else
+			_fst_mgr_peer_set_active_iface(p, s->new_iface, g->drv);
+		_fst_mgr_session_switch_account(s, FST_MGR_SWITCH_HOSTAPD,
+			s->switch_transfer_us);
+		_fst_mgr_session_switch_account(s, FST_MGR_SWITCH_TOTAL,
+			s->switch_trigger_us);
+		_fst_mgr_session_set_state(s, FST_MGR_SESSION_STATE_IDLE);
 
 		const u8 *old_addr = _fst_mgr_peer_get_addr_of_iface(p, s->old_iface);
 		if (old_addr)
 			fst_cfgmgr_on_switch_completed(&g->info,
-						       s->old_iface->info.name,
-						       s->new_iface->info.name,
+						       s->old_iface->ifid,
+						       s->new_iface->ifid,
 						       old_addr);
 
 		break;
@@ -1357,30 +2392,46 @@ static void _fst_mgr_on_ctrl_notification_state_change(struct fst_mgr *mgr,
 		break;
 	}
 
-	/* delete old session */
+	/* hostapd holds the session in the initial state now, so it can be
+	 * reused */
+	_fst_mgr_session_set_state(s, FST_MGR_SESSION_STATE_IDLE);
+
+	/*
+	 * Back to the group pool for the next setup. Being idle, it is neither
+	 * torn down nor marked dirty by the reset: only sessions torn down or
+	 * reset while in progress are dirty, and those are removed rather than
+	 * pooled as hostapd may still send events for them.
+	 */
 	_fst_mgr_peer_session_deinit(p, TRUE);
 
-	if (evext->session_state.extra.to_initial.reason == REASON_STT)
-		retry_counter++;
-	else
-		retry_counter = 0;
+	if (evext->session_state.extra.to_initial.reason == REASON_STT) {
+		p->retries++;
+		g->stats.setup_timeouts++;
+	} else
+		p->retries = 0;
 
 	if (evext->session_state.extra.to_initial.reason == REASON_SETUP)
 		/* session requested by peer. We're done */
 		return;
 
 	/* session setup (initiate_next_setup) is invoked in following cases:
-	 * 1. following STT (retry)
+	 * 1. following STT (retry after backoff)
 	 * 2. following other error cases like reject (TODO: should this be
 	      considered as retry???)
 	 * 3. following successful session switch
 	 */
-	if (retry_counter < fst_num_of_retries) {
-		fst_mgr_printf(MSG_INFO, "initiating setup. retry %d", retry_counter);
+	if (!p->retries) {
 		_fst_mgr_peer_try_to_initiate_next_setup(p, g);
+	} else if (p->retries < fst_num_of_retries) {
+		fst_mgr_printf(MSG_INFO, "peer %p: scheduling setup retry %u",
+			p, p->retries);
+		g->stats.retries++;
+		fst_metrics_inc(setup_retries);
+		_fst_mgr_peer_schedule_retry(p, g);
 	} else {
-		fst_mgr_printf(MSG_INFO, "no more retries. give up");
-		retry_counter = 0;
+		fst_mgr_printf(MSG_INFO, "peer %p: no more retries. give up", p);
+		g->stats.retries_exhausted++;
+		p->retries = 0;
 	}
 }
 
@@ -1395,6 +2446,13 @@ static void _fst_mgr_on_setup(struct fst_mgr *mgr, u32 session_id)
 
 	memset(&sinfo, 0, sizeof(sinfo));
 
+	/* already answered by a resync */
+	if (_fst_mgr_group_by_session_id(mgr, session_id, NULL)) {
+		fst_mgr_printf(MSG_INFO, "session %u: already known",
+			session_id);
+		return;
+	}
+
 	if (fst_session_get_info(session_id, &sinfo)) {
 		fst_mgr_printf(MSG_ERROR, "session %u: cannot get info",
 			session_id);
@@ -1474,6 +2532,7 @@ static void _fst_mgr_on_setup(struct fst_mgr *mgr, u32 session_id)
 	}
 
 	p->session = s;
+	_fst_mgr_peer_publish(p);
 
 	_fst_mgr_session_respond(s , TRUE);
 
@@ -1482,6 +2541,282 @@ static void _fst_mgr_on_setup(struct fst_mgr *mgr, u32 session_id)
 }
 
 
+/*
+ * FST Manager Resync
+ *
+ * Events lost on their way from hostapd leave the model behind it. A resync
+ * pulls the peers and the sessions of every group from hostapd and applies
+ * the differences the way the missed events would have: peers are connected
+ * or disconnected, sessions hostapd dropped or reset are set up again, setups
+ * of the peers nobody answered are answered and sessions nobody owns are
+ * reclaimed. It runs when the control interface reports a loss and every
+ * fst_resync_interval seconds. Events still queued when it runs find the
+ * model updated already and are ignored.
+ */
+static Boolean _fst_mgr_addr_in(const u8 *addrs, int nof_addrs, const u8 *addr)
+{
+	int k;
+
+	for (k = 0; k < nof_addrs; k++)
+		if (!os_memcmp(addrs + k * ETH_ALEN, addr, ETH_ALEN))
+			return TRUE;
+	return FALSE;
+}
+
+static Boolean _fst_mgr_id_in(const u32 *ids, int nof_ids, u32 id)
+{
+	int k;
+
+	for (k = 0; k < nof_ids; k++)
+		if (ids[k] == id)
+			return TRUE;
+	return FALSE;
+}
+
+static struct fst_mgr_session *
+_fst_mgr_group_session_by_id(struct fst_mgr_group *g, u32 session_id)
+{
+	struct fst_mgr_session *s;
+
+	_fst_grp_foreach_session(g, s)
+		if (s->id == session_id)
+			return s;
+	return NULL;
+}
+
+static int _fst_mgr_group_resync_peers(struct fst_mgr *mgr,
+	struct fst_mgr_group *g)
+{
+	struct fst_mgr_iface *i;
+	int fixes = 0;
+
+	_fst_grp_foreach_iface(g, i) {
+		struct fst_mgr_peer *p;
+		u8 *peers = NULL, *gone = NULL;
+		int nof_peers, nof_gone = 0, k;
+
+		nof_peers = fst_get_iface_peers(&g->info, &i->info, &peers);
+		if (nof_peers < 0) {
+			fst_mgr_printf(MSG_WARNING, "group %s: resync: cannot "
+				"get peers for iface %s", g->info.id,
+				i->info.name);
+			continue;
+		}
+
+		/* collected first, a disconnect may deinit the peer */
+		_fst_grp_foreach_peer(g, p)
+			if (_fst_mgr_peer_get_addr_of_iface(p, i))
+				nof_gone++;
+		if (nof_gone) {
+			gone = os_malloc(nof_gone * ETH_ALEN);
+			if (!gone) {
+				fst_free(peers);
+				continue;
+			}
+		}
+		nof_gone = 0;
+		_fst_grp_foreach_peer(g, p) {
+			const u8 *addr = _fst_mgr_peer_get_addr_of_iface(p, i);
+
+			if (addr && !_fst_mgr_addr_in(peers, nof_peers, addr))
+				os_memcpy(gone + ETH_ALEN * nof_gone++, addr,
+					ETH_ALEN);
+		}
+
+		for (k = 0; k < nof_gone; k++) {
+			fst_mgr_printf(MSG_WARNING, "group %s: resync: peer "
+				MACSTR " not connected on iface %s",
+				g->info.id, MAC2STR(gone + k * ETH_ALEN),
+				i->info.name);
+			_fst_mgr_on_peer_disconnected(mgr, i->info.name,
+				gone + k * ETH_ALEN);
+			fixes++;
+		}
+
+		for (k = 0; k < nof_peers; k++) {
+			const u8 *addr = peers + k * ETH_ALEN;
+
+			if (_fst_mgr_is_peer_connected(g, i, addr))
+				continue;
+			fst_mgr_printf(MSG_WARNING, "group %s: resync: peer "
+				MACSTR " connected on iface %s", g->info.id,
+				MAC2STR(addr), i->info.name);
+			_fst_mgr_on_peer_connected(mgr, i->info.name, addr);
+			fixes++;
+		}
+
+		os_free(gone);
+		if (peers)
+			fst_free(peers);
+	}
+
+	return fixes;
+}
+
+/* drops a session hostapd lost or reset and sets the peer up again */
+static void _fst_mgr_session_resync_reset(struct fst_mgr_group *g,
+	struct fst_mgr_session *s, Boolean gone)
+{
+	struct fst_mgr_peer *p = _fst_mgr_group_peer_by_session(g, s);
+
+	fst_mgr_printf(MSG_WARNING, "group %s: resync: session %u (%s) %s",
+		g->info.id, s->id, state_name(s->state),
+		gone ? "gone" : "reset");
+
+	_fst_mgr_session_set_state(s, FST_MGR_SESSION_STATE_IDLE);
+	s->gone = gone;
+	/* the events of the reset may still be on their way */
+	s->dirty = TRUE;
+	_fst_mgr_session_deinit(s);
+	if (!p)
+		return;
+
+	p->session = NULL;
+	p->retries = 0;
+	_fst_mgr_peer_publish(p);
+	_fst_mgr_peer_try_to_initiate_next_setup(p, g);
+}
+
+static int _fst_mgr_group_resync_sessions(struct fst_mgr *mgr,
+	struct fst_mgr_group *g)
+{
+	struct fst_session_info sinfo;
+	struct fst_mgr_session *s;
+	u32 *ids = NULL, *reset;
+	int nof_ids, nof_reset = 0, fixes = 0, k;
+	unsigned int j;
+
+	nof_ids = fst_get_sessions(&g->info, &ids);
+	if (nof_ids < 0) {
+		fst_mgr_printf(MSG_WARNING, "group %s: resync: cannot get "
+			"sessions", g->info.id);
+		return 0;
+	}
+
+	for (j = 0; j < g->pool_count; ) {
+		if (_fst_mgr_id_in(ids, nof_ids, g->pool[j])) {
+			j++;
+			continue;
+		}
+		fst_mgr_printf(MSG_WARNING, "group %s: resync: pooled session "
+			"%u gone", g->info.id, g->pool[j]);
+		g->pool[j] = g->pool[--g->pool_count];
+		_fst_mgr_group_pool_schedule_refill(g);
+		fixes++;
+	}
+
+	/*
+	 * Ids of the sessions to reset, collected first as the setups started
+	 * by a reset add sessions hostapd did not report
+	 */
+	reset = os_calloc(dl_list_len(&g->sessions) + 1, sizeof(*reset));
+	if (!reset) {
+		fst_free(ids);
+		return fixes;
+	}
+	_fst_grp_foreach_session(g, s) {
+		if (!_fst_mgr_id_in(ids, nof_ids, s->id)) {
+			reset[nof_reset++] = s->id;
+			continue;
+		}
+		if (!_fst_mgr_session_is_in_progress(s) ||
+		    fst_session_get_info(s->id, &sinfo))
+			continue;
+		if (sinfo.state == FST_SESSION_STATE_INITIAL)
+			reset[nof_reset++] = s->id;
+		else if (s->state == FST_MGR_SESSION_STATE_INITIATED &&
+			 sinfo.state == FST_SESSION_STATE_SETUP_COMPLETION &&
+			 _fst_mgr_now_us() - s->setup_us >
+			 FST_MGR_RESYNC_SETUP_TIMEOUT_MS * 1000ULL) {
+			fst_mgr_printf(MSG_WARNING, "group %s: resync: "
+				"session %u established", g->info.id, s->id);
+			_fst_mgr_session_established(s);
+			fixes++;
+		}
+	}
+	for (k = 0; k < nof_reset; k++) {
+		s = _fst_mgr_group_session_by_id(g, reset[k]);
+		if (!s)
+			continue;
+		_fst_mgr_session_resync_reset(g, s,
+			!_fst_mgr_id_in(ids, nof_ids, reset[k]));
+		fixes++;
+	}
+	os_free(reset);
+
+	/* sessions hostapd holds for nobody here */
+	for (k = 0; k < nof_ids; k++) {
+		if (_fst_mgr_group_session_by_id(g, ids[k]))
+			continue;
+		for (j = 0; j < g->pool_count && g->pool[j] != ids[k]; j++)
+			;
+		if (j < g->pool_count ||
+		    fst_session_get_info(ids[k], &sinfo))
+			continue;
+
+		if (sinfo.state == FST_SESSION_STATE_INITIAL) {
+			fst_mgr_printf(MSG_WARNING, "group %s: resync: "
+				"session %u reclaimed", g->info.id, ids[k]);
+			if (_fst_mgr_group_pool_put(g, ids[k]))
+				fst_session_remove(ids[k]);
+		} else if (sinfo.state == FST_SESSION_STATE_SETUP_COMPLETION) {
+			fst_mgr_printf(MSG_WARNING, "group %s: resync: "
+				"session %u set up by the peer", g->info.id,
+				ids[k]);
+			_fst_mgr_on_setup(mgr, ids[k]);
+		} else {
+			fst_mgr_printf(MSG_WARNING, "group %s: resync: "
+				"session %u %s, left alone", g->info.id,
+				ids[k], fst_session_state_name(sinfo.state));
+			continue;
+		}
+		fixes++;
+	}
+
+	fst_free(ids);
+	return fixes;
+}
+
+static void _fst_mgr_resync(struct fst_mgr *mgr, const char *why)
+{
+	struct fst_mgr_group *g;
+
+	_fst_mgr_foreach_grp(mgr, g) {
+		int fixes;
+
+		fixes = _fst_mgr_group_resync_peers(mgr, g);
+		fixes += _fst_mgr_group_resync_sessions(mgr, g);
+		g->stats.resyncs++;
+		g->stats.resync_fixes += fixes;
+		fst_mgr_printf(fixes ? MSG_WARNING : MSG_DEBUG,
+			"group %s: resync (%s): %d differences applied",
+			g->info.id, why, fixes);
+	}
+}
+
+static void _fst_mgr_resync_timeout(void *eloop_data, void *user_ctx)
+{
+	struct fst_mgr *mgr = eloop_data;
+
+	_fst_mgr_resync(mgr, "periodic");
+	eloop_register_timeout(fst_resync_interval, 0, _fst_mgr_resync_timeout,
+		mgr, NULL);
+}
+
+/* the setups pending at the loss are only known to be accepted later */
+static void _fst_mgr_resync_loss_timeout(void *eloop_data, void *user_ctx)
+{
+	_fst_mgr_resync(eloop_data, "events lost, setups");
+}
+
+static void _fst_mgr_on_events_lost(struct fst_mgr *mgr)
+{
+	_fst_mgr_resync(mgr, "events lost");
+	eloop_cancel_timeout(_fst_mgr_resync_loss_timeout, mgr, NULL);
+	eloop_register_timeout(0, (FST_MGR_RESYNC_SETUP_TIMEOUT_MS + 100) * 1000,
+		_fst_mgr_resync_loss_timeout, mgr, NULL);
+}
+
 static void _fst_mgr_ctrl_notification_cb_func(void *cb_ctx,
 	u32 session_id, enum fst_event_type event_type, void *extra)
 {
@@ -1504,17 +2839,7 @@ static void _fst_mgr_ctrl_notification_cb_func(void *cb_ctx,
 		if (s != NULL) {
 			fst_mgr_printf(MSG_WARNING, "session %u: established (initiator)",
 					session_id);
-			s->state = FST_MGR_SESSION_STATE_ESTABLISHED;
-
-			if (s->llt > 0)
-				/*
-				 * at this point the active interface is the one
-				 * with highest priority and we have a backup
-				 * interface. Set active interface to aggressive
-				 * link loss detection for fast switching to
-				 * backup once signal quality is low.
-				 */
-				_fst_mgr_session_set_link_loss(s, true);
+			_fst_mgr_session_established(s);
 		}
 		else
 			fst_mgr_printf(MSG_ERROR, "Cannot find session object");
@@ -1531,6 +2856,9 @@ static void _fst_mgr_ctrl_notification_cb_func(void *cb_ctx,
 	case EVENT_PEER_STATE_CHANGED:
 		_fst_mgr_on_peer_state_changed(mgr, extra);
 		break;
+	case EVENT_FST_EVENTS_LOST:
+		_fst_mgr_on_events_lost(mgr);
+		break;
 	default:
 		fst_mgr_printf(MSG_WARNING, "session %u: unknown event #%d",
 				session_id, event_type);
@@ -1544,6 +2872,170 @@ static void _fst_mgr_ctrl_notification_cb_func(void *cb_ctx,
 static struct fst_mgr g_fst_mgr;
 static int            g_fst_mgr_initalized = 0;
 
+/* gauges of the current state, computed on export */
+static void _fst_mgr_metrics_collect(FILE *f, void *ctx)
+{
+	struct fst_mgr *mgr = ctx;
+	struct fst_mgr_group *g;
+	char labels[128];
+
+	fst_metrics_print_header(f, "peers", "gauge",
+		"Peers connected, by group and iface");
+	_fst_mgr_foreach_grp(mgr, g) {
+		struct fst_mgr_iface *i;
+
+		_fst_grp_foreach_iface(g, i) {
+			struct fst_mgr_peer *p;
+			unsigned int n = 0;
+
+			_fst_grp_foreach_peer(g, p)
+				if (_fst_mgr_peer_get_addr_of_iface(p, i))
+					n++;
+			os_snprintf(labels, sizeof(labels),
+				"group=\"%s\",iface=\"%s\"", g->info.id,
+				i->info.name);
+			fst_metrics_print(f, "peers", labels, n);
+		}
+	}
+
+	fst_metrics_print_header(f, "sessions", "gauge",
+		"Sessions, by group and state");
+	_fst_mgr_foreach_grp(mgr, g) {
+		unsigned int n[FST_MGR_SESSION_STATE_LAST] = { 0 };
+		struct fst_mgr_session *s;
+		int state;
+
+		_fst_grp_foreach_session(g, s)
+			if (s->state < FST_MGR_SESSION_STATE_LAST)
+				n[s->state]++;
+		for (state = 0; state < FST_MGR_SESSION_STATE_LAST; state++) {
+			os_snprintf(labels, sizeof(labels),
+				"group=\"%s\",state=\"%s\"", g->info.id,
+				state_name(state));
+			fst_metrics_print(f, "sessions", labels, n[state]);
+		}
+	}
+
+	fst_metrics_print_header(f, "session_pool", "gauge",
+		"Idle hostapd sessions ready for reuse, by group");
+	_fst_mgr_foreach_grp(mgr, g) {
+		os_snprintf(labels, sizeof(labels), "group=\"%s\"", g->info.id);
+		fst_metrics_print(f, "session_pool", labels, g->pool_count);
+	}
+
+	fst_metrics_print_header(f, "setups_queued", "gauge",
+		"Peers waiting for a setup to be admitted, by group");
+	_fst_mgr_foreach_grp(mgr, g) {
+		os_snprintf(labels, sizeof(labels), "group=\"%s\"", g->info.id);
+		fst_metrics_print(f, "setups_queued", labels,
+			dl_list_len(&g->setup_queue));
+	}
+	fst_metrics_print_header(f, "setup_queue_high_water", "gauge",
+		"Most peers ever waiting for a setup, by group");
+	_fst_mgr_foreach_grp(mgr, g) {
+		os_snprintf(labels, sizeof(labels), "group=\"%s\"", g->info.id);
+		fst_metrics_print(f, "setup_queue_high_water", labels,
+			g->stats.setup_queue_high_water);
+	}
+	fst_metrics_print_header(f, "setups_deferred_total", "counter",
+		"Setups queued by the setup admission, by group");
+	_fst_mgr_foreach_grp(mgr, g) {
+		os_snprintf(labels, sizeof(labels), "group=\"%s\"", g->info.id);
+		fst_metrics_print(f, "setups_deferred_total", labels,
+			g->stats.setups_deferred);
+	}
+	fst_metrics_print_header(f, "setup_queue_wait_us", "summary",
+		"Time peers waited for a setup to be admitted, by group");
+	_fst_mgr_foreach_grp(mgr, g) {
+		os_snprintf(labels, sizeof(labels),
+			"group=\"%s\",quantile=\"0.5\"", g->info.id);
+		fst_metrics_print(f, "setup_queue_wait_us", labels,
+			fst_hist_percentile(&g->setup_wait, 500));
+		os_snprintf(labels, sizeof(labels),
+			"group=\"%s\",quantile=\"0.99\"", g->info.id);
+		fst_metrics_print(f, "setup_queue_wait_us", labels,
+			fst_hist_percentile(&g->setup_wait, 990));
+		os_snprintf(labels, sizeof(labels), "group=\"%s\"", g->info.id);
+		fprintf(f, "fstman_setup_queue_wait_us_sum{%s} %llu\n",
+			labels, (unsigned long long)g->setup_wait.sum);
+		fprintf(f, "fstman_setup_queue_wait_us_count{%s} %u\n",
+			labels, g->setup_wait.count);
+	}
+
+	fst_metrics_print_header(f, "lazy_setups_waiting", "gauge",
+		"Peers whose setup waits for their traffic, by group");
+	_fst_mgr_foreach_grp(mgr, g) {
+		struct fst_mgr_peer *p;
+		unsigned int waiting = 0;
+
+		_fst_grp_foreach_peer(g, p)
+			if (p->lazy_waiting)
+				waiting++;
+		os_snprintf(labels, sizeof(labels), "group=\"%s\"", g->info.id);
+		fst_metrics_print(f, "lazy_setups_waiting", labels, waiting);
+	}
+	fst_metrics_print_header(f, "lazy_setups_deferred_total", "counter",
+		"Setups deferred as their peer was idle, by group");
+	_fst_mgr_foreach_grp(mgr, g) {
+		os_snprintf(labels, sizeof(labels), "group=\"%s\"", g->info.id);
+		fst_metrics_print(f, "lazy_setups_deferred_total", labels,
+			g->stats.lazy_deferrals);
+	}
+	fst_metrics_print_header(f, "lazy_setups_activated_total", "counter",
+		"Deferred setups initiated once their peer became active, "
+		"by group");
+	_fst_mgr_foreach_grp(mgr, g) {
+		os_snprintf(labels, sizeof(labels), "group=\"%s\"", g->info.id);
+		fst_metrics_print(f, "lazy_setups_activated_total", labels,
+			g->stats.lazy_activations);
+	}
+
+	fst_metrics_print_header(f, "switch_latency_us", "summary",
+		"Band switch latency, by group and phase");
+	_fst_mgr_foreach_grp(mgr, g) {
+		int phase;
+
+		for (phase = 0; phase < FST_MGR_SWITCH_PHASE_LAST; phase++) {
+			const struct fst_hist *h =
+				&g->switch_stats.phase[phase];
+
+			os_snprintf(labels, sizeof(labels),
+				"group=\"%s\",phase=\"%s\",quantile=\"0.5\"",
+				g->info.id, switch_phase_name(phase));
+			fst_metrics_print(f, "switch_latency_us", labels,
+				fst_hist_percentile(h, 500));
+			os_snprintf(labels, sizeof(labels),
+				"group=\"%s\",phase=\"%s\",quantile=\"0.99\"",
+				g->info.id, switch_phase_name(phase));
+			fst_metrics_print(f, "switch_latency_us", labels,
+				fst_hist_percentile(h, 990));
+			os_snprintf(labels, sizeof(labels),
+				"group=\"%s\",phase=\"%s\"",
+				g->info.id, switch_phase_name(phase));
+			fprintf(f, "fstman_switch_latency_us_sum{%s} %llu\n",
+				labels, (unsigned long long)h->sum);
+			fprintf(f, "fstman_switch_latency_us_count{%s} %u\n",
+				labels, h->count);
+		}
+	}
+
+	fst_metrics_print_header(f, "resyncs_total", "counter",
+		"State resynchronizations with hostapd, by group");
+	_fst_mgr_foreach_grp(mgr, g) {
+		os_snprintf(labels, sizeof(labels), "group=\"%s\"", g->info.id);
+		fst_metrics_print(f, "resyncs_total", labels, g->stats.resyncs);
+	}
+	fst_metrics_print_header(f, "resync_differences_total", "counter",
+		"Differences with hostapd applied by resyncs, by group");
+	_fst_mgr_foreach_grp(mgr, g) {
+		os_snprintf(labels, sizeof(labels), "group=\"%s\"", g->info.id);
+		fst_metrics_print(f, "resync_differences_total", labels,
+			g->stats.resync_fixes);
+	}
+
+	fst_ctrl_prof_write_metrics(f);
+}
+
 int fst_manager_init(void)
 {
 	int res, i, nof_groups;
@@ -1581,6 +3073,10 @@ int fst_manager_init(void)
 			nof_groups);
 
 	g_fst_mgr_initalized = 1;
+	fst_metrics_register_collector(_fst_mgr_metrics_collect, &g_fst_mgr);
+	if (fst_resync_interval)
+		eloop_register_timeout(fst_resync_interval, 0,
+			_fst_mgr_resync_timeout, &g_fst_mgr, NULL);
 
 finish:
 	if (groups)
@@ -1592,9 +3088,98 @@ finish:
 	return res;
 }
 
+static void _fst_mgr_switch_stats_dump(const char *group_id,
+	const char *prefix, const struct fst_mgr_switch_stats *stats)
+{
+	int phase;
+
+	for (phase = 0; phase < FST_MGR_SWITCH_PHASE_LAST; phase++) {
+		const struct fst_hist *h = &stats->phase[phase];
+
+		if (!h->count)
+			continue;
+		fst_mgr_printf(MSG_INFO, "group %s: switch%s %s: n=%u "
+			"avg=%llu p50=%u p90=%u p99=%u max=%u us", group_id,
+			prefix, switch_phase_name(phase), h->count,
+			(unsigned long long)(h->sum / h->count),
+			fst_hist_percentile(h, 500), fst_hist_percentile(h, 900),
+			fst_hist_percentile(h, 990), h->max);
+	}
+}
+
+void fst_manager_dump_stats(void)
+{
+	struct fst_mgr_group *g;
+
+	if (!g_fst_mgr_initalized)
+		return;
+
+	fst_mgr_printf(MSG_INFO, "log: %u messages dropped, %llu suppressed",
+		wpa_debug_async_dropped(),
+		(unsigned long long)fst_metrics.log_suppressed);
+	fst_ctrl_prof_dump();
+	fst_pool_dump();
+	_fst_mgr_foreach_grp(&g_fst_mgr, g) {
+		struct fst_mgr_iface_pair *pair;
+		struct fst_mgr_peer *p;
+
+		fst_mgr_printf(MSG_INFO, "group %s: setups=%u in_progress=%u "
+			"deferred=%u stt=%u retries=%u retries_exhausted=%u",
+			g->info.id, g->stats.setups_initiated,
+			_fst_mgr_group_setups_in_progress(g),
+			g->stats.setups_deferred, g->stats.setup_timeouts,
+			g->stats.retries, g->stats.retries_exhausted);
+		fst_mgr_printf(MSG_INFO, "group %s: setup queue %u "
+			"high_water=%u wait p50=%u p99=%u us", g->info.id,
+			dl_list_len(&g->setup_queue),
+			g->stats.setup_queue_high_water,
+			fst_hist_percentile(&g->setup_wait, 500),
+			fst_hist_percentile(&g->setup_wait, 990));
+		if (fst_lazy_setup_rate)
+			fst_mgr_printf(MSG_INFO, "group %s: lazy setups "
+				"deferred=%u activated=%u%s", g->info.id,
+				g->stats.lazy_deferrals,
+				g->stats.lazy_activations,
+				g->lazy_blind ? " (no traffic counters)" : "");
+		fst_mgr_printf(MSG_INFO, "group %s: session pool %u/%u "
+			"hits=%u misses=%u", g->info.id, g->pool_count,
+			g->pool ? fst_session_pool_size : 0,
+			g->stats.pool_hits, g->stats.pool_misses);
+		fst_mgr_printf(MSG_INFO, "group %s: bulk failovers=%u peers=%u "
+			"last=%u us", g->info.id, g->stats.bulk_failovers,
+			g->stats.bulk_failover_peers,
+			g->stats.bulk_failover_last_us);
+		fst_mgr_printf(MSG_INFO, "group %s: resyncs=%u differences=%u",
+			g->info.id, g->stats.resyncs, g->stats.resync_fixes);
+		_fst_mgr_switch_stats_dump(g->info.id, "", &g->switch_stats);
+		dl_list_for_each(pair, &g->pairs, struct fst_mgr_iface_pair,
+				 grp_lentry) {
+			char prefix[2 * FST_MAX_INTERFACE_SIZE + 4];
+
+			os_snprintf(prefix, sizeof(prefix), " %s->%s",
+				pair->old_iface->info.name,
+				pair->new_iface->info.name);
+			_fst_mgr_switch_stats_dump(g->info.id, prefix,
+				&pair->stats);
+		}
+		_fst_grp_foreach_peer(g, p)
+			if (p->retries || p->link_loss_toggles)
+				fst_mgr_printf(MSG_INFO, "group %s: peer %p: "
+					"%u consecutive setup timeouts, "
+					"%u link loss toggles",
+					g->info.id, p, p->retries,
+					p->link_loss_toggles);
+	}
+}
+
 void fst_manager_deinit(void)
 {
 	if (g_fst_mgr_initalized) {
+		fst_metrics_unregister_collector(_fst_mgr_metrics_collect,
+			&g_fst_mgr);
+		eloop_cancel_timeout(_fst_mgr_resync_timeout, &g_fst_mgr, NULL);
+		eloop_cancel_timeout(_fst_mgr_resync_loss_timeout, &g_fst_mgr,
+			NULL);
 		fst_set_notify_cb(NULL, NULL);
 		while (!dl_list_empty(&g_fst_mgr.groups)) {
 			struct fst_mgr_group *g = dl_list_first(&g_fst_mgr.groups,
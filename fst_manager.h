@@ -35,6 +35,7 @@
 
 #include "utils/common.h"
 #include "common/ieee802_11_defs.h"
+#include "fst_metrics.h"
 
 #ifndef FST_MGR_COMPONENT
 #error "FST_MGR_COMPONENT has to be defined"
@@ -55,11 +56,73 @@ extern unsigned int fst_debug_level;
 
 #include <sys/time.h>
 
+/*
+ * Messages below this level are compiled out, e.g.
+ * -DFST_MIN_LOG_LEVEL=MSG_INFO for production builds
+ */
+#ifndef FST_MIN_LOG_LEVEL
+#define FST_MIN_LOG_LEVEL MSG_EXCESSIVE
+#endif
+
+/*
+ * Max messages below MSG_WARNING per component (source file) and second, the
+ * rest are counted in fst_metrics.log_suppressed
+ */
+#ifndef FST_MGR_LOG_RATE_LIMIT
+#define FST_MGR_LOG_RATE_LIMIT 200
+#endif
+
+struct fst_mgr_log_limit {
+	unsigned long sec;
+	unsigned int  count;
+	unsigned int  suppressed;
+};
+
+static struct fst_mgr_log_limit fst_mgr_log_limit __attribute__((unused));
+
+/*
+ * Returns FALSE if the message has to be suppressed. Otherwise, the number of
+ * messages suppressed since the last one that was let through is returned in
+ * *suppressed.
+ */
+static inline int fst_mgr_log_limit_check(struct fst_mgr_log_limit *l,
+	int level, unsigned long sec, unsigned int *suppressed)
+{
+	*suppressed = 0;
+	if (level >= MSG_WARNING)
+		return 1;
+	if (l->sec != sec) {
+		l->sec = sec;
+		l->count = 0;
+	}
+	if (l->count >= FST_MGR_LOG_RATE_LIMIT) {
+		l->suppressed++;
+		fst_metrics_inc(log_suppressed);
+		return 0;
+	}
+	l->count++;
+	*suppressed = l->suppressed;
+	l->suppressed = 0;
+	return 1;
+}
+
 #define fst_mgr_printf(level, format, ...) \
 	do { \
-		if ((level) >= fst_debug_level) { \
+		if ((level) >= FST_MIN_LOG_LEVEL && \
+		    (level) >= fst_debug_level) { \
 			struct timeval tv = {0}; \
+			unsigned int _suppressed; \
 			gettimeofday(&tv, NULL); \
+			if (!fst_mgr_log_limit_check(&fst_mgr_log_limit, \
+					(level), tv.tv_sec, &_suppressed)) \
+				break; \
+			if (_suppressed) \
+				_fst_mgr_printf("[%08lu.%06lu] FST: " \
+					FST_MGR_COMPONENT ": %u messages " \
+					"suppressed\n", \
+					(unsigned long)tv.tv_sec, \
+					(unsigned long)tv.tv_usec, \
+					_suppressed); \
 			_fst_mgr_printf("[%08lu.%06lu] FST: " FST_MGR_COMPONENT \
 				": %s: " format "\n", \
 				(unsigned long)tv.tv_sec, \
@@ -71,5 +134,9 @@ extern unsigned int fst_debug_level;
 
 int  fst_manager_init(void);
 void fst_manager_deinit(void);
+/**
+ * fst_manager_dump_stats - logs per-group setup and retry counters
+ */
+void fst_manager_dump_stats(void);
 const u8 *fst_mgr_get_addr_from_mbie(struct multi_band_ie *mbie);
 #endif /* __FST_MANAGER_H__ */
@@ -0,0 +1,395 @@
+/*
+ * FST Manager: metrics export in Prometheus text format
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "common/defs.h"
+#include "fst_metrics.h"
+#define FST_MGR_COMPONENT "METRICS"
+#include "fst_manager.h"
+
+#define FST_METRICS_PREFIX            "fstman_"
+#define FST_METRICS_MAX_COLLECTORS    4
+#define FST_METRICS_MAX_CLIENTS       4
+/* a client that sends no request gets the plain text after this delay */
+#define FST_METRICS_CLIENT_TIMEOUT_MS 500
+#define FST_METRICS_FILE_INTERVAL_SEC 10
+
+struct fst_metrics fst_metrics;
+
+static struct {
+	fst_metrics_collector_cb cb;
+	void *ctx;
+} collectors[FST_METRICS_MAX_COLLECTORS];
+
+static int   metrics_sock = -1;
+static char *metrics_sock_path;
+static char *metrics_file_path;
+static int   metrics_clients[FST_METRICS_MAX_CLIENTS];
+
+int fst_metrics_register_collector(fst_metrics_collector_cb cb, void *ctx)
+{
+	int i;
+
+	for (i = 0; i < FST_METRICS_MAX_COLLECTORS; i++)
+		if (!collectors[i].cb) {
+			collectors[i].cb = cb;
+			collectors[i].ctx = ctx;
+			return 0;
+		}
+
+	fst_mgr_printf(MSG_ERROR, "too many metrics collectors");
+	return -1;
+}
+
+void fst_metrics_unregister_collector(fst_metrics_collector_cb cb, void *ctx)
+{
+	int i;
+
+	for (i = 0; i < FST_METRICS_MAX_COLLECTORS; i++)
+		if (collectors[i].cb == cb && collectors[i].ctx == ctx) {
+			collectors[i].cb = NULL;
+			collectors[i].ctx = NULL;
+		}
+}
+
+void fst_metrics_print_header(FILE *f, const char *name, const char *type,
+	const char *help)
+{
+	fprintf(f, "# HELP " FST_METRICS_PREFIX "%s %s\n", name, help);
+	fprintf(f, "# TYPE " FST_METRICS_PREFIX "%s %s\n", name, type);
+}
+
+void fst_metrics_print(FILE *f, const char *name, const char *labels,
+	unsigned long long value)
+{
+	if (labels)
+		fprintf(f, FST_METRICS_PREFIX "%s{%s} %llu\n", name, labels,
+			value);
+	else
+		fprintf(f, FST_METRICS_PREFIX "%s %llu\n", name, value);
+}
+
+static void fst_metrics_print_counter(FILE *f, const char *name,
+	const char *help, unsigned long long value)
+{
+	fst_metrics_print_header(f, name, "counter", help);
+	fst_metrics_print(f, name, NULL, value);
+}
+
+static void fst_metrics_print_summary(FILE *f, const char *name,
+	const char *help, const struct fst_hist *h)
+{
+	static const unsigned int quantiles[] = { 500, 900, 990 };
+	char labels[32];
+	size_t i;
+
+	fst_metrics_print_header(f, name, "summary", help);
+	for (i = 0; i < ARRAY_SIZE(quantiles); i++) {
+		os_snprintf(labels, sizeof(labels), "quantile=\"0.%u\"",
+			quantiles[i] / 10);
+		fst_metrics_print(f, name, labels,
+			fst_hist_percentile(h, quantiles[i]));
+	}
+	fprintf(f, FST_METRICS_PREFIX "%s_sum %llu\n", name,
+		(unsigned long long)h->sum);
+	fprintf(f, FST_METRICS_PREFIX "%s_count %u\n", name, h->count);
+}
+
+void fst_metrics_write(FILE *f)
+{
+	static const char *initiators[FST_METRICS_INITIATORS] = {
+		[FST_INITIATOR_UNDEFINED] = "none",
+		[FST_INITIATOR_LOCAL] = "local",
+		[FST_INITIATOR_REMOTE] = "remote",
+	};
+	char labels[64];
+	int r, i;
+
+	fst_metrics_print_header(f, "sessions_ended_total", "counter",
+		"Sessions returned to the initial state, by reason and initiator");
+	for (r = 0; r < FST_METRICS_REASONS; r++)
+		for (i = 0; i < FST_METRICS_INITIATORS; i++) {
+			if (!fst_metrics.sessions_ended[r][i])
+				continue;
+			os_snprintf(labels, sizeof(labels),
+				"reason=\"%s\",initiator=\"%s\"",
+				fst_reason_name(r), initiators[i]);
+			fst_metrics_print(f, "sessions_ended_total", labels,
+				fst_metrics.sessions_ended[r][i]);
+		}
+
+	fst_metrics_print_counter(f, "setups_initiated_total",
+		"Session setups initiated", fst_metrics.setups_initiated);
+	fst_metrics_print_counter(f, "setup_failures_total",
+		"Session setups that could not be initiated",
+		fst_metrics.setup_failures);
+	fst_metrics_print_counter(f, "setup_retries_total",
+		"Session setups retried after a timeout",
+		fst_metrics.setup_retries);
+	fst_metrics_print_counter(f, "ctrl_commands_total",
+		"Commands sent to hostapd", fst_metrics.ctrl_commands);
+	fst_metrics_print_counter(f, "ctrl_failures_total",
+		"Commands to hostapd that failed or timed out",
+		fst_metrics.ctrl_failures);
+	fst_metrics_print_summary(f, "ctrl_rtt_us",
+		"Round trip time of the commands to hostapd",
+		&fst_metrics.ctrl_rtt_us);
+	fst_metrics_print_counter(f, "netlink_ops_total",
+		"Netlink requests sent by the mux", fst_metrics.netlink_ops);
+	fst_metrics_print_counter(f, "netlink_failures_total",
+		"Netlink requests of the mux that failed",
+		fst_metrics.netlink_failures);
+	fst_metrics_print_counter(f, "log_messages_suppressed_total",
+		"Log messages over the per component rate limit",
+		fst_metrics.log_suppressed);
+	fst_metrics_print_counter(f, "log_messages_dropped_total",
+		"Log messages dropped as the log writer fell behind",
+		wpa_debug_async_dropped());
+	fst_metrics_print_header(f, "acl_entries", "gauge",
+		"Entries of the rate upgrade ACLs");
+	fst_metrics_print(f, "acl_entries", NULL, fst_metrics.acl_entries);
+
+	for (i = 0; i < FST_METRICS_MAX_COLLECTORS; i++)
+		if (collectors[i].cb)
+			collectors[i].cb(f, collectors[i].ctx);
+}
+
+static void fst_metrics_write_file(void *eloop_data, void *user_ctx)
+{
+	char tmp_path[256];
+	FILE *f;
+
+	eloop_register_timeout(FST_METRICS_FILE_INTERVAL_SEC, 0,
+		fst_metrics_write_file, NULL, NULL);
+
+	/* the readers never see a partially written file */
+	os_snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", metrics_file_path);
+	f = fopen(tmp_path, "w");
+	if (!f) {
+		fst_mgr_printf(MSG_ERROR, "Cannot open %s: %s", tmp_path,
+			strerror(errno));
+		return;
+	}
+	fst_metrics_write(f);
+	if (fclose(f) || rename(tmp_path, metrics_file_path)) {
+		fst_mgr_printf(MSG_ERROR, "Cannot write %s: %s",
+			metrics_file_path, strerror(errno));
+		unlink(tmp_path);
+	}
+}
+
+static void fst_metrics_client_respond(int idx, Boolean http)
+{
+	int fd = dup(metrics_clients[idx]);
+	FILE *f = fd >= 0 ? fdopen(fd, "w") : NULL;
+
+	if (!f) {
+		fst_mgr_printf(MSG_ERROR, "Cannot respond: %s", strerror(errno));
+		if (fd >= 0)
+			close(fd);
+	} else {
+		if (http)
+			fprintf(f, "HTTP/1.0 200 OK\r\nContent-Type: text/plain; "
+				"version=0.0.4\r\nConnection: close\r\n\r\n");
+		fst_metrics_write(f);
+		fclose(f);
+	}
+}
+
+static int fst_metrics_client_idx(int sock)
+{
+	int i;
+
+	for (i = 0; i < FST_METRICS_MAX_CLIENTS; i++)
+		if (metrics_clients[i] == sock)
+			return i;
+	return -1;
+}
+
+static void fst_metrics_client_timeout(void *eloop_data, void *user_ctx);
+
+static void fst_metrics_client_close(int idx)
+{
+	int sock = metrics_clients[idx];
+
+	eloop_cancel_timeout(fst_metrics_client_timeout, NULL,
+		(void *)(intptr_t)sock);
+	eloop_unregister_read_sock(sock);
+	close(sock);
+	metrics_clients[idx] = -1;
+}
+
+static void fst_metrics_client_timeout(void *eloop_data, void *user_ctx)
+{
+	int idx = fst_metrics_client_idx((int)(intptr_t)user_ctx);
+
+	if (idx < 0)
+		return;
+	fst_metrics_client_respond(idx, FALSE);
+	fst_metrics_client_close(idx);
+}
+
+/* answers HTTP GET requests, and anything else with the plain text */
+static void fst_metrics_client_receive(int sock, void *eloop_ctx,
+	void *sock_ctx)
+{
+	int idx = fst_metrics_client_idx(sock);
+	char buf[512];
+	ssize_t len;
+
+	if (idx < 0)
+		return;
+
+	len = recv(sock, buf, sizeof(buf), MSG_DONTWAIT);
+	if (len >= 0)
+		fst_metrics_client_respond(idx,
+			len >= 4 && !os_memcmp(buf, "GET ", 4));
+	fst_metrics_client_close(idx);
+}
+
+static void fst_metrics_accept(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	int client, idx;
+
+	client = accept(sock, NULL, NULL);
+	if (client < 0) {
+		fst_mgr_printf(MSG_ERROR, "accept failed: %s", strerror(errno));
+		return;
+	}
+
+	idx = fst_metrics_client_idx(-1);
+	if (idx < 0) {
+		fst_mgr_printf(MSG_WARNING, "too many metrics clients");
+		close(client);
+		return;
+	}
+
+	if (eloop_register_read_sock(client, fst_metrics_client_receive, NULL,
+			NULL)) {
+		close(client);
+		return;
+	}
+	metrics_clients[idx] = client;
+	eloop_register_timeout(0, FST_METRICS_CLIENT_TIMEOUT_MS * 1000,
+		fst_metrics_client_timeout, NULL, (void *)(intptr_t)client);
+}
+
+static int fst_metrics_open_sock(const char *path)
+{
+	struct sockaddr_un addr;
+
+	if (os_strlen(path) >= sizeof(addr.sun_path)) {
+		fst_mgr_printf(MSG_ERROR, "socket path too long: %s", path);
+		return -1;
+	}
+
+	metrics_sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (metrics_sock < 0) {
+		fst_mgr_printf(MSG_ERROR, "Cannot open socket: %s",
+			strerror(errno));
+		return -1;
+	}
+
+	os_memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	os_strlcpy(addr.sun_path, path, sizeof(addr.sun_path));
+	unlink(path);
+	if (bind(metrics_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    listen(metrics_sock, FST_METRICS_MAX_CLIENTS) < 0 ||
+	    eloop_register_read_sock(metrics_sock, fst_metrics_accept, NULL,
+			NULL)) {
+		fst_mgr_printf(MSG_ERROR, "Cannot listen on %s: %s", path,
+			strerror(errno));
+		close(metrics_sock);
+		metrics_sock = -1;
+		return -1;
+	}
+
+	return 0;
+}
+
+int fst_metrics_init(const char *sock_path, const char *file_path)
+{
+	int i;
+
+	for (i = 0; i < FST_METRICS_MAX_CLIENTS; i++)
+		metrics_clients[i] = -1;
+
+	if (sock_path) {
+		metrics_sock_path = os_strdup(sock_path);
+		if (!metrics_sock_path || fst_metrics_open_sock(sock_path))
+			goto error;
+		fst_mgr_printf(MSG_INFO, "serving metrics on %s", sock_path);
+	}
+
+	if (file_path) {
+		metrics_file_path = os_strdup(file_path);
+		if (!metrics_file_path)
+			goto error;
+		eloop_register_timeout(0, 0, fst_metrics_write_file, NULL, NULL);
+		fst_mgr_printf(MSG_INFO, "writing metrics to %s", file_path);
+	}
+
+	return 0;
+
+error:
+	fst_metrics_deinit();
+	return -1;
+}
+
+void fst_metrics_deinit(void)
+{
+	int i;
+
+	for (i = 0; i < FST_METRICS_MAX_CLIENTS; i++)
+		if (metrics_clients[i] >= 0)
+			fst_metrics_client_close(i);
+
+	if (metrics_sock >= 0) {
+		eloop_unregister_read_sock(metrics_sock);
+		close(metrics_sock);
+		metrics_sock = -1;
+		unlink(metrics_sock_path);
+	}
+	os_free(metrics_sock_path);
+	metrics_sock_path = NULL;
+
+	eloop_cancel_timeout(fst_metrics_write_file, NULL, NULL);
+	os_free(metrics_file_path);
+	metrics_file_path = NULL;
+}
@@ -0,0 +1,102 @@
+/*
+ * FST Manager: metrics definitions
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __FST_METRICS_H__
+#define __FST_METRICS_H__
+
+#include <stdio.h>
+#include "utils/common.h"
+#include "fst/fst_ctrl_aux.h"
+#include "fst_hist.h"
+
+#define FST_METRICS_REASONS    (REASON_DETACH_IFACE + 1)
+#define FST_METRICS_INITIATORS (FST_INITIATOR_REMOTE + 1)
+
+/* Counters and gauges updated in place, without any allocation */
+struct fst_metrics {
+	/* by enum fst_reason and enum fst_initiator */
+	u64 sessions_ended[FST_METRICS_REASONS][FST_METRICS_INITIATORS];
+	u64 setups_initiated;
+	u64 setup_failures; /* fst_session_initiate() failed */
+	u64 setup_retries;
+	u64 ctrl_commands;
+	u64 ctrl_failures;
+	struct fst_hist ctrl_rtt_us;
+	u64 netlink_ops;
+	u64 netlink_failures;
+	u32 acl_entries;
+	u64 log_suppressed; /* over the fst_mgr_printf() rate limit */
+};
+
+extern struct fst_metrics fst_metrics;
+
+#define fst_metrics_inc(field) (fst_metrics.field++)
+#define fst_metrics_dec(field) (fst_metrics.field--)
+
+/**
+ * fst_metrics_collector_cb - prints the metrics of a module on export
+ * @f: output, see fst_metrics_print_header() and fst_metrics_print()
+ * @ctx: context given on registration
+ */
+typedef void (*fst_metrics_collector_cb)(FILE *f, void *ctx);
+
+/**
+ * fst_metrics_init - start exporting the metrics
+ * @sock_path: unix socket serving the metrics on connect, or NULL
+ * @file_path: file the metrics are periodically written to, or NULL
+ * Returns: 0 on success, -1 on error
+ */
+int fst_metrics_init(const char *sock_path, const char *file_path);
+void fst_metrics_deinit(void);
+
+int fst_metrics_register_collector(fst_metrics_collector_cb cb, void *ctx);
+void fst_metrics_unregister_collector(fst_metrics_collector_cb cb, void *ctx);
+
+/**
+ * fst_metrics_write - print all the metrics in Prometheus text format
+ * @f: output
+ */
+void fst_metrics_write(FILE *f);
+
+void fst_metrics_print_header(FILE *f, const char *name, const char *type,
+	const char *help);
+/**
+ * fst_metrics_print - print a sample
+ * @f: output
+ * @name: metric name, without the fstman_ prefix
+ * @labels: labels without the braces, e.g. "group=\"g0\"", or NULL
+ * @value: sample value
+ */
+void fst_metrics_print(FILE *f, const char *name, const char *labels,
+	unsigned long long value);
+
+#endif /* __FST_METRICS_H__ */
@@ -34,16 +34,50 @@
 #define __FST_MUX_H__
 
 #include "utils/common.h"
+#include "fst_ifreg.h"
 
 struct fst_mux;
 
+struct fst_mux_map_entry {
+	const u8 *da;
+	u16       ifid; /* FST_IFREG_NONE removes the entry */
+};
+
 struct fst_mux *fst_mux_init(const char *drv_iface_name);
 int fst_mux_start(struct fst_mux *ctx);
 int fst_mux_register_iface(struct fst_mux *ctx, const char *iface_name,
 		u8 priority);
-int fst_mux_add_map_entry(struct fst_mux *ctx, const u8 *da,
-		const char *iface_name);
+/**
+ * fst_mux_add_map_entry - map a destination to an interface
+ * @ctx: mux context
+ * @da: destination address
+ * @ifid: registered interface, see fst_ifreg_get()
+ * Returns: 0 on success, -1 on error
+ */
+int fst_mux_add_map_entry(struct fst_mux *ctx, const u8 *da, u16 ifid);
 int fst_mux_del_map_entry(struct fst_mux *ctx, const u8 *da);
+/**
+ * fst_mux_set_map_entries - (re)map several destinations in one batch
+ * @ctx: mux context
+ * @entries: destinations and the interfaces to map them to, in order
+ * @n: number of entries
+ * Returns: number of entries that could not be mapped
+ */
+int fst_mux_set_map_entries(struct fst_mux *ctx,
+		const struct fst_mux_map_entry *entries, int n);
+typedef void (*fst_mux_bytes_cb)(const u8 *da, u64 bytes, void *cb_ctx);
+
+/**
+ * fst_mux_get_map_bytes - read the TX byte counters of the mapped destinations
+ * @ctx: mux context
+ * @cb: called for every mapped destination
+ * @cb_ctx: context passed to @cb
+ * Returns: 0 on success, -1 if the mux does not count the traffic
+ *
+ * A counter starts from zero when its destination is (re)mapped.
+ */
+int fst_mux_get_map_bytes(struct fst_mux *ctx, fst_mux_bytes_cb cb,
+		void *cb_ctx);
 void fst_mux_unregister_iface(struct fst_mux *ctx, const char *iface_name);
 void fst_mux_stop(struct fst_mux *ctx);
 void fst_mux_cleanup(struct fst_mux *ctx);
@@ -37,6 +37,8 @@
 #include "fst_mux.h"
 #include "fst_tc.h"
 #include "fst_cfgmgr.h"
+#include "fst_trace.h"
+#include "fst_pool.h"
 #include <sys/ioctl.h>
 #include <linux/if.h>
 #include <linux/if_bonding.h>
@@ -52,7 +54,7 @@
 
 struct fst_mux_iface
 {
-	char           ifname[IFNAMSIZ + 1];
+	u16            ifid;
 	u8             priority;
 	int            queue_id;
 	struct dl_list filters;
@@ -67,6 +69,10 @@ struct fst_mux_filter
 	struct dl_list              lentry;
 };
 
+/* a filter is installed for every connected peer */
+static struct fst_pool fst_mux_filter_pool =
+	FST_POOL_INITIALIZER("mux_filter", struct fst_mux_filter, 1, 0);
+
 struct fst_mux
 {
 	char           bond_ifname[IFNAMSIZ + 1];
@@ -76,18 +82,25 @@ struct fst_mux
 	struct fst_tc *tc;
 };
 
-struct fst_mux_iface * _drv_get_iface_by_name(struct fst_mux *ctx,
-		const char *ifname)
+struct fst_mux_iface * _drv_get_iface_by_id(struct fst_mux *ctx, u16 ifid)
 {
 	struct fst_mux_iface *i;
 	dl_list_for_each(i, &ctx->ifaces, struct fst_mux_iface, lentry) {
-		if (!os_strcmp(i->ifname, ifname))
+		if (i->ifid == ifid)
 			return i;
 	}
 
 	return NULL;
 }
 
+struct fst_mux_iface * _drv_get_iface_by_name(struct fst_mux *ctx,
+		const char *ifname)
+{
+	u16 ifid = fst_ifreg_lookup(ifname);
+
+	return ifid != FST_IFREG_NONE ? _drv_get_iface_by_id(ctx, ifid) : NULL;
+}
+
 struct fst_mux_filter *_drv_get_filter_by_da(struct fst_mux *ctx, const u8 *da)
 {
 	struct fst_mux_iface *i;
@@ -237,7 +250,7 @@ static int _drv_del_filter(struct fst_mux *ctx, struct fst_mux_filter *filter,
 	WPA_ASSERT(!fst_is_supplicant() ||
 		   dl_list_empty(&filter->iface->filters));
 
-	os_free(filter);
+	fst_pool_free(&fst_mux_filter_pool, filter);
 
 	return 0;
 }
@@ -265,6 +278,8 @@ void _drv_del_iface(struct fst_mux *ctx, struct fst_mux_iface *iface)
 {
 	dl_list_del(&iface->lentry);
 	_drv_purge_iface_filters(ctx, iface);
+	fst_tc_unregister_iface(ctx->tc, iface->ifid);
+	fst_ifreg_put(iface->ifid);
 	os_free(iface);
 }
 
@@ -341,9 +356,10 @@ int fst_mux_start(struct fst_mux *ctx)
 	dl_list_for_each(i, &ctx->ifaces, struct fst_mux_iface, lentry) {
 		i->queue_id = ++ctx->queue_id;
 
-		if (_mux_bond_assign_queue_id(ctx, i->ifname, i->queue_id)) {
+		if (_mux_bond_assign_queue_id(ctx, fst_ifreg_name(i->ifid),
+				i->queue_id)) {
 			fst_mgr_printf(MSG_ERROR, "Cannot assign queue_id#%d for %s",
-					i->queue_id, i->ifname);
+					i->queue_id, fst_ifreg_name(i->ifid));
 			goto fail;
 
 		}
@@ -361,7 +377,7 @@ int fst_mux_start(struct fst_mux *ctx)
 
 fail:
 	dl_list_for_each(i, &ctx->ifaces, struct fst_mux_iface, lentry)
-		_mux_bond_assign_queue_id(ctx, i->ifname, 0);
+		_mux_bond_assign_queue_id(ctx, fst_ifreg_name(i->ifid), 0);
 	return -1;
 }
 
@@ -384,7 +400,11 @@ int fst_mux_register_iface(struct fst_mux *ctx, const char *iface_name,
 		goto fail;
 	}
 
-	if (fst_tc_register_iface(ctx->tc, iface_name)) {
+	iface->ifid = fst_ifreg_get(iface_name);
+	if (iface->ifid == FST_IFREG_NONE)
+		goto fail_ifreg;
+
+	if (fst_tc_register_iface(ctx->tc, iface->ifid)) {
 		fst_mgr_printf(MSG_ERROR, "Cannot register TC for %s",
 				iface_name);
 		goto fail_tc_register;
@@ -393,7 +413,6 @@ int fst_mux_register_iface(struct fst_mux *ctx, const char *iface_name,
 	iface->priority = priority;
 
 	dl_list_init(&iface->filters);
-	os_strlcpy(iface->ifname, iface_name, sizeof(iface->ifname));
 
 	dl_list_add_tail(&ctx->ifaces, &iface->lentry);
 
@@ -403,18 +422,20 @@ int fst_mux_register_iface(struct fst_mux *ctx, const char *iface_name,
 	return 0;
 
 fail_tc_register:
+	fst_ifreg_put(iface->ifid);
+fail_ifreg:
 	os_free(iface);
 fail:
 	return -1;
 }
 
-int fst_mux_add_map_entry(struct fst_mux *ctx, const u8 *da,
-		const char *iface_name)
+int fst_mux_add_map_entry(struct fst_mux *ctx, const u8 *da, u16 ifid)
 {
+	const char *iface_name = fst_ifreg_name(ifid);
 	struct fst_mux_iface  *iface;
 	struct fst_mux_filter *filter;
 
-	iface = _drv_get_iface_by_name(ctx, iface_name);
+	iface = _drv_get_iface_by_id(ctx, ifid);
 	if (!iface) {
 		fst_mgr_printf(MSG_ERROR, "Cannot find interface %s", iface_name);
 		return -1;
@@ -422,7 +443,7 @@ int fst_mux_add_map_entry(struct fst_mux *ctx, const u8 *da,
 
 	fst_mux_del_map_entry(ctx, da);
 
-	filter = os_zalloc(sizeof(*filter));
+	filter = fst_pool_zalloc(&fst_mux_filter_pool);
 	if (!filter) {
 		fst_mgr_printf(MSG_ERROR, "Cannot allocate filter "
 			"for [" MACSTR ",%s]",
@@ -430,13 +451,15 @@ int fst_mux_add_map_entry(struct fst_mux *ctx, const u8 *da,
 		return -1;
 	}
 
-	if (fst_tc_add_l2da_filter(ctx->tc, da, iface->queue_id, iface_name,
+	if (fst_tc_add_l2da_filter(ctx->tc, da, iface->queue_id, ifid,
 			&filter->filter_handle)) {
 		fst_mgr_printf(MSG_ERROR, "Cannot add TC filter for [" MACSTR ",%s]",
 			MAC2STR(da), iface_name);
-		os_free(filter);
+		fst_pool_free(&fst_mux_filter_pool, filter);
+		fst_trace_map(FST_TRACE_MUX_MAP_ADD, da, -1);
 		return -1;
 	}
+	fst_trace_map(FST_TRACE_MUX_MAP_ADD, da, 0);
 
 	os_memcpy(filter->da, da, ETH_ALEN);
 	filter->iface = iface;
@@ -451,6 +474,7 @@ int fst_mux_add_map_entry(struct fst_mux *ctx, const u8 *da,
 int fst_mux_del_map_entry(struct fst_mux *ctx, const u8 *da)
 {
 	struct fst_mux_filter *filter;
+	int res;
 
 	filter = _drv_get_filter_by_da(ctx, da);
 	if (!filter) {
@@ -459,15 +483,58 @@ int fst_mux_del_map_entry(struct fst_mux *ctx, const u8 *da)
 		return -1;
 	}
 
-	return _drv_del_filter(ctx, filter, FALSE);
+	res = _drv_del_filter(ctx, filter, FALSE);
+	fst_trace_map(FST_TRACE_MUX_MAP_DEL, da, res);
+	return res;
+}
+
+int fst_mux_set_map_entries(struct fst_mux *ctx,
+		const struct fst_mux_map_entry *entries, int n)
+{
+	int i, failed = 0;
+
+	fst_tc_batch_begin(ctx->tc);
+	for (i = 0; i < n; i++) {
+		int res = entries[i].ifid != FST_IFREG_NONE ?
+			fst_mux_add_map_entry(ctx, entries[i].da,
+				entries[i].ifid) :
+			fst_mux_del_map_entry(ctx, entries[i].da);
+		if (res)
+			failed++;
+	}
+	failed += fst_tc_batch_end(ctx->tc);
+
+	return failed;
+}
+
+struct _drv_bytes_ctx {
+	fst_mux_bytes_cb cb;
+	void *cb_ctx;
+};
+
+static void _drv_filter_bytes(struct fst_tc_filter_handle *filter_handle,
+	u64 bytes, void *cb_ctx)
+{
+	struct _drv_bytes_ctx *c = cb_ctx;
+	struct fst_mux_filter *filter = dl_list_entry(filter_handle,
+		struct fst_mux_filter, filter_handle);
+
+	c->cb(filter->da, bytes, c->cb_ctx);
+}
+
+int fst_mux_get_map_bytes(struct fst_mux *ctx, fst_mux_bytes_cb cb,
+		void *cb_ctx)
+{
+	struct _drv_bytes_ctx c = { .cb = cb, .cb_ctx = cb_ctx };
+
+	/* each destination has its own filter counting what it redirects */
+	return fst_tc_get_l2da_bytes(ctx->tc, _drv_filter_bytes, &c);
 }
 
 void fst_mux_unregister_iface(struct fst_mux *ctx, const char *iface_name)
 {
 	struct fst_mux_iface *iface;
 
-	fst_tc_unregister_iface(ctx->tc, iface_name);
-
 	iface = _drv_get_iface_by_name(ctx, iface_name);
 	if (iface) {
 		_drv_del_iface(ctx, iface);
@@ -482,7 +549,7 @@ void fst_mux_stop(struct fst_mux *ctx)
 	_drv_purge_filters(ctx);
 	fst_tc_stop(ctx->tc);
 	dl_list_for_each(i, &ctx->ifaces, struct fst_mux_iface, lentry) {
-		_mux_bond_assign_queue_id(ctx, i->ifname, 0);
+		_mux_bond_assign_queue_id(ctx, fst_ifreg_name(i->ifid), 0);
 	}
 }
 
@@ -41,6 +41,8 @@
 #include "common/defs.h"
 #include "fst_mux.h"
 #include "fst_cfgmgr.h"
+#include "fst_trace.h"
+#include "fst_metrics.h"
 
 #define FST_MGR_COMPONENT "MUX"
 #include "fst_manager.h"
@@ -96,11 +98,17 @@ fail_nlmsg:
 
 static int _send_and_free_genl_msg(struct fst_mux *ctx, struct nl_msg *msg)
 {
+	u64 start_ns = fst_trace_ring ? fst_trace_now() : 0;
 	int res;
 
 	res = nl_send_auto(ctx->nl, msg);
+	fst_trace_record(FST_TRACE_NETLINK,
+		genlmsg_hdr(nlmsg_hdr(msg))->cmd, 0,
+		(u32)((fst_trace_now() - start_ns) / 1000), (u32)res, 0);
 	nlmsg_free(msg);
+	fst_metrics_inc(netlink_ops);
 	if (res < 0) {
+		fst_metrics_inc(netlink_failures);
 		fst_mgr_printf(MSG_ERROR, "Cannot nl_send: %s", nl_geterror(res));
 		return -1;
 	}
@@ -319,19 +327,53 @@ int fst_mux_start(struct fst_mux *ctx)
 	return 0;
 }
 
-int fst_mux_add_map_entry(struct fst_mux *ctx, const u8 *da,
-		const char *iface_name)
+int fst_mux_add_map_entry(struct fst_mux *ctx, const u8 *da, u16 ifid)
 {
-	return fst_is_supplicant() ?
+	const char *iface_name = fst_ifreg_name(ifid);
+	int res = fst_is_supplicant() ?
 			_send_genl_set_def_slave_msg(ctx, iface_name) :
 			_send_genl_set_change_map_msg(ctx, da, iface_name);
+
+	fst_trace_map(FST_TRACE_MUX_MAP_ADD, da, res);
+	return res;
 }
 
 int fst_mux_del_map_entry(struct fst_mux *ctx, const u8 *da)
 {
+	int res;
+
 	/* "No need to del map entry for STA as we use default slave */
-	return fst_is_supplicant() ?
-			0 : _send_genl_set_change_map_msg(ctx, da, NULL);
+	if (fst_is_supplicant())
+		return 0;
+
+	res = _send_genl_set_change_map_msg(ctx, da, NULL);
+	fst_trace_map(FST_TRACE_MUX_MAP_DEL, da, res);
+	return res;
+}
+
+int fst_mux_set_map_entries(struct fst_mux *ctx,
+		const struct fst_mux_map_entry *entries, int n)
+{
+	int i, failed = 0;
+
+	/* genl map changes are not acknowledged, so they are batched anyway */
+	for (i = 0; i < n; i++) {
+		int res = entries[i].ifid != FST_IFREG_NONE ?
+			fst_mux_add_map_entry(ctx, entries[i].da,
+				entries[i].ifid) :
+			fst_mux_del_map_entry(ctx, entries[i].da);
+		if (res)
+			failed++;
+	}
+
+	return failed;
+}
+
+int fst_mux_get_map_bytes(struct fst_mux *ctx, fst_mux_bytes_cb cb,
+		void *cb_ctx)
+{
+	/* the L2DA map of the bonding driver keeps no per-destination stats */
+	return -1;
 }
 
 int fst_mux_register_iface(struct fst_mux *ctx, const char *iface_name,
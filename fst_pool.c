@@ -0,0 +1,213 @@
+/*
+ * FST Manager: fixed-size object pools
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "fst_pool.h"
+#include "fst_metrics.h"
+#define FST_MGR_COMPONENT "POOL"
+#include "fst_manager.h"
+
+#define FST_POOL_ALIGN 8
+
+extern unsigned int fst_max_peers;
+
+struct fst_pool_obj {
+	struct fst_pool_obj *next;
+};
+
+/* pools set up so far, for the dumps and the metrics */
+static struct fst_pool *fst_pools;
+
+static void fst_pool_metrics_collect(FILE *f, void *ctx)
+{
+	char labels[64];
+	struct fst_pool *p;
+
+	fst_metrics_print_header(f, "pool_capacity", "gauge",
+		"Objects preallocated, by pool");
+	for (p = fst_pools; p; p = p->next) {
+		os_snprintf(labels, sizeof(labels), "pool=\"%s\"", p->name);
+		fst_metrics_print(f, "pool_capacity", labels, p->capacity);
+	}
+	fst_metrics_print_header(f, "pool_in_use", "gauge",
+		"Objects in use, including those taken from the heap, by pool");
+	for (p = fst_pools; p; p = p->next) {
+		os_snprintf(labels, sizeof(labels), "pool=\"%s\"", p->name);
+		fst_metrics_print(f, "pool_in_use", labels, p->in_use);
+	}
+	fst_metrics_print_header(f, "pool_high_water", "gauge",
+		"Most objects ever in use at once, by pool");
+	for (p = fst_pools; p; p = p->next) {
+		os_snprintf(labels, sizeof(labels), "pool=\"%s\"", p->name);
+		fst_metrics_print(f, "pool_high_water", labels, p->high_water);
+	}
+	fst_metrics_print_header(f, "pool_heap_high_water", "gauge",
+		"Most objects taken from the heap at once, by pool");
+	for (p = fst_pools; p; p = p->next) {
+		os_snprintf(labels, sizeof(labels), "pool=\"%s\"", p->name);
+		fst_metrics_print(f, "pool_heap_high_water", labels,
+			p->heap_high_water);
+	}
+	fst_metrics_print_header(f, "pool_heap_allocs_total", "counter",
+		"Objects taken from the heap as the pool was exhausted");
+	for (p = fst_pools; p; p = p->next) {
+		os_snprintf(labels, sizeof(labels), "pool=\"%s\"", p->name);
+		fst_metrics_print(f, "pool_heap_allocs_total", labels,
+			p->heap_allocs);
+	}
+}
+
+static void fst_pool_setup(struct fst_pool *p)
+{
+	unsigned int i;
+
+	p->stride = (p->obj_size + FST_POOL_ALIGN - 1) & ~(FST_POOL_ALIGN - 1);
+	p->capacity = p->per_peer * fst_max_peers + p->fixed;
+	p->slab = p->capacity ? os_malloc(p->capacity * p->stride) : NULL;
+	if (!p->slab) {
+		if (p->capacity)
+			fst_mgr_printf(MSG_WARNING,
+				"pool %s: cannot preallocate %u objects",
+				p->name, p->capacity);
+		p->capacity = 0;
+	}
+
+	/* the free list is built in order so the slab is used from its start */
+	p->free_list = NULL;
+	for (i = p->capacity; i > 0; i--) {
+		struct fst_pool_obj *o =
+			(struct fst_pool_obj *)(p->slab + (i - 1) * p->stride);
+
+		o->next = p->free_list;
+		p->free_list = o;
+	}
+
+	if (!fst_pools)
+		fst_metrics_register_collector(fst_pool_metrics_collect, NULL);
+	p->next = fst_pools;
+	fst_pools = p;
+	p->ready = TRUE;
+
+	fst_mgr_printf(MSG_DEBUG, "pool %s: %u objects of %zu bytes preallocated",
+		p->name, p->capacity, p->stride);
+}
+
+static Boolean fst_pool_owns(const struct fst_pool *p, const void *obj)
+{
+	const u8 *o = obj;
+
+	return p->slab && o >= p->slab && o < p->slab + p->capacity * p->stride;
+}
+
+void *fst_pool_zalloc(struct fst_pool *p)
+{
+	void *obj;
+
+	if (!p->ready)
+		fst_pool_setup(p);
+
+	if (p->free_list) {
+		obj = p->free_list;
+		p->free_list = ((struct fst_pool_obj *)obj)->next;
+		os_memset(obj, 0, p->obj_size);
+	} else {
+		obj = os_zalloc(p->obj_size);
+		if (!obj)
+			return NULL;
+		if (++p->heap_in_use > p->heap_high_water)
+			p->heap_high_water = p->heap_in_use;
+		p->heap_allocs++;
+	}
+
+	if (++p->in_use > p->high_water)
+		p->high_water = p->in_use;
+
+	return obj;
+}
+
+void fst_pool_free(struct fst_pool *p, void *obj)
+{
+	if (!obj)
+		return;
+
+	WPA_ASSERT(p->in_use);
+	p->in_use--;
+	if (fst_pool_owns(p, obj)) {
+		((struct fst_pool_obj *)obj)->next = p->free_list;
+		p->free_list = obj;
+	} else {
+		p->heap_in_use--;
+		os_free(obj);
+	}
+}
+
+struct fst_pool *fst_pool_first(void)
+{
+	return fst_pools;
+}
+
+void fst_pool_dump(void)
+{
+	struct fst_pool *p;
+
+	for (p = fst_pools; p; p = p->next)
+		fst_mgr_printf(MSG_INFO, "pool %s: in_use=%u/%u high_water=%u "
+			"heap_in_use=%u heap_high_water=%u heap_allocs=%llu",
+			p->name, p->in_use, p->capacity, p->high_water,
+			p->heap_in_use, p->heap_high_water,
+			(unsigned long long) p->heap_allocs);
+}
+
+void fst_pool_deinit(void)
+{
+	struct fst_pool *p;
+
+	if (fst_pools)
+		fst_metrics_unregister_collector(fst_pool_metrics_collect, NULL);
+
+	while ((p = fst_pools) != NULL) {
+		fst_pools = p->next;
+		if (p->in_use > p->heap_in_use) {
+			/* objects still refer to the slab, keep it */
+			fst_mgr_printf(MSG_ERROR, "pool %s: %u objects leaked",
+				p->name, p->in_use - p->heap_in_use);
+			continue;
+		}
+		os_free(p->slab);
+		p->slab = NULL;
+		p->free_list = NULL;
+		p->capacity = 0;
+		p->ready = FALSE;
+		p->next = NULL;
+	}
+}
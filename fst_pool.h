@@ -0,0 +1,107 @@
+/*
+ * FST Manager: fixed-size object pools
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __FST_POOL_H__
+#define __FST_POOL_H__
+
+#include "utils/common.h"
+#include "common/defs.h"
+
+/*
+ * Per-type pool of fixed-size objects. The objects are carved from a single
+ * slab allocated on first use, sized from fst_max_peers, and recycled through
+ * a free list; the heap is only used once the slab is exhausted.
+ */
+struct fst_pool {
+	const char      *name;
+	size_t           obj_size;
+	unsigned int     per_peer;   /* slab objects per fst_max_peers */
+	unsigned int     fixed;      /* slab objects regardless of the peers */
+	/* set up on first use */
+	Boolean          ready;
+	size_t           stride;
+	unsigned int     capacity;
+	u8              *slab;
+	void            *free_list;
+	unsigned int     in_use;     /* slab and heap objects */
+	unsigned int     heap_in_use;
+	unsigned int     heap_high_water; /* most heap objects at once */
+	unsigned int     high_water;
+	u64              heap_allocs;
+	struct fst_pool *next;
+};
+
+/**
+ * FST_POOL_INITIALIZER - static initializer of a pool
+ * @_name: pool name, used in the logs and the metrics
+ * @_type: object type
+ * @_per_peer: objects preallocated for every peer allowed by fst_max_peers
+ * @_fixed: objects preallocated in addition
+ */
+#define FST_POOL_INITIALIZER(_name, _type, _per_peer, _fixed) \
+	{ .name = (_name), .obj_size = sizeof(_type), \
+	  .per_peer = (_per_peer), .fixed = (_fixed) }
+
+/**
+ * fst_pool_zalloc - get a zeroed object
+ * @p: pool
+ * Returns: object from the slab or, once it is exhausted, from the heap;
+ *	NULL on allocation failure
+ */
+void *fst_pool_zalloc(struct fst_pool *p);
+
+/**
+ * fst_pool_free - return an object obtained with fst_pool_zalloc()
+ * @p: pool the object was obtained from
+ * @obj: object, may be NULL
+ */
+void fst_pool_free(struct fst_pool *p, void *obj);
+
+/**
+ * fst_pool_first - get the pools set up so far
+ * Returns: first pool, the others are linked by next; NULL if none
+ */
+struct fst_pool *fst_pool_first(void);
+
+/**
+ * fst_pool_dump - log the occupancy and high-water mark of every pool
+ */
+void fst_pool_dump(void);
+
+/**
+ * fst_pool_deinit - release the slabs of all the pools
+ *
+ * A slab with objects still in use is kept and reported.
+ */
+void fst_pool_deinit(void);
+
+#endif /* __FST_POOL_H__ */
@@ -35,19 +35,26 @@
 #include <stdio.h>
 #include "utils/list.h"
 #include "fst_rateupg.h"
+#include "fst_metrics.h"
 
 #define FST_MGR_COMPONENT "RATEUPG"
 #include "fst_manager.h"
 #include "common/ieee802_11_defs.h"
+#include "fst_pool.h"
 
 struct rate_upgrade_mac {
 	u8             addr[ETH_ALEN];
 	struct dl_list lentry;
 };
 
+/* the ACLs list the connected peers */
+static struct fst_pool rate_upgrade_mac_pool =
+	FST_POOL_INITIALIZER("rateupg_mac", struct rate_upgrade_mac, 1, 0);
+
 struct rate_upgrade_group {
 	char                  *groupname;
 	char                  *master;
+	u16                    master_ifid;
 	char                  *acl_fname;
 	struct fst_iface_info *slaves;
 	int                    slave_cnt;
@@ -77,10 +84,11 @@ static struct rate_upgrade_mac *find_rate_upgrade_mac(
 static struct rate_upgrade_mac *add_rate_upgrade_mac(
 	struct rate_upgrade_group *g, const u8 *addr)
 {
-	struct rate_upgrade_mac *p = os_malloc(sizeof(*p));
+	struct rate_upgrade_mac *p = fst_pool_zalloc(&rate_upgrade_mac_pool);
 	if (p) {
 		os_memcpy(p->addr, addr, ETH_ALEN);
 		dl_list_add_tail(&g->acl_macs, &p->lentry);
+		fst_metrics_inc(acl_entries);
 	}
 	return p;
 }
@@ -88,7 +96,8 @@ static struct rate_upgrade_mac *add_rate_upgrade_mac(
 static void del_rate_upgrade_mac(struct rate_upgrade_mac *p)
 {
 	dl_list_del(&p->lentry);
-	os_free(p);
+	fst_pool_free(&rate_upgrade_mac_pool, p);
+	fst_metrics_dec(acl_entries);
 }
 
 static int update_acl_file(struct rate_upgrade_group *g)
@@ -136,6 +145,7 @@ static struct rate_upgrade_group *find_rate_upgrade_group(const char *name)
 static void deinit_rate_upgrade_group(struct rate_upgrade_group *g)
 {
 	free(g->slaves);
+	fst_ifreg_put(g->master_ifid);
 	free(g->master);
 	free(g->groupname);
 	free(g->acl_fname);
@@ -237,6 +247,10 @@ int fst_rate_upgrade_add_group(const struct fst_group_info *group)
 		}
 	}
 
+	g->master_ifid = fst_ifreg_get(master);
+	if (g->master_ifid == FST_IFREG_NONE)
+		goto error_add;
+
 	dl_list_add_tail(&g_rateupg_mgr.groups, &g->lentry);
 
 	return 0;
@@ -372,14 +386,14 @@ error_connect:
 }
 
 int fst_rate_upgrade_on_connect(const struct fst_group_info *group,
-	const char *iface, const u8* addr)
+	u16 ifid, const u8* addr)
 {
 	int res;
 	struct rate_upgrade_group *g;
 	struct rate_upgrade_mac *p;
 
 	g = find_rate_upgrade_group(group->id);
-	if (!g || os_strcmp(iface, g->master))
+	if (!g || ifid != g->master_ifid)
 		return 0;
 
 	if (find_rate_upgrade_mac(g, addr)) {
@@ -401,7 +415,7 @@ int fst_rate_upgrade_on_connect(const struct fst_group_info *group,
 	}
 
 	if (fst_is_supplicant())
-		res = fst_dup_connection_sta(g, iface, addr);
+		res = fst_dup_connection_sta(g, fst_ifreg_name(ifid), addr);
 	else
 		res = fst_dup_connection_ap(g, addr);
 
@@ -414,14 +428,14 @@ error_acl_file:
 }
 
 int fst_rate_upgrade_on_disconnect(const struct fst_group_info *group,
-	const char *iface, const u8* addr)
+	u16 ifid, const u8* addr)
 {
 	int i, res = 0;
 	struct rate_upgrade_group *g;
 	struct rate_upgrade_mac *p;
 
 	g = find_rate_upgrade_group(group->id);
-	if (!g || os_strcmp(iface, g->master))
+	if (!g || ifid != g->master_ifid)
 		return 0;
 
 	p = find_rate_upgrade_mac(g, addr);
@@ -449,13 +463,14 @@ int fst_rate_upgrade_on_disconnect(const struct fst_group_info *group,
 }
 
 void fst_rate_upgrade_on_switch_completed(const struct fst_group_info *group,
-	const char *old_iface, const char *new_iface, const u8* old_peer_addr)
+	u16 old_ifid, u16 new_ifid, const u8* old_peer_addr)
 {
 	struct rate_upgrade_group *g;
 	int ret;
 
 	fst_mgr_printf(MSG_INFO, "%s=>%s, old peer address " MACSTR,
-		old_iface, new_iface, MAC2STR(old_peer_addr));
+		fst_ifreg_name(old_ifid), fst_ifreg_name(new_ifid),
+		MAC2STR(old_peer_addr));
 
 	if (fst_is_supplicant())
 		/* do nothing for STA mode */
@@ -467,13 +482,13 @@ void fst_rate_upgrade_on_switch_completed(const struct fst_group_info *group,
 		return;
 	}
 
-	if (os_strcmp(old_iface, g->master) == 0) {
+	if (old_ifid == g->master_ifid) {
 		fst_mgr_printf(MSG_INFO, "switching from master, do nothing");
 		return;
 	}
 
 	/* old_iface is not master, disconnect from peer */
-	ret = fst_disconnect_peer(old_iface, old_peer_addr);
+	ret = fst_disconnect_peer(fst_ifreg_name(old_ifid), old_peer_addr);
 	if (ret)
 		fst_mgr_printf(MSG_ERROR, "failed to disconnect peer");
 }
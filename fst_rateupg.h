@@ -33,26 +33,27 @@
 #ifndef __FST_RATEUPG_H__
 #define __FST_RATEUPG_H__
 #include "fst_ini_conf.h"
+#include "fst_ifreg.h"
 
 int fst_rate_upgrade_init(struct fst_ini_config *h);
 void fst_rate_upgrade_deinit();
 int fst_rate_upgrade_add_group(const struct fst_group_info *group);
 int fst_rate_upgrade_del_group(const struct fst_group_info *group);
 int fst_rate_upgrade_on_connect(const struct fst_group_info *group,
-	const char *iface, const u8* addr);
+	u16 ifid, const u8* addr);
 int fst_rate_upgrade_on_disconnect(const struct fst_group_info *group,
-	const char *iface, const u8* addr);
+	u16 ifid, const u8* addr);
 /**
  * fst_rate_upgrade_on_switch_completed - called after successful session
  * switch. This function will trigger disconnect from peer on old_iface if it's
  * not the group's master interface
  *
  * @group: FST group of the session
- * @old_iface: interface that we switch from
- * @new_iface: interface that we switch to
+ * @old_ifid: interface that we switch from
+ * @new_ifid: interface that we switch to
  * @old_peer_addr: peer's MAC address on old_iface
  */
 void fst_rate_upgrade_on_switch_completed(const struct fst_group_info *group,
-	const char *old_iface, const char *new_iface, const u8* old_peer_addr);
+	u16 old_ifid, u16 new_ifid, const u8* old_peer_addr);
 
 #endif /* __FST_RATEUPG_H */
@@ -0,0 +1,217 @@
+/*
+ * FST Manager: shared memory status page
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "common/defs.h"
+#include "fst_status.h"
+#define FST_MGR_COMPONENT "STATUS"
+#include "fst_manager.h"
+
+struct fst_status_hdr *fst_status_page = NULL;
+static struct fst_status_peer *fst_status_peers;
+static size_t fst_status_size;
+static char *fst_status_path;
+static u32 *fst_status_free; /* free record indices, next one last */
+static unsigned int fst_status_free_num;
+
+int fst_status_init(const char *path, unsigned int peers)
+{
+	struct fst_status_hdr *hdr;
+	char *tmp = NULL;
+	size_t len;
+	unsigned int k;
+	int fd;
+
+	fst_status_deinit();
+	if (!path)
+		return 0;
+
+	if (peers < FST_STATUS_MIN_PEERS)
+		peers = FST_STATUS_MIN_PEERS;
+	fst_status_size = sizeof(*hdr) + peers * sizeof(struct fst_status_peer);
+
+	fst_status_path = os_strdup(path);
+	fst_status_free = os_calloc(peers, sizeof(*fst_status_free));
+	len = os_strlen(path) + 5;
+	tmp = os_malloc(len);
+	if (!fst_status_path || !fst_status_free || !tmp) {
+		fst_mgr_printf(MSG_ERROR, "Cannot allocate status page of %u peers",
+			peers);
+		goto error_alloc;
+	}
+
+	/* readers never see a partially set up page: it is renamed once ready */
+	os_snprintf(tmp, len, "%s.tmp", path);
+	fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		fst_mgr_printf(MSG_ERROR, "Cannot create %s: %s", tmp,
+			strerror(errno));
+		goto error_alloc;
+	}
+	if (ftruncate(fd, fst_status_size)) {
+		fst_mgr_printf(MSG_ERROR, "Cannot size %s: %s", tmp,
+			strerror(errno));
+		goto error_map;
+	}
+	hdr = mmap(NULL, fst_status_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+		fd, 0);
+	if (hdr == MAP_FAILED) {
+		fst_mgr_printf(MSG_ERROR, "Cannot map %s: %s", tmp,
+			strerror(errno));
+		goto error_map;
+	}
+
+	hdr->version = FST_STATUS_VERSION;
+	hdr->hdr_size = sizeof(*hdr);
+	hdr->record_size = sizeof(struct fst_status_peer);
+	hdr->records_num = peers;
+	hdr->pid = getpid();
+	__atomic_store_n(&hdr->magic, FST_STATUS_MAGIC, __ATOMIC_RELEASE);
+	if (rename(tmp, path)) {
+		fst_mgr_printf(MSG_ERROR, "Cannot rename %s to %s: %s", tmp, path,
+			strerror(errno));
+		munmap(hdr, fst_status_size);
+		goto error_map;
+	}
+	close(fd);
+	os_free(tmp);
+
+	for (k = 0; k < peers; k++)
+		fst_status_free[k] = peers - 1 - k;
+	fst_status_free_num = peers;
+	fst_status_peers = (struct fst_status_peer *)(hdr + 1);
+	fst_status_page = hdr;
+	fst_mgr_printf(MSG_INFO, "status page of %u peers at %s", peers, path);
+	return 0;
+
+error_map:
+	close(fd);
+	unlink(tmp);
+error_alloc:
+	os_free(tmp);
+	os_free(fst_status_free);
+	fst_status_free = NULL;
+	os_free(fst_status_path);
+	fst_status_path = NULL;
+	return -1;
+}
+
+void fst_status_deinit(void)
+{
+	if (fst_status_page) {
+		/* readers still holding the page see it is stale */
+		__atomic_store_n(&fst_status_page->magic, 0, __ATOMIC_RELEASE);
+		munmap(fst_status_page, fst_status_size);
+		unlink(fst_status_path);
+		fst_status_page = NULL;
+		fst_status_peers = NULL;
+	}
+	os_free(fst_status_path);
+	fst_status_path = NULL;
+	os_free(fst_status_free);
+	fst_status_free = NULL;
+	fst_status_free_num = 0;
+}
+
+int fst_status_peer_alloc(const char *group)
+{
+	struct fst_status_peer *r;
+	u32 idx;
+
+	if (!fst_status_page)
+		return -1;
+
+	if (!fst_status_free_num) {
+		if (!fst_status_page->overflows)
+			fst_mgr_printf(MSG_WARNING,
+				"status page full, peers of group %s left out",
+				group);
+		__atomic_store_n(&fst_status_page->overflows,
+			fst_status_page->overflows + 1, __ATOMIC_RELAXED);
+		return -1;
+	}
+
+	idx = fst_status_free[--fst_status_free_num];
+	if (idx >= fst_status_page->records_used)
+		__atomic_store_n(&fst_status_page->records_used, idx + 1,
+			__ATOMIC_RELEASE);
+
+	r = fst_status_peer_begin(idx);
+	/* seq is left alone, the reader relies on it across reuse */
+	r->in_use = 1;
+	r->active = FST_STATUS_NO_IFACE;
+	r->ifaces_num = 0;
+	r->session_state = FST_STATUS_SESSION_NONE;
+	r->session_id = 0;
+	r->switches = 0;
+	r->switch_us = 0;
+	os_memset(r->group, 0, sizeof(r->group));
+	os_strlcpy(r->group, group, sizeof(r->group));
+	os_memset(r->ifaces, 0, sizeof(r->ifaces));
+	fst_status_peer_end(r);
+	return idx;
+}
+
+void fst_status_peer_free(int idx)
+{
+	struct fst_status_peer *r = fst_status_peer_begin(idx);
+
+	if (!r)
+		return;
+	r->in_use = 0;
+	fst_status_peer_end(r);
+	fst_status_free[fst_status_free_num++] = idx;
+}
+
+struct fst_status_peer *fst_status_peer_begin(int idx)
+{
+	struct fst_status_peer *r;
+
+	if (!fst_status_page || idx < 0)
+		return NULL;
+
+	r = &fst_status_peers[idx];
+	__atomic_store_n(&r->seq, r->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	return r;
+}
+
+void fst_status_peer_end(struct fst_status_peer *r)
+{
+	__atomic_store_n(&r->seq, r->seq + 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&fst_status_page->generation,
+		fst_status_page->generation + 1, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,169 @@
+/*
+ * FST Manager: shared memory status page
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __FST_STATUS_H__
+#define __FST_STATUS_H__
+
+#include "utils/common.h"
+#include "fst/fst_ctrl_aux.h"
+
+/*
+ * The status page is a file of fixed-layout records the manager maps shared
+ * and keeps up to date with the band every peer is mapped to. Other
+ * processes map it read-only and get the state without any request to the
+ * manager:
+ *
+ *   struct fst_status_hdr | struct fst_status_peer[records_num]
+ *
+ * Every record is written under its own sequence counter, odd while the
+ * record is being written; see fst_status_read_peer() for the reader side.
+ * Records are reused once their peer is gone, so a reader matches them by
+ * the peer addresses rather than by their index.
+ */
+#define FST_STATUS_MAGIC      0x53545346 /* "FSTS" */
+#define FST_STATUS_VERSION    1
+#define FST_STATUS_MAX_IFACES 4
+#define FST_STATUS_NO_IFACE   0xff
+#define FST_STATUS_MIN_PEERS  256
+
+/* in the order of enum fst_mgr_session_state */
+enum fst_status_session_state {
+	FST_STATUS_SESSION_IDLE,
+	FST_STATUS_SESSION_INITIATED,
+	FST_STATUS_SESSION_ESTABLISHED,
+	FST_STATUS_SESSION_IN_TRANSITION,
+	FST_STATUS_SESSION_NONE = 0xff,
+};
+
+struct fst_status_hdr {
+	u32 magic;        /* cleared once the manager is gone */
+	u32 version;
+	u32 hdr_size;     /* offset of the first record */
+	u32 record_size;
+	u32 records_num;
+	u32 records_used; /* records ever in use, the rest are zero */
+	u32 generation;   /* bumped after every record update */
+	u32 overflows;    /* peers left out as all the records were in use */
+	s32 pid;
+	u32 reserved[7];
+};
+
+struct fst_status_iface {
+	char name[FST_MAX_INTERFACE_SIZE];
+	u8   addr[ETH_ALEN]; /* peer address on the iface */
+	u8   reserved[2];
+};
+
+struct fst_status_peer {
+	u32 seq;           /* odd while the record is written */
+	u8  in_use;
+	u8  active;        /* index in ifaces or FST_STATUS_NO_IFACE */
+	u8  ifaces_num;
+	u8  session_state; /* enum fst_status_session_state */
+	u32 session_id;
+	u32 switches;      /* active iface changes */
+	u64 switch_us;     /* last change, CLOCK_MONOTONIC; 0 if none */
+	char group[FST_MAX_GROUP_ID_SIZE];
+	struct fst_status_iface ifaces[FST_STATUS_MAX_IFACES];
+};
+
+/**
+ * fst_status_read_peer - take a consistent copy of a record
+ * @hdr: status page mapped by the reader
+ * @idx: record index, below hdr->records_used
+ * @peer: buffer for the copy
+ * Returns: 0 on success, -1 if the record is not in use or is still being
+ *	written after a number of attempts
+ */
+static inline int fst_status_read_peer(const struct fst_status_hdr *hdr,
+	unsigned int idx, struct fst_status_peer *peer)
+{
+	const struct fst_status_peer *r = (const struct fst_status_peer *)
+		((const u8 *)hdr + hdr->hdr_size + (size_t)idx * hdr->record_size);
+	unsigned int attempts;
+	u32 seq;
+
+	for (attempts = 0; attempts < 1000; attempts++) {
+		seq = __atomic_load_n(&r->seq, __ATOMIC_ACQUIRE);
+		if (seq & 1)
+			continue;
+		os_memcpy(peer, r, sizeof(*peer));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&r->seq, __ATOMIC_RELAXED) == seq)
+			return peer->in_use ? 0 : -1;
+	}
+	return -1;
+}
+
+/* NULL while the status page is disabled */
+extern struct fst_status_hdr *fst_status_page;
+
+/**
+ * fst_status_init - create and map the status page
+ * @path: file to create, replacing any previous one; NULL disables the page
+ * @peers: records to provide, at least FST_STATUS_MIN_PEERS
+ * Returns: 0 on success, -1 on error
+ */
+int fst_status_init(const char *path, unsigned int peers);
+
+/**
+ * fst_status_deinit - mark the status page stale, unmap and remove it
+ */
+void fst_status_deinit(void);
+
+/**
+ * fst_status_peer_alloc - take a free record for a peer
+ * @group: group id of the peer
+ * Returns: record index or -1 if the page is disabled or full
+ */
+int fst_status_peer_alloc(const char *group);
+
+/**
+ * fst_status_peer_free - release a record taken by fst_status_peer_alloc()
+ * @idx: record index, -1 is ignored
+ */
+void fst_status_peer_free(int idx);
+
+/**
+ * fst_status_peer_begin - start an update of a record
+ * @idx: record index, -1 is ignored
+ * Returns: record to fill in or NULL; fst_status_peer_end() must follow
+ */
+struct fst_status_peer *fst_status_peer_begin(int idx);
+
+/**
+ * fst_status_peer_end - publish a record filled in after fst_status_peer_begin()
+ * @r: record
+ */
+void fst_status_peer_end(struct fst_status_peer *r);
+
+#endif /* __FST_STATUS_H__ */
@@ -47,12 +47,17 @@
 #include <linux/tc_act/tc_skbedit.h>
 #include <linux/tc_act/tc_mirred.h>
 #include <linux/tc_act/tc_gact.h>
+#include <linux/gen_stats.h>
 #include <net/if.h>
 
 #include "utils/list.h"
 #define FST_MGR_COMPONENT "TC"
 #include "fst_manager.h"
 #include "fst_tc.h"
+#include "fst_trace.h"
+#include "fst_metrics.h"
+#include "fst_pool.h"
+#include "fst_ifreg.h"
 
 #define IF_INDEX_NONE (-1)
 #define MULTIQ_QDISC_HANDLE 0x00010000
@@ -78,11 +83,14 @@
 
 struct fst_tc_iface
 {
-	char ifname[IFNAMSIZ];
-	int ifidx;
+	u16 ifid; /* the ifindex is cached by the interface registry */
 	struct dl_list ifaces_lentry;
 };
 
+/* two slaves for each of a couple of bonds */
+static struct fst_pool fst_tc_iface_pool =
+	FST_POOL_INITIALIZER("tc_iface", struct fst_tc_iface, 0, 4);
+
 struct fst_tc {
 	struct nl_sock *nl;
 	char ifname[IFNAMSIZ];
@@ -90,6 +98,8 @@ struct fst_tc {
 	Boolean is_sta;
 	struct dl_list ifaces;
 	struct dl_list filters;
+	Boolean batch; /* see fst_tc_batch_begin() */
+	unsigned int batch_pending;
 };
 
 static u16 fst_tc_get_lowest_unused_prio(struct fst_tc *f)
@@ -116,18 +126,12 @@ static u16 fst_tc_get_lowest_unused_prio(struct fst_tc *f)
 
 static void tc_set_ifidx(struct fst_tc *f, char *ifname, int ifidx)
 {
-	struct fst_tc_iface *i;
-
 	if (!os_strcmp(f->ifname, ifname)) {
 		f->ifidx = ifidx;
 		return;
 	}
 
-	dl_list_for_each(i, &f->ifaces, struct fst_tc_iface, ifaces_lentry)
-		if (!strcmp(ifname, i->ifname)) {
-			i->ifidx = ifidx;
-			break;
-		}
+	fst_ifreg_set_ifindex(fst_ifreg_lookup(ifname), ifidx);
 }
 
 static int cb_network_link(struct nl_msg *msg, void *arg)
@@ -230,15 +234,16 @@ static inline int tc_multiq_qdisc_modify(struct fst_tc *f, unsigned add)
 static int tc_ingress_qdisc_modify(struct fst_tc *f, unsigned add,
 	struct fst_tc_iface *i)
 {
-	int res = tc_qdisc_modify(f, add, "ingress", i->ifidx,
+	int res = tc_qdisc_modify(f, add, "ingress",
+				fst_ifreg_ifindex(i->ifid),
 				INGRESS_QDISC_HANDLE,
 				TC_H_INGRESS);
 	if (res)
 		fst_mgr_printf(MSG_ERROR, "%s: cannot %s ingress qdisc",
-			i->ifname, add ? "add": "remove");
+			fst_ifreg_name(i->ifid), add ? "add": "remove");
 	else
 		fst_mgr_printf(MSG_DEBUG, "%s: ingress qdisc %s",
-			i->ifname, add ? "added": "removed");
+			fst_ifreg_name(i->ifid), add ? "added": "removed");
 	return res;
 }
 
@@ -258,6 +263,7 @@ static int tc_filter_modify(struct fst_tc *f, unsigned add,
 	struct nl_msg *msg;
 	int nlmsgtype = RTM_DELTFILTER;
 	int nlmsflags = NLM_F_REQUEST | NLM_F_ACK;
+	u64 start_ns = fst_trace_ring ? fst_trace_now() : 0;
 
 	if (add) {
 		nlmsgtype = RTM_NEWTFILTER;
@@ -296,6 +302,13 @@ static int tc_filter_modify(struct fst_tc *f, unsigned add,
 		goto tfm_ret;
 	}
 
+	if (f->batch) {
+		/* the ACK is collected by fst_tc_batch_end() */
+		f->batch_pending++;
+		res = 0;
+		goto tfm_ret;
+	}
+
 	res = nl_recvmsgs_default(f->nl);
 	if(res < 0) {
 		fst_mgr_printf(MSG_ERROR, "nl_recvmsgs_default failed: %s",
@@ -306,6 +319,11 @@ static int tc_filter_modify(struct fst_tc *f, unsigned add,
 
 tfm_ret:
 	nlmsg_free(msg);
+	fst_metrics_inc(netlink_ops);
+	if (res < 0)
+		fst_metrics_inc(netlink_failures);
+	fst_trace_record(FST_TRACE_NETLINK, nlmsgtype, prio,
+		(u32)((fst_trace_now() - start_ns) / 1000), (u32)res, 0);
 	return res;
 }
 
@@ -433,7 +451,7 @@ static int tc_l2da_filter_modify(struct fst_tc *f, unsigned add,
 }
 
 static int tc_filter_add_mirred_action(struct nl_msg *msg,
-	const char *ifname, int prio)
+	int ifindex, int prio)
 {
 	const char kind[] = "mirred";
 	struct nlattr *t_prio, *t_act_opt;
@@ -443,7 +461,7 @@ static int tc_filter_add_mirred_action(struct nl_msg *msg,
 
 	p.eaction = TCA_EGRESS_MIRROR;
 	p.action = TC_ACT_PIPE;
-	p.ifindex = if_nametoindex(ifname);
+	p.ifindex = ifindex;
 
 	t_prio = nla_nest_start(msg, prio);
 	if (t_prio == NULL) {
@@ -531,7 +549,8 @@ static int tc_mc_filter_modify_clb(struct fst_tc *f, unsigned add,
 
 		dl_list_for_each(i, &f->ifaces, struct fst_tc_iface,
 			ifaces_lentry) {
-			res = tc_filter_add_mirred_action(msg, i->ifname, prio);
+			res = tc_filter_add_mirred_action(msg,
+				fst_ifreg_ifindex(i->ifid), prio);
 			if (res < 0)
 				return res;
 			++prio;
@@ -568,6 +587,10 @@ static int fst_tc_get_iface_idxs(struct fst_tc *f)
 	struct rtgenmsg rt_hdr = { .rtgen_family = AF_UNSPEC, };
 	struct fst_tc_iface *i;
 
+	/* forget the indexes cached by a previous start, the dump sets them */
+	dl_list_for_each(i, &f->ifaces, struct fst_tc_iface, ifaces_lentry)
+		fst_ifreg_set_ifindex(i->ifid, 0);
+
 	/* Set the receiving messages callback to get and process the links */
 	nl_socket_modify_cb(f->nl, NL_CB_VALID, NL_CB_CUSTOM, cb_network_link,
 		(void*)f);
@@ -599,13 +622,14 @@ static int fst_tc_get_iface_idxs(struct fst_tc *f)
 		f->ifname, f->ifidx);
 
 	dl_list_for_each(i, &f->ifaces, struct fst_tc_iface, ifaces_lentry) {
-		if (i->ifidx == IF_INDEX_NONE) {
+		if (!fst_ifreg_ifindex(i->ifid)) {
 			fst_mgr_printf(MSG_ERROR,
-				"Cannot find interface %s index", i->ifname);
+				"Cannot find interface %s index",
+				fst_ifreg_name(i->ifid));
 			return -1;
 		}
 		fst_mgr_printf(MSG_INFO, "Interface %s index = %d",
-			i->ifname, i->ifidx);
+			fst_ifreg_name(i->ifid), fst_ifreg_ifindex(i->ifid));
 	}
 
 	return 0;
@@ -628,11 +652,11 @@ static int fst_tc_add_ingress_qdisc(struct fst_tc *f)
 	dl_list_for_each(i, &f->ifaces, struct fst_tc_iface, ifaces_lentry) {
 		if (!tc_ingress_qdisc_modify(f, 1, i))
 			fst_mgr_printf(MSG_WARNING, "%s: ingress qdisc added",
-				i->ifname);
+				fst_ifreg_name(i->ifid));
 		else {
 			fst_mgr_printf(MSG_WARNING,
 				"%s: cannot remove ingress qdisc",
-				i->ifname);
+				fst_ifreg_name(i->ifid));
 			goto add_failed;
 		}
 	}
@@ -652,11 +676,11 @@ static void fst_tc_del_ingress_qdisc(struct fst_tc *f)
 	dl_list_for_each(i, &f->ifaces, struct fst_tc_iface, ifaces_lentry)
 		if (!tc_ingress_qdisc_modify(f, 0, i))
 			fst_mgr_printf(MSG_WARNING, "%s: ingress qdisc removed",
-				i->ifname);
+				fst_ifreg_name(i->ifid));
 		else
 			fst_mgr_printf(MSG_WARNING,
 				"%s: cannot remove ingress qdisc",
-				i->ifname);
+				fst_ifreg_name(i->ifid));
 }
 
 struct tc_rx_mc_filter_modify_ctx
@@ -723,7 +747,7 @@ static int tc_rx_mc_filter_modify_clb(struct fst_tc *f, unsigned add,
 }
 
 static int fst_tc_modify_rx_mc_filters(struct fst_tc *f, unsigned add,
-	const u8 * mac, const char *active_ifname,
+	const u8 * mac, u16 active_ifid,
 	u16 prio)
 {
 	struct fst_tc_iface *i;
@@ -734,25 +758,26 @@ static int fst_tc_modify_rx_mc_filters(struct fst_tc *f, unsigned add,
 	dl_list_for_each(i, &f->ifaces, struct fst_tc_iface, ifaces_lentry) {
 		int res;
 
-		if (!os_strcmp(i->ifname, active_ifname))
+		if (i->ifid == active_ifid)
 			continue;
 
 		res = tc_filter_modify(f, add, INGRESS_QDISC_HANDLE,
-			i->ifidx, prio, "u32", tc_rx_mc_filter_modify_clb, &ctx);
+			fst_ifreg_ifindex(i->ifid), prio, "u32",
+			tc_rx_mc_filter_modify_clb, &ctx);
 
 		if (res)
 			fst_mgr_printf(MSG_WARNING,
 				"%s: cannot %s ingress filter#%u",
-				i->ifname, add ? "add" : "remove",
+				fst_ifreg_name(i->ifid), add ? "add" : "remove",
 				prio);
 		else if (add)
 			fst_mgr_printf(MSG_DEBUG,
 				"%s: ingress filter#%u for " MACSTR " added",
-				i->ifname, prio, MAC2STR(mac));
+				fst_ifreg_name(i->ifid), prio, MAC2STR(mac));
 		else
 			fst_mgr_printf(MSG_DEBUG,
 				"%s: ingress filter#%u removed",
-				i->ifname, prio);
+				fst_ifreg_name(i->ifid), prio);
 	}
 
 	return 0;
@@ -810,21 +835,23 @@ static int fst_tc_modify_rx_eapol_filters(struct fst_tc *f, unsigned add)
 		int res;
 
 		res = tc_filter_modify(f, add, INGRESS_QDISC_HANDLE,
-			i->ifidx, PRIO_WLAN_RX_EAPOL_FILTER, "u32",
+			fst_ifreg_ifindex(i->ifid), PRIO_WLAN_RX_EAPOL_FILTER,
+			"u32",
 			tc_rx_eapol_filter_modify_clb, NULL);
 
 		if (res)
 			fst_mgr_printf(MSG_WARNING,
 				"%s: cannot %s ingress EAPOL filter",
-				i->ifname, add ? "add" : "remove");
+				fst_ifreg_name(i->ifid),
+				add ? "add" : "remove");
 		else if (add)
 			fst_mgr_printf(MSG_DEBUG,
 				"%s: ingress EAPOL filter added",
-				i->ifname);
+				fst_ifreg_name(i->ifid));
 		else
 			fst_mgr_printf(MSG_DEBUG,
 				"%s: ingress EAPOL filter removed",
-				i->ifname);
+				fst_ifreg_name(i->ifid));
 	}
 
 	return 0;
@@ -842,6 +869,8 @@ struct fst_tc *fst_tc_create(Boolean is_sta)
 	}
 
 	f->ifidx = IF_INDEX_NONE;
+	f->batch = FALSE;
+	f->batch_pending = 0;
 
 	f->nl = nl_socket_alloc();
 	if (f->nl == NULL) {
@@ -959,43 +988,44 @@ void fst_tc_delete(struct fst_tc *f)
 	while ((i = dl_list_first(&f->ifaces,
 			struct fst_tc_iface,
 			ifaces_lentry)) != NULL)
-		fst_tc_unregister_iface(f, i->ifname);
+		fst_tc_unregister_iface(f, i->ifid);
 	free(f);
 }
 
-int fst_tc_register_iface(struct fst_tc *f, const char *ifname)
+int fst_tc_register_iface(struct fst_tc *f, u16 ifid)
 {
 	struct fst_tc_iface *i;
 
-	i = os_zalloc(sizeof(*i));
+	i = fst_pool_zalloc(&fst_tc_iface_pool);
 	if (!i) {
-		fst_mgr_printf(MSG_ERROR, "Cannot register iface %s", ifname);
+		fst_mgr_printf(MSG_ERROR, "Cannot register iface %s",
+			fst_ifreg_name(ifid));
 		return -1;
 	}
 
-	os_strlcpy(i->ifname, ifname, sizeof(i->ifname));
-	i->ifidx = IF_INDEX_NONE;
+	i->ifid = ifid;
 	dl_list_add_tail(&f->ifaces, &i->ifaces_lentry);
 
 	return 0;
 }
 
-void fst_tc_unregister_iface(struct fst_tc *f, const char *ifname)
+void fst_tc_unregister_iface(struct fst_tc *f, u16 ifid)
 {
 	struct fst_tc_iface *i;
 
 	dl_list_for_each(i, &f->ifaces, struct fst_tc_iface, ifaces_lentry) {
-		if (os_strcmp(i->ifname, ifname)) {
+		if (i->ifid == ifid) {
 			dl_list_del(&i->ifaces_lentry);
-			os_free(i);
+			fst_pool_free(&fst_tc_iface_pool, i);
 			break;
 		}
 	}
 }
 
 int fst_tc_add_l2da_filter(struct fst_tc *f, const uint8_t * mac, int queue_id,
-	const char *ifname, struct fst_tc_filter_handle *filter_handle)
+	u16 ifid, struct fst_tc_filter_handle *filter_handle)
 {
+	const char *ifname = fst_ifreg_name(ifid);
 	int res;
 
 	filter_handle->prio = fst_tc_get_lowest_unused_prio(f);
@@ -1039,7 +1069,7 @@ int fst_tc_add_l2da_filter(struct fst_tc *f, const uint8_t * mac, int queue_id,
 			goto l2da_filter_fail;
 		}
 
-		res = fst_tc_modify_rx_mc_filters(f, 1, mac, ifname,
+		res = fst_tc_modify_rx_mc_filters(f, 1, mac, ifid,
 			filter_handle->prio);
 		if (res != 0)  {
 			fst_mgr_printf(MSG_ERROR, "%s: cannot add RX MC filter",
@@ -1048,8 +1078,7 @@ int fst_tc_add_l2da_filter(struct fst_tc *f, const uint8_t * mac, int queue_id,
 		}
 	}
 
-	os_strlcpy(filter_handle->ifname, ifname,
-		sizeof(filter_handle->ifname));
+	filter_handle->ifid = ifid;
 	dl_list_add(&f->filters, &filter_handle->filters_lentry);
 
 	return 0;
@@ -1070,14 +1099,16 @@ int fst_tc_del_l2da_filter(struct fst_tc *f,
 
 	if (tc_l2da_filter_modify(f, 0, NULL, 0, filter_handle->prio)) {
 		fst_mgr_printf(MSG_ERROR, "%s: cannot del UC filter#%u",
-			filter_handle->ifname, filter_handle->prio);
+			fst_ifreg_name(filter_handle->ifid),
+			filter_handle->prio);
 		res = -1;
 	}
 
 	if (f->is_sta && fst_tc_modify_rx_mc_filters(f, 0, NULL,
-		filter_handle->ifname, filter_handle->prio) != 0) {
+		filter_handle->ifid, filter_handle->prio) != 0) {
 		fst_mgr_printf(MSG_ERROR, "%s: cannot del MC RX filter#%u",
-			filter_handle->ifname, filter_handle->prio);
+			fst_ifreg_name(filter_handle->ifid),
+			filter_handle->prio);
 		res = -1;
 	}
 
@@ -1087,3 +1118,134 @@ int fst_tc_del_l2da_filter(struct fst_tc *f,
 	return res;
 }
 
+struct tc_l2da_bytes_ctx {
+	struct fst_tc *f;
+	fst_tc_bytes_cb cb;
+	void *cb_ctx;
+};
+
+static int cb_l2da_bytes(struct nl_msg *msg, void *arg)
+{
+	struct tc_l2da_bytes_ctx *c = arg;
+	struct nlmsghdr *hdr = nlmsg_hdr(msg);
+	struct tcmsg *t = nlmsg_data(hdr);
+	struct nlattr *tb[TCA_MAX + 1];
+	struct nlattr *opts[TCA_U32_MAX + 1];
+	struct nlattr *acts[TCA_ACT_MAX_PRIO + 1];
+	struct nlattr *act[TCA_ACT_MAX + 1];
+	struct nlattr *stats[TCA_STATS_MAX + 1];
+	struct gnet_stats_basic basic;
+	struct fst_tc_filter_handle *h;
+	u16 prio = TC_H_MAJ(t->tcm_info) >> 16;
+
+	if (hdr->nlmsg_type != RTM_NEWTFILTER || t->tcm_ifindex != c->f->ifidx)
+		return NL_OK;
+
+	/* OPTIONS -> U32_ACT -> action#1 -> ACT_STATS -> STATS_BASIC. The
+	 * key node of a filter carries no actions and is skipped here.
+	 */
+	if (nlmsg_parse(hdr, sizeof(*t), tb, TCA_MAX, NULL) < 0 ||
+	    !tb[TCA_OPTIONS] ||
+	    nla_parse_nested(opts, TCA_U32_MAX, tb[TCA_OPTIONS], NULL) < 0 ||
+	    !opts[TCA_U32_ACT] ||
+	    nla_parse_nested(acts, TCA_ACT_MAX_PRIO, opts[TCA_U32_ACT],
+		NULL) < 0 || !acts[1] ||
+	    nla_parse_nested(act, TCA_ACT_MAX, acts[1], NULL) < 0 ||
+	    !act[TCA_ACT_KIND] || !act[TCA_ACT_STATS] ||
+	    nla_parse_nested(stats, TCA_STATS_MAX, act[TCA_ACT_STATS],
+		NULL) < 0 || !stats[TCA_STATS_BASIC])
+		return NL_OK;
+
+	/* the MC duplication filter shares a prio with the first L2DA one */
+	if (os_strcmp(nla_get_string(act[TCA_ACT_KIND]), "skbedit"))
+		return NL_OK;
+
+	os_memset(&basic, 0, sizeof(basic));
+	nla_memcpy(&basic, stats[TCA_STATS_BASIC], sizeof(basic));
+
+	dl_list_for_each(h, &c->f->filters, struct fst_tc_filter_handle,
+		filters_lentry) {
+		if (h->prio == prio) {
+			c->cb(h, basic.bytes, c->cb_ctx);
+			break;
+		}
+	}
+
+	return NL_OK;
+}
+
+int fst_tc_get_l2da_bytes(struct fst_tc *f, fst_tc_bytes_cb cb, void *cb_ctx)
+{
+	struct tc_l2da_bytes_ctx ctx = { .f = f, .cb = cb, .cb_ctx = cb_ctx };
+	struct tcmsg t;
+	struct nl_msg *msg;
+	int res;
+
+	WPA_ASSERT(!f->batch);
+
+	if (f->ifidx == IF_INDEX_NONE)
+		return -1;
+
+	msg = nlmsg_alloc_simple(RTM_GETTFILTER, NLM_F_REQUEST | NLM_F_DUMP);
+	if (!msg) {
+		fst_mgr_printf(MSG_ERROR, "nlmsg_alloc_simple failed");
+		return -1;
+	}
+
+	os_memset(&t, 0, sizeof(t));
+	t.tcm_family = AF_UNSPEC;
+	t.tcm_ifindex = f->ifidx;
+	t.tcm_parent = MULTIQ_QDISC_HANDLE;
+	if (nlmsg_append(msg, &t, sizeof(t), NLMSG_ALIGNTO) < 0) {
+		fst_mgr_printf(MSG_ERROR, "nlmsg_append failed");
+		nlmsg_free(msg);
+		return -1;
+	}
+
+	nl_socket_modify_cb(f->nl, NL_CB_VALID, NL_CB_CUSTOM, cb_l2da_bytes,
+		&ctx);
+
+	res = nl_send_auto(f->nl, msg);
+	nlmsg_free(msg);
+	if (res >= 0)
+		res = nl_recvmsgs_default(f->nl);
+
+	nl_socket_modify_cb(f->nl, NL_CB_VALID, NL_CB_DEFAULT, NULL, NULL);
+
+	if (res < 0) {
+		fst_mgr_printf(MSG_ERROR, "%s: filter dump failed: %s",
+			f->ifname, nl_geterror(res));
+		fst_metrics_inc(netlink_failures);
+		return -1;
+	}
+
+	return 0;
+}
+
+void fst_tc_batch_begin(struct fst_tc *f)
+{
+	WPA_ASSERT(!f->batch);
+	f->batch = TRUE;
+	f->batch_pending = 0;
+}
+
+int fst_tc_batch_end(struct fst_tc *f)
+{
+	int failed = 0;
+
+	f->batch = FALSE;
+	/* The kernel acknowledges every request with a separate message */
+	while (f->batch_pending) {
+		int res = nl_recvmsgs_default(f->nl);
+
+		if (res < 0) {
+			fst_mgr_printf(MSG_ERROR, "%s: batched request failed: %s",
+				f->ifname, nl_geterror(res));
+			fst_metrics_inc(netlink_failures);
+			failed++;
+		}
+		f->batch_pending--;
+	}
+
+	return failed;
+}
@@ -42,18 +42,50 @@ int fst_tc_start(struct fst_tc *f, const char *ifname);
 void fst_tc_stop(struct fst_tc *f);
 void fst_tc_delete(struct fst_tc *f);
 
-int fst_tc_register_iface(struct fst_tc *f, const char *ifname);
-void fst_tc_unregister_iface(struct fst_tc *f, const char *ifname);
+/* the interfaces are IDs of the interface registry, see fst_ifreg.h */
+int fst_tc_register_iface(struct fst_tc *f, u16 ifid);
+void fst_tc_unregister_iface(struct fst_tc *f, u16 ifid);
 
 struct fst_tc_filter_handle {
 	u16  prio;
-	char ifname[IFNAMSIZ + 1];
+	u16  ifid;
 	struct dl_list filters_lentry;
 };
 
 int fst_tc_add_l2da_filter(struct fst_tc *f, const u8 *mac, int queue_id,
-	const char *ifname, struct fst_tc_filter_handle *filter_handle);
+	u16 ifid, struct fst_tc_filter_handle *filter_handle);
 int fst_tc_del_l2da_filter(struct fst_tc *f,
 	struct fst_tc_filter_handle *filter_handle);
 
+typedef void (*fst_tc_bytes_cb)(struct fst_tc_filter_handle *filter_handle,
+	u64 bytes, void *cb_ctx);
+
+/**
+ * fst_tc_get_l2da_bytes - read the TX byte counters of the L2DA filters
+ * @f: TC context
+ * @cb: called for every installed filter with the bytes it has redirected
+ * @cb_ctx: context passed to @cb
+ * Returns: 0 on success, -1 if the filters cannot be dumped
+ *
+ * The counters are kept by the kernel per filter, so they start from zero
+ * whenever a filter is re-added.
+ */
+int fst_tc_get_l2da_bytes(struct fst_tc *f, fst_tc_bytes_cb cb, void *cb_ctx);
+
+/**
+ * fst_tc_batch_begin - start batching filter modifications
+ * @f: TC context
+ *
+ * Until fst_tc_batch_end() is called, filter modifications are sent to the
+ * kernel without waiting for the acknowledgement of each one.
+ */
+void fst_tc_batch_begin(struct fst_tc *f);
+
+/**
+ * fst_tc_batch_end - collect acknowledgements of a batch
+ * @f: TC context
+ * Returns: number of modifications in the batch that failed
+ */
+int fst_tc_batch_end(struct fst_tc *f);
+
 #endif /* __FST_TC_H__ */
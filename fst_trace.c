@@ -0,0 +1,284 @@
+/*
+ * FST Manager: binary trace ring
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <time.h>
+
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "common/defs.h"
+#include "fst_trace.h"
+#define FST_MGR_COMPONENT "TRACE"
+#include "fst_manager.h"
+
+struct fst_trace_rec *fst_trace_ring = NULL;
+static unsigned int fst_trace_mask;
+static u64 fst_trace_head; /* total number of records ever stored */
+
+static const char *fst_trace_event_names[FST_TRACE_EVENT_LAST] = {
+	[FST_TRACE_SESSION_STATE] = "SESSION_STATE",
+	[FST_TRACE_MUX_MAP_ADD] = "MUX_MAP_ADD",
+	[FST_TRACE_MUX_MAP_DEL] = "MUX_MAP_DEL",
+	[FST_TRACE_CTRL_CMD] = "CTRL_CMD",
+	[FST_TRACE_NETLINK] = "NETLINK",
+};
+
+/* in the order of enum fst_mgr_session_state */
+static const char *fst_trace_state_names[] = {
+	"IDLE", "INITIATED", "ESTABLISHED", "IN_TRANSITION",
+};
+
+int fst_trace_init(unsigned int size)
+{
+	unsigned int n = 1;
+
+	fst_trace_deinit();
+	if (!size)
+		return 0;
+
+	while (n < size)
+		n <<= 1;
+	fst_trace_ring = os_calloc(n, sizeof(*fst_trace_ring));
+	if (!fst_trace_ring) {
+		fst_mgr_printf(MSG_ERROR, "Cannot allocate %u trace records", n);
+		return -1;
+	}
+
+	fst_trace_mask = n - 1;
+	fst_trace_head = 0;
+	fst_mgr_printf(MSG_INFO, "tracing to a ring of %u records", n);
+	return 0;
+}
+
+void fst_trace_deinit(void)
+{
+	os_free(fst_trace_ring);
+	fst_trace_ring = NULL;
+	fst_trace_head = 0;
+}
+
+u64 fst_trace_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void _fst_trace_record(enum fst_trace_event event, u32 a0, u32 a1, u32 a2,
+	u32 a3, u32 a4)
+{
+	struct fst_trace_rec *r =
+		&fst_trace_ring[fst_trace_head++ & fst_trace_mask];
+
+	r->ts_ns = fst_trace_now();
+	r->event = event;
+	r->arg[0] = a0;
+	r->arg[1] = a1;
+	r->arg[2] = a2;
+	r->arg[3] = a3;
+	r->arg[4] = a4;
+}
+
+void fst_trace_ctrl_cmd(const char *cmd, u64 start_ns, int res)
+{
+	u8 verb[12];
+	const char *p;
+	size_t len;
+
+	if (!fst_trace_ring)
+		return;
+
+	/* skip the "FST-MANAGER " style prefix of the hostapd commands */
+	p = os_strchr(cmd, ' ');
+	if (p && !os_strncmp(cmd, "FST-", 4))
+		cmd = p + 1;
+	for (len = 0; len < sizeof(verb) && cmd[len] && cmd[len] != ' '; len++)
+		;
+	os_memset(verb, 0, sizeof(verb));
+	os_memcpy(verb, cmd, len);
+
+	_fst_trace_record(FST_TRACE_CTRL_CMD, WPA_GET_BE32(verb),
+		WPA_GET_BE32(verb + 4), WPA_GET_BE32(verb + 8),
+		(u32)((fst_trace_now() - start_ns) / 1000), (u32)res);
+}
+
+static const char *fst_trace_state_name(u32 state)
+{
+	if (state >= ARRAY_SIZE(fst_trace_state_names))
+		return "UNKNOWN";
+	return fst_trace_state_names[state];
+}
+
+static void fst_trace_verb(const struct fst_trace_rec *r, char *verb)
+{
+	WPA_PUT_BE32((u8 *)verb, r->arg[0]);
+	WPA_PUT_BE32((u8 *)verb + 4, r->arg[1]);
+	WPA_PUT_BE32((u8 *)verb + 8, r->arg[2]);
+	verb[12] = '\0';
+}
+
+/* decodes the record arguments, without the timestamp and the event name */
+static void fst_trace_decode_args(const struct fst_trace_rec *r, char *buf,
+	size_t size)
+{
+	char verb[13];
+
+	switch (r->event) {
+	case FST_TRACE_SESSION_STATE:
+		os_snprintf(buf, size, "session=%u %s -> %s", r->arg[0],
+			fst_trace_state_name(r->arg[1]),
+			fst_trace_state_name(r->arg[2]));
+		break;
+	case FST_TRACE_MUX_MAP_ADD:
+	case FST_TRACE_MUX_MAP_DEL:
+		os_snprintf(buf, size, "da=%02x:%02x:%02x:%02x:%02x:%02x res=%d",
+			(r->arg[0] >> 8) & 0xff, r->arg[0] & 0xff,
+			(r->arg[1] >> 24) & 0xff, (r->arg[1] >> 16) & 0xff,
+			(r->arg[1] >> 8) & 0xff, r->arg[1] & 0xff,
+			(int)r->arg[2]);
+		break;
+	case FST_TRACE_CTRL_CMD:
+		fst_trace_verb(r, verb);
+		os_snprintf(buf, size, "cmd=%s latency_us=%u res=%d", verb,
+			r->arg[3], (int)r->arg[4]);
+		break;
+	case FST_TRACE_NETLINK:
+		os_snprintf(buf, size, "op=%u arg=%u latency_us=%u res=%d",
+			r->arg[0], r->arg[1], r->arg[2], (int)r->arg[3]);
+		break;
+	default:
+		os_snprintf(buf, size, "%u %u %u %u %u", r->arg[0], r->arg[1],
+			r->arg[2], r->arg[3], r->arg[4]);
+		break;
+	}
+}
+
+static const char *fst_trace_event_name(u32 event)
+{
+	if (event >= FST_TRACE_EVENT_LAST || !fst_trace_event_names[event])
+		return "UNKNOWN";
+	return fst_trace_event_names[event];
+}
+
+static void fst_trace_dump_text(FILE *f, const struct fst_trace_rec *r)
+{
+	char args[128];
+
+	fst_trace_decode_args(r, args, sizeof(args));
+	if (f)
+		fprintf(f, "[%llu.%09llu] %s %s\n",
+			(unsigned long long)(r->ts_ns / 1000000000ULL),
+			(unsigned long long)(r->ts_ns % 1000000000ULL),
+			fst_trace_event_name(r->event), args);
+	else
+		fst_mgr_printf(MSG_INFO, "[%llu.%09llu] %s %s",
+			(unsigned long long)(r->ts_ns / 1000000000ULL),
+			(unsigned long long)(r->ts_ns % 1000000000ULL),
+			fst_trace_event_name(r->event), args);
+}
+
+/*
+ * Commands and netlink operations become complete ("X") events spanning
+ * their latency, everything else is an instant ("i") event.
+ */
+static void fst_trace_dump_chrome(FILE *f, const struct fst_trace_rec *r,
+	Boolean first)
+{
+	u64 ts_us = r->ts_ns / 1000, dur_us = 0;
+	const char *name = fst_trace_event_name(r->event);
+	char verb[13], args[128];
+
+	fst_trace_decode_args(r, args, sizeof(args));
+	if (r->event == FST_TRACE_CTRL_CMD) {
+		fst_trace_verb(r, verb);
+		name = verb;
+		dur_us = r->arg[3];
+	} else if (r->event == FST_TRACE_NETLINK)
+		dur_us = r->arg[2];
+
+	fprintf(f, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"pid\":1,\"tid\":1,",
+		first ? "" : ",", name, fst_trace_event_name(r->event));
+	if (r->event == FST_TRACE_CTRL_CMD || r->event == FST_TRACE_NETLINK)
+		fprintf(f, "\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,",
+			(unsigned long long)(ts_us - dur_us),
+			(unsigned long long)dur_us);
+	else
+		fprintf(f, "\"ph\":\"i\",\"s\":\"g\",\"ts\":%llu,",
+			(unsigned long long)ts_us);
+	fprintf(f, "\"args\":{\"info\":\"%s\"}}", args);
+}
+
+int fst_trace_dump(const char *path, enum fst_trace_format format)
+{
+	FILE *f = NULL;
+	u64 idx, first;
+
+	if (!fst_trace_ring) {
+		fst_mgr_printf(MSG_WARNING, "tracing is disabled");
+		return -1;
+	}
+
+	if (path) {
+		f = fopen(path, "w");
+		if (!f) {
+			fst_mgr_printf(MSG_ERROR, "Cannot open %s: %s", path,
+				strerror(errno));
+			return -1;
+		}
+	} else if (format != FST_TRACE_FORMAT_TEXT) {
+		fst_mgr_printf(MSG_ERROR, "trace file is required");
+		return -1;
+	}
+
+	first = fst_trace_head > fst_trace_mask ?
+		fst_trace_head - fst_trace_mask - 1 : 0;
+	if (format == FST_TRACE_FORMAT_CHROME)
+		fprintf(f, "{\"traceEvents\":[");
+	for (idx = first; idx < fst_trace_head; idx++) {
+		const struct fst_trace_rec *r =
+			&fst_trace_ring[idx & fst_trace_mask];
+
+		if (format == FST_TRACE_FORMAT_CHROME)
+			fst_trace_dump_chrome(f, r, idx == first);
+		else
+			fst_trace_dump_text(f, r);
+	}
+	if (format == FST_TRACE_FORMAT_CHROME)
+		fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+	fst_mgr_printf(MSG_INFO, "%llu trace records dumped%s%s",
+		(unsigned long long)(fst_trace_head - first),
+		path ? " to " : "", path ? path : "");
+	if (f)
+		fclose(f);
+	return 0;
+}
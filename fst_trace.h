@@ -0,0 +1,120 @@
+/*
+ * FST Manager: binary trace ring definitions
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __FST_TRACE_H__
+#define __FST_TRACE_H__
+
+#include "utils/common.h"
+
+enum fst_trace_event {
+	FST_TRACE_SESSION_STATE, /* session id, old state, new state */
+	FST_TRACE_MUX_MAP_ADD,   /* da[0..1], da[2..5], result */
+	FST_TRACE_MUX_MAP_DEL,   /* da[0..1], da[2..5], result */
+	FST_TRACE_CTRL_CMD,      /* verb[0..11], latency us, result */
+	FST_TRACE_NETLINK,       /* op, arg, latency us, result */
+	FST_TRACE_EVENT_LAST
+};
+
+#define FST_TRACE_ARGS 5
+
+struct fst_trace_rec {
+	u64 ts_ns; /* CLOCK_MONOTONIC */
+	u32 event;
+	u32 arg[FST_TRACE_ARGS];
+};
+
+enum fst_trace_format {
+	FST_TRACE_FORMAT_TEXT,
+	FST_TRACE_FORMAT_CHROME, /* chrome://tracing JSON */
+};
+
+/* NULL while tracing is disabled */
+extern struct fst_trace_rec *fst_trace_ring;
+
+/**
+ * fst_trace_init - allocate the trace ring
+ * @size: number of records, rounded up to a power of 2; 0 disables tracing
+ * Returns: 0 on success, -1 on error
+ */
+int fst_trace_init(unsigned int size);
+
+/**
+ * fst_trace_deinit - free the trace ring
+ */
+void fst_trace_deinit(void);
+
+/**
+ * fst_trace_now - current CLOCK_MONOTONIC time in ns
+ */
+u64 fst_trace_now(void);
+
+void _fst_trace_record(enum fst_trace_event event, u32 a0, u32 a1, u32 a2,
+	u32 a3, u32 a4);
+
+/**
+ * fst_trace_record - store a record in the ring, overwriting the oldest one
+ *
+ * The arguments are not formatted, see the decoders in fst_trace_dump().
+ */
+#define fst_trace_record(event, a0, a1, a2, a3, a4) \
+	do { \
+		if (fst_trace_ring) \
+			_fst_trace_record((event), (a0), (a1), (a2), (a3), (a4)); \
+	} while (0)
+
+/**
+ * fst_trace_map - record a mux map change
+ * @event: FST_TRACE_MUX_MAP_ADD or FST_TRACE_MUX_MAP_DEL
+ * @da: destination address
+ * @res: result of the change
+ */
+#define fst_trace_map(event, da, res) \
+	fst_trace_record((event), WPA_GET_BE16(da), WPA_GET_BE32((da) + 2), \
+		(u32)(res), 0, 0)
+
+/**
+ * fst_trace_ctrl_cmd - record a control command with its latency
+ * @cmd: command line, only its verb is stored
+ * @start_ns: fst_trace_now() before the command was sent
+ * @res: result of the command
+ */
+void fst_trace_ctrl_cmd(const char *cmd, u64 start_ns, int res);
+
+/**
+ * fst_trace_dump - decode the ring into a file, oldest record first
+ * @path: file name, or NULL for the log
+ * @format: output format
+ * Returns: 0 on success, -1 on error
+ */
+int fst_trace_dump(const char *path, enum fst_trace_format format);
+
+#endif /* __FST_TRACE_H__ */
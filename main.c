@@ -46,6 +46,11 @@
 #include "fst_manager.h"
 #include "fst_ctrl.h"
 #include "fst_cfgmgr.h"
+#include "fst_trace.h"
+#include "fst_status.h"
+#include "fst_metrics.h"
+#include "fst_ctrl_prof.h"
+#include "fst_pool.h"
 
 #define DEFAULT_FST_INIT_RETRY_PERIOD_SEC 1
 #define MAX_CTRL_IFACE_SIZE 256
@@ -58,7 +63,30 @@ extern void fst_ctrl_free(void);
 unsigned int fst_debug_level = MSG_INFO;
 unsigned int fst_num_of_retries = 20;
 unsigned int fst_ping_interval = 1;
+unsigned int fst_retry_backoff_ms = 100;
+unsigned int fst_max_concurrent_setups = 4;
+unsigned int fst_setup_rate = 0;
+unsigned int fst_setup_burst = 4;
+unsigned int fst_lazy_setup_rate = 0;
+unsigned int fst_session_pool_size = 4;
+/*
+ * A home AP serves a handful of FST capable stations, so the pools only
+ * preallocate for 16 and take the rest from the heap. An AP with more should
+ * set -N to its station limit, fstman_pool_heap_high_water shows by how much
+ * the pools ran over.
+ */
+unsigned int fst_max_peers = 16;
+unsigned int fst_resync_interval = 60;
 Boolean      fst_force_nc = FALSE;
+static unsigned int fst_trace_size = 0;
+static const char *fst_trace_file = NULL;
+static const char *fst_metrics_sock = NULL;
+static const char *fst_metrics_file = NULL;
+static const char *fst_status_file = NULL;
+static const char *fst_ctrl_record_path = NULL;
+static const char *fst_ctrl_replay_path = NULL;
+static Boolean fst_ctrl_replay_fast = FALSE;
+static Boolean fst_ctrl_replay_virtual = FALSE;
 static Boolean fst_main_do_loop = FALSE;
 static Boolean fst_continuous_loop = FALSE;
 static Boolean terminate_signalled = FALSE;
@@ -76,6 +104,19 @@ static void fst_manager_eloop_terminate(int sig, void *signal_ctx)
 	fst_manager_signal_terminate(sig);
 }
 
+static void fst_manager_eloop_dump_stats(int sig, void *signal_ctx)
+{
+	fst_manager_dump_stats();
+}
+
+static void fst_manager_eloop_dump_trace(int sig, void *signal_ctx)
+{
+	const char *ext = fst_trace_file ? os_strrchr(fst_trace_file, '.') : NULL;
+
+	fst_trace_dump(fst_trace_file, ext && !os_strcmp(ext, ".json") ?
+		FST_TRACE_FORMAT_CHROME : FST_TRACE_FORMAT_TEXT);
+}
+
 static void usage(const char *prog)
 {
 	printf("Usage: %s [options] [<ctrl_interace_name>]\n", prog);
@@ -87,8 +128,46 @@ static void usage(const char *prog)
 			"wpa_supplicant/hostapd\n"
 	       "\t--config, -c <file> - read the FST configuration from the file\n"
 	       "\t--retries -r <int>  - number of session setup retries.\n"
+	       "\t--backoff -k <int>  - initial setup retry backoff in ms, "
+			"doubled on every retry\n"
+	       "\t--max-setups -s <int> - max concurrent setups per group, "
+			"0 for unlimited\n"
+	       "\t--setup-rate -R <int> - setups admitted per second and "
+			"group, 0 for unlimited\n"
+	       "\t--setup-burst -K <int> - setups admitted back to back "
+			"within the setup rate\n"
+	       "\t--lazy-setup -L <int> - defer setups of peers sent less "
+			"than <int> bytes/s, 0 to set up all\n"
+	       "\t--session-pool -P <int> - pre-created sessions per group, "
+			"0 to disable\n"
+	       "\t--max-peers -N <int> - peers the object pools are "
+			"preallocated for, 0 to disable\n"
+	       "\t--resync -y <int>   - state resync with hostapd interval in "
+			"sec, 0 to resync on event loss only\n"
 	       "\t--ping-int -p <int> - CLI ping interval in sec, 0 to disable\n"
 	       "\t--force-nc -n       - force non-compliant mode.\n"
+	       "\t--ctrl-slow -w <int> - log control commands slower than "
+			"this many ms, 0 to disable\n"
+	       "\t--ctrl-queue -g <int> - read the events on a thread into a "
+			"queue of this many KiB, 0 to disable\n"
+	       "\t--trace -t <int>    - trace ring size in records, 0 to "
+			"disable\n"
+	       "\t--trace-file -T <file> - file the trace is dumped to on "
+			"SIGUSR2, Chrome JSON if named *.json\n"
+	       "\t--metrics-socket -M <path> - serve Prometheus metrics on "
+			"a unix socket\n"
+	       "\t--metrics-file -m <file> - periodically write Prometheus "
+			"metrics to the file\n"
+	       "\t--status-file -S <file> - publish the active iface of "
+			"every peer in a shared memory file\n"
+	       "\t--ctrl-record -O <file> - capture the control traffic to "
+			"the file\n"
+	       "\t--ctrl-replay -I <file> - replay a capture instead of "
+			"connecting to the control interface\n"
+	       "\t--replay-fast -X    - replay the capture as fast as "
+			"possible\n"
+	       "\t--replay-virtual -z - replay the capture on a virtual "
+			"clock, keeping its timing without waiting for it\n"
 	       "\t--debug, -d         - increase debugging verbosity (-dd - more, "
 			"-ddd - even more)\n"
 	       "\t--logfile, -f <file>- log output to specified file\n"
@@ -100,7 +179,10 @@ static void usage(const char *prog)
 
 void main_loop(const char *ctrl_iface)
 {
-	if (!fst_ctrl_create(ctrl_iface, fst_ping_interval)) {
+	if (fst_ctrl_replay_path ?
+	    !fst_ctrl_replay_create(fst_ctrl_replay_path,
+		fst_ctrl_replay_fast) :
+	    !fst_ctrl_create(ctrl_iface, fst_ping_interval)) {
 		fst_mgr_printf(MSG_ERROR, "cannot create fst_ctrl");
 		goto error_fst_ctrl_create;
 	}
@@ -137,8 +219,27 @@ int main(int argc, char *argv[])
 		{"daemonex", no_argument, NULL, 'b'},
 		{"config",   required_argument, NULL, 'c'},
 		{"retries",  required_argument, NULL, 'r'},
+		{"backoff",  required_argument, NULL, 'k'},
+		{"max-setups", required_argument, NULL, 's'},
+		{"setup-rate", required_argument, NULL, 'R'},
+		{"setup-burst", required_argument, NULL, 'K'},
+		{"lazy-setup", required_argument, NULL, 'L'},
+		{"session-pool", required_argument, NULL, 'P'},
+		{"max-peers", required_argument, NULL, 'N'},
+		{"resync", required_argument, NULL, 'y'},
 		{"ping-int",  required_argument, NULL, 'p'},
 		{"force-nc", no_argument, NULL, 'n'},
+		{"trace",    required_argument, NULL, 't'},
+		{"trace-file", required_argument, NULL, 'T'},
+		{"metrics-socket", required_argument, NULL, 'M'},
+		{"metrics-file", required_argument, NULL, 'm'},
+		{"status-file", required_argument, NULL, 'S'},
+		{"ctrl-slow", required_argument, NULL, 'w'},
+		{"ctrl-queue", required_argument, NULL, 'g'},
+		{"ctrl-record", required_argument, NULL, 'O'},
+		{"ctrl-replay", required_argument, NULL, 'I'},
+		{"replay-fast", no_argument, NULL, 'X'},
+		{"replay-virtual", no_argument, NULL, 'z'},
 		{"debug",    optional_argument, NULL, 'd'},
 		{"logfile",  required_argument, NULL, 'f'},
 		{"usage",    no_argument, NULL, 'u'},
@@ -146,7 +247,7 @@ int main(int argc, char *argv[])
 		{NULL}
 	};
 	int res = -1;
-	char short_opts[] = "VBbc:r:nd::f:uh";
+	char short_opts[] = "VBbc:r:k:s:R:K:L:P:N:y:nt:T:M:m:S:w:g:O:I:Xzd::f:uh";
 	const char *ctrl_iface = NULL;
 	char *fstman_config_file = NULL;
 	int opt, i;
@@ -185,10 +286,78 @@ int main(int argc, char *argv[])
 			if (optarg != NULL)
 				fst_num_of_retries = strtoul(optarg, NULL, 0);
 			break;
+		case 'k':
+			if (optarg != NULL)
+				fst_retry_backoff_ms = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			if (optarg != NULL)
+				fst_max_concurrent_setups =
+					strtoul(optarg, NULL, 0);
+			break;
+		case 'R':
+			if (optarg != NULL)
+				fst_setup_rate = strtoul(optarg, NULL, 0);
+			break;
+		case 'K':
+			if (optarg != NULL)
+				fst_setup_burst = strtoul(optarg, NULL, 0);
+			break;
+		case 'L':
+			if (optarg != NULL)
+				fst_lazy_setup_rate = strtoul(optarg, NULL, 0);
+			break;
+		case 'P':
+			if (optarg != NULL)
+				fst_session_pool_size =
+					strtoul(optarg, NULL, 0);
+			break;
+		case 'N':
+			if (optarg != NULL)
+				fst_max_peers = strtoul(optarg, NULL, 0);
+			break;
+		case 'y':
+			if (optarg != NULL)
+				fst_resync_interval = strtoul(optarg, NULL, 0);
+			break;
 		case 'p':
 			if (optarg != NULL)
 				fst_ping_interval = strtoul(optarg, NULL, 0);
 			break;
+		case 't':
+			if (optarg != NULL)
+				fst_trace_size = strtoul(optarg, NULL, 0);
+			break;
+		case 'T':
+			fst_trace_file = optarg;
+			break;
+		case 'M':
+			fst_metrics_sock = optarg;
+			break;
+		case 'm':
+			fst_metrics_file = optarg;
+			break;
+		case 'S':
+			fst_status_file = optarg;
+			break;
+		case 'w':
+			fst_ctrl_prof_slow_ms = strtoul(optarg, NULL, 0);
+			break;
+		case 'g':
+			fst_ctrl_ingest_kb = strtoul(optarg, NULL, 0);
+			break;
+		case 'O':
+			fst_ctrl_record_path = optarg;
+			break;
+		case 'I':
+			fst_ctrl_replay_path = optarg;
+			break;
+		case 'X':
+			fst_ctrl_replay_fast = TRUE;
+			break;
+		case 'z':
+			fst_ctrl_replay_virtual = TRUE;
+			break;
 		case 'n':
 			fst_force_nc = TRUE;
 			fst_mgr_printf(MSG_INFO, "Non-compliant FST mode forced\n");
@@ -217,13 +386,29 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	if (!fstman_config_file && argc - optind != 1) {
+	if (!fstman_config_file && !fst_ctrl_replay_path &&
+	    argc - optind != 1) {
 		fst_mgr_printf(MSG_ERROR,
 			"either ctrl_interace_name or config has to be specified");
 		usage(argv[0]);
 		goto error_cfmgr_params;
 	}
 
+	if (fst_ctrl_replay_virtual) {
+		if (!fst_ctrl_replay_path) {
+			fst_mgr_printf(MSG_ERROR,
+				"a virtual clock needs a capture to replay");
+			usage(argv[0]);
+			goto error_cfmgr_params;
+		}
+		/* the timeouts fire as during the capture, without the waits */
+		os_set_virtual_clock(1);
+	}
+
+	/* the log file and the other outputs are written by a thread */
+	if (wpa_debug_async_start())
+		fst_mgr_printf(MSG_WARNING, "cannot start async logging");
+
 	if (fstman_config_file)
 		i = fst_cfgmgr_init(FST_CONFIG_INI, (void*)fstman_config_file);
 	else
@@ -235,6 +420,8 @@ int main(int argc, char *argv[])
 
 	if (argc - optind == 1)
 		ctrl_iface = argv[optind];
+	else if (fst_ctrl_replay_path)
+		ctrl_iface = fst_ctrl_replay_path;
 	else if (!fst_cfgmgr_get_ctrl_iface(buf, sizeof(buf)))
 		ctrl_iface = buf;
 	else {
@@ -247,6 +434,29 @@ int main(int argc, char *argv[])
 		goto error_eloop_init;
 	}
 
+	/* SIGUSR1 dumps the manager statistics to the log */
+	eloop_register_signal(SIGUSR1, fst_manager_eloop_dump_stats, NULL);
+
+	if (fst_trace_init(fst_trace_size)) {
+		fst_mgr_printf(MSG_ERROR, "cannot init trace");
+		goto error_trace_init;
+	}
+	/* SIGUSR2 dumps the trace ring to the trace file or to the log */
+	eloop_register_signal(SIGUSR2, fst_manager_eloop_dump_trace, NULL);
+
+	if (fst_metrics_init(fst_metrics_sock, fst_metrics_file)) {
+		fst_mgr_printf(MSG_ERROR, "cannot init metrics");
+		goto error_metrics_init;
+	}
+
+	if (fst_status_init(fst_status_file, fst_max_peers)) {
+		fst_mgr_printf(MSG_ERROR, "cannot init status page");
+		goto error_status_init;
+	}
+
+	if (fst_ctrl_record_path && fst_ctrl_record_start(fst_ctrl_record_path))
+		goto error_ctrl_record_start;
+
 	signal(SIGINT, fst_manager_signal_terminate);
 	signal(SIGTERM, fst_manager_signal_terminate);
 	while (TRUE) {
@@ -258,14 +468,24 @@ int main(int argc, char *argv[])
 		os_sleep(DEFAULT_FST_INIT_RETRY_PERIOD_SEC, 0);
 	}
 
-	eloop_destroy();
 	res = 0;
 
+	fst_pool_deinit();
+	fst_ctrl_record_stop();
+error_ctrl_record_start:
+	fst_status_deinit();
+error_status_init:
+	fst_metrics_deinit();
+error_metrics_init:
+	fst_trace_deinit();
+error_trace_init:
+	eloop_destroy();
 error_eloop_init:
 error_ctrl_iface:
 	fst_cfgmgr_deinit();
 error_cfmgr_init:
 error_cfmgr_params:
+	wpa_debug_async_stop();
 	wpa_debug_close_file();
 	os_free(fstman_config_file);
 	return res;
@@ -44,6 +44,7 @@
 #include "common/defs.h"
 
 #include "fst_ctrl.h"
+#include "fst_ctrl_prof.h"
 
 #include <glib.h>
 #include <glib-unix.h>
@@ -55,6 +56,14 @@ extern void fst_ctrl_free(void);
 /* globals */
 unsigned int fst_debug_level = MSG_INFO;
 unsigned int fst_num_of_retries = 3;
+unsigned int fst_retry_backoff_ms = 100;
+unsigned int fst_max_concurrent_setups = 4;
+unsigned int fst_setup_rate = 0;
+unsigned int fst_setup_burst = 4;
+unsigned int fst_lazy_setup_rate = 0;
+unsigned int fst_session_pool_size = 0;
+unsigned int fst_max_peers = 16;
+unsigned int fst_resync_interval = 60;
 Boolean      fst_force_nc = FALSE;
 
 static gboolean register_signal_terminate(GSourceFunc handler,
@@ -83,6 +92,7 @@ static void usage(const char *prog)
 	g_print(", where options are:\n"
 	       "\t--version, -V    - show version.\n"
 	       "\t--retries -r     - number of session setup retries.\n"
+	       "\t--ctrl-slow -w   - log D-Bus calls slower than this many ms\n"
 	       "\t--debug, -d      - debug output\n"
 	       "\t--usage, -u      - this message\n"
 	       "\t--help, -h       - this message\n");
@@ -97,12 +107,13 @@ int main(int argc, char *argv[])
 		{"version", 0, NULL, 'V'},
 		{"retries", 1, NULL, 'r'},
 		{"force-nc", 0, NULL, 'n'},
+		{"ctrl-slow", 1, NULL, 'w'},
 		{"debug", 2, NULL, 'd'},
 		{"usage", 0, NULL, 'u'},
 		{"help", 0, NULL, 'h'},
 		{}
 	};
-	char short_opts[] = "vr:nd::uh";
+	char short_opts[] = "vr:nw:d::uh";
 	int opt;
 
 	while ((opt = getopt_long_only(argc, argv, short_opts, long_opts, NULL))
@@ -116,6 +127,9 @@ int main(int argc, char *argv[])
 		case 'r':
 			fst_num_of_retries = strtoul(optarg, NULL, 0);
 			break;
+		case 'w':
+			fst_ctrl_prof_slow_ms = strtoul(optarg, NULL, 0);
+			break;
 		case 'n':
 			fst_force_nc = TRUE;
 			fst_mgr_printf(MSG_INFO,
@@ -0,0 +1,1332 @@
+/*
+ * FST Manager: mock hostapd control interface
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * A stand-in for hostapd serving the FST part of its control interface over
+ * a unix datagram socket, so that fstman can be run and load tested on a
+ * plain Linux box:
+ *
+ *   fstman_mock_hostapd -g bond0:wlan0,wlan1 -p 64 -c 20 /tmp/fst-global &
+ *   fstman /tmp/fst-global
+ *
+ * All peers are connected on all the ifaces of their group at startup.
+ * Sessions follow the FST-MANAGER commands fstman sends; the rates given on
+ * the command line add peer churn, remote initiated setups and switches on
+ * top of that, and a script can inject arbitrary events. Configuration
+ * commands (SET, DUP_NETWORK, ENABLE, ...) are acknowledged but ignored.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <net/if.h>
+
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "utils/list.h"
+#include "common/defs.h"
+#include "common/ieee802_11_defs.h"
+#include "fst/fst_ctrl_defs.h"
+#include "fst/fst_ctrl_aux.h"
+
+#define MOCK_MAX_GROUPS  8
+#define MOCK_MAX_IFACES  4
+#define MOCK_MAX_CLIENTS 8
+#define MOCK_MSG_SIZE    4096
+/* events dropped in a row before a monitor is detached, as in hostapd */
+#define MOCK_MONITOR_MAX_ERRORS 10
+
+#define FST_MANAGER_CMD "FST-MANAGER "
+
+struct mock_iface {
+	char name[IFNAMSIZ + 1];
+	u8 addr[ETH_ALEN];
+	unsigned int priority;
+	unsigned int llt;
+};
+
+struct mock_peer {
+	u8 addr[MOCK_MAX_IFACES][ETH_ALEN];
+	unsigned int connected; /* bitmap of iface indices */
+};
+
+struct mock_group {
+	char id[FST_MAX_GROUP_ID_SIZE];
+	struct mock_iface ifaces[MOCK_MAX_IFACES];
+	unsigned int ifaces_num;
+	struct mock_peer *peers;
+};
+
+struct mock_session {
+	u32 id;
+	struct mock_group *g;
+	enum fst_session_state state;
+	Boolean established;
+	char old_ifname[FST_MAX_INTERFACE_SIZE];
+	char new_ifname[FST_MAX_INTERFACE_SIZE];
+	u8 old_peer_addr[ETH_ALEN];
+	u8 new_peer_addr[ETH_ALEN];
+	unsigned int llt;
+};
+
+struct mock_client {
+	struct sockaddr_un addr;
+	socklen_t addr_len;
+	unsigned int errors; /* events dropped in a row */
+};
+
+struct mock_reply {
+	struct dl_list lentry;
+	struct sockaddr_un addr;
+	socklen_t addr_len;
+	size_t len;
+	char buf[];
+};
+
+/* events generated at a given rate, see mock_rate_tick() */
+struct mock_rate {
+	const char *name;
+	double per_sec;
+	void (*fire)(void);
+	unsigned int interval_us;
+	double credit;
+	u64 fired;
+};
+
+static struct mock {
+	int sock;
+	const char *path;
+	struct mock_group groups[MOCK_MAX_GROUPS];
+	unsigned int groups_num;
+	unsigned int peers_num;
+	struct mock_client clients[MOCK_MAX_CLIENTS];
+	unsigned int clients_num;
+	/* indexed by session id, ids are not reused */
+	struct mock_session **sessions;
+	u32 sessions_size;
+	u32 next_session_id;
+	struct dl_list replies; /* delayed, see mock_reply() */
+	unsigned int latency_us;
+	unsigned int jitter_us;
+	unsigned int setup_delay_ms;
+	unsigned int switch_delay_ms;
+	unsigned int setup_fail_permille;
+	FILE *script;
+	struct {
+		u64 commands;
+		u64 events;
+		u64 events_dropped;
+		u64 setups;
+		u64 setups_failed;
+		u64 switches;
+	} stats;
+} mock;
+
+static void mock_rate_churn(void);
+static void mock_rate_remote_setup(void);
+static void mock_rate_remote_switch(void);
+
+static struct mock_rate mock_rates[] = {
+	{ "churn", 0, mock_rate_churn },
+	{ "remote_setup", 0, mock_rate_remote_setup },
+	{ "remote_switch", 0, mock_rate_remote_switch },
+};
+
+/* helpers */
+static unsigned int mock_random(unsigned int n)
+{
+	return n ? (unsigned int)(os_random() % n) : 0;
+}
+
+static struct mock_group *mock_group_by_id(const char *id)
+{
+	unsigned int i;
+
+	for (i = 0; i < mock.groups_num; i++)
+		if (!os_strcmp(mock.groups[i].id, id))
+			return &mock.groups[i];
+	return NULL;
+}
+
+static int mock_iface_by_name(const char *name, struct mock_group **g)
+{
+	unsigned int i, j;
+
+	for (i = 0; i < mock.groups_num; i++)
+		for (j = 0; j < mock.groups[i].ifaces_num; j++)
+			if (!os_strcmp(mock.groups[i].ifaces[j].name, name)) {
+				*g = &mock.groups[i];
+				return j;
+			}
+	return -1;
+}
+
+static struct mock_peer *mock_peer_by_addr(struct mock_group *g,
+	const u8 *addr, unsigned int *iface_idx)
+{
+	unsigned int i, j;
+
+	for (i = 0; i < mock.peers_num; i++)
+		for (j = 0; j < g->ifaces_num; j++)
+			if (!os_memcmp(g->peers[i].addr[j], addr, ETH_ALEN)) {
+				if (iface_idx)
+					*iface_idx = j;
+				return &g->peers[i];
+			}
+	return NULL;
+}
+
+static struct mock_session *mock_session_by_id(u32 id)
+{
+	return id < mock.sessions_size ? mock.sessions[id] : NULL;
+}
+
+static struct mock_session *mock_session_by_args(const char *args)
+{
+	char *end;
+	unsigned long id = strtoul(args, &end, 0);
+
+	if (end == args || (*end && !isspace(*end)))
+		return NULL;
+	return mock_session_by_id(id);
+}
+
+/* events */
+static void mock_event(const char *fmt, ...)
+{
+	char buf[MOCK_MSG_SIZE];
+	unsigned int i;
+	va_list ap;
+	int len;
+
+	len = os_snprintf(buf, sizeof(buf), "<%d>", MSG_INFO);
+	va_start(ap, fmt);
+	len += vsnprintf(buf + len, sizeof(buf) - len, fmt, ap);
+	va_end(ap);
+	if ((size_t)len >= sizeof(buf))
+		len = sizeof(buf) - 1;
+
+	wpa_printf(MSG_DEBUG, "mock: event %s", buf);
+	mock.stats.events++;
+
+	for (i = 0; i < mock.clients_num; ) {
+		struct mock_client *c = &mock.clients[i];
+
+		if (sendto(mock.sock, buf, len, MSG_DONTWAIT,
+			   (struct sockaddr *)&c->addr, c->addr_len) >= 0) {
+			c->errors = 0;
+			i++;
+			continue;
+		}
+		mock.stats.events_dropped++;
+		/* like hostapd, a monitor that keeps failing is detached */
+		if (errno != EAGAIN ||
+		    ++c->errors > MOCK_MONITOR_MAX_ERRORS) {
+			wpa_printf(MSG_INFO, "mock: dropping monitor %s: %s",
+				c->addr.sun_path, strerror(errno));
+			*c = mock.clients[--mock.clients_num];
+			continue;
+		}
+		i++;
+	}
+}
+
+static void mock_event_peer(struct mock_group *g, struct mock_peer *p,
+	unsigned int iface_idx, Boolean connected)
+{
+	mock_event(FST_CTRL_EVENT_PEER " " FST_CEP_PNAME_IFNAME "=%s "
+		FST_CEP_PNAME_ADDR "=" MACSTR " %s", g->ifaces[iface_idx].name,
+		MAC2STR(p->addr[iface_idx]), connected ?
+		FST_CEP_PNAME_CONNECTED : FST_CEP_PNAME_DISCONNECTED);
+}
+
+static void mock_event_session(struct mock_session *s,
+	enum fst_event_type type)
+{
+	mock_event(FST_CTRL_EVENT_SESSION " " FST_CES_PNAME_SESSION_ID "=%u "
+		FST_CES_PNAME_EVT_TYPE "=%s", s->id,
+		fst_session_event_type_name(type));
+}
+
+/* sessions */
+static void mock_session_timeout_cancel(struct mock_session *s);
+
+static void mock_session_set_state(struct mock_session *s,
+	enum fst_session_state state, enum fst_reason reason,
+	enum fst_initiator initiator)
+{
+	char extra[128] = "";
+
+	if (state == FST_SESSION_STATE_INITIAL) {
+		os_snprintf(extra, sizeof(extra), " " FST_CES_PNAME_REASON
+			"=%s " FST_CES_PNAME_INITIATOR "=%s%s",
+			fst_reason_name(reason),
+			initiator == FST_INITIATOR_LOCAL ?
+			FST_CS_PVAL_INITIATOR_LOCAL :
+			FST_CS_PVAL_INITIATOR_REMOTE,
+			reason == REASON_REJECT ?
+			" " FST_CES_PNAME_REJECT_CODE "=1" : "");
+		s->established = FALSE;
+		mock_session_timeout_cancel(s);
+	}
+
+	mock_event(FST_CTRL_EVENT_SESSION " " FST_CES_PNAME_SESSION_ID "=%u "
+		FST_CES_PNAME_EVT_TYPE "=" FST_PVAL_EVT_TYPE_SESSION_STATE " "
+		FST_CES_PNAME_OLD_STATE "=%s " FST_CES_PNAME_NEW_STATE "=%s%s",
+		s->id, fst_session_state_name(s->state),
+		fst_session_state_name(state), extra);
+	s->state = state;
+}
+
+static void mock_session_swap(struct mock_session *s)
+{
+	char ifname[FST_MAX_INTERFACE_SIZE];
+	u8 addr[ETH_ALEN];
+
+	os_memcpy(ifname, s->old_ifname, sizeof(ifname));
+	os_memcpy(s->old_ifname, s->new_ifname, sizeof(ifname));
+	os_memcpy(s->new_ifname, ifname, sizeof(ifname));
+	os_memcpy(addr, s->old_peer_addr, ETH_ALEN);
+	os_memcpy(s->old_peer_addr, s->new_peer_addr, ETH_ALEN);
+	os_memcpy(s->new_peer_addr, addr, ETH_ALEN);
+}
+
+static void mock_session_switch(struct mock_session *s,
+	enum fst_initiator initiator)
+{
+	if (s->state != FST_SESSION_STATE_TRANSITION_DONE)
+		mock_session_set_state(s, FST_SESSION_STATE_TRANSITION_DONE,
+			0, 0);
+	mock_session_set_state(s, FST_SESSION_STATE_TRANSITION_CONFIRMED,
+		0, 0);
+	mock_session_set_state(s, FST_SESSION_STATE_INITIAL, REASON_SWITCH,
+		initiator);
+	mock_session_swap(s);
+	mock.stats.switches++;
+}
+
+static void mock_session_setup_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct mock_session *s = mock_session_by_id((uintptr_t)timeout_ctx);
+
+	if (!s || s->state != FST_SESSION_STATE_SETUP_COMPLETION)
+		return;
+
+	if (mock_random(1000) < mock.setup_fail_permille) {
+		mock.stats.setups_failed++;
+		mock_session_set_state(s, FST_SESSION_STATE_INITIAL,
+			mock_random(2) ? REASON_STT : REASON_REJECT,
+			FST_INITIATOR_REMOTE);
+		return;
+	}
+
+	s->established = TRUE;
+	mock_event_session(s, EVENT_FST_ESTABLISHED);
+}
+
+static void mock_session_switch_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct mock_session *s = mock_session_by_id((uintptr_t)timeout_ctx);
+
+	if (s && s->state == FST_SESSION_STATE_TRANSITION_DONE)
+		mock_session_switch(s, FST_INITIATOR_LOCAL);
+}
+
+static void mock_session_timeout_cancel(struct mock_session *s)
+{
+	void *ctx = (void *)(uintptr_t)s->id;
+
+	eloop_cancel_timeout(mock_session_setup_timeout, NULL, ctx);
+	eloop_cancel_timeout(mock_session_switch_timeout, NULL, ctx);
+}
+
+static struct mock_session *mock_session_add(struct mock_group *g)
+{
+	struct mock_session *s;
+
+	if (mock.next_session_id >= mock.sessions_size) {
+		u32 size = mock.sessions_size ? mock.sessions_size * 2 : 64;
+		struct mock_session **n;
+
+		n = os_realloc_array(mock.sessions, size, sizeof(*n));
+		if (!n)
+			return NULL;
+		os_memset(n + mock.sessions_size, 0,
+			(size - mock.sessions_size) * sizeof(*n));
+		mock.sessions = n;
+		mock.sessions_size = size;
+	}
+
+	s = os_zalloc(sizeof(*s));
+	if (!s)
+		return NULL;
+	s->id = mock.next_session_id++;
+	s->g = g;
+	s->state = FST_SESSION_STATE_INITIAL;
+	mock.sessions[s->id] = s;
+	return s;
+}
+
+static void mock_session_remove(struct mock_session *s)
+{
+	mock_session_timeout_cancel(s);
+	mock.sessions[s->id] = NULL;
+	os_free(s);
+}
+
+/* resets the sessions of a peer that has left the iface */
+static void mock_peer_reset_sessions(const u8 *addr)
+{
+	u32 id;
+
+	for (id = 0; id < mock.next_session_id; id++) {
+		struct mock_session *s = mock.sessions[id];
+
+		if (s && s->state != FST_SESSION_STATE_INITIAL &&
+		    (!os_memcmp(s->old_peer_addr, addr, ETH_ALEN) ||
+		     !os_memcmp(s->new_peer_addr, addr, ETH_ALEN)))
+			mock_session_set_state(s, FST_SESSION_STATE_INITIAL,
+				REASON_RESET, FST_INITIATOR_LOCAL);
+	}
+}
+
+/* FST-MANAGER commands, each returns the reply length or -1 for FAIL */
+static int mock_cmd_list_groups(char *args, char *reply, size_t size)
+{
+	size_t len = 0;
+	unsigned int i;
+
+	for (i = 0; i < mock.groups_num && len < size; i++)
+		len += os_snprintf(reply + len, size - len, "%s\n",
+			mock.groups[i].id);
+	return len;
+}
+
+static int mock_cmd_list_ifaces(char *args, char *reply, size_t size)
+{
+	struct mock_group *g = mock_group_by_id(args);
+	size_t len = 0;
+	unsigned int i;
+
+	if (!g)
+		return -1;
+	for (i = 0; i < g->ifaces_num && len < size; i++)
+		len += os_snprintf(reply + len, size - len,
+			"%s|" MACSTR "|%u|%u\n", g->ifaces[i].name,
+			MAC2STR(g->ifaces[i].addr), g->ifaces[i].priority,
+			g->ifaces[i].llt);
+	return len;
+}
+
+static int mock_cmd_iface_peers(char *args, char *reply, size_t size)
+{
+	char *ifname = os_strchr(args, ' ');
+	struct mock_group *g;
+	size_t len = 0;
+	unsigned int i;
+	int idx;
+
+	if (!ifname)
+		return -1;
+	*ifname++ = '\0';
+	idx = mock_iface_by_name(ifname, &g);
+	if (idx < 0 || g != mock_group_by_id(args))
+		return -1;
+
+	for (i = 0; i < mock.peers_num && len < size; i++)
+		if (g->peers[i].connected & BIT(idx))
+			len += os_snprintf(reply + len, size - len,
+				MACSTR "\n", MAC2STR(g->peers[i].addr[idx]));
+	return len;
+}
+
+/* one multi-band element per other iface of the peer */
+static int mock_cmd_get_peer_mbies(char *args, char *reply, size_t size)
+{
+	char *addr_str = os_strchr(args, ' ');
+	struct mock_group *g;
+	struct mock_peer *p;
+	unsigned int i, pidx;
+	size_t len = 0;
+	u8 addr[ETH_ALEN];
+	int idx;
+
+	if (!addr_str)
+		return -1;
+	*addr_str++ = '\0';
+	idx = mock_iface_by_name(args, &g);
+	if (idx < 0 || hwaddr_aton(addr_str, addr))
+		return -1;
+	p = mock_peer_by_addr(g, addr, &pidx);
+	if (!p || (unsigned int)idx != pidx || !(p->connected & BIT(idx)))
+		return -1;
+
+	for (i = 0; i < g->ifaces_num; i++) {
+		struct {
+			struct multi_band_ie ie;
+			u8 sta_addr[ETH_ALEN];
+		} STRUCT_PACKED mbie;
+
+		if (i == (unsigned int)idx)
+			continue;
+		os_memset(&mbie, 0, sizeof(mbie));
+		mbie.ie.eid = WLAN_EID_MULTI_BAND;
+		mbie.ie.len = sizeof(mbie) - 2;
+		mbie.ie.mb_ctrl = MB_STA_ROLE_NON_PCP_NON_AP |
+			MB_CTRL_STA_MAC_PRESENT;
+		mbie.ie.band_id = i ? MB_BAND_ID_WIFI_5GHZ : MB_BAND_ID_WIFI_60GHZ;
+		os_memcpy(mbie.ie.bssid, g->ifaces[i].addr, ETH_ALEN);
+		os_memcpy(mbie.sta_addr, p->addr[i], ETH_ALEN);
+		if (len + 2 * sizeof(mbie) + 1 > size)
+			break;
+		len += wpa_snprintf_hex(reply + len, size - len, (u8 *)&mbie,
+			sizeof(mbie));
+	}
+	return len ? (int)len : -1;
+}
+
+static int mock_cmd_list_sessions(char *args, char *reply, size_t size)
+{
+	struct mock_group *g = mock_group_by_id(args);
+	size_t len = 0;
+	u32 id;
+
+	if (!g)
+		return -1;
+	for (id = 0; id < mock.next_session_id && len < size; id++)
+		if (mock.sessions[id] && mock.sessions[id]->g == g)
+			len += os_snprintf(reply + len, size - len, "%u ", id);
+	return len;
+}
+
+static int mock_cmd_session_add(char *args, char *reply, size_t size)
+{
+	struct mock_group *g = mock_group_by_id(args);
+	struct mock_session *s;
+
+	if (!g || !(s = mock_session_add(g)))
+		return -1;
+	return os_snprintf(reply, size, "%u", s->id);
+}
+
+static int mock_cmd_session_remove(char *args, char *reply, size_t size)
+{
+	struct mock_session *s = mock_session_by_args(args);
+
+	if (!s)
+		return -1;
+	mock_session_remove(s);
+	return 0;
+}
+
+static int mock_cmd_session_get(char *args, char *reply, size_t size)
+{
+	struct mock_session *s = mock_session_by_args(args);
+
+	if (!s)
+		return -1;
+	return os_snprintf(reply, size,
+		FST_CSG_PNAME_OLD_PEER_ADDR "=" MACSTR "\n"
+		FST_CSG_PNAME_NEW_PEER_ADDR "=" MACSTR "\n"
+		FST_CSG_PNAME_NEW_IFNAME "=%s\n"
+		FST_CSG_PNAME_OLD_IFNAME "=%s\n"
+		FST_CSG_PNAME_LLT "=%u\n"
+		FST_CSG_PNAME_STATE "=%s\n",
+		MAC2STR(s->old_peer_addr), MAC2STR(s->new_peer_addr),
+		s->new_ifname[0] ? s->new_ifname : FST_CTRL_PVAL_NONE,
+		s->old_ifname[0] ? s->old_ifname : FST_CTRL_PVAL_NONE,
+		s->llt, fst_session_state_name(s->state));
+}
+
+static int mock_cmd_session_set(char *args, char *reply, size_t size)
+{
+	struct mock_session *s = mock_session_by_args(args);
+	char *pname = os_strchr(args, ' '), *pval;
+
+	if (!s || !pname || !(pval = os_strchr(++pname, '=')))
+		return -1;
+	*pval++ = '\0';
+
+	if (!os_strcmp(pname, FST_CSS_PNAME_OLD_IFNAME))
+		os_strlcpy(s->old_ifname, pval, sizeof(s->old_ifname));
+	else if (!os_strcmp(pname, FST_CSS_PNAME_NEW_IFNAME))
+		os_strlcpy(s->new_ifname, pval, sizeof(s->new_ifname));
+	else if (!os_strcmp(pname, FST_CSS_PNAME_OLD_PEER_ADDR))
+		return hwaddr_aton(pval, s->old_peer_addr) ? -1 : 0;
+	else if (!os_strcmp(pname, FST_CSS_PNAME_NEW_PEER_ADDR))
+		return hwaddr_aton(pval, s->new_peer_addr) ? -1 : 0;
+	else if (!os_strcmp(pname, FST_CSS_PNAME_LLT))
+		s->llt = strtoul(pval, NULL, 0);
+	else
+		return -1;
+	return 0;
+}
+
+static int mock_cmd_session_initiate(char *args, char *reply, size_t size)
+{
+	struct mock_session *s = mock_session_by_args(args);
+
+	if (!s || s->state != FST_SESSION_STATE_INITIAL ||
+	    !s->old_ifname[0] || !s->new_ifname[0])
+		return -1;
+
+	mock.stats.setups++;
+	mock_session_set_state(s, FST_SESSION_STATE_SETUP_COMPLETION, 0, 0);
+	eloop_register_timeout(mock.setup_delay_ms / 1000,
+		(mock.setup_delay_ms % 1000) * 1000,
+		mock_session_setup_timeout, NULL, (void *)(uintptr_t)s->id);
+	return 0;
+}
+
+static int mock_cmd_session_respond(char *args, char *reply, size_t size)
+{
+	struct mock_session *s = mock_session_by_args(args);
+	char *status = os_strchr(args, ' ');
+
+	if (!s || !status || s->state != FST_SESSION_STATE_SETUP_COMPLETION)
+		return -1;
+	status++;
+
+	if (!os_strcmp(status, FST_CS_PVAL_RESPONSE_ACCEPT)) {
+		s->established = TRUE;
+		mock_event_session(s, EVENT_FST_ESTABLISHED);
+	} else if (!os_strcmp(status, FST_CS_PVAL_RESPONSE_REJECT)) {
+		mock_session_set_state(s, FST_SESSION_STATE_INITIAL,
+			REASON_REJECT, FST_INITIATOR_LOCAL);
+	} else
+		return -1;
+	return 0;
+}
+
+static int mock_cmd_session_transfer(char *args, char *reply, size_t size)
+{
+	struct mock_session *s = mock_session_by_args(args);
+
+	if (!s || !s->established)
+		return -1;
+
+	mock_session_set_state(s, FST_SESSION_STATE_TRANSITION_DONE, 0, 0);
+	eloop_register_timeout(mock.switch_delay_ms / 1000,
+		(mock.switch_delay_ms % 1000) * 1000,
+		mock_session_switch_timeout, NULL, (void *)(uintptr_t)s->id);
+	return 0;
+}
+
+static int mock_cmd_session_teardown(char *args, char *reply, size_t size)
+{
+	struct mock_session *s = mock_session_by_args(args);
+
+	if (!s)
+		return -1;
+	if (s->state != FST_SESSION_STATE_INITIAL)
+		mock_session_set_state(s, FST_SESSION_STATE_INITIAL,
+			REASON_TEARDOWN, FST_INITIATOR_LOCAL);
+	return 0;
+}
+
+/* an empty reply of a list command is an empty list, not OK */
+static const struct mock_cmd {
+	const char *name;
+	int (*handler)(char *args, char *reply, size_t size);
+	Boolean list;
+} mock_cmds[] = {
+	{ FST_CMD_LIST_GROUPS, mock_cmd_list_groups, TRUE },
+	{ FST_CMD_LIST_IFACES, mock_cmd_list_ifaces, TRUE },
+	{ FST_CMD_IFACE_PEERS, mock_cmd_iface_peers, TRUE },
+	{ FST_CMD_GET_PEER_MBIES, mock_cmd_get_peer_mbies, FALSE },
+	{ FST_CMD_LIST_SESSIONS, mock_cmd_list_sessions, TRUE },
+	{ FST_CMD_SESSION_ADD, mock_cmd_session_add, FALSE },
+	{ FST_CMD_SESSION_REMOVE, mock_cmd_session_remove, FALSE },
+	{ FST_CMD_SESSION_GET, mock_cmd_session_get, FALSE },
+	{ FST_CMD_SESSION_SET, mock_cmd_session_set, FALSE },
+	{ FST_CMD_SESSION_INITIATE, mock_cmd_session_initiate, FALSE },
+	{ FST_CMD_SESSION_RESPOND, mock_cmd_session_respond, FALSE },
+	{ FST_CMD_SESSION_TRANSFER, mock_cmd_session_transfer, FALSE },
+	{ FST_CMD_SESSION_TEARDOWN, mock_cmd_session_teardown, FALSE },
+};
+
+static int mock_fst_manager_cmd(char *cmd, char *reply, size_t size)
+{
+	char *args = os_strchr(cmd, ' ');
+	unsigned int i;
+	int len;
+
+	if (args)
+		*args++ = '\0';
+	else
+		args = cmd + os_strlen(cmd);
+
+	for (i = 0; i < ARRAY_SIZE(mock_cmds); i++) {
+		if (os_strcmp(cmd, mock_cmds[i].name))
+			continue;
+		len = mock_cmds[i].handler(args, reply, size);
+		if (len < 0)
+			return os_snprintf(reply, size, "FAIL\n");
+		if (!len && !mock_cmds[i].list)
+			return os_snprintf(reply, size, "OK\n");
+		return len;
+	}
+
+	return os_snprintf(reply, size, "UNKNOWN FST COMMAND\n");
+}
+
+/* control socket */
+static int mock_attach(struct sockaddr_un *from, socklen_t from_len)
+{
+	struct mock_client *c;
+
+	if (mock.clients_num == MOCK_MAX_CLIENTS)
+		return -1;
+	c = &mock.clients[mock.clients_num++];
+	os_memcpy(&c->addr, from, from_len);
+	c->addr_len = from_len;
+	wpa_printf(MSG_INFO, "mock: monitor %s attached", from->sun_path);
+	return 0;
+}
+
+static struct mock_client *mock_client_get(struct sockaddr_un *from,
+	socklen_t from_len)
+{
+	unsigned int i;
+
+	for (i = 0; i < mock.clients_num; i++)
+		if (mock.clients[i].addr_len == from_len &&
+		    !os_memcmp(&mock.clients[i].addr, from, from_len))
+			return &mock.clients[i];
+	return NULL;
+}
+
+static int mock_detach(struct sockaddr_un *from, socklen_t from_len)
+{
+	struct mock_client *c = mock_client_get(from, from_len);
+
+	if (!c)
+		return -1;
+	*c = mock.clients[--mock.clients_num];
+	return 0;
+}
+
+static void mock_reply_send(const struct sockaddr_un *to, socklen_t to_len,
+	const char *buf, size_t len)
+{
+	if (sendto(mock.sock, buf, len, 0, (const struct sockaddr *)to,
+		   to_len) < 0)
+		wpa_printf(MSG_ERROR, "mock: cannot reply to %s: %s",
+			to->sun_path, strerror(errno));
+}
+
+static void mock_reply_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct mock_reply *r = timeout_ctx;
+
+	mock_reply_send(&r->addr, r->addr_len, r->buf, r->len);
+	dl_list_del(&r->lentry);
+	os_free(r);
+}
+
+static void mock_reply(struct sockaddr_un *to, socklen_t to_len,
+	const char *buf, size_t len)
+{
+	unsigned int delay_us = mock.latency_us;
+	struct mock_reply *r;
+
+	if (mock.jitter_us)
+		delay_us += mock_random(mock.jitter_us + 1);
+	if (!delay_us) {
+		mock_reply_send(to, to_len, buf, len);
+		return;
+	}
+
+	r = os_malloc(sizeof(*r) + len);
+	if (!r) {
+		mock_reply_send(to, to_len, buf, len);
+		return;
+	}
+	os_memcpy(&r->addr, to, to_len);
+	r->addr_len = to_len;
+	r->len = len;
+	os_memcpy(r->buf, buf, len);
+	dl_list_add_tail(&mock.replies, &r->lentry);
+	eloop_register_timeout(delay_us / 1000000, delay_us % 1000000,
+		mock_reply_timeout, NULL, r);
+}
+
+static void mock_receive(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	char buf[MOCK_MSG_SIZE], reply[MOCK_MSG_SIZE];
+	struct sockaddr_un from;
+	socklen_t from_len = sizeof(from);
+	ssize_t res;
+	int len;
+
+	res = recvfrom(sock, buf, sizeof(buf) - 1, 0,
+		(struct sockaddr *)&from, &from_len);
+	if (res < 0) {
+		wpa_printf(MSG_ERROR, "mock: recvfrom: %s", strerror(errno));
+		return;
+	}
+	while (res > 0 && (buf[res - 1] == '\n' || buf[res - 1] == '\r'))
+		res--;
+	buf[res] = '\0';
+
+	wpa_printf(MSG_DEBUG, "mock: command %s", buf);
+	mock.stats.commands++;
+
+	if (!os_strcmp(buf, "PING"))
+		len = os_snprintf(reply, sizeof(reply), "PONG\n");
+	else if (!os_strcmp(buf, "ATTACH"))
+		len = os_snprintf(reply, sizeof(reply), "%s\n",
+			mock_attach(&from, from_len) ? "FAIL" : "OK");
+	else if (!os_strcmp(buf, "DETACH"))
+		len = os_snprintf(reply, sizeof(reply), "%s\n",
+			mock_detach(&from, from_len) ? "FAIL" : "OK");
+	else if (!os_strncmp(buf, "LEVEL ", 6))
+		len = os_snprintf(reply, sizeof(reply), "%s\n",
+			mock_client_get(&from, from_len) ? "OK" : "FAIL");
+	else if (!os_strcmp(buf, "INTERFACE_LIST"))
+		/* what the hostapd global control interface answers */
+		len = os_snprintf(reply, sizeof(reply), "FAIL\n");
+	else if (!os_strncmp(buf, FST_MANAGER_CMD,
+			     sizeof(FST_MANAGER_CMD) - 1))
+		len = mock_fst_manager_cmd(buf + sizeof(FST_MANAGER_CMD) - 1,
+			reply, sizeof(reply));
+	else
+		len = os_snprintf(reply, sizeof(reply), "OK\n");
+
+	if (len >= (int)sizeof(reply))
+		len = sizeof(reply) - 1;
+	mock_reply(&from, from_len, reply, len);
+}
+
+static int mock_ctrl_open(const char *path)
+{
+	struct sockaddr_un addr;
+
+	mock.sock = socket(PF_UNIX, SOCK_DGRAM, 0);
+	if (mock.sock < 0) {
+		wpa_printf(MSG_ERROR, "mock: socket: %s", strerror(errno));
+		return -1;
+	}
+
+	os_memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (os_strlcpy(addr.sun_path, path, sizeof(addr.sun_path)) >=
+	    sizeof(addr.sun_path)) {
+		wpa_printf(MSG_ERROR, "mock: path too long: %s", path);
+		goto error;
+	}
+	unlink(path);
+	if (bind(mock.sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		wpa_printf(MSG_ERROR, "mock: bind %s: %s", path,
+			strerror(errno));
+		goto error;
+	}
+
+	if (eloop_register_read_sock(mock.sock, mock_receive, NULL, NULL))
+		goto error_unlink;
+
+	mock.path = path;
+	return 0;
+
+error_unlink:
+	unlink(path);
+error:
+	close(mock.sock);
+	mock.sock = -1;
+	return -1;
+}
+
+static void mock_ctrl_close(void)
+{
+	if (mock.sock < 0)
+		return;
+	eloop_unregister_read_sock(mock.sock);
+	close(mock.sock);
+	unlink(mock.path);
+}
+
+/* generated events */
+static struct mock_group *mock_random_group(void)
+{
+	return &mock.groups[mock_random(mock.groups_num)];
+}
+
+/* a peer leaves one iface, or rejoins all the ifaces it has left */
+static void mock_rate_churn(void)
+{
+	struct mock_group *g = mock_random_group();
+	struct mock_peer *p = &g->peers[mock_random(mock.peers_num)];
+	unsigned int all = BIT(g->ifaces_num) - 1, i;
+
+	if (p->connected == all) {
+		i = mock_random(g->ifaces_num);
+		p->connected &= ~BIT(i);
+		mock_peer_reset_sessions(p->addr[i]);
+		mock_event_peer(g, p, i, FALSE);
+		return;
+	}
+
+	for (i = 0; i < g->ifaces_num; i++)
+		if (!(p->connected & BIT(i))) {
+			p->connected |= BIT(i);
+			mock_event_peer(g, p, i, TRUE);
+		}
+}
+
+static Boolean mock_peer_has_session(const u8 *addr)
+{
+	u32 id;
+
+	for (id = 0; id < mock.next_session_id; id++) {
+		struct mock_session *s = mock.sessions[id];
+
+		if (s && s->state != FST_SESSION_STATE_INITIAL &&
+		    !os_memcmp(s->old_peer_addr, addr, ETH_ALEN))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* a peer connected on two ifaces asks for a session */
+static void mock_rate_remote_setup(void)
+{
+	struct mock_group *g = mock_random_group();
+	struct mock_peer *p = &g->peers[mock_random(mock.peers_num)];
+	unsigned int old_i, new_i;
+	struct mock_session *s;
+
+	if (g->ifaces_num < 2)
+		return;
+	old_i = mock_random(g->ifaces_num);
+	new_i = (old_i + 1 + mock_random(g->ifaces_num - 1)) % g->ifaces_num;
+	if (!(p->connected & BIT(old_i)) || !(p->connected & BIT(new_i)) ||
+	    mock_peer_has_session(p->addr[old_i]))
+		return;
+
+	s = mock_session_add(g);
+	if (!s)
+		return;
+	os_strlcpy(s->old_ifname, g->ifaces[old_i].name, sizeof(s->old_ifname));
+	os_strlcpy(s->new_ifname, g->ifaces[new_i].name, sizeof(s->new_ifname));
+	os_memcpy(s->old_peer_addr, p->addr[old_i], ETH_ALEN);
+	os_memcpy(s->new_peer_addr, p->addr[new_i], ETH_ALEN);
+	s->llt = g->ifaces[new_i].llt;
+	s->state = FST_SESSION_STATE_SETUP_COMPLETION;
+	mock_event_session(s, EVENT_FST_SETUP);
+}
+
+/* the peer of an established session switches the band */
+static void mock_rate_remote_switch(void)
+{
+	unsigned int tries;
+
+	if (!mock.next_session_id)
+		return;
+
+	for (tries = 0; tries < 16; tries++) {
+		struct mock_session *s =
+			mock.sessions[mock_random(mock.next_session_id)];
+
+		if (s && s->established &&
+		    s->state == FST_SESSION_STATE_SETUP_COMPLETION) {
+			mock_session_switch(s, FST_INITIATOR_REMOTE);
+			return;
+		}
+	}
+}
+
+static void mock_rate_tick(void *eloop_ctx, void *timeout_ctx)
+{
+	struct mock_rate *r = timeout_ctx;
+
+	r->credit += r->per_sec * r->interval_us / 1000000.0;
+	while (r->credit >= 1) {
+		r->fire();
+		r->fired++;
+		r->credit -= 1;
+	}
+
+	eloop_register_timeout(0, r->interval_us, mock_rate_tick, NULL, r);
+}
+
+static void mock_rate_start(struct mock_rate *r)
+{
+	if (r->per_sec <= 0)
+		return;
+
+	/* above 1000/s the events are generated in bursts every 1ms */
+	r->interval_us = r->per_sec >= 1000 ? 1000 :
+		(unsigned int)(1000000 / r->per_sec);
+	eloop_register_timeout(0, r->interval_us, mock_rate_tick, NULL, r);
+}
+
+/*
+ * script lines are "<delay ms> <event>", the delay is relative to the
+ * previous line, e.g.
+ *   500 FST-EVENT-PEER ifname=wlan0 peer_addr=06:00:00:00:00:00 disconnected
+ */
+static void mock_script_next(void *eloop_ctx, void *timeout_ctx);
+
+static void mock_script_schedule(void)
+{
+	static char line[MOCK_MSG_SIZE];
+	unsigned long delay_ms;
+	char *event, *nl;
+
+	while (fgets(line, sizeof(line), mock.script)) {
+		if ((nl = os_strchr(line, '\n')))
+			*nl = '\0';
+		if (line[0] == '#' || line[0] == '\0')
+			continue;
+		delay_ms = strtoul(line, &event, 10);
+		if (event == line || *event != ' ') {
+			wpa_printf(MSG_ERROR, "mock: bad script line: %s",
+				line);
+			continue;
+		}
+		eloop_register_timeout(delay_ms / 1000,
+			(delay_ms % 1000) * 1000, mock_script_next, NULL,
+			event + 1);
+		return;
+	}
+
+	wpa_printf(MSG_INFO, "mock: script done");
+}
+
+static void mock_script_next(void *eloop_ctx, void *timeout_ctx)
+{
+	mock_event("%s", (const char *)timeout_ctx);
+	mock_script_schedule();
+}
+
+/* setup */
+static int mock_group_add(const char *desc)
+{
+	struct mock_group *g;
+	char *buf, *ifname, *tok;
+	unsigned int gidx = mock.groups_num;
+
+	if (gidx == MOCK_MAX_GROUPS)
+		return -1;
+	g = &mock.groups[gidx];
+
+	buf = os_strdup(desc);
+	if (!buf)
+		return -1;
+
+	ifname = os_strchr(buf, ':');
+	if (!ifname || ifname == buf)
+		goto error;
+	*ifname++ = '\0';
+	os_strlcpy(g->id, buf, sizeof(g->id));
+
+	for (tok = strtok(ifname, ","); tok; tok = strtok(NULL, ",")) {
+		struct mock_iface *i = &g->ifaces[g->ifaces_num];
+		char *p;
+
+		if (g->ifaces_num == MOCK_MAX_IFACES)
+			goto error;
+		if ((p = os_strchr(tok, '/'))) {
+			*p++ = '\0';
+			i->priority = strtoul(p, &p, 0);
+			if (*p == '/')
+				i->llt = strtoul(p + 1, NULL, 0);
+		} else
+			i->priority = MOCK_MAX_IFACES - g->ifaces_num;
+		os_strlcpy(i->name, tok, sizeof(i->name));
+		i->addr[0] = 0x02;
+		i->addr[2] = gidx;
+		i->addr[3] = g->ifaces_num;
+		g->ifaces_num++;
+	}
+	if (!g->ifaces_num)
+		goto error;
+
+	os_free(buf);
+	mock.groups_num++;
+	return 0;
+
+error:
+	os_free(buf);
+	os_memset(g, 0, sizeof(*g));
+	return -1;
+}
+
+static int mock_peers_init(void)
+{
+	unsigned int gi, p, i;
+
+	for (gi = 0; gi < mock.groups_num; gi++) {
+		struct mock_group *g = &mock.groups[gi];
+
+		g->peers = os_calloc(mock.peers_num, sizeof(*g->peers));
+		if (!g->peers)
+			return -1;
+		for (p = 0; p < mock.peers_num; p++) {
+			for (i = 0; i < g->ifaces_num; i++) {
+				u8 *addr = g->peers[p].addr[i];
+
+				addr[0] = 0x06;
+				addr[2] = gi;
+				addr[3] = i;
+				WPA_PUT_BE16(addr + 4, p);
+			}
+			g->peers[p].connected = BIT(g->ifaces_num) - 1;
+		}
+	}
+	return 0;
+}
+
+static void mock_deinit(void)
+{
+	struct mock_reply *r, *tmp;
+	unsigned int i;
+	u32 id;
+
+	eloop_cancel_timeout(mock_rate_tick, NULL, ELOOP_ALL_CTX);
+	eloop_cancel_timeout(mock_script_next, NULL, ELOOP_ALL_CTX);
+	dl_list_for_each_safe(r, tmp, &mock.replies, struct mock_reply,
+			      lentry) {
+		eloop_cancel_timeout(mock_reply_timeout, NULL, r);
+		dl_list_del(&r->lentry);
+		os_free(r);
+	}
+
+	for (id = 0; id < mock.next_session_id; id++)
+		if (mock.sessions[id])
+			mock_session_remove(mock.sessions[id]);
+	os_free(mock.sessions);
+	for (i = 0; i < mock.groups_num; i++)
+		os_free(mock.groups[i].peers);
+	if (mock.script)
+		fclose(mock.script);
+}
+
+static void mock_dump_stats(int sig, void *signal_ctx)
+{
+	unsigned int i, sessions = 0;
+	u32 id;
+
+	for (id = 0; id < mock.next_session_id; id++)
+		if (mock.sessions[id])
+			sessions++;
+
+	wpa_printf(MSG_INFO, "mock: commands=%llu events=%llu "
+		"events_dropped=%llu sessions=%u setups=%llu setups_failed=%llu "
+		"switches=%llu monitors=%u",
+		(unsigned long long)mock.stats.commands,
+		(unsigned long long)mock.stats.events,
+		(unsigned long long)mock.stats.events_dropped, sessions,
+		(unsigned long long)mock.stats.setups,
+		(unsigned long long)mock.stats.setups_failed,
+		(unsigned long long)mock.stats.switches, mock.clients_num);
+	for (i = 0; i < ARRAY_SIZE(mock_rates); i++)
+		if (mock_rates[i].per_sec > 0)
+			wpa_printf(MSG_INFO, "mock: %s: %llu generated",
+				mock_rates[i].name,
+				(unsigned long long)mock_rates[i].fired);
+}
+
+static void mock_terminate(int sig, void *signal_ctx)
+{
+	eloop_terminate();
+}
+
+static void usage(const char *prog)
+{
+	printf("Usage: %s [options] <ctrl_socket_path>\n"
+	       ", where options are:\n"
+	       "\t--group, -g <id>:<iface>[/<prio>[/<llt>]][,...] - FST group, "
+			"may be repeated (default bond0:wlan0,wlan1)\n"
+	       "\t--peers, -p <int>        - peers per group (default 1)\n"
+	       "\t--latency, -l <us>       - added to every reply\n"
+	       "\t--jitter, -j <us>        - random extra reply latency\n"
+	       "\t--setup-delay, -D <ms>   - setup request to response "
+			"(default 10)\n"
+	       "\t--switch-delay, -W <ms>  - transfer to switch done "
+			"(default 1)\n"
+	       "\t--setup-fail, -F <int>   - setups failing, per mille\n"
+	       "\t--churn, -c <rate>       - peer disconnects/reconnects "
+			"per second\n"
+	       "\t--remote-setup, -R <rate> - setups initiated by peers "
+			"per second\n"
+	       "\t--remote-switch, -w <rate> - switches initiated by peers "
+			"per second\n"
+	       "\t--script, -S <file>      - inject the events of the script\n"
+	       "\t--seed, -s <int>         - random seed\n"
+	       "\t--debug, -d              - debug output\n"
+	       "\t--help, -h               - this message\n"
+	       "SIGUSR1 prints statistics.\n", prog);
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	const struct option long_opts[] = {
+		{"group", required_argument, NULL, 'g'},
+		{"peers", required_argument, NULL, 'p'},
+		{"latency", required_argument, NULL, 'l'},
+		{"jitter", required_argument, NULL, 'j'},
+		{"setup-delay", required_argument, NULL, 'D'},
+		{"switch-delay", required_argument, NULL, 'W'},
+		{"setup-fail", required_argument, NULL, 'F'},
+		{"churn", required_argument, NULL, 'c'},
+		{"remote-setup", required_argument, NULL, 'R'},
+		{"remote-switch", required_argument, NULL, 'w'},
+		{"script", required_argument, NULL, 'S'},
+		{"seed", required_argument, NULL, 's'},
+		{"debug", no_argument, NULL, 'd'},
+		{"help", no_argument, NULL, 'h'},
+		{}
+	};
+	const char *script = NULL;
+	unsigned int i;
+	int opt, res = 1;
+
+	/* usually run in the background with the output redirected */
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	mock.sock = -1;
+	dl_list_init(&mock.replies);
+	mock.peers_num = 1;
+	mock.setup_delay_ms = 10;
+	mock.switch_delay_ms = 1;
+	wpa_debug_level = MSG_INFO;
+
+	while ((opt = getopt_long(argc, argv, "g:p:l:j:D:W:F:c:R:w:S:s:dh",
+				  long_opts, NULL)) != -1) {
+		switch (opt) {
+		case 'g':
+			if (mock_group_add(optarg)) {
+				fprintf(stderr, "bad group: %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'p':
+			mock.peers_num = strtoul(optarg, NULL, 0);
+			break;
+		case 'l':
+			mock.latency_us = strtoul(optarg, NULL, 0);
+			break;
+		case 'j':
+			mock.jitter_us = strtoul(optarg, NULL, 0);
+			break;
+		case 'D':
+			mock.setup_delay_ms = strtoul(optarg, NULL, 0);
+			break;
+		case 'W':
+			mock.switch_delay_ms = strtoul(optarg, NULL, 0);
+			break;
+		case 'F':
+			mock.setup_fail_permille = strtoul(optarg, NULL, 0);
+			break;
+		case 'c':
+			mock_rates[0].per_sec = atof(optarg);
+			break;
+		case 'R':
+			mock_rates[1].per_sec = atof(optarg);
+			break;
+		case 'w':
+			mock_rates[2].per_sec = atof(optarg);
+			break;
+		case 'S':
+			script = optarg;
+			break;
+		case 's':
+			srandom(strtoul(optarg, NULL, 0));
+			break;
+		case 'd':
+			wpa_debug_level = MSG_DEBUG;
+			break;
+		case 'h':
+		default:
+			usage(argv[0]);
+			break;
+		}
+	}
+
+	if (optind != argc - 1)
+		usage(argv[0]);
+	if (!mock.groups_num && mock_group_add("bond0:wlan0,wlan1"))
+		return 1;
+	if (mock.peers_num > 0xffff) {
+		fprintf(stderr, "too many peers: %u\n", mock.peers_num);
+		return 1;
+	}
+
+	if (eloop_init()) {
+		wpa_printf(MSG_ERROR, "mock: eloop_init failed");
+		return 1;
+	}
+
+	if (mock_peers_init())
+		goto out;
+
+	if (script) {
+		mock.script = fopen(script, "r");
+		if (!mock.script) {
+			wpa_printf(MSG_ERROR, "mock: cannot open %s: %s",
+				script, strerror(errno));
+			goto out;
+		}
+	}
+
+	if (mock_ctrl_open(argv[optind]))
+		goto out;
+
+	eloop_register_signal_terminate(mock_terminate, NULL);
+	eloop_register_signal(SIGUSR1, mock_dump_stats, NULL);
+
+	for (i = 0; i < ARRAY_SIZE(mock_rates); i++)
+		mock_rate_start(&mock_rates[i]);
+	if (mock.script)
+		mock_script_schedule();
+
+	wpa_printf(MSG_INFO, "mock: serving %u groups, %u peers each on %s",
+		mock.groups_num, mock.peers_num, argv[optind]);
+	eloop_run();
+
+	mock_dump_stats(0, NULL);
+	mock_ctrl_close();
+	res = 0;
+
+out:
+	mock_deinit();
+	eloop_destroy();
+	return res;
+}
@@ -0,0 +1,99 @@
+#!/bin/sh
+#
+# Association storm: fstman is started against fstman_mock_hostapd with all
+# the peers of the mock connected at once, as after an AP reboot, in a
+# scratch network namespace where a bonding master stands in for the FST
+# group.
+#
+#   mock/storm_bench.sh [-p peers] [-t sec] [-D ms] [fstman options]
+#
+#   -p  peers connected at startup (default 200)
+#   -t  time the manager is given before the statistics are taken
+#       (default 15)
+#   -D  mock setup request to response delay in ms (default 10)
+#
+# The fstman options, e.g. --max-setups, --setup-rate and --setup-burst,
+# are passed through. The mock command and setup counts and the fstman
+# setup statistics are printed; the logs are left in the work directory.
+#
+# Needs root and the bonding and veth modules. FSTMAN and FSTMAN_MOCK
+# override the paths to the binaries, W the work directory.
+
+NS=fstman_storm
+BOND=bond0
+SLAVES="wlan0 wlan1"
+PEERS=200
+SEC=15
+SETUP_DELAY=10
+DIR=$(dirname "$0")/..
+FSTMAN=${FSTMAN:-$DIR/fstman}
+FSTMAN_MOCK=${FSTMAN_MOCK:-$DIR/fstman_mock_hostapd}
+W=${W:-/tmp/fstman_storm}
+
+while getopts "p:t:D:" opt; do
+	case $opt in
+	p) PEERS=$OPTARG ;;
+	t) SEC=$OPTARG ;;
+	D) SETUP_DELAY=$OPTARG ;;
+	*) exit 2 ;;
+	esac
+done
+shift $((OPTIND - 1))
+
+for b in "$FSTMAN" "$FSTMAN_MOCK"; do
+	if [ ! -x "$b" ]; then
+		echo "$b not found, run \"make\" and \"make mock\" first" >&2
+		exit 1
+	fi
+done
+
+cleanup() {
+	[ -n "$FSTMAN_PID" ] && kill $FSTMAN_PID 2>/dev/null
+	[ -n "$MOCK_PID" ] && kill $MOCK_PID 2>/dev/null
+	wait 2>/dev/null
+	ip netns del $NS 2>/dev/null
+}
+
+nsrun() {
+	ip netns exec $NS "$@"
+}
+
+for m in bonding veth; do
+	modprobe -q $m 2>/dev/null
+done
+
+mkdir -p "$W" || exit 1
+rm -f "$W/ctrl" "$W/mock.log" "$W/fstman.log" "$W/metrics.prom"
+
+ip netns del $NS 2>/dev/null
+ip netns add $NS || exit 1
+trap cleanup EXIT
+trap 'exit 1' INT TERM
+
+nsrun ip link set lo up
+if ! nsrun ip link add $BOND type bond mode active-backup miimon 100; then
+	echo "cannot create $BOND, is bonding available?" >&2
+	exit 1
+fi
+for s in $SLAVES; do
+	nsrun ip link add $s type veth peer name ${s}_p || exit 1
+	nsrun ip link set ${s}_p up || exit 1
+	nsrun ip link set $s master $BOND || exit 1
+done
+nsrun ip link set $BOND up || exit 1
+
+nsrun "$FSTMAN_MOCK" -g "$BOND:$(echo $SLAVES | tr ' ' ',')" -p $PEERS \
+	-D $SETUP_DELAY "$W/ctrl" > "$W/mock.log" 2>&1 &
+MOCK_PID=$!
+sleep 1
+
+nsrun "$FSTMAN" -m "$W/metrics.prom" "$@" "$W/ctrl" > "$W/fstman.log" 2>&1 &
+FSTMAN_PID=$!
+sleep $SEC
+
+kill -USR1 $MOCK_PID $FSTMAN_PID
+sleep 1
+
+echo "peers=$PEERS sec=$SEC fstman options: $*"
+grep "mock: commands=" "$W/mock.log" | tail -1
+grep -E "group $BOND: (setups=|setup queue)" "$W/fstman.log" | tail -2
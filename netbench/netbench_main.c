@@ -0,0 +1,764 @@
+/*
+ * FST Manager: mux data-plane benchmark
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Drives the bonding + tc mux (fst_mux_bonding.c, fst_tc.c) against a real
+ * bond and measures what it does to packets. Meant to be run by
+ * netbench/netns_bench.sh inside a network namespace where a bond stands in
+ * for the FST group, with veth or dummy slaves standing in for the ifaces:
+ *
+ *   fstman_netbench -b bond0 -i wlan0 -i wigig0 -p 0,16,64,256,1024
+ *
+ * For every peer count, filters are installed for the missing peers one by
+ * one (install latency), then frames are sent through the bond to the last
+ * mapped peer, the worst case of the u32 chain, and to an unmapped one (TX
+ * classification cost). All filters are then removed one by one and as one
+ * batch. Finally a single destination is remapped between the ifaces under
+ * a constant rate of frames, which are counted as they leave the slaves
+ * (packet loss during a remap), after an idle run of the same length that
+ * gives the loss without remaps.
+ *
+ * Results are printed as key=value pairs.
+ */
+
+#define _GNU_SOURCE /* recvmmsg() */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <net/if.h>
+
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "fst_cfgmgr.h"
+#include "fst_mux.h"
+#include "fst_hist.h"
+#define FST_MGR_COMPONENT "NETBENCH"
+#include "fst_manager.h"
+
+#define NB_MAX_IFACES  4
+#define NB_MAX_STEPS   16
+#define NB_ETHERTYPE   0x88b5 /* local experimental */
+#define NB_MAGIC       0x46535442
+#define NB_FRAME_LEN   60
+#define NB_RX_BATCH    64
+#define NB_DRAIN_MS    100
+
+/* the knobs main.c sets from the command line */
+unsigned int fst_debug_level = MSG_ERROR;
+unsigned int fst_max_peers = 16;
+
+struct nb_frame {
+	u8 da[ETH_ALEN];
+	u8 sa[ETH_ALEN];
+	be16 ethertype;
+	be32 magic;
+	be32 seq;
+	u8 pad[NB_FRAME_LEN - 2 * ETH_ALEN - 10];
+} STRUCT_PACKED;
+
+static struct netbench {
+	const char *bond;
+	const char *ifaces[NB_MAX_IFACES];
+	u16 ifids[NB_MAX_IFACES]; /* registered by the mux */
+	unsigned int ifaces_num;
+	unsigned int steps[NB_MAX_STEPS];
+	unsigned int steps_num;
+	unsigned int pkts;
+	unsigned int loss_peers;
+	unsigned int remaps;
+	unsigned int remap_interval_ms;
+	unsigned int rate;
+	struct fst_mux *mux;
+	unsigned int mapped;
+	int tx_sock;
+	int bond_ifidx;
+} nb;
+
+/* the frame stream of the loss test, shared with its threads */
+static struct nb_stream {
+	volatile int stop_tx;
+	volatile int stop_rx;
+	u8 da[ETH_ALEN];
+	unsigned long sent;
+	unsigned long send_errors;
+	int rx_socks[NB_MAX_IFACES];
+	unsigned long received[NB_MAX_IFACES];
+	unsigned long reordered;
+	unsigned long rx_drops;
+	u32 last_seq;
+} stream;
+
+static u64 nb_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void nb_sleep_ms(unsigned int ms)
+{
+	struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+
+	while (nanosleep(&ts, &ts) && errno == EINTR)
+		;
+}
+
+/* locally administered unicast addresses, peer NB_LOSS_PEER is the stream */
+#define NB_LOSS_PEER 0xffffff
+static void nb_peer_addr(unsigned int k, u8 *addr)
+{
+	addr[0] = 0x02;
+	addr[1] = 0xfb;
+	addr[2] = 0x00;
+	addr[3] = k >> 16;
+	addr[4] = k >> 8;
+	addr[5] = k;
+}
+
+/*
+ * fst_cfgmgr and fst_ctrl hooks the mux calls
+ */
+int fst_cfgmgr_get_mux_type(const char *gname, char *buf, int blen)
+{
+	return os_strlcpy(buf, "bonding", blen);
+}
+
+int fst_cfgmgr_get_mux_ifname(const char *gname, char *buf, int blen)
+{
+	return os_strlcpy(buf, gname, blen);
+}
+
+Boolean fst_is_supplicant(void)
+{
+	return FALSE;
+}
+
+/*
+ * Frames
+ */
+static void nb_frame_init(struct nb_frame *f, const u8 *da, u32 seq)
+{
+	os_memset(f, 0, sizeof(*f));
+	os_memcpy(f->da, da, ETH_ALEN);
+	f->sa[0] = 0x02;
+	f->sa[1] = 0xfb;
+	f->sa[2] = 0xff;
+	f->ethertype = host_to_be16(NB_ETHERTYPE);
+	f->magic = host_to_be32(NB_MAGIC);
+	f->seq = host_to_be32(seq);
+}
+
+static int nb_send(struct nb_frame *f)
+{
+	struct sockaddr_ll sll;
+
+	os_memset(&sll, 0, sizeof(sll));
+	sll.sll_family = AF_PACKET;
+	sll.sll_ifindex = nb.bond_ifidx;
+	sll.sll_halen = ETH_ALEN;
+	os_memcpy(sll.sll_addr, f->da, ETH_ALEN);
+
+	return sendto(nb.tx_sock, f, sizeof(*f), 0, (struct sockaddr *)&sll,
+		sizeof(sll)) == sizeof(*f) ? 0 : -1;
+}
+
+/* outgoing frames are only passed to ETH_P_ALL taps, so filter here */
+static int nb_open_rx_sock(const char *ifname)
+{
+	struct sockaddr_ll sll;
+	int sock, rcvbuf = 4 << 20;
+
+	sock = socket(AF_PACKET, SOCK_RAW, host_to_be16(ETH_P_ALL));
+	if (sock < 0) {
+		fprintf(stderr, "netbench: packet socket: %s\n",
+			strerror(errno));
+		return -1;
+	}
+	setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+	os_memset(&sll, 0, sizeof(sll));
+	sll.sll_family = AF_PACKET;
+	sll.sll_protocol = host_to_be16(ETH_P_ALL);
+	sll.sll_ifindex = if_nametoindex(ifname);
+	if (!sll.sll_ifindex ||
+	    bind(sock, (struct sockaddr *)&sll, sizeof(sll))) {
+		fprintf(stderr, "netbench: cannot bind to %s: %s\n", ifname,
+			strerror(errno));
+		close(sock);
+		return -1;
+	}
+
+	return sock;
+}
+
+static void nb_rx_account(unsigned int i, const struct nb_frame *f, int len,
+	const struct sockaddr_ll *sll)
+{
+	u32 seq;
+
+	if (len < (int)sizeof(*f) || sll->sll_pkttype != PACKET_OUTGOING ||
+	    f->ethertype != host_to_be16(NB_ETHERTYPE) ||
+	    f->magic != host_to_be32(NB_MAGIC) ||
+	    os_memcmp(f->da, stream.da, ETH_ALEN))
+		return;
+
+	seq = be_to_host32(f->seq);
+	if (seq < stream.last_seq)
+		stream.reordered++;
+	stream.last_seq = seq;
+	stream.received[i]++;
+}
+
+static void nb_rx_drain(unsigned int i)
+{
+	struct nb_frame frames[NB_RX_BATCH];
+	struct sockaddr_ll addrs[NB_RX_BATCH];
+	struct mmsghdr msgs[NB_RX_BATCH];
+	struct iovec iovs[NB_RX_BATCH];
+	int k, n;
+
+	os_memset(msgs, 0, sizeof(msgs));
+	for (k = 0; k < NB_RX_BATCH; k++) {
+		iovs[k].iov_base = &frames[k];
+		iovs[k].iov_len = sizeof(frames[k]);
+		msgs[k].msg_hdr.msg_iov = &iovs[k];
+		msgs[k].msg_hdr.msg_iovlen = 1;
+		msgs[k].msg_hdr.msg_name = &addrs[k];
+		msgs[k].msg_hdr.msg_namelen = sizeof(addrs[k]);
+	}
+
+	n = recvmmsg(stream.rx_socks[i], msgs, NB_RX_BATCH, MSG_DONTWAIT,
+		NULL);
+	for (k = 0; k < n; k++)
+		nb_rx_account(i, &frames[k], msgs[k].msg_len, &addrs[k]);
+}
+
+static void *nb_rx_thread(void *arg)
+{
+	struct pollfd fds[NB_MAX_IFACES];
+	unsigned int i;
+
+	for (i = 0; i < nb.ifaces_num; i++) {
+		fds[i].fd = stream.rx_socks[i];
+		fds[i].events = POLLIN;
+	}
+
+	while (!stream.stop_rx) {
+		if (poll(fds, nb.ifaces_num, 10) <= 0)
+			continue;
+		for (i = 0; i < nb.ifaces_num; i++)
+			if (fds[i].revents & POLLIN)
+				nb_rx_drain(i);
+	}
+
+	return NULL;
+}
+
+/* sends nb.rate frames per second in 1 ms bursts */
+static void *nb_tx_thread(void *arg)
+{
+	struct nb_frame f;
+	struct timespec tick;
+	u64 start_ns = nb_now_ns();
+	unsigned long due;
+
+	clock_gettime(CLOCK_MONOTONIC, &tick);
+	while (!stream.stop_tx) {
+		due = (nb_now_ns() - start_ns) * nb.rate / 1000000000ULL;
+		while (stream.sent < due) {
+			nb_frame_init(&f, stream.da, stream.sent);
+			if (nb_send(&f))
+				stream.send_errors++;
+			stream.sent++;
+		}
+
+		tick.tv_nsec += 1000000;
+		if (tick.tv_nsec >= 1000000000) {
+			tick.tv_sec++;
+			tick.tv_nsec -= 1000000000;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &tick, NULL);
+	}
+
+	return NULL;
+}
+
+/*
+ * Benchmarks
+ */
+static void nb_report_hist(const char *name, const char *params,
+	const struct fst_hist *h)
+{
+	printf("netbench %s %s count=%u avg_us=%llu p50_us=%u p99_us=%u "
+	       "max_us=%u\n", name, params, h->count,
+	       (unsigned long long)(h->count ? h->sum / h->count : 0),
+	       fst_hist_percentile(h, 500), fst_hist_percentile(h, 990),
+	       h->max);
+	fflush(stdout);
+}
+
+/* peers alternate between the ifaces, as they would across bands */
+static u16 nb_peer_iface(unsigned int k)
+{
+	return nb.ifids[k % nb.ifaces_num];
+}
+
+static int nb_map_peers(unsigned int n, struct fst_hist *h)
+{
+	u8 addr[ETH_ALEN];
+	u64 start_ns;
+
+	for (; nb.mapped < n; nb.mapped++) {
+		nb_peer_addr(nb.mapped, addr);
+		start_ns = nb_now_ns();
+		if (fst_mux_add_map_entry(nb.mux, addr,
+				nb_peer_iface(nb.mapped))) {
+			fprintf(stderr, "netbench: cannot map peer %u\n",
+				nb.mapped);
+			return -1;
+		}
+		fst_hist_add(h, (nb_now_ns() - start_ns) / 1000);
+	}
+
+	return 0;
+}
+
+static int nb_unmap_peers(struct fst_hist *h)
+{
+	u8 addr[ETH_ALEN];
+	u64 start_ns;
+	int res = 0;
+
+	while (nb.mapped) {
+		nb_peer_addr(--nb.mapped, addr);
+		start_ns = nb_now_ns();
+		if (fst_mux_del_map_entry(nb.mux, addr))
+			res = -1;
+		else if (h)
+			fst_hist_add(h, (nb_now_ns() - start_ns) / 1000);
+	}
+
+	return res;
+}
+
+static double nb_tx_ns_per_pkt(const u8 *da, unsigned long *errors)
+{
+	struct nb_frame f;
+	unsigned int k;
+	u64 start_ns;
+
+	nb_frame_init(&f, da, 0);
+	start_ns = nb_now_ns();
+	for (k = 0; k < nb.pkts; k++)
+		if (nb_send(&f))
+			(*errors)++;
+
+	return (double)(nb_now_ns() - start_ns) / nb.pkts;
+}
+
+static int nb_bench_filters(void)
+{
+	struct fst_hist h;
+	u8 hit[ETH_ALEN], miss[ETH_ALEN];
+	unsigned int s;
+	unsigned long errors;
+	char params[32];
+	double hit_ns;
+	u64 start_ns;
+	int n;
+
+	nb_peer_addr(NB_LOSS_PEER - 1, miss);
+	for (s = 0; s < nb.steps_num; s++) {
+		os_memset(&h, 0, sizeof(h));
+		if (nb_map_peers(nb.steps[s], &h))
+			return -1;
+		os_snprintf(params, sizeof(params), "peers=%u", nb.mapped);
+		if (h.count)
+			nb_report_hist("filter_add", params, &h);
+
+		errors = 0;
+		hit_ns = 0;
+		if (nb.mapped) {
+			nb_peer_addr(nb.mapped - 1, hit);
+			hit_ns = nb_tx_ns_per_pkt(hit, &errors);
+		}
+		printf("netbench tx peers=%u pkts=%u hit_ns_per_pkt=%.1f "
+		       "miss_ns_per_pkt=%.1f send_errors=%lu\n", nb.mapped,
+		       nb.pkts, hit_ns, nb_tx_ns_per_pkt(miss, &errors),
+		       errors);
+		fflush(stdout);
+	}
+
+	os_memset(&h, 0, sizeof(h));
+	os_snprintf(params, sizeof(params), "peers=%u", nb.mapped);
+	if (nb_unmap_peers(&h))
+		return -1;
+	nb_report_hist("filter_del", params, &h);
+
+	/* the same through the batched path the manager uses on failover */
+	if (nb.steps[nb.steps_num - 1]) {
+		unsigned int k, num = nb.steps[nb.steps_num - 1];
+		struct fst_mux_map_entry *entries;
+		u8 *addrs;
+
+		entries = os_calloc(num, sizeof(*entries));
+		addrs = os_calloc(num, ETH_ALEN);
+		if (!entries || !addrs) {
+			os_free(entries);
+			os_free(addrs);
+			return -1;
+		}
+		for (k = 0; k < num; k++) {
+			nb_peer_addr(k, &addrs[k * ETH_ALEN]);
+			entries[k].da = &addrs[k * ETH_ALEN];
+			entries[k].ifid = nb_peer_iface(k);
+		}
+
+		start_ns = nb_now_ns();
+		n = fst_mux_set_map_entries(nb.mux, entries, num);
+		printf("netbench batch_add entries=%u failed=%d total_us=%llu\n",
+		       num, n, (unsigned long long)(nb_now_ns() - start_ns) /
+		       1000);
+		nb.mapped = num;
+
+		for (k = 0; k < num; k++)
+			entries[k].ifid = FST_IFREG_NONE;
+		start_ns = nb_now_ns();
+		n = fst_mux_set_map_entries(nb.mux, entries, num);
+		printf("netbench batch_del entries=%u failed=%d total_us=%llu\n",
+		       num, n, (unsigned long long)(nb_now_ns() - start_ns) /
+		       1000);
+		nb.mapped = 0;
+		fflush(stdout);
+
+		os_free(entries);
+		os_free(addrs);
+	}
+
+	return 0;
+}
+
+static void nb_report_stream(const char *phase, unsigned int remaps)
+{
+	unsigned long received = 0;
+	unsigned int i;
+
+	printf("netbench loss phase=%s remaps=%u rate=%u sent=%lu",
+	       phase, remaps, nb.rate, stream.sent);
+	for (i = 0; i < nb.ifaces_num; i++) {
+		printf(" rx_%s=%lu", nb.ifaces[i], stream.received[i]);
+		received += stream.received[i];
+	}
+	printf(" lost=%ld lost_ppm=%.0f reordered=%lu send_errors=%lu "
+	       "rx_drops=%lu\n", (long)(stream.sent - received),
+	       stream.sent ? (stream.sent - (double)received) * 1e6 /
+	       stream.sent : 0.0, stream.reordered, stream.send_errors,
+	       stream.rx_drops);
+	fflush(stdout);
+}
+
+/* runs the stream for remaps * interval, remapping its destination if told */
+static int nb_run_stream(Boolean remap, struct fst_hist *h)
+{
+	pthread_t tx, rx;
+	struct tpacket_stats st;
+	struct nb_frame f;
+	socklen_t len;
+	unsigned int i, k;
+	u64 start_ns;
+	int res = 0;
+
+	stream.stop_tx = stream.stop_rx = 0;
+	stream.sent = stream.send_errors = 0;
+	stream.reordered = stream.rx_drops = 0;
+	stream.last_seq = 0;
+	os_memset(stream.received, 0, sizeof(stream.received));
+	for (i = 0; i < nb.ifaces_num; i++) {
+		/* reading the statistics resets them */
+		len = sizeof(st);
+		getsockopt(stream.rx_socks[i], SOL_PACKET, PACKET_STATISTICS,
+			&st, &len);
+		while (recv(stream.rx_socks[i], &f, sizeof(f),
+			    MSG_DONTWAIT) >= 0)
+			;
+	}
+
+	if (pthread_create(&rx, NULL, nb_rx_thread, NULL))
+		return -1;
+	if (pthread_create(&tx, NULL, nb_tx_thread, NULL)) {
+		stream.stop_rx = 1;
+		pthread_join(rx, NULL);
+		return -1;
+	}
+
+	for (k = 1; k <= nb.remaps; k++) {
+		nb_sleep_ms(nb.remap_interval_ms);
+		if (!remap)
+			continue;
+		start_ns = nb_now_ns();
+		if (fst_mux_add_map_entry(nb.mux, stream.da,
+				nb.ifids[k % nb.ifaces_num]))
+			res = -1;
+		else
+			fst_hist_add(h, (nb_now_ns() - start_ns) / 1000);
+	}
+
+	stream.stop_tx = 1;
+	pthread_join(tx, NULL);
+	nb_sleep_ms(NB_DRAIN_MS);
+	stream.stop_rx = 1;
+	pthread_join(rx, NULL);
+
+	for (i = 0; i < nb.ifaces_num; i++) {
+		len = sizeof(st);
+		if (!getsockopt(stream.rx_socks[i], SOL_PACKET,
+				PACKET_STATISTICS, &st, &len))
+			stream.rx_drops += st.tp_drops;
+	}
+
+	return res;
+}
+
+static int nb_bench_loss(void)
+{
+	struct fst_hist h;
+	char params[32];
+	unsigned int i;
+	int res = -1;
+
+	for (i = 0; i < nb.ifaces_num; i++)
+		stream.rx_socks[i] = -1;
+	for (i = 0; i < nb.ifaces_num; i++) {
+		stream.rx_socks[i] = nb_open_rx_sock(nb.ifaces[i]);
+		if (stream.rx_socks[i] < 0)
+			goto out;
+	}
+
+	os_memset(&h, 0, sizeof(h));
+	if (nb_map_peers(nb.loss_peers, &h))
+		goto out;
+	nb_peer_addr(NB_LOSS_PEER, stream.da);
+	if (fst_mux_add_map_entry(nb.mux, stream.da, nb.ifids[0]))
+		goto out;
+
+	if (nb_run_stream(FALSE, NULL))
+		goto out;
+	nb_report_stream("idle", 0);
+
+	os_memset(&h, 0, sizeof(h));
+	if (nb_run_stream(TRUE, &h))
+		goto out;
+	nb_report_stream("remap", nb.remaps);
+	os_snprintf(params, sizeof(params), "peers=%u", nb.mapped + 1);
+	nb_report_hist("remap", params, &h);
+
+	fst_mux_del_map_entry(nb.mux, stream.da);
+	res = 0;
+out:
+	nb_unmap_peers(NULL);
+	for (i = 0; i < nb.ifaces_num; i++)
+		if (stream.rx_socks[i] >= 0)
+			close(stream.rx_socks[i]);
+	return res;
+}
+
+static int nb_parse_steps(const char *arg)
+{
+	char *end;
+
+	nb.steps_num = 0;
+	do {
+		unsigned long v = strtoul(arg, &end, 0);
+
+		if (end == arg || nb.steps_num == NB_MAX_STEPS ||
+		    v >= NB_LOSS_PEER - 1 ||
+		    (nb.steps_num && v < nb.steps[nb.steps_num - 1]))
+			return -1;
+		nb.steps[nb.steps_num++] = v;
+		arg = end + 1;
+	} while (*end == ',');
+
+	return *end ? -1 : 0;
+}
+
+static void usage(const char *prog)
+{
+	printf("Usage: %s [options]\n"
+	       ", where options are:\n"
+	       "\t--bond, -b <ifname>      - bond to drive (default bond0)\n"
+	       "\t--iface, -i <ifname>     - bond slave, in priority order, "
+			"repeat for each (default wlan0 and wigig0, max %u)\n"
+	       "\t--peers, -p <int,...>    - ascending peer counts to "
+			"measure at (default 0,16,64,256,1024)\n"
+	       "\t--pkts, -k <int>         - frames sent per TX measurement "
+			"(default 100000)\n"
+	       "\t--loss-peers, -L <int>   - peers mapped during the loss "
+			"test (default 64)\n"
+	       "\t--remaps, -m <int>       - remaps in the loss test "
+			"(default 100)\n"
+	       "\t--interval, -t <ms>      - time between remaps "
+			"(default 20)\n"
+	       "\t--rate, -r <int>         - frames per second in the loss "
+			"test (default 20000)\n"
+	       "\t--debug, -d              - mux output, repeat for more\n"
+	       "\t--help, -h               - this message\n",
+	       prog, NB_MAX_IFACES);
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	const struct option long_opts[] = {
+		{"bond", required_argument, NULL, 'b'},
+		{"iface", required_argument, NULL, 'i'},
+		{"peers", required_argument, NULL, 'p'},
+		{"pkts", required_argument, NULL, 'k'},
+		{"loss-peers", required_argument, NULL, 'L'},
+		{"remaps", required_argument, NULL, 'm'},
+		{"interval", required_argument, NULL, 't'},
+		{"rate", required_argument, NULL, 'r'},
+		{"debug", no_argument, NULL, 'd'},
+		{"help", no_argument, NULL, 'h'},
+		{}
+	};
+	unsigned int i;
+	int opt, res = 1;
+
+	nb.bond = "bond0";
+	nb.pkts = 100000;
+	nb.loss_peers = 64;
+	nb.remaps = 100;
+	nb.remap_interval_ms = 20;
+	nb.rate = 20000;
+	nb.tx_sock = -1;
+	nb_parse_steps("0,16,64,256,1024");
+
+	while ((opt = getopt_long(argc, argv, "b:i:p:k:L:m:t:r:dh",
+				  long_opts, NULL)) != -1) {
+		switch (opt) {
+		case 'b':
+			nb.bond = optarg;
+			break;
+		case 'i':
+			if (nb.ifaces_num == NB_MAX_IFACES)
+				usage(argv[0]);
+			nb.ifaces[nb.ifaces_num++] = optarg;
+			break;
+		case 'p':
+			if (nb_parse_steps(optarg))
+				usage(argv[0]);
+			break;
+		case 'k':
+			nb.pkts = strtoul(optarg, NULL, 0);
+			break;
+		case 'L':
+			nb.loss_peers = strtoul(optarg, NULL, 0);
+			break;
+		case 'm':
+			nb.remaps = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			nb.remap_interval_ms = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			nb.rate = strtoul(optarg, NULL, 0);
+			break;
+		case 'd':
+			fst_debug_level = fst_debug_level > MSG_INFO ?
+				MSG_INFO : MSG_DEBUG;
+			break;
+		case 'h':
+		default:
+			usage(argv[0]);
+			break;
+		}
+	}
+
+	if (!nb.ifaces_num) {
+		nb.ifaces[nb.ifaces_num++] = "wlan0";
+		nb.ifaces[nb.ifaces_num++] = "wigig0";
+	}
+	if (optind != argc || nb.ifaces_num < 2 || !nb.pkts || !nb.rate ||
+	    nb.loss_peers >= NB_LOSS_PEER - 1)
+		usage(argv[0]);
+
+	nb.bond_ifidx = if_nametoindex(nb.bond);
+	if (!nb.bond_ifidx) {
+		fprintf(stderr, "netbench: no %s, run from netns_bench.sh\n",
+			nb.bond);
+		return 1;
+	}
+	nb.tx_sock = socket(AF_PACKET, SOCK_RAW, 0);
+	if (nb.tx_sock < 0) {
+		fprintf(stderr, "netbench: packet socket: %s\n",
+			strerror(errno));
+		return 1;
+	}
+
+	nb.mux = fst_mux_init(nb.bond);
+	if (!nb.mux) {
+		fprintf(stderr, "netbench: fst_mux_init failed\n");
+		goto out;
+	}
+	for (i = 0; i < nb.ifaces_num; i++) {
+		if (fst_mux_register_iface(nb.mux, nb.ifaces[i],
+				nb.ifaces_num - i)) {
+			fprintf(stderr, "netbench: cannot register %s\n",
+				nb.ifaces[i]);
+			goto out_cleanup;
+		}
+		nb.ifids[i] = fst_ifreg_lookup(nb.ifaces[i]);
+	}
+	if (fst_mux_start(nb.mux)) {
+		fprintf(stderr, "netbench: fst_mux_start failed\n");
+		goto out_cleanup;
+	}
+
+	printf("netbench bond=%s ifaces=%u\n", nb.bond, nb.ifaces_num);
+	if (!nb_bench_filters() && !nb_bench_loss())
+		res = 0;
+
+	fst_mux_stop(nb.mux);
+out_cleanup:
+	fst_mux_cleanup(nb.mux);
+out:
+	close(nb.tx_sock);
+	return res;
+}
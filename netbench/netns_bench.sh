@@ -0,0 +1,83 @@
+#!/bin/sh
+#
+# Runs fstman_netbench in a scratch network namespace: a bonding master
+# stands in for the FST group and veth (or dummy) slaves for its ifaces.
+#
+#   netbench/netns_bench.sh [-s veth|dummy] [-k] [fstman_netbench options]
+#
+#   -s  slave type; the peer ends of veth slaves are kept up in the same
+#       namespace so that the slaves have carrier (default veth)
+#   -k  keep the namespace for inspection instead of deleting it
+#
+# Needs root and the bonding, sch_multiq, cls_u32, act_skbedit and
+# act_mirred modules. FSTMAN_NETBENCH overrides the path to the driver.
+
+NS=fstman_bench
+BOND=bond0
+SLAVES="wlan0 wigig0"
+SLAVE_TYPE=veth
+KEEP=0
+BIN=${FSTMAN_NETBENCH:-$(dirname "$0")/../fstman_netbench}
+
+while getopts "s:k" opt; do
+	case $opt in
+	s) SLAVE_TYPE=$OPTARG ;;
+	k) KEEP=1 ;;
+	*) exit 2 ;;
+	esac
+done
+shift $((OPTIND - 1))
+
+case $SLAVE_TYPE in
+veth|dummy) ;;
+*) echo "unknown slave type: $SLAVE_TYPE" >&2; exit 2 ;;
+esac
+
+if [ ! -x "$BIN" ]; then
+	echo "$BIN not found, run \"make netbench\" first" >&2
+	exit 1
+fi
+
+cleanup() {
+	[ $KEEP -eq 1 ] || ip netns del $NS 2>/dev/null
+}
+
+nsrun() {
+	ip netns exec $NS "$@"
+}
+
+for m in bonding sch_multiq cls_u32 act_skbedit act_mirred $SLAVE_TYPE; do
+	modprobe -q $m 2>/dev/null
+done
+
+ip netns del $NS 2>/dev/null
+ip netns add $NS || exit 1
+trap cleanup EXIT
+trap 'exit 1' INT TERM
+
+nsrun ip link set lo up
+if ! nsrun ip link add $BOND type bond mode active-backup miimon 100; then
+	echo "cannot create $BOND, is bonding available?" >&2
+	exit 1
+fi
+
+for s in $SLAVES; do
+	if [ $SLAVE_TYPE = veth ]; then
+		nsrun ip link add $s type veth peer name ${s}_p || exit 1
+		nsrun ip link set ${s}_p up || exit 1
+	else
+		nsrun ip link add $s type dummy || exit 1
+	fi
+	nsrun ip link set $s master $BOND || exit 1
+done
+nsrun ip link set $BOND up || exit 1
+
+# give miimon the time to see the slaves up
+sleep 1
+
+opts="-b $BOND"
+for s in $SLAVES; do
+	opts="$opts -i $s"
+done
+
+nsrun "$BIN" $opts "$@"
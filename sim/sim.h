@@ -0,0 +1,150 @@
+/*
+ * FST Manager: in-process simulation harness
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __FST_SIM_H__
+#define __FST_SIM_H__
+
+#include "utils/common.h"
+#include "fst_ctrl.h"
+#include "fst_mux.h"
+#include "fst_hist.h"
+
+#define SIM_MAX_IFACES 4
+
+/*
+ * Addresses encode their owner, so the fakes find it without a search:
+ * peer   06:<iface>:<group hi>:<group lo>:<peer hi>:<peer lo>
+ * iface  02:<iface>:<group hi>:<group lo>:00:00
+ */
+#define SIM_PEER_ADDR_TYPE  0x06
+#define SIM_IFACE_ADDR_TYPE 0x02
+
+struct sim_peer {
+	unsigned int connected; /* bitmap of iface indices */
+	u32 session_id;         /* last session set up with the peer */
+	unsigned int tx_rate;   /* bytes/s sent to the peer */
+};
+
+struct sim_group {
+	struct fst_group_info info;
+	struct fst_iface_info ifaces[SIM_MAX_IFACES];
+	unsigned int down;      /* bitmap of ifaces without carrier */
+	struct sim_peer *peers;
+	struct fst_mux *mux;
+};
+
+struct sim_session {
+	struct sim_group *g;    /* NULL if the id is free */
+	Boolean established;
+	struct fst_session_info info;
+};
+
+struct sim_stats {
+	u64 events;             /* notifications delivered to the manager */
+	u64 ctrl_calls;         /* fst_ctrl API calls made by the manager */
+	u64 ctrl_failures;
+	u64 mbies_calls;
+	u64 setups;             /* setups the manager initiated */
+	u64 ioctls;
+	u64 map_adds;
+	u64 map_replaces;       /* adds of a destination already mapped */
+	u64 map_dels;
+	u64 map_dels_missing;   /* dels of a destination not mapped */
+	u64 map_batches;
+	u64 bytes_dumps;        /* reads of the per-destination counters */
+	u64 stale_events;       /* dropped as their session was removed */
+	u64 lost_events;        /* dropped at random, see loss_permille */
+	struct fst_hist event_ns; /* manager time per notification */
+};
+
+/* the model shared by the fakes and the driver */
+struct sim {
+	unsigned int groups_num;
+	unsigned int ifaces_num;
+	unsigned int peers_num;
+	struct sim_group *groups;
+	unsigned int fail_permille; /* setups ending with STT */
+	unsigned int loss_permille; /* events lost on their way */
+	struct sim_session *sessions; /* indexed by session id */
+	u32 sessions_size;
+	u32 *free_ids;
+	u32 free_ids_num;
+	u32 sessions_in_use;
+	struct sim_stats stats;
+};
+
+extern struct sim sim;
+
+void sim_peer_addr(unsigned int g, unsigned int i, unsigned int p, u8 *addr);
+struct sim_peer *sim_peer_by_addr(const u8 *addr, struct sim_group **g,
+	unsigned int *iface);
+int sim_iface_by_name(const char *ifname, struct sim_group **g);
+struct sim_session *sim_session_get(u32 session_id);
+
+/**
+ * sim_ctrl_queue - queue a notification the way hostapd would send it
+ * @session_id: session the event refers to or %FST_INVALID_SESSION_ID
+ * @type: event type
+ * @extra: event data or %NULL
+ *
+ * Events are delivered in order by sim_ctrl_drain(), never from within a
+ * call the manager made, like replies and events on the real socket.
+ */
+void sim_ctrl_queue(u32 session_id, enum fst_event_type type,
+	const union fst_event_extra *extra);
+void sim_ctrl_queue_state(u32 session_id, enum fst_session_state old_state,
+	enum fst_session_state new_state, enum fst_reason reason,
+	enum fst_initiator initiator);
+/**
+ * sim_ctrl_drain - deliver the queued notifications
+ * Returns: number of notifications delivered
+ */
+unsigned int sim_ctrl_drain(void);
+u32 sim_ctrl_session_new(struct sim_group *g);
+/**
+ * sim_session_switch - complete a band switch of an established session
+ * @s: session
+ * @initiator: side the switch is reported to be initiated by
+ */
+void sim_session_switch(struct sim_session *s, enum fst_initiator initiator);
+void sim_ctrl_deinit(void);
+
+/**
+ * sim_mux_lookup - get the iface a destination is mapped to
+ * @ctx: mux of the group
+ * @da: destination address
+ * Returns: iface name or %NULL if not mapped
+ */
+const char *sim_mux_lookup(struct fst_mux *ctx, const u8 *da);
+unsigned int sim_mux_entries(struct fst_mux *ctx);
+
+#endif /* __FST_SIM_H__ */
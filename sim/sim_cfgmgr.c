@@ -0,0 +1,119 @@
+/*
+ * FST Manager: simulated configuration
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Implements the fst_cfgmgr hooks fst_manager.c calls, reporting the groups
+ * and ifaces of the model and accepting every connection.
+ */
+
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "fst_cfgmgr.h"
+#include "sim.h"
+
+int fst_cfgmgr_get_groups(struct fst_group_info **groups)
+{
+	unsigned int k;
+
+	*groups = os_calloc(sim.groups_num, sizeof(**groups));
+	if (!*groups)
+		return -1;
+	for (k = 0; k < sim.groups_num; k++)
+		(*groups)[k] = sim.groups[k].info;
+	return sim.groups_num;
+}
+
+int fst_cfgmgr_get_group_ifaces(const struct fst_group_info *group,
+	struct fst_iface_info **ifaces)
+{
+	unsigned int k;
+
+	for (k = 0; k < sim.groups_num; k++)
+		if (!os_strcmp(sim.groups[k].info.id, group->id))
+			break;
+	if (k == sim.groups_num)
+		return -1;
+
+	*ifaces = os_calloc(sim.ifaces_num, sizeof(**ifaces));
+	if (!*ifaces)
+		return -1;
+	os_memcpy(*ifaces, sim.groups[k].ifaces,
+		sim.ifaces_num * sizeof(**ifaces));
+	return sim.ifaces_num;
+}
+
+int fst_cfgmgr_on_global_init(void)
+{
+	return 0;
+}
+
+void fst_cfgmgr_on_global_deinit(void)
+{
+}
+
+int fst_cfgmgr_on_group_init(const struct fst_group_info *group)
+{
+	return 0;
+}
+
+int fst_cfgmgr_on_group_deinit(const struct fst_group_info *group)
+{
+	return 0;
+}
+
+int fst_cfgmgr_on_iface_init(const struct fst_group_info *group,
+	struct fst_iface_info *iface)
+{
+	return 0;
+}
+
+int fst_cfgmgr_on_iface_deinit(struct fst_iface_info *iface)
+{
+	return 0;
+}
+
+int fst_cfgmgr_on_connect(struct fst_group_info *group, u16 ifid,
+	const u8 *addr)
+{
+	return 0;
+}
+
+int fst_cfgmgr_on_disconnect(struct fst_group_info *group, u16 ifid,
+	const u8 *addr)
+{
+	return 0;
+}
+
+void fst_cfgmgr_on_switch_completed(const struct fst_group_info *group,
+	u16 old_ifid, u16 new_ifid, const u8 *peer_addr)
+{
+}
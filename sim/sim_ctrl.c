@@ -0,0 +1,587 @@
+/*
+ * FST Manager: simulated hostapd control interface
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Implements the fst_ctrl API fst_manager.c is linked against on top of the
+ * in-memory model, answering every call synchronously. The notifications
+ * hostapd would send in reaction to a command are queued and delivered by
+ * the driver once the manager returns, never from within the command.
+ */
+
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <stdarg.h>
+#include <time.h>
+
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "common/defs.h"
+#include "common/ieee802_11_defs.h"
+#include "fst/fst_ctrl_defs.h"
+#include "sim.h"
+
+struct sim_event {
+	u32 session_id;
+	enum fst_event_type type;
+	union fst_event_extra extra;
+	Boolean dropped;
+};
+
+static fst_notification_cb_func sim_ntfy_cb;
+static void *sim_ntfy_cb_ctx;
+
+/* ring of queued notifications, grown on demand */
+static struct sim_event *sim_events;
+static unsigned int sim_events_size;
+static unsigned int sim_events_head;
+static unsigned int sim_events_num;
+
+int fst_set_notify_cb(fst_notification_cb_func ntfy_cb, void *ntfy_cb_ctx)
+{
+	sim_ntfy_cb = ntfy_cb;
+	sim_ntfy_cb_ctx = ntfy_cb_ctx;
+	return 0;
+}
+
+void fst_free(void *p)
+{
+	free(p);
+}
+
+void sim_ctrl_queue(u32 session_id, enum fst_event_type type,
+	const union fst_event_extra *extra)
+{
+	struct sim_event *e;
+
+	if (sim_events_num == sim_events_size) {
+		unsigned int size = sim_events_size ? sim_events_size * 2 : 256;
+		struct sim_event *events = os_calloc(size, sizeof(*events));
+		unsigned int k;
+
+		if (!events) {
+			fprintf(stderr, "sim: cannot grow the event queue\n");
+			exit(2);
+		}
+		for (k = 0; k < sim_events_num; k++)
+			events[k] = sim_events[(sim_events_head + k) %
+				sim_events_size];
+		os_free(sim_events);
+		sim_events = events;
+		sim_events_size = size;
+		sim_events_head = 0;
+	}
+
+	e = &sim_events[(sim_events_head + sim_events_num++) % sim_events_size];
+	e->session_id = session_id;
+	e->type = type;
+	e->dropped = FALSE;
+	if (extra)
+		e->extra = *extra;
+	else
+		os_memset(&e->extra, 0, sizeof(e->extra));
+}
+
+void sim_ctrl_queue_state(u32 session_id, enum fst_session_state old_state,
+	enum fst_session_state new_state, enum fst_reason reason,
+	enum fst_initiator initiator)
+{
+	union fst_event_extra extra;
+
+	os_memset(&extra, 0, sizeof(extra));
+	extra.session_state.old_state = old_state;
+	extra.session_state.new_state = new_state;
+	extra.session_state.extra.to_initial.reason = reason;
+	extra.session_state.extra.to_initial.initiator = initiator;
+	sim_ctrl_queue(session_id, EVENT_FST_SESSION_STATE_CHANGED, &extra);
+}
+
+/* hostapd sends nothing more about a session once it is removed */
+static void sim_ctrl_drop_events(u32 session_id)
+{
+	unsigned int k;
+
+	for (k = 0; k < sim_events_num; k++) {
+		struct sim_event *e =
+			&sim_events[(sim_events_head + k) % sim_events_size];
+
+		if (e->session_id == session_id && !e->dropped) {
+			e->dropped = TRUE;
+			sim.stats.stale_events++;
+		}
+	}
+}
+
+unsigned int sim_ctrl_drain(void)
+{
+	unsigned int n = 0;
+	Boolean lost = FALSE;
+
+	while (sim_events_num) {
+		struct sim_event e = sim_events[sim_events_head];
+		struct timespec start, end;
+
+		sim_events_head = (sim_events_head + 1) % sim_events_size;
+		sim_events_num--;
+		if (e.dropped || !sim_ntfy_cb)
+			continue;
+		if (sim.loss_permille &&
+		    os_random() % 1000 < sim.loss_permille) {
+			sim.stats.lost_events++;
+			lost = TRUE;
+			continue;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		sim_ntfy_cb(sim_ntfy_cb_ctx, e.session_id, e.type, &e.extra);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		fst_hist_add(&sim.stats.event_ns,
+			(end.tv_sec - start.tv_sec) * 1000000000 +
+			end.tv_nsec - start.tv_nsec);
+		sim.stats.events++;
+		n++;
+	}
+
+	/* reported once the burst is over, as fst_ctrl does */
+	if (lost) {
+		sim_ntfy_cb(sim_ntfy_cb_ctx, FST_INVALID_SESSION_ID,
+			EVENT_FST_EVENTS_LOST, NULL);
+		n += sim_ctrl_drain();
+	}
+
+	return n;
+}
+
+void sim_ctrl_deinit(void)
+{
+	os_free(sim_events);
+	sim_events = NULL;
+	sim_events_size = sim_events_head = sim_events_num = 0;
+	os_free(sim.sessions);
+	sim.sessions = NULL;
+	os_free(sim.free_ids);
+	sim.free_ids = NULL;
+	sim.sessions_size = sim.free_ids_num = sim.sessions_in_use = 0;
+}
+
+/*
+ * Sessions
+ */
+struct sim_session *sim_session_get(u32 session_id)
+{
+	if (session_id >= sim.sessions_size || !sim.sessions[session_id].g)
+		return NULL;
+	return &sim.sessions[session_id];
+}
+
+/* hostapd reuses the ids of removed sessions the same way */
+u32 sim_ctrl_session_new(struct sim_group *g)
+{
+	struct sim_session *s;
+	u32 id;
+
+	if (sim.free_ids_num)
+		id = sim.free_ids[--sim.free_ids_num];
+	else {
+		if (sim.sessions_size == (u32)-1 - 1)
+			return FST_INVALID_SESSION_ID;
+		if ((sim.sessions_size & 255) == 0) {
+			struct sim_session *sessions;
+			u32 *free_ids;
+
+			sessions = os_realloc_array(sim.sessions,
+				sim.sessions_size + 256, sizeof(*sessions));
+			if (!sessions)
+				return FST_INVALID_SESSION_ID;
+			sim.sessions = sessions;
+			free_ids = os_realloc_array(sim.free_ids,
+				sim.sessions_size + 256, sizeof(*free_ids));
+			if (!free_ids)
+				return FST_INVALID_SESSION_ID;
+			sim.free_ids = free_ids;
+		}
+		id = sim.sessions_size++;
+	}
+
+	s = &sim.sessions[id];
+	os_memset(s, 0, sizeof(*s));
+	s->g = g;
+	s->info.session_id = id;
+	s->info.state = FST_SESSION_STATE_INITIAL;
+	sim.sessions_in_use++;
+	return id;
+}
+
+static struct sim_session *sim_ctrl_call(u32 session_id)
+{
+	struct sim_session *s = sim_session_get(session_id);
+
+	sim.stats.ctrl_calls++;
+	if (!s)
+		sim.stats.ctrl_failures++;
+	return s;
+}
+
+static int sim_ctrl_fail(void)
+{
+	sim.stats.ctrl_failures++;
+	return -EINVAL;
+}
+
+int fst_session_add(const char *group_id, u32 *session_id)
+{
+	unsigned int k;
+
+	sim.stats.ctrl_calls++;
+	for (k = 0; k < sim.groups_num; k++)
+		if (!os_strcmp(sim.groups[k].info.id, group_id))
+			break;
+	if (k == sim.groups_num)
+		return sim_ctrl_fail();
+
+	*session_id = sim_ctrl_session_new(&sim.groups[k]);
+	if (*session_id == FST_INVALID_SESSION_ID)
+		return sim_ctrl_fail();
+	return 0;
+}
+
+int fst_session_remove(u32 session_id)
+{
+	struct sim_session *s = sim_ctrl_call(session_id);
+	struct sim_peer *p;
+
+	if (!s)
+		return -EINVAL;
+
+	p = sim_peer_by_addr(s->info.old_peer_addr, NULL, NULL);
+	if (p && p->session_id == session_id)
+		p->session_id = FST_INVALID_SESSION_ID;
+	s->g = NULL;
+	sim.free_ids[sim.free_ids_num++] = session_id;
+	sim.sessions_in_use--;
+	sim_ctrl_drop_events(session_id);
+	return 0;
+}
+
+int fst_session_get_info(u32 session_id, struct fst_session_info *info)
+{
+	struct sim_session *s = sim_ctrl_call(session_id);
+
+	if (!s)
+		return -EINVAL;
+	*info = s->info;
+	return 0;
+}
+
+int fst_get_sessions(const struct fst_group_info *group, u32 **sessions)
+{
+	u32 id;
+	int n = 0;
+
+	sim.stats.ctrl_calls++;
+	*sessions = NULL;
+	for (id = 0; id < sim.sessions_size; id++)
+		if (sim.sessions[id].g &&
+		    !os_strcmp(sim.sessions[id].g->info.id, group->id))
+			n++;
+	if (!n)
+		return 0;
+
+	*sessions = os_malloc(n * sizeof(**sessions));
+	if (!*sessions)
+		return sim_ctrl_fail();
+	n = 0;
+	for (id = 0; id < sim.sessions_size; id++)
+		if (sim.sessions[id].g &&
+		    !os_strcmp(sim.sessions[id].g->info.id, group->id))
+			(*sessions)[n++] = id;
+	return n;
+}
+
+int fst_session_set(u32 session_id, const char *pname, const char *pval)
+{
+	struct sim_session *s = sim_ctrl_call(session_id);
+	struct sim_peer *p;
+
+	if (!s)
+		return -EINVAL;
+	if (s->info.state != FST_SESSION_STATE_INITIAL)
+		return sim_ctrl_fail();
+
+	if (!os_strcmp(pname, FST_CSS_PNAME_OLD_IFNAME))
+		os_strlcpy(s->info.old_ifname, pval, sizeof(s->info.old_ifname));
+	else if (!os_strcmp(pname, FST_CSS_PNAME_NEW_IFNAME))
+		os_strlcpy(s->info.new_ifname, pval, sizeof(s->info.new_ifname));
+	else if (!os_strcmp(pname, FST_CSS_PNAME_LLT))
+		s->info.llt = strtoul(pval, NULL, 0);
+	else if (!os_strcmp(pname, FST_CSS_PNAME_OLD_PEER_ADDR) ||
+		 !os_strcmp(pname, FST_CSS_PNAME_NEW_PEER_ADDR)) {
+		u8 *addr = !os_strcmp(pname, FST_CSS_PNAME_OLD_PEER_ADDR) ?
+			s->info.old_peer_addr : s->info.new_peer_addr;
+
+		if (hwaddr_aton(pval, addr))
+			return sim_ctrl_fail();
+		p = sim_peer_by_addr(addr, NULL, NULL);
+		if (!p)
+			return sim_ctrl_fail();
+		p->session_id = session_id;
+	} else
+		return sim_ctrl_fail();
+
+	return 0;
+}
+
+/* both ends of the session must be connected for hostapd to set it up */
+static Boolean sim_session_is_valid(struct sim_session *s)
+{
+	struct sim_group *g;
+	struct sim_peer *old_p, *new_p;
+	unsigned int old_i, new_i;
+
+	old_p = sim_peer_by_addr(s->info.old_peer_addr, &g, &old_i);
+	new_p = sim_peer_by_addr(s->info.new_peer_addr, NULL, &new_i);
+	return old_p && old_p == new_p && g == s->g && old_i != new_i &&
+		sim_iface_by_name(s->info.old_ifname, NULL) == (int)old_i &&
+		sim_iface_by_name(s->info.new_ifname, NULL) == (int)new_i &&
+		(old_p->connected & BIT(old_i)) &&
+		(old_p->connected & BIT(new_i));
+}
+
+int fst_session_initiate(u32 session_id)
+{
+	struct sim_session *s = sim_ctrl_call(session_id);
+
+	if (!s)
+		return -EINVAL;
+	if (s->info.state != FST_SESSION_STATE_INITIAL ||
+	    !sim_session_is_valid(s))
+		return sim_ctrl_fail();
+
+	sim.stats.setups++;
+	s->info.state = FST_SESSION_STATE_SETUP_COMPLETION;
+	sim_ctrl_queue_state(session_id, FST_SESSION_STATE_INITIAL,
+		FST_SESSION_STATE_SETUP_COMPLETION, REASON_SETUP,
+		FST_INITIATOR_LOCAL);
+	if (sim.fail_permille && os_random() % 1000 < sim.fail_permille) {
+		s->info.state = FST_SESSION_STATE_INITIAL;
+		sim_ctrl_queue_state(session_id,
+			FST_SESSION_STATE_SETUP_COMPLETION,
+			FST_SESSION_STATE_INITIAL, REASON_STT,
+			FST_INITIATOR_LOCAL);
+		return 0;
+	}
+	s->established = TRUE;
+	sim_ctrl_queue(session_id, EVENT_FST_ESTABLISHED, NULL);
+	return 0;
+}
+
+int fst_session_respond(u32 session_id, const char *response_status)
+{
+	struct sim_session *s = sim_ctrl_call(session_id);
+
+	if (!s)
+		return -EINVAL;
+	if (s->info.state != FST_SESSION_STATE_SETUP_COMPLETION ||
+	    s->established)
+		return sim_ctrl_fail();
+
+	if (!os_strcmp(response_status, FST_CS_PVAL_RESPONSE_ACCEPT)) {
+		s->established = TRUE;
+		sim_ctrl_queue(session_id, EVENT_FST_ESTABLISHED, NULL);
+	} else {
+		s->info.state = FST_SESSION_STATE_INITIAL;
+		sim_ctrl_queue_state(session_id,
+			FST_SESSION_STATE_SETUP_COMPLETION,
+			FST_SESSION_STATE_INITIAL, REASON_REJECT,
+			FST_INITIATOR_LOCAL);
+	}
+	return 0;
+}
+
+/* completes at once, as if the peer acknowledged on the new band */
+void sim_session_switch(struct sim_session *s, enum fst_initiator initiator)
+{
+	u32 id = s->info.session_id;
+
+	s->info.state = FST_SESSION_STATE_INITIAL;
+	s->established = FALSE;
+	sim_ctrl_queue_state(id, FST_SESSION_STATE_SETUP_COMPLETION,
+		FST_SESSION_STATE_TRANSITION_DONE, REASON_SWITCH, initiator);
+	sim_ctrl_queue_state(id, FST_SESSION_STATE_TRANSITION_DONE,
+		FST_SESSION_STATE_INITIAL, REASON_SWITCH, initiator);
+}
+
+int fst_session_transfer(u32 session_id)
+{
+	struct sim_session *s = sim_ctrl_call(session_id);
+
+	if (!s)
+		return -EINVAL;
+	if (s->info.state != FST_SESSION_STATE_SETUP_COMPLETION ||
+	    !s->established)
+		return sim_ctrl_fail();
+
+	sim_session_switch(s, FST_INITIATOR_LOCAL);
+	return 0;
+}
+
+int fst_session_teardown(u32 session_id)
+{
+	struct sim_session *s = sim_ctrl_call(session_id);
+	enum fst_session_state state;
+
+	if (!s)
+		return -EINVAL;
+	if (s->info.state == FST_SESSION_STATE_INITIAL)
+		return sim_ctrl_fail();
+
+	state = s->info.state;
+	s->info.state = FST_SESSION_STATE_INITIAL;
+	s->established = FALSE;
+	sim_ctrl_queue_state(session_id, state, FST_SESSION_STATE_INITIAL,
+		REASON_TEARDOWN, FST_INITIATOR_LOCAL);
+	return 0;
+}
+
+/*
+ * Peers
+ */
+int fst_get_iface_peers(const struct fst_group_info *group,
+	struct fst_iface_info *iface, uint8_t **peers)
+{
+	struct sim_group *g;
+	unsigned int k, n = 0;
+	int idx;
+
+	sim.stats.ctrl_calls++;
+	*peers = NULL;
+	idx = sim_iface_by_name(iface->name, &g);
+	if (idx < 0)
+		return sim_ctrl_fail();
+
+	for (k = 0; k < sim.peers_num; k++)
+		if (g->peers[k].connected & BIT(idx))
+			n++;
+	if (!n)
+		return 0;
+
+	*peers = os_malloc(n * ETH_ALEN);
+	if (!*peers)
+		return sim_ctrl_fail();
+	n = 0;
+	for (k = 0; k < sim.peers_num; k++)
+		if (g->peers[k].connected & BIT(idx))
+			sim_peer_addr(g - sim.groups, idx, k,
+				*peers + ETH_ALEN * n++);
+	return n;
+}
+
+/* one multi-band element per other iface of the peer */
+int fst_get_peer_mbies(const char *ifname, const uint8_t *peer, char **mbies)
+{
+	struct sim_group *g, *pg;
+	struct sim_peer *p;
+	unsigned int i, pidx, k;
+	char *buf;
+	size_t len = 0, size;
+	int idx;
+
+	sim.stats.ctrl_calls++;
+	sim.stats.mbies_calls++;
+	if (mbies)
+		*mbies = NULL;
+	idx = sim_iface_by_name(ifname, &g);
+	p = sim_peer_by_addr(peer, &pg, &pidx);
+	if (idx < 0 || !p || pg != g || (unsigned int)idx != pidx ||
+	    !(p->connected & BIT(idx)))
+		return sim_ctrl_fail();
+
+	size = 2 * (sim.ifaces_num - 1) *
+		(sizeof(struct multi_band_ie) + ETH_ALEN) + 1;
+	if (!mbies)
+		return size - 1;
+	buf = os_malloc(size);
+	if (!buf)
+		return sim_ctrl_fail();
+
+	k = p - pg->peers;
+	for (i = 0; i < sim.ifaces_num; i++) {
+		struct {
+			struct multi_band_ie ie;
+			u8 sta_addr[ETH_ALEN];
+		} STRUCT_PACKED mbie;
+
+		if (i == (unsigned int)idx)
+			continue;
+		os_memset(&mbie, 0, sizeof(mbie));
+		mbie.ie.eid = WLAN_EID_MULTI_BAND;
+		mbie.ie.len = sizeof(mbie) - 2;
+		mbie.ie.mb_ctrl = MB_STA_ROLE_NON_PCP_NON_AP |
+			MB_CTRL_STA_MAC_PRESENT;
+		mbie.ie.band_id = i ? MB_BAND_ID_WIFI_5GHZ : MB_BAND_ID_WIFI_60GHZ;
+		os_memcpy(mbie.ie.bssid, g->ifaces[i].addr, ETH_ALEN);
+		sim_peer_addr(g - sim.groups, i, k, mbie.sta_addr);
+		len += wpa_snprintf_hex(buf + len, size - len, (u8 *)&mbie,
+			sizeof(mbie));
+	}
+	*mbies = buf;
+	return len;
+}
+
+/*
+ * The manager asks the kernel whether an iface lost its carrier when a peer
+ * disconnects. The binary is linked with -Wl,--wrap=ioctl so that the
+ * simulated ifaces answer from the model.
+ */
+int __real_ioctl(int fd, unsigned long request, ...);
+
+int __wrap_ioctl(int fd, unsigned long request, ...)
+{
+	struct sim_group *g;
+	struct ifreq *ifr;
+	va_list ap;
+	int idx;
+
+	va_start(ap, request);
+	ifr = va_arg(ap, struct ifreq *);
+	va_end(ap);
+
+	if (request == SIOCGIFFLAGS &&
+	    (idx = sim_iface_by_name(ifr->ifr_name, &g)) >= 0) {
+		sim.stats.ioctls++;
+		ifr->ifr_flags = IFF_UP;
+		if (!(g->down & BIT(idx)))
+			ifr->ifr_flags |= IFF_RUNNING;
+		return 0;
+	}
+
+	return __real_ioctl(fd, request, ifr);
+}
@@ -0,0 +1,929 @@
+/*
+ * FST Manager: simulation driver
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Runs fst_manager.c against the in-process fakes of hostapd (sim_ctrl.c),
+ * the mux (sim_mux.c) and the configuration (sim_cfgmgr.c), feeding it
+ * random connect, disconnect, band loss, remote setup and remote switch
+ * sequences for many peers across many groups:
+ *
+ *   fstman_sim -g 8 -p 256 -n 20000
+ *
+ * The map entries the manager leaves in the mux are checked against the
+ * model every few thousand operations and at the end. Every connected peer
+ * must have exactly one entry, via an iface it is connected on, and a
+ * disconnected peer none. Once the operations are over and the manager has
+ * settled, every peer connected on several ifaces must also have an
+ * established session unless setups are made to fail.
+ *
+ * The mux counts the bytes sent to every peer: a share of the peers, drawn
+ * again whenever one connects, sends SIM_ACTIVE_RATE and the rest
+ * SIM_IDLE_RATE. With a lazy setup rate in between, only the active ones
+ * must have a session in the end:
+ *
+ *   fstman_sim -V -C -a 100 -l 10000
+ *
+ * With a rate, operations are spread over time, so that the manager's
+ * timeouts (setup retries, pool refills) interleave with them as they would
+ * on a device. On the virtual clock the waits are skipped: an hour of churn
+ *
+ *   fstman_sim -V -r 10 -n 36000
+ *
+ * runs in seconds.
+ *
+ * Results are printed as key=value pairs; the exit status is 1 if any
+ * invariant was violated.
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "utils/eloop.h"
+#define FST_MGR_COMPONENT "SIM"
+#include "fst_manager.h"
+#include "fst_pool.h"
+#include "fst_status.h"
+#include "sim.h"
+
+#define SIM_BATCH_OPS          64
+#define SIM_SETTLE_INTERVAL_MS 10
+#define SIM_MAX_REPORTED       10
+#define SIM_ACTIVE_RATE        1000000 /* bytes/s, a video stream */
+#define SIM_IDLE_RATE          200     /* bytes/s, keepalives */
+
+/* the knobs main.c sets from the command line, with its defaults */
+unsigned int fst_debug_level = MSG_ERROR + 1;
+unsigned int fst_num_of_retries = 20;
+unsigned int fst_retry_backoff_ms = 100;
+unsigned int fst_max_concurrent_setups = 4;
+unsigned int fst_setup_rate = 0;
+unsigned int fst_setup_burst = 4;
+unsigned int fst_lazy_setup_rate = 0;
+unsigned int fst_session_pool_size = 4;
+unsigned int fst_max_peers = 16;
+unsigned int fst_resync_interval = 0;
+Boolean      fst_force_nc = FALSE;
+
+struct sim sim;
+
+static struct sim_driver {
+	unsigned long ops;
+	unsigned long ops_done;
+	unsigned long check_interval;
+	unsigned long band_loss_interval;
+	unsigned int settle_ms;
+	unsigned int settled_ms;
+	unsigned int rate;    /* ops per second, 0 for back to back */
+	Boolean start_connected;
+	unsigned int active_permille; /* peers sending SIM_ACTIVE_RATE */
+	const char *status_file;
+	const struct fst_status_hdr *status; /* mapped as by another process */
+	size_t status_size;
+	u64 start_ns;
+	u64 end_ns;
+	struct os_reltime start_time; /* on the clock eloop runs on */
+	struct os_reltime end_time;
+	unsigned long checks;
+	unsigned long violations;
+	unsigned long band_losses;
+	unsigned long remote_switches;
+	unsigned long remote_setups;
+	unsigned long connects;
+	unsigned long disconnects;
+} drv;
+
+static u64 sim_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Model
+ */
+static void sim_peer_draw_rate(struct sim_peer *p)
+{
+	/* keeps the random sequence of runs without idle peers */
+	p->tx_rate = drv.active_permille >= 1000 ||
+		(unsigned int)(os_random() % 1000) < drv.active_permille ?
+		SIM_ACTIVE_RATE : SIM_IDLE_RATE;
+}
+
+void sim_peer_addr(unsigned int g, unsigned int i, unsigned int p, u8 *addr)
+{
+	addr[0] = SIM_PEER_ADDR_TYPE;
+	addr[1] = i;
+	addr[2] = g >> 8;
+	addr[3] = g & 0xff;
+	addr[4] = p >> 8;
+	addr[5] = p & 0xff;
+}
+
+struct sim_peer *sim_peer_by_addr(const u8 *addr, struct sim_group **g,
+	unsigned int *iface)
+{
+	unsigned int gi = (addr[2] << 8) | addr[3];
+	unsigned int pi = (addr[4] << 8) | addr[5];
+
+	if (addr[0] != SIM_PEER_ADDR_TYPE || addr[1] >= sim.ifaces_num ||
+	    gi >= sim.groups_num || pi >= sim.peers_num)
+		return NULL;
+	if (g)
+		*g = &sim.groups[gi];
+	if (iface)
+		*iface = addr[1];
+	return &sim.groups[gi].peers[pi];
+}
+
+int sim_iface_by_name(const char *ifname, struct sim_group **g)
+{
+	unsigned int gi, i;
+	char c;
+
+	if (sscanf(ifname, "sim%ui%u%c", &gi, &i, &c) != 2 ||
+	    gi >= sim.groups_num || i >= sim.ifaces_num)
+		return -1;
+	if (g)
+		*g = &sim.groups[gi];
+	return i;
+}
+
+static int sim_model_init(void)
+{
+	unsigned int gi, i, k;
+
+	sim.groups = os_calloc(sim.groups_num, sizeof(*sim.groups));
+	if (!sim.groups)
+		return -1;
+
+	for (gi = 0; gi < sim.groups_num; gi++) {
+		struct sim_group *g = &sim.groups[gi];
+
+		os_snprintf(g->info.id, sizeof(g->info.id), "sim%u", gi);
+		for (i = 0; i < sim.ifaces_num; i++) {
+			struct fst_iface_info *iface = &g->ifaces[i];
+
+			os_snprintf(iface->name, sizeof(iface->name),
+				"sim%ui%u", gi, i);
+			iface->addr[0] = SIM_IFACE_ADDR_TYPE;
+			iface->addr[1] = i;
+			iface->addr[2] = gi >> 8;
+			iface->addr[3] = gi & 0xff;
+			/* the first iface is the preferred one */
+			iface->priority = sim.ifaces_num - i;
+		}
+		g->peers = os_calloc(sim.peers_num, sizeof(*g->peers));
+		if (!g->peers)
+			return -1;
+		for (k = 0; k < sim.peers_num; k++) {
+			g->peers[k].session_id = FST_INVALID_SESSION_ID;
+			sim_peer_draw_rate(&g->peers[k]);
+			if (drv.start_connected)
+				g->peers[k].connected = BIT(sim.ifaces_num) - 1;
+		}
+	}
+
+	return 0;
+}
+
+static void sim_model_deinit(void)
+{
+	unsigned int gi;
+
+	for (gi = 0; gi < sim.groups_num && sim.groups; gi++)
+		os_free(sim.groups[gi].peers);
+	os_free(sim.groups);
+	sim.groups = NULL;
+}
+
+/*
+ * Operations
+ */
+
+/* picks a random set bit of a non-empty bitmap */
+static unsigned int sim_random_bit(unsigned int bits)
+{
+	unsigned int n = os_random() % __builtin_popcount(bits);
+
+	while (n--)
+		bits &= bits - 1;
+	return __builtin_ctz(bits);
+}
+
+static void sim_peer_state(struct sim_group *g, struct sim_peer *p,
+	unsigned int i, Boolean connected)
+{
+	union fst_event_extra extra;
+
+	os_memset(&extra, 0, sizeof(extra));
+	extra.peer_state.connected = connected;
+	os_strlcpy(extra.peer_state.ifname, g->ifaces[i].name,
+		sizeof(extra.peer_state.ifname));
+	sim_peer_addr(g - sim.groups, i, p - g->peers, extra.peer_state.addr);
+	if (fst_debug_level <= MSG_INFO)
+		printf("sim: op %lu: peer %u %s on %s\n", drv.ops_done,
+		       (unsigned int)(p - g->peers),
+		       connected ? "connected" : "disconnected",
+		       g->ifaces[i].name);
+	if (connected) {
+		if (!p->connected)
+			sim_peer_draw_rate(p);
+		p->connected |= BIT(i);
+		drv.connects++;
+	} else {
+		p->connected &= ~BIT(i);
+		drv.disconnects++;
+	}
+	sim_ctrl_queue(FST_INVALID_SESSION_ID, EVENT_PEER_STATE_CHANGED,
+		&extra);
+}
+
+/* the iface the mux sends the peer's traffic through, -1 if none */
+static int sim_peer_mapped_iface(struct sim_group *g, struct sim_peer *p)
+{
+	unsigned int i;
+	u8 addr[ETH_ALEN];
+
+	for (i = 0; i < sim.ifaces_num; i++) {
+		sim_peer_addr(g - sim.groups, i, p - g->peers, addr);
+		if (sim_mux_lookup(g->mux, addr))
+			return i;
+	}
+	return -1;
+}
+
+static Boolean sim_op_remote_switch(struct sim_group *g, struct sim_peer *p)
+{
+	struct sim_session *s = sim_session_get(p->session_id);
+
+	if (!s || !s->established ||
+	    s->info.state != FST_SESSION_STATE_SETUP_COMPLETION)
+		return FALSE;
+
+	if (fst_debug_level <= MSG_INFO)
+		printf("sim: op %lu: peer %u switched from %s to %s\n",
+		       drv.ops_done, (unsigned int)(p - g->peers),
+		       s->info.old_ifname, s->info.new_ifname);
+	sim_session_switch(s, FST_INITIATOR_REMOTE);
+	drv.remote_switches++;
+	return TRUE;
+}
+
+static Boolean sim_op_remote_setup(struct sim_group *g, struct sim_peer *p)
+{
+	struct sim_session *s = sim_session_get(p->session_id);
+	unsigned int gi = g - sim.groups, pi = p - g->peers;
+	int old_i = sim_peer_mapped_iface(g, p);
+	unsigned int new_i;
+	u32 id;
+
+	/* a peer may set up a new session in place of an established one */
+	if ((s && s->info.state != FST_SESSION_STATE_INITIAL &&
+	     !s->established) || old_i < 0 || !(p->connected & ~BIT(old_i)))
+		return FALSE;
+
+	id = sim_ctrl_session_new(g);
+	if (id == FST_INVALID_SESSION_ID)
+		return FALSE;
+	new_i = sim_random_bit(p->connected & ~BIT(old_i));
+	s = sim_session_get(id);
+	os_strlcpy(s->info.old_ifname, g->ifaces[old_i].name,
+		sizeof(s->info.old_ifname));
+	os_strlcpy(s->info.new_ifname, g->ifaces[new_i].name,
+		sizeof(s->info.new_ifname));
+	sim_peer_addr(gi, old_i, pi, s->info.old_peer_addr);
+	sim_peer_addr(gi, new_i, pi, s->info.new_peer_addr);
+	s->info.state = FST_SESSION_STATE_SETUP_COMPLETION;
+	p->session_id = id;
+	if (fst_debug_level <= MSG_INFO)
+		printf("sim: op %lu: peer %u set up session %u from %s to %s\n",
+		       drv.ops_done, pi, id, s->info.old_ifname,
+		       s->info.new_ifname);
+	sim_ctrl_queue(id, EVENT_FST_SETUP, NULL);
+	drv.remote_setups++;
+	return TRUE;
+}
+
+/* the whole band goes down: all its peers disconnect in a burst */
+static void sim_op_band_loss(void)
+{
+	struct sim_group *g = &sim.groups[os_random() % sim.groups_num];
+	unsigned int i = os_random() % sim.ifaces_num, k;
+
+	g->down |= BIT(i);
+	for (k = 0; k < sim.peers_num; k++)
+		if (g->peers[k].connected & BIT(i))
+			sim_peer_state(g, &g->peers[k], i, FALSE);
+	sim_ctrl_drain();
+	g->down &= ~BIT(i);
+	drv.band_losses++;
+}
+
+static void sim_op(void)
+{
+	struct sim_group *g = &sim.groups[os_random() % sim.groups_num];
+	struct sim_peer *p = &g->peers[os_random() % sim.peers_num];
+	unsigned int missing = (BIT(sim.ifaces_num) - 1) & ~p->connected;
+	unsigned int r = os_random() % 100;
+
+	Boolean done = FALSE;
+
+	if (!p->connected || (missing && r < 60)) {
+		sim_peer_state(g, p, sim_random_bit(missing), TRUE);
+		done = TRUE;
+	} else if (!missing && r >= 40 && r < 80)
+		done = sim_op_remote_switch(g, p);
+	else if (!missing && r >= 80 && r < 90)
+		done = sim_op_remote_setup(g, p);
+
+	/* whatever is not possible right now becomes a disconnect */
+	if (!done)
+		sim_peer_state(g, p, sim_random_bit(p->connected), FALSE);
+	sim_ctrl_drain();
+}
+
+/*
+ * Invariants
+ */
+static void sim_violation(const char *fmt, ...)
+{
+	va_list ap;
+
+	if (drv.violations++ >= SIM_MAX_REPORTED)
+		return;
+	printf("violation: after %lu ops: ", drv.ops_done);
+	va_start(ap, fmt);
+	vprintf(fmt, ap);
+	va_end(ap);
+	printf("\n");
+}
+
+static Boolean sim_peer_has_session(struct sim_peer *p)
+{
+	struct sim_session *s = sim_session_get(p->session_id);
+
+	return s && s->established &&
+		s->info.state != FST_SESSION_STATE_INITIAL;
+}
+
+/* connected on several ifaces and, with lazy setups, sending enough */
+static Boolean sim_peer_needs_session(struct sim_peer *p)
+{
+	return __builtin_popcount(p->connected) > 1 &&
+		p->tx_rate >= fst_lazy_setup_rate;
+}
+
+/* peers that need a session but have no established one */
+static unsigned int sim_idle_peers(void)
+{
+	unsigned int gi, k, n = 0;
+
+	for (gi = 0; gi < sim.groups_num; gi++)
+		for (k = 0; k < sim.peers_num; k++) {
+			struct sim_peer *p = &sim.groups[gi].peers[k];
+
+			if (sim_peer_needs_session(p) &&
+			    !sim_peer_has_session(p))
+				n++;
+		}
+	return n;
+}
+
+/* the status page must agree with the mux, as read by another process */
+static void sim_status_check(Boolean final)
+{
+	const struct fst_status_hdr *hdr = drv.status;
+	struct fst_status_peer r;
+	unsigned int gi, k, idx, records = 0, connected = 0;
+
+	if (!hdr)
+		return;
+
+	for (idx = 0; idx < hdr->records_used; idx++) {
+		struct sim_group *g;
+		struct sim_peer *p = NULL;
+		const char *ifname;
+
+		if (fst_status_read_peer(hdr, idx, &r))
+			continue;
+		records++;
+		if (r.ifaces_num)
+			p = sim_peer_by_addr(r.ifaces[0].addr, &g, NULL);
+		if (!p || os_strcmp(r.group, g->info.id)) {
+			sim_violation("status record %u: unknown peer in group "
+				"%s", idx, r.group);
+			continue;
+		}
+		if (r.active >= r.ifaces_num) {
+			sim_violation("status record %u: " MACSTR " without an "
+				"active iface", idx, MAC2STR(r.ifaces[0].addr));
+			continue;
+		}
+		ifname = sim_mux_lookup(g->mux, r.ifaces[r.active].addr);
+		if (!ifname || os_strcmp(ifname, r.ifaces[r.active].name))
+			sim_violation("status record %u: " MACSTR " active via "
+				"%s, mapped via %s", idx,
+				MAC2STR(r.ifaces[r.active].addr),
+				r.ifaces[r.active].name, ifname ? ifname : "none");
+		if (final && !sim.fail_permille && !sim.loss_permille &&
+		    sim_peer_needs_session(p) &&
+		    r.session_state != FST_STATUS_SESSION_ESTABLISHED)
+			sim_violation("status record %u: " MACSTR " session "
+				"state %u", idx, MAC2STR(r.ifaces[0].addr),
+				r.session_state);
+	}
+
+	for (gi = 0; gi < sim.groups_num; gi++)
+		for (k = 0; k < sim.peers_num; k++)
+			if (sim.groups[gi].peers[k].connected)
+				connected++;
+	if (records != connected)
+		sim_violation("status page: %u records for %u peers", records,
+			connected);
+}
+
+static int sim_status_map(void)
+{
+	struct stat st;
+	void *page;
+	int fd;
+
+	fd = open(drv.status_file, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	if (fstat(fd, &st)) {
+		close(fd);
+		return -1;
+	}
+	page = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (page == MAP_FAILED)
+		return -1;
+
+	drv.status = page;
+	drv.status_size = st.st_size;
+	if (drv.status->magic != FST_STATUS_MAGIC ||
+	    drv.status->version != FST_STATUS_VERSION ||
+	    drv.status->record_size != sizeof(struct fst_status_peer))
+		return -1;
+	return 0;
+}
+
+static void sim_check(Boolean final)
+{
+	unsigned int gi, i, k, connected = 0;
+
+	drv.checks++;
+	for (gi = 0; gi < sim.groups_num; gi++) {
+		struct sim_group *g = &sim.groups[gi];
+		unsigned int entries = 0;
+
+		for (k = 0; k < sim.peers_num; k++) {
+			struct sim_peer *p = &g->peers[k];
+			unsigned int n = 0;
+
+			for (i = 0; i < sim.ifaces_num; i++) {
+				u8 addr[ETH_ALEN];
+				const char *ifname;
+
+				sim_peer_addr(gi, i, k, addr);
+				ifname = sim_mux_lookup(g->mux, addr);
+				if (!ifname)
+					continue;
+				n++;
+				if (os_strcmp(ifname, g->ifaces[i].name))
+					sim_violation("group %s peer %u: " MACSTR
+						" mapped via %s", g->info.id, k,
+						MAC2STR(addr), ifname);
+				else if (!(p->connected & BIT(i)))
+					sim_violation("group %s peer %u: mapped "
+						"via %s, not connected there",
+						g->info.id, k, ifname);
+			}
+			if (n != (p->connected ? 1U : 0U))
+				sim_violation("group %s peer %u: %u map entries, "
+					"connected on 0x%x", g->info.id, k, n,
+					p->connected);
+			if (final && !sim.fail_permille &&
+			    sim_peer_needs_session(p) &&
+			    !sim_peer_has_session(p))
+				sim_violation("group %s peer %u: connected on "
+					"0x%x without a session", g->info.id, k,
+					p->connected);
+			entries += n;
+			if (p->connected)
+				connected++;
+		}
+		if (sim_mux_entries(g->mux) != entries)
+			sim_violation("group %s: %u map entries, %u for peers",
+				g->info.id, sim_mux_entries(g->mux), entries);
+	}
+
+	/* every peer holds at most one session, the pools the rest */
+	if (sim.sessions_in_use >
+	    connected + sim.groups_num * fst_session_pool_size)
+		sim_violation("%u hostapd sessions for %u peers",
+			sim.sessions_in_use, connected);
+	sim_status_check(final);
+}
+
+/*
+ * Driver
+ */
+static void sim_step(void *eloop_data, void *user_ctx)
+{
+	unsigned int k;
+
+	/* events queued by the manager's own timeouts */
+	sim_ctrl_drain();
+
+	if (drv.ops_done < drv.ops) {
+		unsigned int batch = drv.rate ? 1 : SIM_BATCH_OPS;
+
+		for (k = 0; k < batch && drv.ops_done < drv.ops; k++) {
+			sim_op();
+			drv.ops_done++;
+			if (drv.band_loss_interval &&
+			    drv.ops_done % drv.band_loss_interval == 0)
+				sim_op_band_loss();
+			if (drv.check_interval &&
+			    drv.ops_done % drv.check_interval == 0)
+				sim_check(FALSE);
+		}
+		if (drv.ops_done == drv.ops)
+			drv.end_ns = sim_now_ns();
+		eloop_register_timeout(0, drv.rate ? 1000000 / drv.rate : 0,
+			sim_step, NULL, NULL);
+		return;
+	}
+
+	/* let deferred setups and retries complete */
+	if (drv.settled_ms < drv.settle_ms &&
+	    (sim.fail_permille || sim_idle_peers())) {
+		drv.settled_ms += SIM_SETTLE_INTERVAL_MS;
+		eloop_register_timeout(0, SIM_SETTLE_INTERVAL_MS * 1000,
+			sim_step, NULL, NULL);
+		return;
+	}
+
+	sim_check(TRUE);
+	os_get_reltime(&drv.end_time);
+	eloop_terminate();
+}
+
+static long sim_maxrss_kb(void)
+{
+	struct rusage ru;
+
+	if (getrusage(RUSAGE_SELF, &ru))
+		return -1;
+	return ru.ru_maxrss;
+}
+
+static void sim_report(long rss_base_kb)
+{
+	u64 elapsed_ns = drv.end_ns - drv.start_ns;
+	struct os_reltime sim_time;
+	double sec = elapsed_ns / 1e9;
+	const struct fst_hist *h = &sim.stats.event_ns;
+	unsigned int gi, k, connected = 0, active = 0;
+
+	for (gi = 0; gi < sim.groups_num; gi++)
+		for (k = 0; k < sim.peers_num; k++) {
+			const struct sim_peer *p = &sim.groups[gi].peers[k];
+
+			if (p->connected)
+				connected++;
+			if (p->connected && p->tx_rate == SIM_ACTIVE_RATE)
+				active++;
+		}
+	os_reltime_sub(&drv.end_time, &drv.start_time, &sim_time);
+
+	printf("sim groups=%u ifaces=%u peers=%u ops=%lu elapsed_ms=%llu "
+	       "ops_per_sec=%.0f events=%llu events_per_sec=%.0f\n",
+	       sim.groups_num, sim.ifaces_num,
+	       sim.groups_num * sim.peers_num, drv.ops_done,
+	       (unsigned long long)(elapsed_ns / 1000000),
+	       sec > 0 ? drv.ops_done / sec : 0.0,
+	       (unsigned long long)sim.stats.events,
+	       sec > 0 ? sim.stats.events / sec : 0.0);
+	printf("sim event_ns avg=%llu p50=%u p99=%u max=%u\n",
+	       (unsigned long long)(h->count ? h->sum / h->count : 0),
+	       fst_hist_percentile(h, 500), fst_hist_percentile(h, 990),
+	       h->max);
+	printf("sim clock=%s sim_time_ms=%llu rate=%u\n",
+	       os_is_virtual_clock() ? "virtual" : "system",
+	       (unsigned long long)(sim_time.sec * 1000 + sim_time.usec / 1000),
+	       drv.rate);
+	printf("sim connects=%lu disconnects=%lu band_losses=%lu "
+	       "remote_setups=%lu remote_switches=%lu\n",
+	       drv.connects, drv.disconnects, drv.band_losses,
+	       drv.remote_setups, drv.remote_switches);
+	printf("sim ctrl_calls=%llu ctrl_failures=%llu mbies_calls=%llu "
+	       "setups=%llu ioctls=%llu stale_events=%llu lost_events=%llu\n",
+	       (unsigned long long)sim.stats.ctrl_calls,
+	       (unsigned long long)sim.stats.ctrl_failures,
+	       (unsigned long long)sim.stats.mbies_calls,
+	       (unsigned long long)sim.stats.setups,
+	       (unsigned long long)sim.stats.ioctls,
+	       (unsigned long long)sim.stats.stale_events,
+	       (unsigned long long)sim.stats.lost_events);
+	printf("sim map_adds=%llu map_replaces=%llu map_dels=%llu "
+	       "map_dels_missing=%llu map_batches=%llu\n",
+	       (unsigned long long)sim.stats.map_adds,
+	       (unsigned long long)sim.stats.map_replaces,
+	       (unsigned long long)sim.stats.map_dels,
+	       (unsigned long long)sim.stats.map_dels_missing,
+	       (unsigned long long)sim.stats.map_batches);
+	printf("sim connected_peers=%u idle_peers=%u sessions=%u "
+	       "settle_ms=%u\n", connected, sim_idle_peers(),
+	       sim.sessions_in_use, drv.settled_ms);
+	printf("sim lazy_rate=%u active_peers=%u bytes_dumps=%llu\n",
+	       fst_lazy_setup_rate, active,
+	       (unsigned long long)sim.stats.bytes_dumps);
+	printf("sim maxrss_kb=%ld model_rss_kb=%ld\n", sim_maxrss_kb(),
+	       rss_base_kb);
+	printf("sim checks=%lu violations=%lu\n", drv.checks, drv.violations);
+}
+
+/* every object must be back in its pool once the manager is gone */
+static void sim_pools_report(void)
+{
+	struct fst_pool *p;
+
+	for (p = fst_pool_first(); p; p = p->next) {
+		printf("sim pool=%s capacity=%u high_water=%u "
+		       "heap_high_water=%u heap_allocs=%llu leaked=%u\n",
+		       p->name, p->capacity, p->high_water, p->heap_high_water,
+		       (unsigned long long)p->heap_allocs, p->in_use);
+		if (p->in_use)
+			drv.violations++;
+	}
+}
+
+static void usage(const char *prog)
+{
+	printf("Usage: %s [options]\n"
+	       ", where options are:\n"
+	       "\t--groups, -g <int>       - FST groups (default 8)\n"
+	       "\t--ifaces, -i <int>       - ifaces per group (default 2, "
+			"max %u)\n"
+	       "\t--peers, -p <int>        - peers per group (default 256)\n"
+	       "\t--ops, -n <int>          - operations (default 20000)\n"
+	       "\t--connected, -C          - peers connected at startup\n"
+	       "\t--setup-fail, -F <int>   - setups failing, per mille\n"
+	       "\t--event-loss, -L <int>   - events lost, per mille, "
+			"followed by a resync\n"
+	       "\t--band-loss, -b <int>    - band loss every <int> ops "
+			"(default 20000, 0 disables)\n"
+	       "\t--check, -c <int>        - check the invariants every "
+			"<int> ops (default 10000)\n"
+	       "\t--settle, -t <ms>        - time given to the manager to "
+			"settle (default 3000)\n"
+	       "\t--rate, -r <int>         - ops per second (default as "
+			"fast as possible)\n"
+	       "\t--virtual-clock, -V      - run eloop on a virtual clock\n"
+	       "\t--pool-size, -P <int>    - hostapd session pool size "
+			"(default %u)\n"
+	       "\t--max-setups, -S <int>   - concurrent setups (default %u)\n"
+	       "\t--setup-rate, -R <int>   - setups admitted per second "
+			"(default unlimited)\n"
+	       "\t--setup-burst, -K <int>  - setups admitted back to back "
+			"(default %u)\n"
+	       "\t--max-peers, -N <int>    - peers the object pools are "
+			"preallocated for (default %u)\n"
+	       "\t--status-file, -o <file> - check the status page published "
+			"to the file\n"
+	       "\t--active, -a <int>       - peers sending traffic, per mille "
+			"(default 1000)\n"
+	       "\t--lazy-setup, -l <int>   - defer setups of peers sent less "
+			"than <int> bytes/s\n"
+	       "\t--seed, -s <int>         - random seed\n"
+	       "\t--debug, -d              - manager output, repeat for "
+			"more\n"
+	       "\t--help, -h               - this message\n",
+	       prog, SIM_MAX_IFACES, fst_session_pool_size,
+	       fst_max_concurrent_setups, fst_setup_burst, fst_max_peers);
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	const struct option long_opts[] = {
+		{"groups", required_argument, NULL, 'g'},
+		{"ifaces", required_argument, NULL, 'i'},
+		{"peers", required_argument, NULL, 'p'},
+		{"ops", required_argument, NULL, 'n'},
+		{"connected", no_argument, NULL, 'C'},
+		{"setup-fail", required_argument, NULL, 'F'},
+		{"event-loss", required_argument, NULL, 'L'},
+		{"band-loss", required_argument, NULL, 'b'},
+		{"check", required_argument, NULL, 'c'},
+		{"settle", required_argument, NULL, 't'},
+		{"rate", required_argument, NULL, 'r'},
+		{"virtual-clock", no_argument, NULL, 'V'},
+		{"pool-size", required_argument, NULL, 'P'},
+		{"max-setups", required_argument, NULL, 'S'},
+		{"setup-rate", required_argument, NULL, 'R'},
+		{"setup-burst", required_argument, NULL, 'K'},
+		{"max-peers", required_argument, NULL, 'N'},
+		{"status-file", required_argument, NULL, 'o'},
+		{"active", required_argument, NULL, 'a'},
+		{"lazy-setup", required_argument, NULL, 'l'},
+		{"seed", required_argument, NULL, 's'},
+		{"debug", no_argument, NULL, 'd'},
+		{"help", no_argument, NULL, 'h'},
+		{}
+	};
+	long rss_base_kb;
+	int opt, res = 1;
+
+	sim.groups_num = 8;
+	sim.ifaces_num = 2;
+	sim.peers_num = 256;
+	drv.ops = 20000;
+	drv.band_loss_interval = 20000;
+	drv.check_interval = 10000;
+	drv.settle_ms = 3000;
+	drv.active_permille = 1000;
+
+	while ((opt = getopt_long(argc, argv, "g:i:p:n:CF:L:b:c:t:r:VP:S:R:K:N:o:a:l:s:dh",
+				  long_opts, NULL)) != -1) {
+		switch (opt) {
+		case 'g':
+			sim.groups_num = strtoul(optarg, NULL, 0);
+			break;
+		case 'i':
+			sim.ifaces_num = strtoul(optarg, NULL, 0);
+			break;
+		case 'p':
+			sim.peers_num = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			drv.ops = strtoul(optarg, NULL, 0);
+			break;
+		case 'C':
+			drv.start_connected = TRUE;
+			break;
+		case 'F':
+			sim.fail_permille = strtoul(optarg, NULL, 0);
+			break;
+		case 'L':
+			sim.loss_permille = strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			drv.band_loss_interval = strtoul(optarg, NULL, 0);
+			break;
+		case 'c':
+			drv.check_interval = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			drv.settle_ms = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			drv.rate = strtoul(optarg, NULL, 0);
+			break;
+		case 'V':
+			os_set_virtual_clock(1);
+			break;
+		case 'P':
+			fst_session_pool_size = strtoul(optarg, NULL, 0);
+			break;
+		case 'S':
+			fst_max_concurrent_setups = strtoul(optarg, NULL, 0);
+			break;
+		case 'R':
+			fst_setup_rate = strtoul(optarg, NULL, 0);
+			break;
+		case 'K':
+			fst_setup_burst = strtoul(optarg, NULL, 0);
+			break;
+		case 'N':
+			fst_max_peers = strtoul(optarg, NULL, 0);
+			break;
+		case 'o':
+			drv.status_file = optarg;
+			break;
+		case 'a':
+			drv.active_permille = strtoul(optarg, NULL, 0);
+			break;
+		case 'l':
+			fst_lazy_setup_rate = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			srandom(strtoul(optarg, NULL, 0));
+			break;
+		case 'd':
+			fst_debug_level = fst_debug_level > MSG_INFO ?
+				MSG_INFO : MSG_DEBUG;
+			break;
+		case 'h':
+		default:
+			usage(argv[0]);
+			break;
+		}
+	}
+
+	if (optind != argc || !sim.groups_num || sim.groups_num > 0xffff ||
+	    sim.ifaces_num < 2 || sim.ifaces_num > SIM_MAX_IFACES ||
+	    !sim.peers_num || sim.peers_num > 0xffff)
+		usage(argv[0]);
+
+	if (eloop_init()) {
+		fprintf(stderr, "sim: eloop_init failed\n");
+		return 1;
+	}
+
+	if (sim_model_init()) {
+		fprintf(stderr, "sim: cannot allocate the model\n");
+		goto out;
+	}
+	rss_base_kb = sim_maxrss_kb();
+
+	if (drv.status_file) {
+		if (fst_status_init(drv.status_file,
+				    sim.groups_num * sim.peers_num) ||
+		    sim_status_map()) {
+			fprintf(stderr, "sim: cannot set up the status page\n");
+			goto out;
+		}
+	}
+
+	drv.start_ns = sim_now_ns();
+	os_get_reltime(&drv.start_time);
+	if (fst_manager_init()) {
+		fprintf(stderr, "sim: fst_manager_init failed\n");
+		goto out;
+	}
+
+	eloop_register_timeout(0, 0, sim_step, NULL, NULL);
+	eloop_run();
+	if (!drv.end_ns)
+		drv.end_ns = sim_now_ns();
+
+	sim_report(rss_base_kb);
+
+	fst_manager_deinit();
+	if (drv.status) {
+		struct fst_status_peer r;
+		unsigned int idx;
+
+		/* every record must be released with its peer */
+		for (idx = 0; idx < drv.status->records_used; idx++)
+			if (!fst_status_read_peer(drv.status, idx, &r))
+				sim_violation("status record %u: still in use "
+					"by a peer of %s", idx, r.group);
+	}
+	sim_pools_report();
+	fst_pool_deinit();
+	res = drv.violations ? 1 : 0;
+out:
+	if (drv.status)
+		munmap((void *)drv.status, drv.status_size);
+	fst_status_deinit();
+	sim_ctrl_deinit();
+	sim_model_deinit();
+	eloop_destroy();
+	return res;
+}
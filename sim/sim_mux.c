@@ -0,0 +1,246 @@
+/*
+ * FST Manager: simulated mux
+ *
+ * Copyright (c) 2016, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Implements the fst_mux API on top of a hash of map entries, with the
+ * semantics of the bonding mux: adding a destination replaces its entry and
+ * deleting one that is not mapped fails.
+ */
+
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "utils/list.h"
+#include "sim.h"
+
+#define SIM_MUX_HASH_SIZE 4096
+
+struct sim_mux_entry {
+	struct dl_list lentry;
+	u8 da[ETH_ALEN];
+	const char *iface_name; /* points to the iface of the model */
+	u64 bytes;              /* sent since mapped, see sim_peer.tx_rate */
+	struct os_reltime sampled;
+};
+
+struct fst_mux {
+	struct sim_group *g;
+	unsigned int ifaces;  /* bitmap of registered iface indices */
+	unsigned int entries;
+	Boolean started;
+	struct dl_list hash[SIM_MUX_HASH_SIZE];
+};
+
+static unsigned int sim_mux_hash(const u8 *da)
+{
+	/* peers of a group differ in the iface and peer bytes only */
+	return (((da[4] << 8) | da[5]) * SIM_MAX_IFACES + da[1]) %
+		SIM_MUX_HASH_SIZE;
+}
+
+static struct sim_mux_entry *sim_mux_entry(struct fst_mux *ctx, const u8 *da)
+{
+	struct sim_mux_entry *e;
+
+	dl_list_for_each(e, &ctx->hash[sim_mux_hash(da)],
+			 struct sim_mux_entry, lentry)
+		if (!os_memcmp(e->da, da, ETH_ALEN))
+			return e;
+	return NULL;
+}
+
+struct fst_mux *fst_mux_init(const char *drv_iface_name)
+{
+	struct fst_mux *ctx;
+	unsigned int k;
+
+	for (k = 0; k < sim.groups_num; k++)
+		if (!os_strcmp(sim.groups[k].info.id, drv_iface_name))
+			break;
+	if (k == sim.groups_num)
+		return NULL;
+
+	ctx = os_zalloc(sizeof(*ctx));
+	if (!ctx)
+		return NULL;
+	ctx->g = &sim.groups[k];
+	for (k = 0; k < SIM_MUX_HASH_SIZE; k++)
+		dl_list_init(&ctx->hash[k]);
+	ctx->g->mux = ctx;
+	return ctx;
+}
+
+int fst_mux_start(struct fst_mux *ctx)
+{
+	ctx->started = TRUE;
+	return 0;
+}
+
+int fst_mux_register_iface(struct fst_mux *ctx, const char *iface_name,
+		u8 priority)
+{
+	struct sim_group *g;
+	int idx = sim_iface_by_name(iface_name, &g);
+
+	if (idx < 0 || g != ctx->g)
+		return -1;
+	ctx->ifaces |= BIT(idx);
+	return 0;
+}
+
+int fst_mux_add_map_entry(struct fst_mux *ctx, const u8 *da, u16 ifid)
+{
+	struct sim_mux_entry *e;
+	struct sim_group *g;
+	int idx = sim_iface_by_name(fst_ifreg_name(ifid), &g);
+
+	if (idx < 0 || g != ctx->g || !(ctx->ifaces & BIT(idx)))
+		return -1;
+
+	sim.stats.map_adds++;
+	e = sim_mux_entry(ctx, da);
+	if (e) {
+		sim.stats.map_replaces++;
+		/* the bonding mux re-adds the filter, restarting its counter */
+		e->bytes = 0;
+	} else {
+		e = os_zalloc(sizeof(*e));
+		if (!e)
+			return -1;
+		os_memcpy(e->da, da, ETH_ALEN);
+		dl_list_add(&ctx->hash[sim_mux_hash(da)], &e->lentry);
+		ctx->entries++;
+	}
+	e->iface_name = g->ifaces[idx].name;
+	os_get_reltime(&e->sampled);
+	return 0;
+}
+
+int fst_mux_del_map_entry(struct fst_mux *ctx, const u8 *da)
+{
+	struct sim_mux_entry *e = sim_mux_entry(ctx, da);
+
+	sim.stats.map_dels++;
+	if (!e) {
+		sim.stats.map_dels_missing++;
+		return -1;
+	}
+	dl_list_del(&e->lentry);
+	os_free(e);
+	ctx->entries--;
+	return 0;
+}
+
+int fst_mux_set_map_entries(struct fst_mux *ctx,
+		const struct fst_mux_map_entry *entries, int n)
+{
+	int i, failed = 0;
+
+	sim.stats.map_batches++;
+	for (i = 0; i < n; i++) {
+		int res = entries[i].ifid != FST_IFREG_NONE ?
+			fst_mux_add_map_entry(ctx, entries[i].da,
+				entries[i].ifid) :
+			fst_mux_del_map_entry(ctx, entries[i].da);
+		if (res)
+			failed++;
+	}
+
+	return failed;
+}
+
+int fst_mux_get_map_bytes(struct fst_mux *ctx, fst_mux_bytes_cb cb,
+		void *cb_ctx)
+{
+	struct sim_mux_entry *e;
+	struct os_reltime now, diff;
+	unsigned int k;
+
+	os_get_reltime(&now);
+	sim.stats.bytes_dumps++;
+	for (k = 0; k < SIM_MUX_HASH_SIZE; k++)
+		dl_list_for_each(e, &ctx->hash[k], struct sim_mux_entry,
+				 lentry) {
+			struct sim_peer *p = sim_peer_by_addr(e->da, NULL, NULL);
+
+			os_reltime_sub(&now, &e->sampled, &diff);
+			if (p)
+				e->bytes += (u64)p->tx_rate *
+					(diff.sec * 1000000ULL + diff.usec) /
+					1000000;
+			e->sampled = now;
+			cb(e->da, e->bytes, cb_ctx);
+		}
+
+	return 0;
+}
+
+void fst_mux_unregister_iface(struct fst_mux *ctx, const char *iface_name)
+{
+	struct sim_group *g;
+	int idx = sim_iface_by_name(iface_name, &g);
+
+	if (idx >= 0 && g == ctx->g)
+		ctx->ifaces &= ~BIT(idx);
+}
+
+void fst_mux_stop(struct fst_mux *ctx)
+{
+	ctx->started = FALSE;
+}
+
+void fst_mux_cleanup(struct fst_mux *ctx)
+{
+	unsigned int k;
+
+	for (k = 0; k < SIM_MUX_HASH_SIZE; k++)
+		while (!dl_list_empty(&ctx->hash[k])) {
+			struct sim_mux_entry *e = dl_list_first(&ctx->hash[k],
+				struct sim_mux_entry, lentry);
+
+			dl_list_del(&e->lentry);
+			os_free(e);
+		}
+	ctx->g->mux = NULL;
+	os_free(ctx);
+}
+
+const char *sim_mux_lookup(struct fst_mux *ctx, const u8 *da)
+{
+	struct sim_mux_entry *e = sim_mux_entry(ctx, da);
+
+	return e ? e->iface_name : NULL;
+}
+
+unsigned int sim_mux_entries(struct fst_mux *ctx)
+{
+	return ctx->entries;
+}
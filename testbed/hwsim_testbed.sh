@@ -0,0 +1,361 @@
+#!/bin/sh
+#
+# End-to-end FST testbed built from mac80211_hwsim radios only.
+#
+# Two network namespaces, fst_ap and fst_sta, each get a 2.4 GHz (wlan0)
+# and a 5 GHz (wlan1) radio enslaved to bond0. hostapd runs in the first
+# one and wpa_supplicant in the second, both with FST enabled, and an fstman
+# instance manages each side, so that both the AP and the STA roles of the
+# manager run real FST setups and transfers. fstman is used in its CLI
+# configuration mode: the group (bond0) and its ifaces come from the FST
+# configuration of hostapd and wpa_supplicant, and the bonds are set up by
+# this script.
+#
+#   testbed/hwsim_testbed.sh [options] run | start | stop
+#
+# "run" starts the testbed, pings the AP from the STA over the bonds, drops
+# a 5 GHz radio several times (rfkill, or the link going down without it)
+# and reports:
+#   - the longest traffic gap around every link loss and the overall loss,
+#   - session setup times (setup initiated -> established) on both sides,
+#   - switch latencies from the fstman metrics,
+# and stops the testbed. Its exit status is 1 if no session got established
+# or a traffic gap exceeded the -G threshold. "start" and "stop" leave the
+# testbed running in between for manual experiments.
+#
+# Options:
+#   -n <int>  link losses to emulate (default 5)
+#   -d <sec>  time the radio stays down (default 5)
+#   -u <sec>  time the session is given to come back (default 10)
+#   -s ap|sta side whose 5 GHz radio is dropped (default ap)
+#   -G <ms>   longest acceptable traffic gap (default no limit)
+#   -w <dir>  work directory for configs, logs and results
+#             (default /tmp/fst_testbed)
+#
+# Needs root, mac80211_hwsim, bonding, iw and hostapd and wpa_supplicant
+# built with CONFIG_FST=y. They are taken from HOSTAP_DIR (a built hostap
+# tree) unless HOSTAPD, HOSTAPD_CLI, WPA_SUPPLICANT or WPA_CLI point
+# elsewhere; FSTMAN defaults to the fstman next to this directory.
+
+TB_DIR=$(cd "$(dirname "$0")" && pwd)
+HOSTAP_DIR=${HOSTAP_DIR:-$TB_DIR/../../hostap}
+HOSTAPD=${HOSTAPD:-$HOSTAP_DIR/hostapd/hostapd}
+HOSTAPD_CLI=${HOSTAPD_CLI:-$HOSTAP_DIR/hostapd/hostapd_cli}
+WPA_SUPPLICANT=${WPA_SUPPLICANT:-$HOSTAP_DIR/wpa_supplicant/wpa_supplicant}
+WPA_CLI=${WPA_CLI:-$HOSTAP_DIR/wpa_supplicant/wpa_cli}
+FSTMAN=${FSTMAN:-$TB_DIR/../fstman}
+
+NS_AP=fst_ap
+NS_STA=fst_sta
+IP_AP=192.168.77.1
+IP_STA=192.168.77.2
+SSID=fst-testbed
+PSK=fst-testbed-psk
+PING_INTERVAL=0.01
+
+LOSSES=5
+DOWN_SEC=5
+UP_SEC=10
+DROP_SIDE=ap
+MAX_GAP_MS=
+W=/tmp/fst_testbed
+
+usage() {
+	sed -n '3,/^$/s/^# \{0,1\}//p' "$0"
+	exit 2
+}
+
+while getopts "n:d:u:s:G:w:h" opt; do
+	case $opt in
+	n) LOSSES=$OPTARG ;;
+	d) DOWN_SEC=$OPTARG ;;
+	u) UP_SEC=$OPTARG ;;
+	s) DROP_SIDE=$OPTARG ;;
+	G) MAX_GAP_MS=$OPTARG ;;
+	w) W=$OPTARG ;;
+	*) usage ;;
+	esac
+done
+shift $((OPTIND - 1))
+[ $# -eq 1 ] || usage
+case $DROP_SIDE in
+ap|sta) ;;
+*) usage ;;
+esac
+
+log() {
+	echo "testbed: $*" >&2
+}
+
+now() {
+	date +%s.%N
+}
+
+nsrun() {
+	ns=$1
+	shift
+	ip netns exec "$ns" "$@"
+}
+
+# waits up to $1 seconds for the command that follows to succeed
+wait_for() {
+	tries=$(($1 * 10))
+	shift
+	while ! "$@" >/dev/null 2>&1; do
+		tries=$((tries - 1))
+		[ $tries -gt 0 ] || return 1
+		sleep 0.1
+	done
+}
+
+check_tools() {
+	for t in "$HOSTAPD" "$HOSTAPD_CLI" "$WPA_SUPPLICANT" "$WPA_CLI" \
+		 "$FSTMAN"; do
+		if [ ! -x "$t" ]; then
+			log "$t not found"
+			return 1
+		fi
+	done
+	for t in iw ip ping; do
+		if ! command -v $t >/dev/null; then
+			log "$t not found"
+			return 1
+		fi
+	done
+}
+
+# hwsim phys, in creation order
+hwsim_phys() {
+	for p in /sys/class/ieee80211/*; do
+		[ -e "$p/device/driver" ] || continue
+		[ "$(basename "$(readlink -f "$p/device/driver")")" = \
+		  mac80211_hwsim ] || continue
+		echo "$(cat "$p/index") $(basename "$p")"
+	done | sort -n | cut -d' ' -f2
+}
+
+load_radios() {
+	modprobe -r mac80211_hwsim 2>/dev/null
+	if ! modprobe mac80211_hwsim radios=4; then
+		log "cannot load mac80211_hwsim"
+		return 1
+	fi
+	modprobe bonding
+	iw reg set US
+	wait_for 5 test "$(hwsim_phys | wc -l)" -ge 4
+}
+
+# setup_side <ns> <2.4 GHz phy> <5 GHz phy> <ip>
+setup_side() {
+	ns=$1
+	ip netns add "$ns" || return 1
+	nsrun "$ns" ip link set lo up
+	i=0
+	for phy in $2 $3; do
+		dev=$(ls "/sys/class/ieee80211/$phy/device/net" | head -1)
+		iw phy "$phy" set netns name "$ns" || return 1
+		nsrun "$ns" ip link set "$dev" name wlan$i || return 1
+		i=$((i + 1))
+	done
+	nsrun "$ns" ip link add bond0 type bond mode active-backup \
+		miimon 100 all_slaves_active 1 || return 1
+	for dev in wlan0 wlan1; do
+		nsrun "$ns" ip link set $dev down
+		nsrun "$ns" ip link set $dev master bond0 || return 1
+	done
+	nsrun "$ns" ip addr add "$4/24" dev bond0
+	nsrun "$ns" ip link set bond0 up
+}
+
+write_configs() {
+	mkdir -p "$W/ap" "$W/sta" || return 1
+	rm -f "$W"/*.log "$W"/ap/* "$W"/sta/* 2>/dev/null
+
+	# wlan0: 2.4 GHz, wlan1: 5 GHz with the higher FST priority
+	for i in 0 1; do
+		if [ $i -eq 0 ]; then
+			mode=g; chan=1; freq=2412; prio=100
+		else
+			mode=a; chan=36; freq=5180; prio=110
+		fi
+		cat > "$W/ap/wlan$i.conf" <<-CONF
+		interface=wlan$i
+		driver=nl80211
+		ctrl_interface=$W/ap/ctrl
+		country_code=US
+		ssid=$SSID
+		hw_mode=$mode
+		channel=$chan
+		wpa=2
+		wpa_key_mgmt=WPA-PSK
+		rsn_pairwise=CCMP
+		wpa_passphrase=$PSK
+		fst_group_id=bond0
+		fst_priority=$prio
+		fst_llt=100
+		CONF
+		cat > "$W/sta/wlan$i.conf" <<-CONF
+		ctrl_interface=$W/sta/ctrl
+		country=US
+		fst_group_id=bond0
+		fst_priority=$prio
+		fst_llt=100
+		CONF
+	done
+	# fstman duplicates the network to wlan1 during the FST setup
+	cat >> "$W/sta/wlan0.conf" <<-CONF
+	network={
+		ssid="$SSID"
+		psk="$PSK"
+		key_mgmt=WPA-PSK
+		proto=RSN
+		pairwise=CCMP
+		scan_freq=2412
+	}
+	CONF
+}
+
+start_daemons() {
+	nsrun $NS_AP "$HOSTAPD" -B -P "$W/ap/hostapd.pid" -f "$W/ap/hostapd.log" \
+		-g "$W/ap/global" "$W/ap/wlan0.conf" "$W/ap/wlan1.conf" || return 1
+	nsrun $NS_STA "$WPA_SUPPLICANT" -B -P "$W/sta/wpa_supplicant.pid" \
+		-f "$W/sta/wpa_supplicant.log" -g "$W/sta/global" \
+		-Dnl80211 -i wlan0 -c "$W/sta/wlan0.conf" -N \
+		-Dnl80211 -i wlan1 -c "$W/sta/wlan1.conf" || return 1
+	wait_for 10 test -S "$W/ap/global" -a -S "$W/sta/global" || return 1
+
+	for side in ap sta; do
+		[ $side = ap ] && ns=$NS_AP || ns=$NS_STA
+		nsrun $ns "$FSTMAN" -dd -f "$W/$side/fstman.log" \
+			-m "$W/$side/metrics.prom" -t 65536 \
+			-T "$W/$side/trace.txt" "$W/$side/global" &
+		echo $! > "$W/$side/fstman.pid"
+	done
+}
+
+sta_connected() {
+	nsrun $NS_STA "$WPA_CLI" -p "$W/sta/ctrl" -i wlan0 status |
+		grep -q '^wpa_state=COMPLETED'
+}
+
+session_established() {
+	grep -q ': established (' "$W/ap/fstman.log" "$W/sta/fstman.log" \
+		2>/dev/null
+}
+
+tb_start() {
+	check_tools || return 1
+	load_radios || return 1
+	set -- $(hwsim_phys | tail -4)
+	setup_side $NS_AP "$1" "$2" $IP_AP || return 1
+	setup_side $NS_STA "$3" "$4" $IP_STA || return 1
+	write_configs || return 1
+	start_daemons || return 1
+
+	if ! wait_for 30 sta_connected; then
+		log "STA did not connect on wlan0"
+		return 1
+	fi
+	log "STA connected"
+	if ! wait_for 30 session_established; then
+		log "no FST session got established"
+		return 1
+	fi
+	log "FST session established"
+}
+
+tb_stop() {
+	for f in "$W"/*/fstman.pid "$W"/*/hostapd.pid \
+		 "$W"/*/wpa_supplicant.pid "$W/ping.pid"; do
+		[ -f "$f" ] || continue
+		kill "$(cat "$f")" 2>/dev/null
+		rm -f "$f"
+	done
+	# give fstman the time to restore the bonds and dump its trace
+	sleep 1
+	ip netns del $NS_AP 2>/dev/null
+	ip netns del $NS_STA 2>/dev/null
+	modprobe -r mac80211_hwsim 2>/dev/null
+	return 0
+}
+
+# radio_set <ns> <dev> block|unblock
+radio_set() {
+	phy=$(nsrun "$1" iw dev "$2" info | awk '/wiphy/ { print "phy" $2 }')
+	idx=
+	for r in /sys/class/rfkill/rfkill*; do
+		[ "$(cat "$r/name" 2>/dev/null)" = "$phy" ] && idx=${r##*rfkill}
+	done
+	if [ -n "$idx" ] && command -v rfkill >/dev/null; then
+		rfkill "$3" "$idx"
+	elif [ "$3" = block ]; then
+		nsrun "$1" ip link set "$2" down
+	else
+		nsrun "$1" ip link set "$2" up
+	fi
+}
+
+tb_run() {
+	if ! tb_start; then
+		tb_stop
+		return 1
+	fi
+	[ $DROP_SIDE = ap ] && ns=$NS_AP || ns=$NS_STA
+
+	# let the first switch to 5 GHz complete before the traffic starts
+	sleep 2
+	nsrun $NS_STA ping -D -n -i $PING_INTERVAL $IP_AP > "$W/ping.log" &
+	echo $! > "$W/ping.pid"
+	sleep 2
+
+	: > "$W/events.log"
+	n=0
+	while [ $n -lt "$LOSSES" ]; do
+		log "link loss $((n + 1))/$LOSSES on $DROP_SIDE wlan1"
+		echo "$(now) down" >> "$W/events.log"
+		radio_set $ns wlan1 block
+		sleep "$DOWN_SEC"
+		echo "$(now) up" >> "$W/events.log"
+		radio_set $ns wlan1 unblock
+		sleep "$UP_SEC"
+		n=$((n + 1))
+	done
+
+	kill "$(cat "$W/ping.pid")" 2>/dev/null
+	rm -f "$W/ping.pid"
+	# the metrics file is rewritten periodically, wait for a fresh one
+	sleep 6
+
+	res=0
+	awk -v max_gap_ms="$MAX_GAP_MS" \
+		-f "$TB_DIR/ping_gaps.awk" "$W/events.log" "$W/ping.log" \
+		|| res=1
+	for side in ap sta; do
+		awk -v side=$side -f "$TB_DIR/setup_times.awk" \
+			"$W/$side/fstman.log" || res=1
+		grep '^fstman_switch_latency_us' "$W/$side/metrics.prom" \
+			2>/dev/null | grep 'phase="total"' | sed "s/^/$side: /"
+	done
+
+	tb_stop
+	log "logs and configs are kept in $W"
+	return $res
+}
+
+case $1 in
+start)
+	if ! tb_start; then
+		tb_stop
+		exit 1
+	fi
+	;;
+stop)
+	tb_stop
+	;;
+run)
+	tb_run
+	;;
+*)
+	usage
+	;;
+esac
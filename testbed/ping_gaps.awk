@@ -0,0 +1,62 @@
+#
+# Traffic gaps around the link losses of hwsim_testbed.sh. The first input
+# is the event log ("<time> down|up" lines), the second the output of
+# "ping -D". Every gap between two replies is accounted to the last link
+# loss that started before the gap ended.
+#
+# Variables: max_gap_ms - longest acceptable gap in ms, the exit status is 1
+# if any gap is longer.
+#
+
+FNR == NR {
+	if ($2 == "down")
+		down[++losses] = $1
+	else if ($2 == "up")
+		up[losses] = $1
+	next
+}
+
+/icmp_seq=/ {
+	t = substr($1, 2, length($1) - 2)
+	seq = $0
+	sub(/.*icmp_seq=/, "", seq)
+	sub(/ .*/, "", seq)
+	seq += 0
+	if (!replies++)
+		first_seq = seq
+	last_seq = seq
+
+	if (replies > 1) {
+		gap = (t - prev) * 1000
+		k = 0
+		while (k < losses && down[k + 1] <= t)
+			k++
+		if (gap > max_gap[k])
+			max_gap[k] = gap
+	}
+	prev = t
+}
+
+END {
+	printf("traffic baseline max_gap_ms=%.0f\n", max_gap[0])
+	for (k = 1; k <= losses; k++) {
+		printf("traffic loss=%d down_ms=%.0f max_gap_ms=%.0f\n", k,
+		       (k in up) ? (up[k] - down[k]) * 1000 : 0, max_gap[k])
+		if (max_gap[k] > worst)
+			worst = max_gap[k]
+	}
+	sent = replies ? last_seq - first_seq + 1 : 0
+	printf("traffic sent=%d replies=%d lost=%d lost_pct=%.2f " \
+	       "worst_gap_ms=%.0f\n", sent, replies, sent - replies,
+	       sent ? (sent - replies) * 100 / sent : 0, worst)
+
+	if (!replies) {
+		print "traffic: no replies" > "/dev/stderr"
+		exit 1
+	}
+	if (max_gap_ms != "" && worst > max_gap_ms) {
+		printf("traffic: gap of %.0f ms, over the %d ms limit\n",
+		       worst, max_gap_ms) > "/dev/stderr"
+		exit 1
+	}
+}
@@ -0,0 +1,48 @@
+#
+# Session setup times in an fstman log, from "setup initiated" to
+# "established (initiator)" of the same session. Sessions established as
+# a responder are counted but have no local start. The exit status is 1 if
+# no session got established.
+#
+# Variables: side - label of the report lines.
+#
+
+function log_time(line) {
+	return substr(line, 2, index(line, "]") - 2) + 0
+}
+
+function session_id(line,	id) {
+	id = line
+	sub(/.*session /, "", id)
+	sub(/:.*/, "", id)
+	return id
+}
+
+/: setup initiated/ {
+	start[session_id($0)] = log_time($0)
+	initiated++
+}
+
+/: established \(/ {
+	established++
+	id = session_id($0)
+	if (/\(initiator\)/ && (id in start)) {
+		ms = (log_time($0) - start[id]) * 1000
+		sum += ms
+		if (ms > max)
+			max = ms
+		timed++
+		delete start[id]
+	} else if (/\(responder\)/)
+		responder++
+}
+
+END {
+	printf("%s: setups initiated=%d established=%d responder=%d " \
+	       "setup_ms avg=%.1f max=%.1f\n", side, initiated, established,
+	       responder, timed ? sum / timed : 0, max)
+	if (!established) {
+		printf("%s: no session got established\n", side) > "/dev/stderr"
+		exit 1
+	}
+}